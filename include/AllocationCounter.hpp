@@ -0,0 +1,14 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+
+//? Counts global operator new calls, the replacements live in AllocationCounter.cpp.
+//? Memory Vulkan or GLFW get from malloc isn't seen, neither are custom allocators
+//? like FrameArena once their blocks exist.
+namespace AllocationCounter {
+	//? Made by the calling thread since it started
+	uint64 ThreadAllocations();
+	uint64 ThreadBytes();
+	//? Made by every thread
+	uint64 TotalAllocations();
+}
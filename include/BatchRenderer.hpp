@@ -0,0 +1,94 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "ThreadPool.hpp"
+
+//? One independent render job: a scene rendered offscreen for a number of frames
+struct BatchJob {
+	uint scene = 0;
+	uint frames = 1;
+	uint instances = 1;
+	//? Gets the last frame as tightly packed RGBA8, called on a worker thread
+	std::function<void(const BatchJob& job, const uint8* pixels, VkExtent2D extent)> onFinished;
+};
+
+//? Renders many offscreen scenes at once on one device. Every scene context owns
+//? its target, command pools and fences, and is bound to one of the graphics
+//? family's queues. Jobs are picked up from a queue by one worker per context.
+class BatchRenderer {
+public:
+	//? Uses every queue the graphics family was created with (Context::graphicsQueueCount)
+	void Init(const Context& context, uint contextCount, VkExtent2D extent);
+	void CleanUp();
+
+	void Submit(BatchJob job);
+	//? Blocks until every submitted job has finished
+	void Wait();
+
+	void PrintStats();
+
+private:
+	struct Parameters {
+		float time;
+		uint scene;
+		uint instances;
+		float aspect;
+	};
+
+	//? Queues are externally synchronized, contexts sharing one take turns
+	struct QueueSlot {
+		VkQueue queue = VK_NULL_HANDLE;
+		std::mutex mutex;
+		uint submits = 0;
+	};
+
+	struct SceneContext {
+		QueueSlot* queue = nullptr;
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkBuffer readbackBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+		void* readbackMapped = nullptr;
+		//? A pool per frame slot, reset whole instead of per command buffer
+		std::array<VkCommandPool, 2> commandPools;
+		std::array<VkCommandBuffer, 2> commandBuffers;
+		std::array<VkFence, 2> fences;
+
+		uint jobs = 0;
+		uint frames = 0;
+		double busySeconds = 0.0;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	Context context;
+	VkExtent2D extent;
+	VkRenderPass renderPass;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+	std::vector<std::unique_ptr<QueueSlot>> queues;
+	std::vector<std::unique_ptr<SceneContext>> sceneContexts;
+	std::unique_ptr<ThreadPool> workers;
+
+	//? Contexts not running a job, the pool never runs more jobs than there are contexts
+	std::vector<SceneContext*> idleContexts;
+	std::mutex idleMutex;
+
+	//? Guarded by idleMutex, measured from the first submit to the last finished job
+	Clock::time_point startTime;
+	Clock::time_point endTime;
+	bool started = false;
+	uint jobsFinished = 0;
+
+	void CreateRenderPass();
+	void CreatePipeline();
+	void CreateSceneContext(SceneContext& sceneContext);
+	void DestroySceneContext(SceneContext& sceneContext);
+
+	void RenderJob(SceneContext& sceneContext, const BatchJob& job);
+	void RecordFrame(SceneContext& sceneContext, VkCommandBuffer commandBuffer, const BatchJob& job, uint frame, bool readback);
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "ThreadPool.hpp"
+
+//? Bounding volume hierarchy over bounding spheres, the primitives are their indices.
+//? Built as a binary tree with binned SAH splits, subtrees past
+//? Settings::bvhParallelThreshold primitives on other threads, then collapsed
+//? into nodes of Width children. A node keeps its children's boxes as one array
+//? per coordinate, so a query tests all of them in one loop the compiler can
+//? vectorize. Every child also knows the contiguous run of primitives under it,
+//? which lets a frustum query take a whole subtree without visiting it.
+//? Moving primitives only needs a refit, which grows the boxes of the nodes above them.
+class Bvh {
+public:
+	//? 4 matches SSE and NEON, 8 matches AVX. Queries don't depend on it
+	static const uint Width = 4;
+
+	struct RayHit {
+		uint primitive;
+		float distance;
+	};
+
+	//? Planes of a frustum from a view projection with depth from 0 to 1, normals point inside
+	static void FrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+	//? spheres are center and radius. They're copied, later changes need a Refit
+	void Build(const glm::vec4* spheres, uint count, ThreadPool* workers = nullptr);
+	//? Every primitive moved
+	void Refit(const glm::vec4* spheres);
+	//? Only the listed primitives moved, only their nodes and the ones above are touched
+	void Refit(const glm::vec4* spheres, const uint* moved, uint count);
+
+	//? Appends every primitive whose sphere is not entirely outside one of the planes
+	void QueryFrustum(const glm::vec4 planes[6], std::vector<uint>& results) const;
+	//? Closest sphere the ray enters within maxDistance, direction has to be normalized
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+	//? Sphere with the closest surface, 0 away from anything inside
+	bool Nearest(const glm::vec3& point, float maxDistance, RayHit& hit) const;
+
+	uint NodeCount() const;
+	uint Depth() const;
+	//? Expected cost of a query relative to testing one primitive, grows as refits loosen the tree
+	float SahCost() const;
+
+	//? Build, refit and query times over count random spheres, printed
+	static void Benchmark(uint count);
+
+private:
+	static const uint noChild = UINT32_MAX;
+	static const uint maxLeafSize = 4;
+	static const uint binCount = 16;
+	//? Depth is bounded by maxSahLevel plus the median splits below it, each level pushes at most Width - 1 more
+	static const uint maxStack = 64 * Width;
+
+	struct Node {
+		float minX[Width];
+		float minY[Width];
+		float minZ[Width];
+		float maxX[Width];
+		float maxY[Width];
+		float maxZ[Width];
+		//? Node index, noChild for a leaf
+		uint child[Width];
+		//? Primitives under the child, a slot with none is empty
+		uint first[Width];
+		uint count[Width];
+	};
+
+	struct Reference {
+		glm::vec3 center;
+		float radius;
+		uint primitive;
+	};
+
+	struct BuildNode {
+		glm::vec3 min;
+		glm::vec3 max;
+		uint left;
+		uint first;
+		uint count;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<uint> parents;
+	//? Primitives in leaf order, their spheres next to them in the same order
+	std::vector<uint> order;
+	std::vector<glm::vec4> spheres;
+	//? Where each primitive went: its place in order and the node holding its leaf
+	std::vector<uint> positions;
+	std::vector<uint> leafNodes;
+	uint depth = 0;
+
+	//? Only while building
+	std::vector<BuildNode> buildNodes;
+	std::atomic<uint> buildNodeCount {0};
+	//? Partitioned in place, a subtree's primitives end up next to each other
+	std::vector<Reference> references;
+	ThreadPool* workers = nullptr;
+
+	//? Refit scratch, kept so refits don't allocate
+	std::vector<uint8> nodeDirty;
+	std::vector<uint> dirtyNodes;
+
+	void BuildRange(uint node, uint begin, uint end, uint level);
+	uint Collapse(uint buildNode, uint parent, uint level);
+	void RefitNode(uint node);
+};
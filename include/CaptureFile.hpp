@@ -0,0 +1,189 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include <vulkan/vulkan.h>
+
+//? One frame's render passes, with everything needed to run them again without the app:
+//? the objects the commands use, buffer and texture contents as they were when the frame
+//? finished, and the commands with secondaries already inlined. Objects refer to each other
+//? and commands refer to objects by index into these lists. See FrameCapture and tools/replay.
+//? On disk it's a header followed by the lists in declaration order, integers as varints.
+struct CaptureFile {
+	static constexpr uint magic = 0x50414356;
+	static constexpr uint version = 1;
+	static constexpr uint64 none = ~0ull;
+
+	struct Buffer {
+		VkDeviceSize size = 0;
+		VkBufferUsageFlags usage = 0;
+		std::string data;
+	};
+
+	struct Image {
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkExtent2D extent = {0, 0};
+		uint mipLevels = 1;
+		VkImageUsageFlags usage = 0;
+		//? Sampled images only: the layout descriptors expect and one tightly packed string per level.
+		//? Attachments have neither, render passes produce their contents
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		std::vector<std::string> levels;
+	};
+
+	struct ImageView {
+		uint64 image = none;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkImageAspectFlags aspect = 0;
+		uint mipLevels = 1;
+	};
+
+	//? sType, pNext and flags aren't kept
+	struct Sampler {
+		VkSamplerCreateInfo info {};
+	};
+
+	struct ShaderModule {
+		std::string code;
+	};
+
+	struct SetLayoutBinding {
+		uint binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		uint count = 0;
+		VkShaderStageFlags stages = 0;
+		//? From VkDescriptorSetLayoutBindingFlagsCreateInfo, 0 without it
+		VkDescriptorBindingFlags flags = 0;
+	};
+
+	struct SetLayout {
+		VkDescriptorSetLayoutCreateFlags flags = 0;
+		std::vector<SetLayoutBinding> bindings;
+	};
+
+	struct PipelineLayout {
+		std::vector<uint64> setLayouts;
+		std::vector<VkPushConstantRange> pushConstants;
+	};
+
+	//? One subpass, like every render pass here
+	struct RenderPass {
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+		VkAttachmentReference depthReference = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+		std::vector<VkSubpassDependency> dependencies;
+	};
+
+	struct Framebuffer {
+		uint64 renderPass = none;
+		std::vector<uint64> attachments;
+		VkExtent2D extent = {0, 0};
+	};
+
+	struct ShaderStage {
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+		uint64 module = none;
+		std::string entry;
+		std::vector<VkSpecializationMapEntry> specializationEntries;
+		std::string specializationData;
+	};
+
+	//? The state structs keep their scalar fields only, their pointers are the lists next to them
+	struct Pipeline {
+		uint64 layout = none;
+		uint64 renderPass = none;
+		uint subpass = 0;
+		std::vector<ShaderStage> stages;
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly {};
+		uint viewportCount = 1;
+		uint scissorCount = 1;
+		//? Empty when they're dynamic state
+		std::vector<VkViewport> viewports;
+		std::vector<VkRect2D> scissors;
+		VkPipelineRasterizationStateCreateInfo rasterization {};
+		VkPipelineMultisampleStateCreateInfo multisample {};
+		bool depthStencilEnabled = false;
+		VkPipelineDepthStencilStateCreateInfo depthStencil {};
+		VkPipelineColorBlendStateCreateInfo colorBlend {};
+		std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+		std::vector<VkDynamicState> dynamicStates;
+	};
+
+	//? One array element of one binding
+	struct Descriptor {
+		uint binding = 0;
+		uint arrayElement = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		uint64 buffer = none;
+		VkDeviceSize offset = 0;
+		VkDeviceSize range = 0;
+		uint64 sampler = none;
+		uint64 view = none;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	struct DescriptorSet {
+		uint64 layout = none;
+		std::vector<Descriptor> descriptors;
+	};
+
+	//? Arguments, objects as indices:
+	//? BeginRenderPass: render pass, framebuffer, x, y, width, height. Data: the clear values
+	//? BindPipeline: bind point, pipeline
+	//? BindDescriptorSets: bind point, layout, first set, sets... Data: dynamic offsets
+	//? BindVertexBuffers: first binding, then a buffer and an offset per binding
+	//? BindIndexBuffer: buffer, offset, index type
+	//? PushConstants: layout, stages, offset. Data: the constants
+	//? SetViewport, SetScissor: first. Data: the viewports or rects
+	//? Draw, DrawIndexed, DrawIndexedIndirect(Count): the vkCmd* arguments in order, buffers as indices
+	//? ExecuteCommands: the secondaries, only while capturing, files have them inlined
+	enum class Op : uint {
+		BeginRenderPass,
+		EndRenderPass,
+		BindPipeline,
+		BindDescriptorSets,
+		BindVertexBuffers,
+		BindIndexBuffer,
+		PushConstants,
+		SetViewport,
+		SetScissor,
+		Draw,
+		DrawIndexed,
+		DrawIndexedIndirect,
+		DrawIndexedIndirectCount,
+		ExecuteCommands,
+	};
+
+	struct Command {
+		Op op = Op::EndRenderPass;
+		std::vector<uint64> args;
+		std::string data;
+	};
+
+	std::string deviceName;
+	uint64 frame = 0;
+	//? Device features the commands rely on, a replay device needs them as well
+	bool multiDrawIndirect = false;
+	bool drawIndirectFirstInstance = false;
+	bool drawIndirectCount = false;
+	bool descriptorIndexing = false;
+
+	std::vector<Buffer> buffers;
+	std::vector<Image> images;
+	std::vector<ImageView> imageViews;
+	std::vector<Sampler> samplers;
+	std::vector<ShaderModule> shaderModules;
+	std::vector<SetLayout> setLayouts;
+	std::vector<PipelineLayout> pipelineLayouts;
+	std::vector<RenderPass> renderPasses;
+	std::vector<Framebuffer> framebuffers;
+	std::vector<Pipeline> pipelines;
+	std::vector<DescriptorSet> descriptorSets;
+	std::vector<Command> commands;
+
+	void Save(const std::string& path) const;
+	static CaptureFile Load(const std::string& path);
+	//? Buffer and image contents, what most of the file is
+	VkDeviceSize ContentBytes() const;
+};
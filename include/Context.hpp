@@ -0,0 +1,51 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "MemoryTracker.hpp"
+#include <vulkan/vulkan.h>
+
+//? Device handles shared by every subsystem that owns GPU resources.
+//? TriangleApp fills it once the logical device exists.
+struct Context {
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	//? Lowest of the instance and device versions
+	uint apiVersion = VK_API_VERSION_1_0;
+	uint graphicsFamily = 0;
+	VkQueue graphicsQueue = VK_NULL_HANDLE;
+	//? Queues created in the graphics family, graphicsQueue is the first one
+	uint graphicsQueueCount = 1;
+	//? Same as the graphics family when there's no dedicated compute family
+	uint computeFamily = 0;
+	VkQueue computeQueue = VK_NULL_HANDLE;
+	//? Optional device extensions that turned out to be supported
+	std::set<std::string> enabledExtensions;
+	//? Runtime sized, partially bound, update-after-bind descriptor arrays
+	bool descriptorIndexing = false;
+	//? Core features the indirect draw paths depend on, enabled when supported
+	bool multiDrawIndirect = false;
+	bool drawIndirectFirstInstance = false;
+	//? Owned by TriangleApp, shared by every copy of the context. Null means untracked
+	MemoryTracker* memoryTracker = nullptr;
+
+	bool HasExtension(const std::string& name) const;
+
+	uint FindMemoryType(uint typeFilter, VkMemoryPropertyFlags flags) const;
+	//? Every allocation goes through these two, so the tracker sees all of them
+	VkDeviceMemory AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkDeviceSize requested, const std::string& tag) const;
+	void FreeMemory(VkDeviceMemory memory) const;
+	//? Buffers shared by several queue families use concurrent sharing
+	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory, const std::vector<uint>& queueFamilies = {}) const;
+	void DestroyBuffer(VkBuffer buffer, VkDeviceMemory memory) const;
+	//? 2D, optimal tiling, device local, exclusive to the graphics family
+	void CreateImage(VkExtent2D extent, uint mipLevels, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory) const;
+	VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint mipLevels = 1) const;
+	void DestroyImage(VkImage image, VkDeviceMemory memory) const;
+	//? Copies through a temporary staging buffer and waits for the transfer, meant for loading time
+	void UploadBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize offset = 0) const;
+	//? Records and runs a one-off command buffer on the graphics queue, then waits for it
+	void ImmediateSubmit(const std::function<void(VkCommandBuffer)>& record) const;
+
+	VkShaderModule CreateShaderModule(const std::string& code) const;
+	static std::string ReadFile(const std::string& path);
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "Descriptors.hpp"
+#include "ShaderReloader.hpp"
+
+//? Hierarchical Z. Level 0 is the depth buffer reduced to the power of two
+//? below its size, every further level keeps the farthest depth of the 2x2
+//? texels above it. Anything whose nearest depth lies behind the farthest
+//? depth of the texels it covers is hidden.
+class DepthPyramid {
+public:
+	void Init(const Context& context, DescriptorLayoutCache& layoutCache, VkImageView depthView, VkExtent2D depthExtent);
+	void CleanUp();
+
+	//? The depth buffer has to be in SHADER_READ_ONLY_OPTIMAL with its writes visible to compute.
+	//? Leaves the pyramid's writes visible to later compute reads
+	void Build(VkCommandBuffer commandBuffer);
+
+	//? Every level, the pyramid stays in GENERAL layout
+	VkImageView View() const;
+	VkSampler Sampler() const;
+	VkExtent2D Extent() const;
+	uint Levels() const;
+
+	void RegisterShaders(ShaderReloader& reloader);
+
+private:
+	struct ReduceConstants {
+		glm::ivec2 sourceSize;
+		glm::ivec2 destinationSize;
+	};
+
+	Context context;
+	VkExtent2D depthExtent;
+	VkExtent2D extent;
+	uint levels = 0;
+
+	VkImage image;
+	VkDeviceMemory memory;
+	VkImageView view;
+	std::vector<VkImageView> levelViews;
+	VkSampler sampler;
+
+	DescriptorAllocator descriptorAllocator;
+	VkDescriptorSetLayout setLayout;
+	//? sets[i] reads level i - 1 (the depth buffer for 0) and writes level i
+	std::vector<VkDescriptorSet> sets;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+
+	void CreateImage();
+	void CreateDescriptors(DescriptorLayoutCache& layoutCache, VkImageView depthView);
+	void CreatePipeline();
+	VkPipeline BuildPipeline() const;
+	VkExtent2D LevelExtent(uint level) const;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Context.hpp"
+#include <unordered_map>
+
+//? Hands out descriptor sets from a growing list of pools. Sets are never
+//? freed one by one: the owner resets every pool at once, which is how the
+//? per-frame allocators are recycled after their frame's fence.
+class DescriptorAllocator {
+public:
+	void Init(VkDevice device, uint setsPerPool = 64);
+	void CleanUp();
+
+	VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+	void Reset();
+
+	uint SetsAllocated() const;
+	uint PoolCount() const;
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	uint setsPerPool = 0;
+	VkDescriptorPool currentPool = VK_NULL_HANDLE;
+	std::vector<VkDescriptorPool> usedPools;
+	std::vector<VkDescriptorPool> freePools;
+	uint setsAllocated = 0;
+
+	VkDescriptorPool GrabPool();
+};
+
+//? Deduplicates set layouts by their bindings. Immutable samplers aren't part
+//? of the key, layouts that use them have to be created by hand.
+class DescriptorLayoutCache {
+public:
+	void Init(VkDevice device);
+	void CleanUp();
+
+	VkDescriptorSetLayout Get(std::vector<VkDescriptorSetLayoutBinding> bindings);
+	uint Size() const;
+
+private:
+	struct LayoutKey {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+		bool operator==(const LayoutKey& other) const;
+	};
+
+	struct LayoutKeyHash {
+		size_t operator()(const LayoutKey& key) const;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+};
+
+//? One big update-after-bind set holding every buffer and texture, bound once
+//? per frame. Draws then pick resources by index instead of rebinding sets.
+//? Needs descriptor indexing (Context::descriptorIndexing).
+class BindlessTable {
+public:
+	static const uint bufferBinding = 0;
+	static const uint imageBinding = 1;
+
+	void Init(const Context& context, uint maxBuffers, uint maxImages);
+	void CleanUp();
+
+	VkDescriptorSetLayout Layout() const;
+	VkDescriptorSet Set() const;
+
+	uint AddBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	uint AddImage(VkImageView imageView, VkSampler sampler);
+	//? Repoints a slot, frames in flight must not be using it
+	void SetImage(uint index, VkImageView imageView, VkSampler sampler);
+
+private:
+	VkDevice device = VK_NULL_HANDLE;
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	uint maxBuffers = 0;
+	uint maxImages = 0;
+	uint bufferCount = 0;
+	uint imageCount = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "FrameStats.hpp"
+#include "ThreadPool.hpp"
+#include "FrameArena.hpp"
+
+//? Draw packets collected over a frame, radix sorted by a 64 bit key and
+//? recorded in key order. Binds that repeat the current state are skipped, so
+//? the key decides which state changes least often. From the top bit:
+//? pass 4 bits, pipeline 12, descriptor set 12, vertex buffer 12, depth 24.
+//? Pipeline, set and buffer ids are small numbers picked by whoever adds the packet.
+class DrawQueue {
+public:
+	struct Packet {
+		VkPipeline pipeline;
+		VkPipelineLayout layout;
+		//? Bound from set 0
+		VkDescriptorSet sets[2];
+		uint setCount;
+		VkBuffer vertexBuffer;
+		//? VK_NULL_HANDLE for a non indexed draw, UINT32 indices otherwise
+		VkBuffer indexBuffer;
+		uint count;
+		uint first;
+		int32 vertexOffset;
+		uint firstInstance;
+	};
+
+	//? Depth is 0 at the camera and 1 at the far plane, front to back keeps early depth rejection busy
+	static uint64 Key(uint pass, uint pipeline, uint descriptorSet, uint vertexBuffer, float depth);
+
+	//? Sorts with several threads past Settings::drawSortParallelThreshold packets
+	void Init(uint capacity);
+	//? Drops the last frame's packets and takes this frame's storage from its arena
+	void Begin(FrameArena& arena);
+	void Add(uint64 key, const Packet& packet);
+	void Sort();
+	void Record(VkCommandBuffer commandBuffer, FrameStats& stats);
+
+	void PrintStats(const std::string& name);
+
+private:
+	static const uint radixBits = 8;
+	static const uint radixBuckets = 1 << radixBits;
+	static const uint radixPasses = 64 / radixBits;
+
+	uint capacity = 0;
+	ArenaVector<Packet> packets;
+	//? Sorted in place, order[i] is the packet of the i-th smallest key
+	ArenaVector<uint64> keys;
+	ArenaVector<uint> order;
+	ArenaVector<uint64> scratchKeys;
+	ArenaVector<uint> scratchOrder;
+
+	std::unique_ptr<ThreadPool> workers;
+	//? histograms[chunk][bucket], then the chunk's first output slot for each bucket
+	std::vector<std::array<uint, radixBuckets>> histograms;
+
+	uint64 frames = 0;
+	uint64 packetsRecorded = 0;
+	uint64 parallelSorts = 0;
+	uint64 radixPassesRun = 0;
+	double sortSeconds = 0.0;
+	FrameStats binds;
+	FrameStats skipped;
+
+	void SortSerial();
+	void SortParallel();
+	void Scatter(uint begin, uint end, uint shift, std::array<uint, radixBuckets>& offsets);
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "FrameStats.hpp"
+
+//? Render pass contents recorded into secondary command buffers.
+//? Static streams keep one buffer per frame slot and are only recorded again
+//? when the key they were recorded with changes: the key covers every handle
+//? the stream binds. Dynamic streams are recorded every frame into a
+//? transient pool that is reset as a whole once the slot's fence signals.
+class DrawStreamCache {
+public:
+	//? Where a stream's commands go. Only record into it when record is true,
+	//? the stats counted while recording are kept with the stream and added on every execute
+	struct Recording {
+		VkCommandBuffer commandBuffer;
+		FrameStats stats;
+		bool record;
+		bool dynamic;
+		uint entry;
+	};
+
+	void Init(const Context& context);
+	void CleanUp();
+
+	uint AddStream(const std::string& name);
+	//? Folds a handle or value into a stream key
+	static uint64 Hash(uint64 seed, uint64 value);
+	//? Every static stream records again on its next use, for when something no key covers has changed
+	void Invalidate();
+
+	//? Viewport and scissor, for the pipelines of everything drawn in streams
+	static const VkPipelineDynamicStateCreateInfo dynamicState;
+
+	//? Every stream begins by setting the viewport and scissor to this, pipelines drawing in them
+	//? take both as dynamic state. Static streams record again when it changes
+	void SetViewport(VkExtent2D extent);
+	//? Call after the frame slot's fence, recycles the slot's dynamic buffers
+	void BeginFrame(uint frameIndex);
+	//? Secondaries only inherit the render pass, so the same recording works with every framebuffer
+	Recording BeginStatic(uint stream, uint frameIndex, uint64 key, VkRenderPass renderPass);
+	Recording BeginDynamic(uint frameIndex, VkRenderPass renderPass);
+	//? Queues the stream for the next Execute
+	void End(const Recording& recording);
+	//? Inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+	//? runs everything queued since the last call and adds their stats
+	void Execute(VkCommandBuffer commandBuffer, FrameStats& stats);
+
+	void PrintStats();
+
+private:
+	struct Entry {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		uint64 key = 0;
+		bool valid = false;
+		FrameStats stats;
+	};
+
+	Context context;
+	//? Static buffers are reset one by one, dynamic pools all at once
+	VkCommandPool staticPool;
+	std::vector<VkCommandPool> dynamicPools;
+	std::vector<std::string> names;
+	std::vector<uint64> streamRecords;
+	//? staticEntries[stream * maxFramesInFlight + frameIndex]
+	std::vector<Entry> staticEntries;
+	//? Per frame slot, grown on demand and reused from then on
+	std::vector<std::vector<Entry>> dynamicEntries;
+	std::vector<uint> dynamicUsed;
+	std::vector<VkCommandBuffer> queued;
+	FrameStats queuedStats;
+	uint currentFrame = 0;
+	VkExtent2D viewport = { 0, 0 };
+	std::chrono::steady_clock::time_point recordStart;
+
+	uint64 frames = 0;
+	uint64 hits = 0;
+	uint64 misses = 0;
+	uint64 dynamicRecords = 0;
+	double staticSeconds = 0.0;
+	double dynamicSeconds = 0.0;
+
+	VkCommandBuffer AllocateSecondary(VkCommandPool pool);
+	void Begin(VkCommandBuffer commandBuffer, VkRenderPass renderPass);
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Context.hpp"
+#include <glm/gtc/quaternion.hpp>
+
+//? Renderable objects stored as parallel arrays, one column per component, so
+//? a pass over one component only touches that component's memory. Rows stay
+//? dense: destroying an entity moves the last row into its place. Handles
+//? survive that through a slot table, and a generation per slot tells a
+//? destroyed entity's handle apart from the one that reuses its slot.
+//? Rows are marked dirty when written, CollectDirtyRanges hands them out so
+//? only what changed gets uploaded.
+class EntityStore {
+public:
+	struct Entity {
+		uint slot;
+		uint generation;
+	};
+
+	//? Rows begin to end, end excluded
+	struct Range {
+		uint begin;
+		uint end;
+	};
+
+	enum Flags : uint8 {
+		Visible = 1 << 0,
+	};
+
+	//? What a new entity starts with
+	struct Desc {
+		glm::vec3 position = glm::vec3(0.0f);
+		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		float scale = 1.0f;
+		//? Bounding sphere of the mesh in its own space
+		glm::vec4 localBounds = glm::vec4(0.0f);
+		uint mesh = 0;
+		uint material = 0;
+		uint8 flags = Visible;
+	};
+
+	void Reserve(uint count);
+	//? One row per description, handles[i] is the entity made from descs[i]
+	void Create(const Desc* descs, uint count, Entity* handles);
+	//? Handles of entities that are already gone are skipped
+	void Destroy(const Entity* handles, uint count);
+
+	bool Alive(Entity entity) const;
+	//? Only until the next Destroy, which may move the entity to another row
+	uint Row(Entity entity) const;
+	Entity Handle(uint row) const;
+	uint Size() const;
+
+	//? Columns indexed by row. Writing through them marks nothing, call MarkDirty for the rows
+	glm::vec3* Positions();
+	glm::quat* Rotations();
+	float* Scales();
+	uint* Meshes();
+	uint* Materials();
+	uint8* EntityFlags();
+	const glm::vec3* Positions() const;
+	const glm::quat* Rotations() const;
+	const float* Scales() const;
+	//? World space center and radius, kept up to date by UpdateBounds
+	const glm::vec4* Bounds() const;
+	const uint* Meshes() const;
+	const uint* Materials() const;
+	const uint8* EntityFlags() const;
+
+	void MarkDirty(uint begin, uint end);
+	//? World bounds of the rows from their transforms and local bounds
+	void UpdateBounds(uint begin, uint end);
+	glm::mat4 Model(uint row) const;
+	//? Appends the dirty rows as ranges and clears them. Up to mergeGap clean rows between
+	//? two dirty ones join them into one range, a few extra rows cost less than another copy
+	void CollectDirtyRanges(uint mergeGap, std::vector<Range>& ranges);
+
+	//? Creation, iteration, dirty range collection, packing and upload at count entities, printed
+	static void Benchmark(const Context& context, uint count);
+
+private:
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> rotations;
+	std::vector<float> scales;
+	std::vector<glm::vec4> localBounds;
+	std::vector<glm::vec4> bounds;
+	std::vector<uint> meshes;
+	std::vector<uint> materials;
+	std::vector<uint8> flags;
+	//? One bit per row
+	std::vector<uint64> dirty;
+
+	std::vector<uint> rowSlots;
+	std::vector<uint> slotRows;
+	std::vector<uint> generations;
+	std::vector<uint> freeSlots;
+
+	void Resize(uint count);
+	void MoveRow(uint from, uint to);
+	void SetDirty(uint row, bool value);
+};
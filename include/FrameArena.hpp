@@ -0,0 +1,83 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+
+//? Bump allocator for memory that only lives for one frame slot. Allocating
+//? moves an offset, freeing does nothing, and Reset hands everything back at
+//? once after the slot's fence has signaled. Allocations that don't fit go to
+//? the heap and the next Reset grows the block to cover them, so after a few
+//? frames the arena stops touching the heap.
+class FrameArena {
+public:
+	void Init(size_t capacity);
+	void CleanUp();
+
+	void* Allocate(size_t size, size_t alignment);
+	template<typename T>
+	T* Allocate(size_t count) {
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+	//? Nothing handed out since the last reset may be used afterwards
+	void Reset();
+
+	size_t Used() const;
+	size_t Capacity() const;
+	size_t HighWater() const;
+	//? Allocations that went to the heap because the block was full
+	uint64 Overflows() const;
+	uint Grows() const;
+
+private:
+	std::unique_ptr<uint8[]> block;
+	size_t capacity = 0;
+	size_t offset = 0;
+	size_t highWater = 0;
+	std::vector<std::unique_ptr<uint8[]>> overflowBlocks;
+	size_t overflowBytes = 0;
+	uint64 overflows = 0;
+	uint grows = 0;
+};
+
+//? Standard allocator on top of a FrameArena, for containers that die with the frame.
+//? Growing a container leaves its old storage in the arena, reserve when the size is known
+template<typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+	//? Containers take their arena along, storage from one arena is never handed to another
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator() = default;
+	ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.Arena()) {}
+
+	T* allocate(size_t count) {
+		if (arena == nullptr) {
+			throw std::runtime_error("Couldn't allocate, the container has no arena.");
+		}
+		return arena->Allocate<T>(count);
+	}
+	void deallocate(T*, size_t) {}
+
+	FrameArena* Arena() const {
+		return arena;
+	}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const {
+		return arena == other.Arena();
+	}
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const {
+		return arena != other.Arena();
+	}
+
+private:
+	FrameArena* arena = nullptr;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,62 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Context.hpp"
+#include "CaptureFile.hpp"
+
+//? Captures one frame's render passes into a CaptureFile, for tools/replay to run again.
+//? A frame only uses objects created long before it, so once enabled every object the draw
+//? paths could use is registered as it's created, with what's needed to create it again.
+//? Commands are only recorded during the captured frame, through the Cmd wrappers the draw
+//? paths call instead of vkCmd*. Compute work isn't recorded, its results are in the buffer
+//? contents, read back once the frame has finished.
+//? Everything is static, like AllocationCounter: secondaries get recorded where nothing but
+//? the command buffer is at hand. Registration is off, and the wrappers only forward, until Enable.
+class FrameCapture {
+public:
+	//? Right after the device is created, so nothing is missed. Buffers and images get
+	//? TRANSFER_SRC from then on (see Context), their contents are copied out of them
+	static void Enable();
+	static bool Enabled();
+
+	//? Records primary and the secondaries it executes, until End
+	static void Begin(VkCommandBuffer primary, uint64 frame);
+	static void End();
+	//? Call once the frame has finished, with nothing else in flight
+	static void Save(const Context& context, const std::string& path);
+	static void PrintStats();
+
+	static void AddBuffer(VkBuffer buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+	static void AddImage(VkImage image, VkExtent2D extent, uint mipLevels, VkFormat format, VkImageUsageFlags usage);
+	static void AddImageView(VkImageView view, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint mipLevels);
+	static void RemoveBuffer(VkBuffer buffer);
+	static void RemoveImage(VkImage image);
+	static void AddShaderModule(VkShaderModule module, const std::string& code);
+	static void AddSampler(VkSampler sampler, const VkSamplerCreateInfo& info);
+	static void AddSetLayout(VkDescriptorSetLayout layout, const VkDescriptorSetLayoutCreateInfo& info);
+	static void AddPipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo& info);
+	static void AddRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo& info);
+	static void AddFramebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo& info);
+	static void AddGraphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo& info);
+	//? A newly allocated set, whatever was written to a set with the same handle is dropped
+	static void AddDescriptorSet(VkDescriptorSet set, VkDescriptorSetLayout layout);
+	static void UpdateDescriptorSets(uint writeCount, const VkWriteDescriptorSet* writes);
+
+	//? Secondaries only, right after vkBeginCommandBuffer. Forgets what was recorded into it before
+	static void BeginSecondary(VkCommandBuffer commandBuffer);
+	static void CmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* beginInfo, VkSubpassContents contents);
+	static void CmdEndRenderPass(VkCommandBuffer commandBuffer);
+	static void CmdExecuteCommands(VkCommandBuffer commandBuffer, uint count, const VkCommandBuffer* secondaries);
+	static void CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+	static void CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint firstSet, uint setCount, const VkDescriptorSet* sets, uint dynamicOffsetCount, const uint* dynamicOffsets);
+	static void CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint firstBinding, uint bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+	static void CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	static void CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stages, uint offset, uint size, const void* values);
+	static void CmdSetViewport(VkCommandBuffer commandBuffer, uint firstViewport, uint viewportCount, const VkViewport* viewports);
+	static void CmdSetScissor(VkCommandBuffer commandBuffer, uint firstScissor, uint scissorCount, const VkRect2D* scissors);
+	static void CmdDraw(VkCommandBuffer commandBuffer, uint vertexCount, uint instanceCount, uint firstVertex, uint firstInstance);
+	static void CmdDrawIndexed(VkCommandBuffer commandBuffer, uint indexCount, uint instanceCount, uint firstIndex, int32 vertexOffset, uint firstInstance);
+	static void CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint drawCount, uint stride);
+	//? Takes the function pointer, the extension's entry point has to be loaded by the caller
+	static void CmdDrawIndexedIndirectCount(PFN_vkCmdDrawIndexedIndirectCountKHR function, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint maxDrawCount, uint stride);
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "ThreadPool.hpp"
+
+//? Offline export: every finished frame is copied into a ring of host-visible
+//? readback buffers and encoded to disk by worker threads while the GPU
+//? keeps rendering later frames.
+class FrameExporter {
+public:
+	void Init(const Context& context, VkExtent2D extent, VkFormat format);
+	void CleanUp();
+
+	//? Hands the slots whose copies have finished over to the encoders.
+	//? Must be called after waiting on a frame fence and before resetting it.
+	void Collect();
+	//? Returns a free ring slot, stalling until one retires if all are busy
+	uint AcquireSlot();
+	//? Expects the image in PRESENT_SRC_KHR layout and leaves it there. The copy waits on
+	//? writerStage and writerAccess, whatever wrote the image last
+	void RecordCopy(VkCommandBuffer commandBuffer, VkImage image, uint slot, VkPipelineStageFlags writerStage, VkAccessFlags writerAccess);
+	void Submitted(uint slot, VkFence fence);
+	//? Time the frame loop spent blocked on the GPU, used to find the bottleneck
+	void AddGpuWait(double seconds);
+
+	void Flush();
+	uint FramesSubmitted() const;
+	void PrintStats();
+
+private:
+	enum class SlotState {
+		Free,
+		Recorded,
+		Copying,
+		Encoding,
+	};
+
+	struct Slot {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		VkFence fence = VK_NULL_HANDLE;
+		uint frameNumber = 0;
+		SlotState state = SlotState::Free;
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	Context context;
+	VkExtent2D extent;
+	VkFormat format;
+	VkDeviceSize frameSize = 0;
+	bool memoryCoherent = false;
+	bool swizzleBgr = false;
+	std::vector<Slot> slots;
+	std::unique_ptr<ThreadPool> encoders;
+	std::mutex mutex;
+	std::condition_variable slotFreed;
+	uint nextSlot = 0;
+	uint nextFrameNumber = 0;
+	std::atomic<uint> framesExported {0};
+
+	Clock::time_point startTime;
+	double gpuWaitSeconds = 0.0;
+	double copyStallSeconds = 0.0;
+	double encodeStallSeconds = 0.0;
+	double encodeSeconds = 0.0;
+
+	void CollectLocked();
+	void Encode(uint slotIndex);
+	std::string FramePath(uint frameNumber) const;
+};
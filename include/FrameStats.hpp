@@ -0,0 +1,19 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+
+//? Command counters for one frame, bumped by whoever records the command
+struct FrameStats {
+	uint pipelineBinds = 0;
+	uint descriptorSetBinds = 0;
+	uint vertexBufferBinds = 0;
+	uint draws = 0;
+
+	FrameStats& operator+=(const FrameStats& other) {
+		pipelineBinds += other.pipelineBinds;
+		descriptorSetBinds += other.descriptorSetBinds;
+		vertexBufferBinds += other.vertexBufferBinds;
+		draws += other.draws;
+		return *this;
+	}
+};
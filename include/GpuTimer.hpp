@@ -0,0 +1,51 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+
+//? Timestamp query scopes, one query range per frame in flight.
+//? Scopes are registered up front so the frame loop never allocates.
+class GpuTimer {
+public:
+	void Init(const Context& context, uint queueFamily, uint maxScopes);
+	void CleanUp();
+
+	uint AddScope(const std::string& name);
+	//? False when the queue family doesn't support timestamps
+	bool Enabled() const;
+
+	//? Reads back the queries recorded the last time this frame slot was used, call after its fence
+	void Resolve(uint frameIndex);
+	//? Must be recorded outside of a render pass before any Begin/End of the frame
+	void Reset(VkCommandBuffer commandBuffer, uint frameIndex);
+	void Begin(VkCommandBuffer commandBuffer, uint frameIndex, uint scope);
+	void End(VkCommandBuffer commandBuffer, uint frameIndex, uint scope);
+
+	uint ScopeCount() const;
+	const std::string& Name(uint scope) const;
+	bool Valid(uint scope) const;
+	double Milliseconds(uint scope) const;
+	//? Absolute device timeline, comparable between timers of the same device
+	double StartMilliseconds(uint scope) const;
+	double EndMilliseconds(uint scope) const;
+
+private:
+	struct Result {
+		double startMs = 0.0;
+		double endMs = 0.0;
+		bool valid = false;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	uint maxScopes = 0;
+	double timestampPeriod = 1.0;
+	uint64 timestampMask = ~0ull;
+	std::vector<std::string> names;
+	std::vector<Result> results;
+	//? written[frameIndex * maxScopes + scope]
+	std::vector<bool> written;
+
+	uint QueryIndex(uint frameIndex, uint scope) const;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "GpuTimer.hpp"
+#include "ShaderReloader.hpp"
+
+//? Performance overlay: a CPU and GPU frame time graph and lines of text, drawn into the swap
+//? chain image after everything else. Glyphs are 5x7 bitmaps carried by the vertices, so text,
+//? graph bars and the backdrop are all quads from one host visible vertex buffer per frame slot,
+//? drawn with one pipeline and one draw. Building a frame allocates nothing.
+class Hud {
+public:
+	void Init(const Context& context, VkFormat format, const std::vector<VkImageView>& imageViews, VkExtent2D extent);
+	void CleanUp();
+
+	//? Call after the frame slot's fence, before any Line. Times go into the graph, a negative
+	//? gpuMs when the frame wasn't timed
+	void BeginFrame(uint frameIndex, double cpuMs, double gpuMs);
+	//? One line of text below the last, printf style, cut at Settings::hudColumns
+	void Line(const char* format, ...);
+	//? A line for every scope of the timer with a result
+	void Timings(const GpuTimer& timer);
+	//? Outside of a render pass, after everything else that touches the image. The image has to be
+	//? in PRESENT_SRC_KHR and is left there
+	void Record(VkCommandBuffer commandBuffer, uint imageIndex);
+	//? Its one pipeline, for hot reload
+	void RegisterShaders(ShaderReloader& reloader);
+
+	void PrintStats();
+
+	//? Public so the bench can build the same vertex layout
+	struct Vertex {
+		//? Pixels from the top left of the image
+		glm::vec2 position;
+		//? Glyph texel coordinates, 5x7 across a quad
+		glm::vec2 cell;
+		//? Columns 0 to 3 a byte each, then column 4, bit 0 is the top row
+		uint32 glyph[2];
+		//? RGBA8
+		uint32 color;
+	};
+
+private:
+	struct FrameBuffer {
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		Vertex* vertices;
+	};
+
+	Context context;
+	VkExtent2D extent;
+	VkRenderPass renderPass;
+	std::vector<VkFramebuffer> framebuffers;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+	std::vector<FrameBuffer> frameBuffers;
+
+	uint currentFrame = 0;
+	uint quads = 0;
+	float cursorY = 0.0f;
+	float panelWidth = 0.0f;
+	//? Ring of the last hudGraphFrames frames, negative GPU times weren't measured
+	std::vector<float> cpuHistory;
+	std::vector<float> gpuHistory;
+	uint historyHead = 0;
+	uint historyCount = 0;
+
+	uint64 frames = 0;
+	uint64 totalQuads = 0;
+	uint peakQuads = 0;
+	uint64 droppedQuads = 0;
+
+	void CreateRenderPass(VkFormat format);
+	void CreateFramebuffers(const std::vector<VkImageView>& imageViews);
+	void CreatePipeline();
+	VkPipeline BuildPipeline() const;
+	void CreateBuffers();
+	void Quad(float x, float y, float width, float height, const uint32 glyph[2], uint32 color);
+	void Rectangle(float x, float y, float width, float height, uint32 color);
+	void Text(float x, float y, const char* text, uint32 color);
+	void Graph();
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+
+//? Accounts every device memory allocation made through Context, per heap and
+//? per memory type. Heap budgets come from VK_EXT_memory_budget when it's
+//? enabled, otherwise they're estimated from the heap sizes. When an
+//? allocation would go over budget, registered pressure handlers are asked
+//? to release memory first, lowest priority first.
+class MemoryTracker {
+public:
+	struct HeapStats {
+		VkDeviceSize size = 0;
+		VkDeviceSize budget = 0;
+		//? Whole process usage as reported by the driver, or our own total without the extension
+		VkDeviceSize usage = 0;
+		VkDeviceSize allocated = 0;
+		VkDeviceSize peakAllocated = 0;
+		uint allocations = 0;
+		bool deviceLocal = false;
+	};
+
+	struct TypeStats {
+		uint heap = 0;
+		VkMemoryPropertyFlags flags = 0;
+		VkDeviceSize allocated = 0;
+		//? What the resources asked for, the rest is alignment and size rounding
+		VkDeviceSize requested = 0;
+		uint allocations = 0;
+	};
+
+	//? Returns how many bytes it released, needed is what the allocation is short of
+	using PressureHandler = std::function<VkDeviceSize(uint heap, VkDeviceSize needed)>;
+
+	void Init(VkPhysicalDevice physicalDevice, bool budgetExtension);
+
+	//? vkAllocateMemory with accounting, making room through the pressure handlers when needed
+	VkResult Allocate(VkDevice device, const VkMemoryAllocateInfo& allocInfo, VkDeviceSize requested, const std::string& tag, VkDeviceMemory& memory);
+	void Free(VkDevice device, VkDeviceMemory memory);
+
+	//? Lower priorities are asked first. Returns an id for RemovePressureHandler
+	uint AddPressureHandler(uint priority, PressureHandler handler);
+	void RemovePressureHandler(uint id);
+	//? Fixed at Init, safe to call from pressure handlers
+	bool DeviceLocal(uint heap) const;
+
+	std::vector<HeapStats> HeapStatistics();
+	//? Same, but reuses the caller's storage for per frame checks
+	void HeapStatistics(std::vector<HeapStats>& stats);
+	std::vector<TypeStats> TypeStatistics();
+	//? Share of allocated bytes not asked for by any resource: alignment and size rounding.
+	//? Every resource has its own allocation, so there's no free space left to fragment
+	double PaddingOverhead();
+	uint AllocationCount();
+
+	void PrintStats();
+	//? Lists every allocation that is still alive, call right before destroying the device
+	uint ReportLeaks();
+
+private:
+	struct Allocation {
+		VkDeviceSize size;
+		VkDeviceSize requested;
+		uint type;
+		std::string tag;
+	};
+
+	struct Handler {
+		uint id;
+		uint priority;
+		PressureHandler release;
+	};
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	bool budgetExtension = false;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	uint maxAllocations = 0;
+
+	std::mutex mutex;
+	std::vector<HeapStats> heaps;
+	std::vector<TypeStats> types;
+	std::unordered_map<VkDeviceMemory, Allocation> allocations;
+	std::vector<Handler> handlers;
+	uint nextHandlerId = 0;
+
+	uint pressureEvents = 0;
+	VkDeviceSize pressureReleased = 0;
+	uint failedAllocations = 0;
+
+	//? Refreshes budget and usage, expects the mutex to be held
+	void QueryBudgetLocked();
+	bool OverBudget(uint heap, VkDeviceSize size);
+	void RelievePressure(uint heap, VkDeviceSize needed);
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "MeshSimplifier.hpp"
+
+//? Meshes converted ahead of time by tools/meshconv, laid out so that loading is mapping the file.
+//? A fixed Header, then one section per list, each starting on a sectionAlignment boundary and
+//? stored the way the GPU and MeshLibrary use it: vertices are MeshVertex, indices are uint.
+//? Nothing is parsed, the section accessors are pointers into the mapping. Little endian only.
+class MeshFile {
+public:
+	static constexpr uint magic = 0x48534d56;
+	static constexpr uint version = 1;
+	//? Enough for any cache line, and for copying a section out with aligned loads
+	static constexpr uint64 sectionAlignment = 64;
+
+	struct Section {
+		uint64 offset;
+		uint64 size;
+	};
+
+	struct Header {
+		uint magic;
+		uint version;
+		//? Checked against the build reading the file, a changed vertex layout needs a new conversion
+		uint vertexStride;
+		uint indexSize;
+		Section vertices;
+		Section indices;
+		Section meshes;
+		Section lods;
+		Section meshlets;
+		//? Every name one after the other, without terminators
+		Section names;
+	};
+
+	struct Lod {
+		//? Into the index section
+		uint indexOffset;
+		uint indexCount;
+		//? Largest deviation from the full detail mesh, in object space units
+		float error;
+	};
+
+	//? Up to maxMeshletVertices vertices and maxMeshletTriangles triangles of a mesh's finest level,
+	//? bounded by a sphere to cull them one by one
+	struct Meshlet {
+		//? Relative to the finest level's first index
+		uint indexOffset;
+		uint triangleCount;
+		uint vertexCount;
+		float radius;
+		glm::vec3 center;
+	};
+
+	//? Ranges of the other sections
+	struct Mesh {
+		uint vertexOffset;
+		uint vertexCount;
+		uint lodOffset;
+		uint lodCount;
+		uint meshletOffset;
+		uint meshletCount;
+		uint nameOffset;
+		uint nameLength;
+		glm::vec3 center;
+		float radius;
+	};
+
+	static constexpr uint maxMeshletVertices = 64;
+	static constexpr uint maxMeshletTriangles = 124;
+
+	static void Write(const std::string& path, const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, const std::vector<Mesh>& meshes, const std::vector<Lod>& lods, const std::vector<Meshlet>& meshlets, const std::string& names);
+
+	//? Maps the file read only and checks that every range stays inside its section,
+	//? every meshlet inside its finest level and every index inside its mesh
+	void Open(const std::string& path);
+	void Close();
+
+	uint64 Bytes() const;
+	uint VertexCount() const;
+	uint IndexCount() const;
+	uint MeshCount() const;
+	const MeshVertex* Vertices() const;
+	const uint* Indices() const;
+	const Mesh* Meshes() const;
+	const Lod* Lods() const;
+	const Meshlet* Meshlets() const;
+	std::string Name(const Mesh& mesh) const;
+
+private:
+	const char* data = nullptr;
+	uint64 size = 0;
+
+	const Header& GetHeader() const;
+	const void* GetSection(const Section& section) const;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "MeshSimplifier.hpp"
+
+//? Text and interchange formats, read by tools/meshconv to write a MeshFile, and by
+//? MeshLibrary::Benchmark to measure what reading them at startup would cost.
+//? Positions and normals only, that's all MeshVertex holds. Faces are triangulated as fans,
+//? normals are computed from the faces when the source has none.
+class MeshImport {
+public:
+	struct Mesh {
+		std::string name;
+		std::vector<MeshVertex> vertices;
+		std::vector<uint> indices;
+	};
+
+	//? Picks the format from the extension: .obj, .gltf or .glb
+	static std::vector<Mesh> Load(const std::string& path);
+	//? One mesh per object (o), or a single one named after the file
+	static std::vector<Mesh> LoadObj(const std::string& path);
+	//? glTF 2.0, one mesh per mesh with its triangle primitives merged. Buffers can be next to
+	//? the file, base64 data URIs or a .glb's binary chunk. Node transforms aren't applied
+	static std::vector<Mesh> LoadGltf(const std::string& path);
+
+	//? Area weighted vertex normals
+	static void ComputeNormals(std::vector<MeshVertex>& vertices, const std::vector<uint>& indices);
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Context.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshFile.hpp"
+
+//? Every mesh and each of its levels of detail share one vertex buffer and one
+//? index buffer. A level is just a range of the index buffer over the mesh's
+//? vertices, so switching levels never rebinds anything.
+class MeshLibrary {
+public:
+	//? The same as on disk, so a file's sections are copied over as they are
+	using Lod = MeshFile::Lod;
+	using Meshlet = MeshFile::Meshlet;
+
+	struct Mesh {
+		int32 vertexOffset;
+		uint vertexCount;
+		//? Finest first, errors only grow along the chain
+		std::vector<Lod> lods;
+		//? Over the finest level, see Meshlets
+		uint meshletOffset;
+		uint meshletCount;
+		glm::vec3 center;
+		float radius;
+	};
+
+	void Init(const Context& context);
+	void CleanUp();
+
+	//? Builds up to maxLods levels, halving the triangle count each time and
+	//? stopping early once the simplifier can't make progress
+	uint Add(const std::string& name, const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, uint maxLods);
+	//? Maps a MeshFile and adds its meshes as they are, levels and meshlets were built when it
+	//? was converted. The mapping is kept until Upload copies it. Returns the first mesh's index
+	uint Load(const std::string& path);
+	//? Writes every mesh built with Add as a MeshFile, see tools/meshconv
+	void Save(const std::string& path) const;
+	//? Copies everything added so far to device local buffers through one staging buffer, call
+	//? once after the last Add or Load. Meshes built with Add come first, then each file's
+	void Upload();
+
+	const Mesh& Get(uint mesh) const;
+	uint Count() const;
+	VkBuffer VertexBuffer() const;
+	VkBuffer IndexBuffer() const;
+	//? Not drawn yet, kept for culling at a finer grain than whole meshes
+	const std::vector<Meshlet>& Meshlets() const;
+
+	void PrintStats();
+
+	//? Reads a text or glTF source the way startup would without the container, then the
+	//? container converted from it, reporting time and peak resident memory for both
+	static void Benchmark(const std::string& sourcePath);
+
+private:
+	struct Source {
+		MeshFile file;
+		uint firstMesh;
+	};
+
+	Context context;
+	std::vector<Mesh> meshes;
+	std::vector<std::string> names;
+	std::vector<MeshVertex> vertices;
+	std::vector<uint> indices;
+	std::vector<Meshlet> meshlets;
+	//? Mapped until Upload, their meshes' offsets are relative to the file until then
+	std::vector<Source> files;
+	uint64 fileVertices = 0;
+	uint64 fileIndices = 0;
+	uint64 fileBytes = 0;
+	double buildSeconds = 0.0;
+	double loadSeconds = 0.0;
+
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+
+	VkDeviceSize VertexBytes() const;
+	VkDeviceSize IndexBytes() const;
+	//? Vertices then indices, as Upload lays them out in the buffers
+	void WriteStaging(char* destination) const;
+};
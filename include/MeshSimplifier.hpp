@@ -0,0 +1,44 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+
+struct MeshVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+};
+
+//? Quadric error metric simplification (Garland & Heckbert) by edge collapse.
+//? Vertices are only ever merged into one of their neighbours, never moved,
+//? so every level of detail indexes the original vertex array.
+class MeshSimplifier {
+public:
+	//? Returns a triangle list with at most targetIndexCount indices when the
+	//? mesh allows it. error receives the largest geometric deviation introduced,
+	//? in the units of the vertex positions.
+	static std::vector<uint> Simplify(const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, uint targetIndexCount, float& error);
+
+private:
+	//? Symmetric 4x4 matrix, upper triangle only
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		void AddPlane(const glm::dvec3& normal, double distance, double weight);
+		Quadric& operator+=(const Quadric& other);
+		double Evaluate(const glm::dvec3& point) const;
+	};
+
+	struct Collapse {
+		double cost;
+		uint from;
+		uint to;
+		uint fromVersion;
+		uint toVersion;
+
+		bool operator<(const Collapse& other) const {
+			return cost > other.cost;
+		}
+	};
+};
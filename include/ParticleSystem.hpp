@@ -0,0 +1,85 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "GpuTimer.hpp"
+#include "Descriptors.hpp"
+#include "FrameStats.hpp"
+#include "ShaderReloader.hpp"
+
+//? GPU particle simulation on the compute queue (a dedicated async family when
+//? the device has one). State is stored as separate position and velocity
+//? streams, double buffered: each step reads one copy and writes the other,
+//? and the graphics pass draws the copy written last.
+class ParticleSystem {
+public:
+	void Init(const Context& context, DescriptorLayoutCache& layoutCache, VkRenderPass renderPass, uint particleCount);
+	void CleanUp();
+
+	//? Reads back the timings of the frame slot, call after its fence
+	void Resolve(uint frameIndex);
+	//? Adds how much of the last resolved step ran alongside the given graphics work
+	void AddOverlap(double graphicsStartMs, double graphicsEndMs);
+
+	//? Records and submits one step, which signals SimulationFinished(frameIndex)
+	void Simulate(uint frameIndex, float deltaTime);
+	VkSemaphore SimulationFinished(uint frameIndex) const;
+	//? Draws the latest state, inside the render pass after waiting on SimulationFinished
+	void Draw(VkCommandBuffer commandBuffer, FrameStats& stats);
+
+	//? Simulation step timings
+	const GpuTimer& Timer() const;
+	//? The simulation and draw pipelines, for hot reload
+	void RegisterShaders(ShaderReloader& reloader);
+
+	void PrintStats();
+
+private:
+	struct Parameters {
+		float deltaTime;
+		float time;
+		uint count;
+		uint padding;
+	};
+
+	Context context;
+	uint particleCount = 0;
+	uint workgroupSize = 64;
+	uint current = 0;
+	float time = 0.0f;
+
+	std::array<VkBuffer, 2> positionBuffers;
+	std::array<VkDeviceMemory, 2> positionMemory;
+	std::array<VkBuffer, 2> velocityBuffers;
+	std::array<VkDeviceMemory, 2> velocityMemory;
+
+	VkRenderPass renderPass;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorPool descriptorPool;
+	//? descriptorSets[i] reads state i and writes state 1 - i
+	std::array<VkDescriptorSet, 2> descriptorSets;
+	VkPipelineLayout computeLayout;
+	VkPipeline computePipeline;
+	VkPipelineLayout renderLayout;
+	VkPipeline renderPipeline;
+
+	VkCommandPool commandPool;
+	std::vector<VkCommandBuffer> commandBuffers;
+	std::vector<VkSemaphore> simulationFinished;
+
+	GpuTimer timer;
+	uint simulateScope = 0;
+	uint resolvedSteps = 0;
+	double simulationMs = 0.0;
+	double overlapMs = 0.0;
+
+	void CreateBuffers();
+	void CreateDescriptors(DescriptorLayoutCache& layoutCache);
+	void CreateComputePipeline();
+	void CreateRenderPipeline(VkRenderPass renderPass);
+	VkPipeline BuildComputePipeline() const;
+	VkPipeline BuildRenderPipeline() const;
+	void CreateCommandObjects();
+	uint ChooseWorkgroupSize();
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "Descriptors.hpp"
+#include "GpuTimer.hpp"
+#include "ShaderReloader.hpp"
+
+//? Bloom, auto exposure, tonemapping, color grading and sharpening as three kinds of compute dispatch.
+//? The first bloom downsample also prefilters and sums the frame's log luminance, reduced per subgroup
+//? and then per workgroup before one atomic per group. Upsampling adds each level into the one above.
+//? The composite does everything per pixel in one go: exposure, bloom, tonemap, grade, then sharpens
+//? from a shared memory tile of its own graded results, so no intermediate image is written.
+//? Everything runs over the top left extent of targets sized for the largest frame.
+class PostProcess {
+public:
+	//? The scene target's format with post-processing, it's sampled and stays linear
+	static const VkFormat sceneFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	//? Subgroup arithmetic in compute shaders, so Vulkan 1.1 at least
+	static bool Supported(const Context& context);
+
+	void Init(const Context& context, DescriptorLayoutCache& layoutCache, VkImage sceneImage, VkImageView sceneView, VkExtent2D maxExtent);
+	void CleanUp();
+
+	//? Reads back the timings recorded the last time this frame slot was used, call after its fence
+	void Resolve(uint frameIndex);
+	//? The scene has to be in COLOR_ATTACHMENT_OPTIMAL, it's left in SHADER_READ_ONLY_OPTIMAL.
+	//? Output is left in GENERAL, making the composite's writes visible is up to the caller
+	void Record(VkCommandBuffer commandBuffer, uint frameIndex, VkExtent2D extent, float deltaTime);
+	//? Linear, as large as maxExtent
+	VkImage Output() const;
+
+	//? Per pass timings, read after Resolve
+	const GpuTimer& Timer() const;
+	//? The three compute pipelines, for hot reload
+	void RegisterShaders(ShaderReloader& reloader);
+
+	void PrintStats();
+
+private:
+	//? Shared by every dispatch, each reads what it needs
+	struct PassConstants {
+		//? One over the sampled image's full size, and the largest coordinate inside its used extent
+		glm::vec2 sourceTexel;
+		glm::vec2 sourceMax;
+		glm::vec2 bloomTexel;
+		glm::vec2 bloomMax;
+		glm::ivec2 destinationSize;
+		float deltaTime;
+		//? Downsample: 1 on the first level. Composite: which exposure slot this frame writes
+		uint mode;
+	};
+
+	//? Estimated bytes read and written per frame, every texel of every image touched once
+	struct Traffic {
+		double down = 0.0;
+		double up = 0.0;
+		double composite = 0.0;
+		//? The same effects as separate full screen passes, each with its own full size intermediate
+		double naive = 0.0;
+	};
+
+	enum Scope {
+		DownScope,
+		UpScope,
+		CompositeScope,
+		ScopeCount,
+	};
+
+	Context context;
+	VkImage sceneImage;
+	VkExtent2D maxExtent;
+	uint levels = 0;
+
+	VkImage bloomImage;
+	VkDeviceMemory bloomMemory;
+	std::vector<VkImageView> bloomViews;
+	VkImage outputImage;
+	VkDeviceMemory outputMemory;
+	VkImageView outputView;
+	VkSampler sampler;
+	//? Log luminance sum and sample count, then the adapted luminance of the last two frames
+	VkBuffer exposureBuffer;
+	VkDeviceMemory exposureMemory;
+
+	DescriptorAllocator descriptorAllocator;
+	VkDescriptorSetLayout setLayout;
+	//? downSets[i] writes level i from level i - 1, the scene for 0. upSets[i] adds level i + 1 into level i
+	std::vector<VkDescriptorSet> downSets;
+	std::vector<VkDescriptorSet> upSets;
+	VkDescriptorSet compositeSet;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline downPipeline;
+	VkPipeline upPipeline;
+	VkPipeline compositePipeline;
+
+	GpuTimer timer;
+	std::array<uint, ScopeCount> scopes {};
+	uint64 recordedFrames = 0;
+	uint64 timedFrames = 0;
+	std::array<double, ScopeCount> totalMs {};
+	Traffic totalTraffic;
+	Traffic timedTraffic;
+	std::vector<Traffic> frameTraffic;
+
+	void CreateImages();
+	void CreateDescriptors(DescriptorLayoutCache& layoutCache, VkImageView sceneView);
+	void CreatePipelines();
+	VkPipeline BuildDownPipeline() const;
+	VkPipeline BuildUpPipeline() const;
+	VkPipeline BuildCompositePipeline() const;
+	VkPipeline CreatePipeline(const std::string& path, const std::vector<float>& constants) const;
+	void WriteSet(VkDescriptorSet set, VkImageView source, VkImageView destination, bool sourceIsScene);
+	VkExtent2D LevelExtent(VkExtent2D extent, uint level) const;
+	Traffic Estimate(VkExtent2D extent) const;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+
+//? Picks the fraction of the swap chain size the frame renders at from its measured GPU time.
+//? GPU time is smoothed, and only a frame time over the target or well under it moves the
+//? scale. Between the two nothing happens, so a scale that just fits is kept.
+//? Lowering is proportional to the excess, assuming the time goes with the pixel count.
+//? Raising is one step at a time, after the frame has stayed under for a while. A raise that
+//? gets undone right away doubles the wait before the next one, which stops the scale from
+//? bouncing between two steps. Measurements are ignored for a few frames after every change,
+//? they were taken at the old scale.
+class ResolutionController {
+public:
+	void Init(float minScale, float maxScale, double targetMs);
+
+	//? GPU time of one finished frame. True when the scale changed, it's logged then
+	bool Update(double gpuMs);
+	float Scale() const;
+	//? full scaled and rounded, at least one pixel per side
+	VkExtent2D Extent(VkExtent2D full) const;
+
+	void PrintStats();
+
+private:
+	float minScale = 1.0f;
+	float maxScale = 1.0f;
+	double targetMs = 0.0;
+	float scale = 1.0f;
+	double smoothedMs = 0.0;
+	bool smoothed = false;
+	uint settleFrames = 0;
+	uint underFrames = 0;
+	uint raiseDelay = 0;
+	//? Frames since the last raise, for telling whether a drop undid it
+	uint64 sinceRaise = UINT64_MAX;
+
+	uint64 frames = 0;
+	uint64 framesOver = 0;
+	uint raises = 0;
+	uint drops = 0;
+	uint undoneRaises = 0;
+	double scaleSum = 0.0;
+	double gpuMsSum = 0.0;
+
+	void Change(float newScale, const char* reason);
+};
@@ -0,0 +1,256 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "Descriptors.hpp"
+#include "FrameStats.hpp"
+#include "MeshLibrary.hpp"
+#include "GpuTimer.hpp"
+#include "DepthPyramid.hpp"
+#include "DrawQueue.hpp"
+#include "EntityStore.hpp"
+#include "Bvh.hpp"
+#include "ShaderReloader.hpp"
+
+//? A grid of procedural meshes seen from an orbiting camera, kept in an
+//? EntityStore. Some of them spin, only their rows are uploaded again. Every frame each
+//? object picks the coarsest level of detail whose simplification error
+//? projects to at most Settings::lodPixelError pixels on screen.
+//? With GPU culling, a compute pass does the frustum test and level selection
+//? and writes compacted indirect draws, so recording costs the same for any
+//? number of objects. Otherwise the CPU finds the objects in the frustum with a
+//? Bvh over their bounds, refit as they spin, picks their levels and queues a
+//? draw per object, sorted front to back.
+//? With occlusion culling on top, the first phase also tests objects against
+//? last frame's depth pyramid. Once they are drawn the pyramid is rebuilt and a
+//? second phase draws whatever the first one hid but the new pyramid shows, so
+//? nothing pops in for a frame when it comes out from behind something.
+class Scene {
+public:
+	static bool UsesGpuCulling(const Context& context);
+	//? The frame has to split its render pass around RecordOcclusion when this is true
+	static bool UsesOcclusionCulling(const Context& context);
+
+	//? depthView is only read with occlusion culling, it has to be sampleable then
+	void Init(const Context& context, DescriptorLayoutCache& layoutCache, VkDescriptorSetLayout frameSetLayout, VkRenderPass renderPass, VkExtent2D extent, VkImageView depthView);
+	void CleanUp();
+
+	//? Part of the Init extent the frame renders to from now on, at its top left corner.
+	//? Levels of detail and the occlusion test follow it. Call before Update
+	void SetRenderExtent(VkExtent2D renderExtent);
+	//? Moves the camera and picks the levels of detail for the coming draw.
+	//? Call after the frame slot's fence, it reads back what the slot's last cull produced
+	void Update(uint frameIndex, float time);
+	glm::mat4 ViewProjection() const;
+	//? Outside the render pass, before Draw
+	void RecordCulling(VkCommandBuffer commandBuffer, uint frameIndex);
+	//? Inside the render pass, frameSet is the one the triangle pipeline uses.
+	//? The CPU path queues its draws in the frame slot's arena
+	void Draw(VkCommandBuffer commandBuffer, uint frameIndex, VkDescriptorSet frameSet, FrameArena& arena, FrameStats& stats);
+	//? Between the passes, with the depth buffer in SHADER_READ_ONLY_OPTIMAL. Builds the pyramid and runs the second phase
+	void RecordOcclusion(VkCommandBuffer commandBuffer, uint frameIndex);
+	//? Inside the second render pass, draws what the second phase found
+	void DrawLate(VkCommandBuffer commandBuffer, uint frameIndex, VkDescriptorSet frameSet, FrameStats& stats);
+	//? Outside the render pass once the scene's last draw is recorded
+	void EndFrame(VkCommandBuffer commandBuffer, uint frameIndex);
+	//? True when Draw records different commands every frame. Otherwise only the
+	//? buffers it reads change, so a recording can be reused for the same frame slot
+	bool DrawsChange() const;
+
+	//? Culling and depth pyramid timings
+	const GpuTimer& Timer() const;
+	//? Every pipeline the scene created, for hot reload
+	void RegisterShaders(ShaderReloader& reloader);
+
+	void PrintStats();
+
+private:
+	//? Matches the storage buffer in mesh.vert, instance index selects the object
+	struct ObjectData {
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	//? The std430 structs read by cull.comp
+	struct ObjectBounds {
+		//? World space center and radius
+		glm::vec4 sphere;
+		uint mesh;
+		float scale;
+		//? EntityStore::Flags
+		uint flags;
+		uint padding;
+	};
+
+	struct MeshInfo {
+		int32 vertexOffset;
+		uint firstLod;
+		uint lodCount;
+		uint padding;
+	};
+
+	struct LodInfo {
+		uint indexOffset;
+		uint indexCount;
+		float error;
+		uint padding;
+	};
+
+	static const uint maxLods = 8;
+
+	//? Zeroed before every cull, read back once the frame slot comes around again
+	struct CullCounts {
+		uint drawCount;
+		uint lateDrawCount;
+		uint triangles;
+		uint trianglesFull;
+		uint occluded;
+		uint frustumCulled;
+		uint padding[2];
+		uint lodDraws[maxLods];
+	};
+
+	//? The uniform buffer in cull.glsl, std140
+	struct CullData {
+		glm::mat4 view;
+		glm::vec4 planes[6];
+		//? xyz is the camera position, w the pixels per unit at distance one
+		glm::vec4 camera;
+		//? P00, P11 (positive), P22 and P32 of the projection
+		glm::vec4 projection;
+		float pixelError;
+		float nearPlane;
+		uint objectCount;
+		//? Zero when the first phase should skip the pyramid
+		uint occlusion;
+		glm::vec2 pyramidSize;
+		//? Fraction of the depth image the frame renders to
+		glm::vec2 viewportScale;
+	};
+
+	struct CullPhase {
+		uint late;
+	};
+
+	Context context;
+	VkExtent2D extent;
+	VkExtent2D renderExtent;
+	//? Last frame's pyramid was built at another size, the next first phase can't use it
+	bool renderExtentChanged = false;
+	MeshLibrary meshes;
+	EntityStore entities;
+	//? Per row, what the CPU path picked
+	std::vector<uint> lods;
+	std::vector<glm::vec4> materialColors;
+	std::vector<EntityStore::Entity> spinning;
+	float lastTime = 0.0f;
+	//? CPU path only, rows that spun this frame and rows in the frustum
+	Bvh bvh;
+	std::vector<uint> movedRows;
+	std::vector<uint> visibleRows;
+
+	glm::vec3 cameraPosition;
+	glm::mat4 view;
+	glm::mat4 projection;
+	float farPlane;
+	//? Screen pixels covered by one unit at distance one, vertically
+	float pixelsPerUnit;
+
+	VkBuffer objectBuffer;
+	VkDeviceMemory objectMemory;
+	//? Dirty rows packed by Update, object data first and bounds after room for every row
+	std::vector<VkBuffer> uploadBuffers;
+	std::vector<VkDeviceMemory> uploadMemory;
+	std::vector<void*> uploadMapped;
+	std::vector<EntityStore::Range> dirtyRanges;
+	std::vector<VkBufferCopy> objectCopies;
+	std::vector<VkBufferCopy> boundsCopies;
+	DescriptorAllocator descriptorAllocator;
+	VkDescriptorSetLayout objectSetLayout;
+	VkDescriptorSet objectSet;
+	VkRenderPass renderPass;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+	DrawQueue drawQueue;
+
+	bool gpuCulling = false;
+	bool occlusionCulling = false;
+	PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+	VkBuffer boundsBuffer;
+	VkDeviceMemory boundsMemory;
+	VkBuffer meshInfoBuffer;
+	VkDeviceMemory meshInfoMemory;
+	VkBuffer lodInfoBuffer;
+	VkDeviceMemory lodInfoMemory;
+	//? One of each per frame in flight, the GPU writes them during the frame
+	std::vector<VkBuffer> drawBuffers;
+	std::vector<VkDeviceMemory> drawMemory;
+	std::vector<VkBuffer> countBuffers;
+	std::vector<VkDeviceMemory> countMemory;
+	std::vector<void*> countMapped;
+	std::vector<bool> countsPending;
+	std::vector<VkBuffer> cullDataBuffers;
+	std::vector<VkDeviceMemory> cullDataMemory;
+	std::vector<void*> cullDataMapped;
+	VkDescriptorSetLayout cullSetLayout;
+	std::vector<VkDescriptorSet> cullSets;
+	VkPipelineLayout cullLayout;
+	VkPipeline cullPipeline;
+
+	//? Occlusion culling only, visibility is what the first phase drew
+	std::vector<VkBuffer> lateDrawBuffers;
+	std::vector<VkDeviceMemory> lateDrawMemory;
+	std::vector<VkBuffer> visibilityBuffers;
+	std::vector<VkDeviceMemory> visibilityMemory;
+	DepthPyramid pyramid;
+	GpuTimer gpuTimer;
+	uint sceneScope;
+	uint pyramidScope;
+	//? Whether the frame in each slot skipped the first phase's occlusion test
+	std::vector<bool> baselineFrames;
+
+	uint64 frames = 0;
+	uint64 trianglesDrawn = 0;
+	uint64 trianglesFull = 0;
+	uint64 objectsDrawn = 0;
+	std::vector<uint64> lodHistogram;
+	uint64 updates = 0;
+	uint64 rowsUploaded = 0;
+	uint64 rangesUploaded = 0;
+	double recordSeconds = 0.0;
+	double refitSeconds = 0.0;
+	double querySeconds = 0.0;
+	uint64 occlusionFrames = 0;
+	uint64 objectsOccluded = 0;
+	uint64 objectsFrustumCulled = 0;
+	uint64 lateDraws = 0;
+	//? GPU time of the whole scene, frames with the occlusion test and baseline frames without
+	double occlusionMs = 0.0;
+	uint64 occlusionTimed = 0;
+	double baselineMs = 0.0;
+	uint64 baselineTimed = 0;
+	double pyramidMs = 0.0;
+	uint64 pyramidTimed = 0;
+
+	void CreateMeshes();
+	void CreateObjects();
+	void CreateDescriptors(DescriptorLayoutCache& layoutCache);
+	void CreatePipeline(VkDescriptorSetLayout frameSetLayout, VkRenderPass renderPass);
+	VkPipeline BuildPipeline() const;
+	void CreateCulling(DescriptorLayoutCache& layoutCache, VkImageView depthView);
+	VkPipeline BuildCullPipeline() const;
+	//? GLSL source of the culling pass, the .spv sits next to it
+	std::string CullShader() const;
+	void ReadCullCounts(uint frameIndex);
+	void Spin(float deltaTime);
+	//? Into the frame slot's upload buffer, RecordUploads copies them over in the same frame
+	void PackUploads(uint frameIndex);
+	void RecordUploads(VkCommandBuffer commandBuffer, uint frameIndex);
+	ObjectData MakeObjectData(uint row) const;
+	ObjectBounds MakeBounds(uint row) const;
+	void DispatchCulling(VkCommandBuffer commandBuffer, uint frameIndex, uint late);
+	void BindDrawState(VkCommandBuffer commandBuffer, VkDescriptorSet frameSet, FrameStats& stats);
+	void RecordDraws(VkCommandBuffer commandBuffer, VkBuffer drawBuffer, VkBuffer countBuffer, VkDeviceSize countOffset, VkDescriptorSet frameSet, FrameStats& stats);
+	uint SelectLod(uint row) const;
+};
@@ -1,7 +1,14 @@
+#pragma once
 #include "System.hpp"
 #include "Types.hpp"
 #include <vulkan/vulkan.h>
 
+enum class ExportFormat {
+	Raw,
+	Ppm,
+	Png,
+};
+
 namespace Settings
 {
 	const int windowWidth = 1024;
@@ -16,11 +23,144 @@ namespace Settings
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 	};
 
+	//? Enabled when the device supports them, see Context::HasExtension
+	const std::vector<const char*> optionalDeviceExtensions = {
+		VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+		VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+		VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+	};
+
 	const uint maxFramesInFlight = 2;
 
+	//? Descriptor indexing table, only used when the device supports it
+	const bool useBindless = true;
+	const uint bindlessMaxBuffers = 4096;
+	const uint bindlessMaxImages = 4096;
+
+	//? KTX2 file for the triangle, a generated checkerboard is used when it's missing
+	const std::string triangleTexturePath = "textures/triangle.ktx2";
+	const VkDeviceSize textureBudget = 256ull << 20;
+	//? Texture uploads in flight at once, each slot keeps its staging buffer for the next one
+	const uint textureUploadSlots = 2;
+
+	//? Offline frame export, see FrameExporter
+	const bool exportFrames = false;
+	const uint exportFrameCount = 600;
+	const uint exportRingSize = 6;
+	const uint exportEncoderThreads = 3;
+	const ExportFormat exportFormat = ExportFormat::Ppm;
+	const std::string exportDirectory = "export/";
+
+	//? Compute particle simulation, see ParticleSystem
+	const bool simulateParticles = false;
+	const uint particleCount = 1 << 20;
+
+	//? Headless batch rendering instead of the window loop, see BatchRenderer
+	const bool batchRender = false;
+	const uint batchContexts = 8;
+	//? Upper bound, the graphics family may expose fewer queues
+	const uint batchMaxQueues = 4;
+	const uint batchJobs = 64;
+	const uint batchFramesPerJob = 120;
+	const uint batchInstances = 256;
+	const VkExtent2D batchExtent = { 1280, 720 };
+
+	//? Procedural mesh grid with levels of detail, see Scene
+	const bool renderScene = false;
+	const uint sceneObjects = 1024;
+	//? Objects turning in place, only their rows are uploaded again each frame
+	const uint sceneSpinningObjects = 64;
+	const uint lodLevels = 6;
+	//? Converted with tools/meshconv, their meshes join the procedural ones
+	const std::vector<std::string> sceneMeshFiles = {};
+	//? Each object draws the coarsest level whose error projects under this many pixels
+	const float lodPixelError = 1.0f;
+	//? Frustum culling and level selection in a compute pass feeding indirect draws.
+	//? Needs drawIndirectFirstInstance, the CPU path is used without it
+	const bool gpuCulling = true;
+	//? Two phase occlusion culling against a depth pyramid, on top of GPU culling
+	const bool occlusionCulling = true;
+	//? Every this many frames the first phase skips the occlusion test, to measure what it saves
+	const uint occlusionBaselineInterval = 16;
+	//? Draw packet sorting, see DrawQueue. Below the threshold one thread is faster than handing out chunks
+	const uint drawSortThreads = 4;
+	const uint drawSortParallelThreshold = 16384;
+	//? Runs EntityStore::Benchmark for each count instead of the window loop
+	const bool benchmarkEntities = false;
+	const std::vector<uint> entityBenchmarkCounts = { 100000, 300000, 1000000 };
+	const uint bvhBuildThreads = 4;
+	//? Subtrees with at least this many objects are built on another thread
+	const uint bvhParallelThreshold = 8192;
+	//? Runs Bvh::Benchmark for each count instead of the window loop
+	const bool benchmarkBvh = false;
+	const std::vector<uint> bvhBenchmarkCounts = { 10000, 100000, 1000000 };
+	//? Runs MeshLibrary::Benchmark for each source instead of the window loop: parsing the
+	//? text at startup against mapping the container converted from it, written next to the source
+	const bool benchmarkMeshLoading = false;
+	const std::vector<std::string> meshBenchmarkSources = { "meshes/benchmark.obj" };
+
+	//? Renders into an offscreen target at a fraction of the swap chain size picked from the
+	//? GPU frame time, then upscales it into the swap chain image. See ResolutionController.
+	//? Off while exporting frames, exports compare frames of the same size
+	const bool dynamicResolution = false;
+	//? The target is allocated at the swap chain size, so the scale can't go past 1
+	const float resolutionMinScale = 0.5f;
+	const float resolutionMaxScale = 1.0f;
+	const double resolutionTargetMs = 1000.0 / 60.0;
+
+	//? Bloom, auto exposure, tonemapping, grading and sharpening in compute after the scene, see
+	//? PostProcess. The scene renders into a half float target then. Needs subgroup arithmetic
+	const bool postProcess = false;
+	//? Bloom mips below half the frame size, fewer when the frame runs out of texels first
+	const uint bloomLevels = 5;
+	//? Scene luminance where bloom starts, with a soft knee below it
+	const float bloomThreshold = 1.0f;
+	const float bloomIntensity = 0.05f;
+	//? The frame's average luminance is exposed to this, adapting at this rate per second
+	const float exposureKey = 0.18f;
+	const float exposureAdaptRate = 1.5f;
+	const float sharpenAmount = 0.25f;
+	const float gradeSaturation = 1.1f;
+	const float gradeContrast = 1.05f;
+	const std::array<float, 3> gradeTint = { 1.02f, 1.0f, 0.97f };
+
+	//? Per frame bump allocators, see FrameArena. Grown on reset after a frame didn't fit
+	const size_t frameArenaSize = 1 << 20;
+	//? Frames the loop may allocate in before it counts as steady, see AllocationCounter
+	const uint allocationWarmupFrames = 16;
+	//? Throws from the first steady frame that allocates. Validation layers and some drivers
+	//? allocate through the same operator new, so it's only on while checking the frame loop
+	const bool assertNoFrameAllocations = false;
+
+	//? Writes one frame's render passes to capturePath, see FrameCapture. `make replay` builds
+	//? the tool that runs it again headless. The captured frame allocates, it doesn't count
+	const bool captureFrame = false;
+	const uint64 captureFrameNumber = 300;
+	const std::string capturePath = "capture.vkc";
+
+	//? Watches shaderDirectory and rebuilds the pipelines using whatever changed, see ShaderReloader.
+	//? The command is given the .spv to build, run from the working directory like ReadFile.
+	//? Off while capturing a frame, the capture registry is only safe on the main thread
+	const std::string shaderDirectory = "src/Shaders";
+	const std::string shaderCompileCommand = "make --no-print-directory -s -B";
+	const uint shaderPollMs = 250;
+
+	//? Frame time graph, pass timings, draw counts and memory over the top left corner, see Hud.
+	//? Drawn after a frame export copies the image, so exported frames never include it
+	const bool showHud = false;
+	//? Pixels per glyph texel
+	const uint hudScale = 2;
+	const uint hudColumns = 48;
+	const uint hudGraphFrames = 120;
+	//? Quads past this are dropped and counted, each is six vertices of 28 bytes
+	const uint hudMaxQuads = 4096;
+
 	#if DEBUG
 		const bool useValidationLayers = true;
+		const bool hotReloadShaders = true;
 	#else
 		const bool useValidationLayers = false;
+		const bool hotReloadShaders = false;
 	#endif
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+
+//? Shader hot reload. A watcher thread polls a directory of GLSL, compiles what changed with
+//? Settings::shaderCompileCommand and rebuilds every registered pipeline that uses it, all off the
+//? main thread. Update swaps finished pipelines in at the top of a frame and destroys the old ones
+//? once every frame that could have recorded them has passed its fence.
+//? A shader that fails to compile or link leaves the live pipeline alone.
+class ShaderReloader {
+public:
+	//? Creates a pipeline from the SPIR-V on disk. Runs on the watcher thread, so it may only touch
+	//? what the main thread doesn't change after startup
+	using Builder = std::function<VkPipeline()>;
+
+	void Init(const Context& context, const std::string& directory);
+	//? Stops the watcher and destroys retired pipelines, the registered ones stay with their owners
+	void CleanUp();
+
+	//? sources are GLSL paths as the compile command takes them, the .spv next to each is what build reads.
+	//? pipeline is overwritten by Update, it has to outlive the reloader
+	void Register(const std::string& name, const std::vector<std::string>& sources, VkPipeline& pipeline, Builder build);
+	//? Call after the frame slot's fence, before recording. True when a pipeline changed,
+	//? anything that recorded the old handle has to record again
+	bool Update(uint64 frameNumber);
+
+	void PrintStats();
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Watched {
+		std::string name;
+		std::vector<std::string> sources;
+		VkPipeline* pipeline;
+		Builder build;
+	};
+
+	struct Built {
+		uint watched;
+		VkPipeline pipeline;
+		Clock::time_point changed;
+	};
+
+	struct Retired {
+		VkPipeline pipeline;
+		uint64 frame;
+	};
+
+	Context context;
+	std::string directory;
+	std::thread watcher;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::vector<Watched> watched;
+	//? Finished on the watcher thread, waiting for the next Update
+	std::vector<Built> built;
+	//? Swapped with built under the lock, so Update doesn't allocate
+	std::vector<Built> swapping;
+	//? Fixed ring of registered pipelines times maxFramesInFlight, sized by Register
+	std::vector<Retired> retired;
+	uint retiredHead = 0;
+	uint retiredCount = 0;
+
+	//? Watcher thread only, read by PrintStats after it stopped
+	uint64 compiles = 0;
+	uint64 compileFailures = 0;
+	uint64 buildFailures = 0;
+	double compileSeconds = 0.0;
+	double buildSeconds = 0.0;
+	//? Main thread only
+	uint64 swaps = 0;
+	double changeToSwapSeconds = 0.0;
+	double longestUpdateMs = 0.0;
+
+	void WatchLoop();
+	//? Every shader source in the directory with its modification time
+	std::map<std::string, int64> Scan() const;
+	void Reload(const std::vector<std::string>& changed, Clock::time_point changedAt);
+	std::vector<std::string> Dependents(const std::string& include) const;
+};
@@ -1,3 +1,4 @@
+#pragma once
 #include <iostream>
 #include <vector>
 #include <string>
@@ -10,4 +11,17 @@
 #include <set>
 #include <algorithm>
 #include <fstream>
-#include <glm/glm.hpp>
\ No newline at end of file
+#include <sstream>
+#include <array>
+#include <memory>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+//? Vulkan clip space depth goes from 0 to 1
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
\ No newline at end of file
@@ -0,0 +1,189 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "Descriptors.hpp"
+
+//? Sampled 2D textures. Block compressed data is read from KTX2 files and
+//? uploaded as is, sources without a mip chain get theirs blitted on the GPU.
+//? Resident memory is kept under a budget by evicting the least recently
+//? used textures, which are reloaded from their source when used again.
+//? Under device memory pressure (see MemoryTracker) textures are evicted
+//? early, and files with a mip chain are loaded without their top levels.
+//? Sources are read and decoded on a loader thread, then copied through a
+//? ring of staging slots with a fence each. A texture shows the fallback
+//? until the fence of its upload signals, the frame loop never waits on one.
+class TextureManager {
+public:
+	void Init(const Context& context, VkDeviceSize budget, BindlessTable* bindless = nullptr);
+	void CleanUp();
+
+	//? Registers a KTX2 file (2D, one layer and face, no supercompression) and queues its load
+	uint Load(const std::string& path);
+	//? Registers tightly packed RGBA8 pixels, the CPU copy is kept around for reloading
+	uint Create(const std::string& name, std::vector<uint8> pixels, VkExtent2D extent, bool srgb = true);
+
+	//? Call once per frame after waiting on its fence, before any Use. Finishes the uploads whose
+	//? fence signaled and starts the ones whose source was read
+	void BeginFrame(uint64 frameNumber);
+	//? Marks the texture as used by the current frame, queueing a reload if it was evicted
+	void Use(uint texture);
+
+	bool Resident(uint texture) const;
+	//? A 1x1 white texture stands in while the texture isn't resident or is still uploading
+	VkImageView View(uint texture) const;
+	VkSampler Sampler() const;
+	//? Slot in the bindless image array, the fallback's until the texture is resident. A texture's
+	//? own slot is only rewritten while no frame in flight can be using it
+	uint BindlessIndex(uint texture) const;
+
+	VkDeviceSize ResidentBytes() const;
+	//? Evicts textures no frame in flight uses, then lowers the quality of later loads
+	VkDeviceSize Release(VkDeviceSize bytes);
+	void PrintStats();
+
+	struct FormatInfo {
+		uint blockBytes;
+		//? Pixels per block side, 1 for uncompressed formats
+		uint blockSize;
+	};
+
+	//? False for formats textures can't be read from, FrameCapture sizes its readbacks with these too
+	static bool GetFormatInfo(VkFormat format, FormatInfo& info);
+	static VkDeviceSize LevelSize(const FormatInfo& info, VkExtent2D extent, uint level);
+
+private:
+
+	struct Source {
+		VkFormat format;
+		VkExtent2D extent;
+		//? Level 0 first, each tightly packed
+		std::vector<std::string> levels;
+		bool generateMips = false;
+	};
+
+	struct Texture {
+		std::string name;
+		//? Empty for textures created from memory
+		std::string path;
+		//? Shared with load requests, the loader thread reads it
+		std::shared_ptr<const std::vector<uint8>> pixels;
+		VkExtent2D extent;
+		bool srgb = true;
+
+		VkImage image = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkImageView view = VK_NULL_HANDLE;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint mipLevels = 0;
+		VkDeviceSize bytes = 0;
+		//? Estimated size of the whole mip chain, 0 until the source was first read
+		VkDeviceSize footprint = 0;
+		//? What the same mip chain takes as RGBA8
+		VkDeviceSize uncompressedBytes = 0;
+		uint64 lastUsed = 0;
+		uint bindlessIndex = 0;
+		//? From the request until the upload's fence signals, the image can't be evicted meanwhile
+		bool loading = false;
+		//? The source couldn't be read or decoded, it isn't requested again
+		bool failed = false;
+	};
+
+	//? Copies of what the loader thread needs, it never touches textures
+	struct LoadRequest {
+		uint texture;
+		std::string path;
+		std::shared_ptr<const std::vector<uint8>> pixels;
+		VkExtent2D extent;
+		bool srgb;
+	};
+
+	struct Loaded {
+		uint texture;
+		Source source;
+		bool decoded = false;
+		//? Logged on the main thread, the texture keeps the fallback
+		std::string error;
+	};
+
+	struct UploadSlot {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		//? Persistently mapped, only grows
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+		VkDeviceSize stagingSize = 0;
+		uint8* mapped = nullptr;
+		uint texture = 0;
+		bool busy = false;
+	};
+
+	Context context;
+	VkDeviceSize budget = 0;
+	BindlessTable* bindless = nullptr;
+	VkSampler sampler = VK_NULL_HANDLE;
+	std::vector<Texture> textures;
+	uint64 currentFrame = 0;
+	//? Filled every frame while downgraded, kept so that doesn't allocate
+	std::vector<MemoryTracker::HeapStats> heapStats;
+
+	VkImage fallbackImage = VK_NULL_HANDLE;
+	VkDeviceMemory fallbackMemory = VK_NULL_HANDLE;
+	VkImageView fallbackView = VK_NULL_HANDLE;
+	uint fallbackBindlessIndex = 0;
+
+	std::thread loader;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	std::deque<LoadRequest> requests;
+	std::deque<Loaded> loaded;
+	//? Read and waiting for a free slot, main thread only
+	std::deque<Loaded> ready;
+	VkCommandPool uploadPool = VK_NULL_HANDLE;
+	std::vector<UploadSlot> uploadSlots;
+
+	VkDeviceSize residentBytes = 0;
+	VkDeviceSize peakResidentBytes = 0;
+	uint uploads = 0;
+	uint evictions = 0;
+	uint budgetMisses = 0;
+	uint loadFailures = 0;
+	uint gpuMipChains = 0;
+	uint cpuDecodes = 0;
+	//? Top mip levels skipped on load while memory is tight
+	uint downgradeLevels = 0;
+	uint downgradedLoads = 0;
+	uint pressureEvictions = 0;
+	uint pressureHandler = 0;
+
+	uint Register(Texture texture);
+	//? Queues the texture's source for the loader thread, unless it's known not to fit
+	void Request(uint texture);
+	void LoadLoop();
+	Loaded Read(const LoadRequest& request) const;
+	void StartUploads();
+	void StartUpload(UploadSlot& slot, Loaded& result);
+	void FinishUploads();
+	void Evict(uint texture);
+	bool MakeRoom(VkDeviceSize bytes, uint keep);
+	//? Least recently used texture that no frame in flight can still sample, or keep
+	uint EvictionCandidate(uint keep) const;
+
+	Source ReadKtx2(const std::string& path) const;
+	//? Sets decoded when the data had to be decoded on the CPU
+	Source PrepareSource(Source source, bool& decoded) const;
+	bool FormatSupported(VkFormat format, VkFormatFeatureFlags features) const;
+	//? Waits for the copy, only used for the fallback at startup
+	uint Upload(const Source& source, VkImage& image, VkDeviceMemory& memory);
+	//? Creates the image the source's mip chain goes into, returns its level count
+	uint CreateImage(const Source& source, VkImage& image, VkDeviceMemory& memory);
+	//? Where each level goes in a staging buffer, returns the size it needs
+	static VkDeviceSize StagingOffsets(const Source& source, std::vector<VkDeviceSize>& offsets);
+	//? Copies every level from the staging buffer and leaves the image in SHADER_READ_ONLY_OPTIMAL
+	void RecordUpload(VkCommandBuffer commandBuffer, const Source& source, VkImage image, uint mipLevels, VkBuffer stagingBuffer, const std::vector<VkDeviceSize>& offsets);
+	void GenerateMips(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint mipLevels);
+
+	static std::string DecodeBc(VkFormat format, const std::string& data, VkExtent2D extent);
+};
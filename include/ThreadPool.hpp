@@ -0,0 +1,30 @@
+#pragma once
+#include "System.hpp"
+#include "Types.hpp"
+
+//? Fixed set of worker threads fed from a FIFO of jobs. The FIFO is a ring that
+//? only grows, so a steady stream of jobs stops allocating once it's big enough.
+class ThreadPool {
+public:
+	explicit ThreadPool(uint threadCount);
+	~ThreadPool();
+
+	void Submit(std::function<void()> job);
+	//? Blocks until the queue is empty and no job is running
+	void Wait();
+	uint ThreadCount() const;
+	uint PendingJobs();
+
+private:
+	std::vector<std::thread> workers;
+	std::vector<std::function<void()>> jobs;
+	uint firstJob = 0;
+	uint jobCount = 0;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsDone;
+	uint activeJobs = 0;
+	bool stopping = false;
+
+	void WorkerLoop();
+};
@@ -1,3 +1,4 @@
+#pragma once
 #include "System.hpp"
 
 using uint8 = uint8_t;
@@ -0,0 +1,122 @@
+#include "AllocationCounter.hpp"
+#include <new>
+#include <cstdlib>
+
+namespace {
+	//? Plain values only, operator new can run before or after any constructor or destructor
+	thread_local uint64 threadAllocations = 0;
+	thread_local uint64 threadBytes = 0;
+	std::atomic<uint64> totalAllocations {0};
+
+	void* CountedAllocate(size_t size) {
+		threadAllocations++;
+		threadBytes += size;
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* CountedAllocate(size_t size, std::align_val_t alignment) {
+		threadAllocations++;
+		threadBytes += size;
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+		size_t align = std::max(size_t(alignment), sizeof(void*));
+		#if WINDOWS
+			return _aligned_malloc(size == 0 ? 1 : size, align);
+		#else
+			//? aligned_alloc wants the size to be a multiple of the alignment
+			return std::aligned_alloc(align, (std::max(size, size_t(1)) + align - 1) / align * align);
+		#endif
+	}
+
+	void AlignedFree(void* pointer) {
+		#if WINDOWS
+			_aligned_free(pointer);
+		#else
+			std::free(pointer);
+		#endif
+	}
+}
+
+uint64 AllocationCounter::ThreadAllocations() {
+	return threadAllocations;
+}
+
+uint64 AllocationCounter::ThreadBytes() {
+	return threadBytes;
+}
+
+uint64 AllocationCounter::TotalAllocations() {
+	return totalAllocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+	void* pointer = CountedAllocate(size);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return CountedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return CountedAllocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	void* pointer = CountedAllocate(size, alignment);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	AlignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	AlignedFree(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+	AlignedFree(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+	AlignedFree(pointer);
+}
@@ -0,0 +1,404 @@
+#include "BatchRenderer.hpp"
+
+void BatchRenderer::Init(const Context& context, uint contextCount, VkExtent2D extent) {
+	this->context = context;
+	this->extent = extent;
+
+	for (uint i = 0; i < context.graphicsQueueCount; i++) {
+		queues.push_back(std::make_unique<QueueSlot>());
+		vkGetDeviceQueue(context.device, context.graphicsFamily, i, &queues.back()->queue);
+	}
+
+	CreateRenderPass();
+	CreatePipeline();
+
+	for (uint i = 0; i < contextCount; i++) {
+		sceneContexts.push_back(std::make_unique<SceneContext>());
+		SceneContext& sceneContext = *sceneContexts.back();
+		//? Round robin, so contexts only share a queue once every queue has one
+		sceneContext.queue = queues[i % queues.size()].get();
+		CreateSceneContext(sceneContext);
+		idleContexts.push_back(&sceneContext);
+	}
+
+	workers = std::make_unique<ThreadPool>(contextCount);
+}
+
+void BatchRenderer::CleanUp() {
+	workers.reset();
+	for (auto& sceneContext : sceneContexts) {
+		DestroySceneContext(*sceneContext);
+	}
+	vkDestroyPipeline(context.device, pipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+	vkDestroyRenderPass(context.device, renderPass, nullptr);
+}
+
+void BatchRenderer::Submit(BatchJob job) {
+	{
+		std::lock_guard<std::mutex> lock(idleMutex);
+		if (!started) {
+			startTime = Clock::now();
+			started = true;
+		}
+	}
+
+	workers->Submit([this, job]() {
+		SceneContext* sceneContext;
+		{
+			std::lock_guard<std::mutex> lock(idleMutex);
+			sceneContext = idleContexts.back();
+			idleContexts.pop_back();
+		}
+
+		RenderJob(*sceneContext, job);
+
+		std::lock_guard<std::mutex> lock(idleMutex);
+		idleContexts.push_back(sceneContext);
+		jobsFinished++;
+		endTime = Clock::now();
+	});
+}
+
+void BatchRenderer::Wait() {
+	workers->Wait();
+}
+
+void BatchRenderer::PrintStats() {
+	std::lock_guard<std::mutex> lock(idleMutex);
+	double seconds = started ? std::chrono::duration<double>(endTime - startTime).count() : 0.0;
+	uint frames = 0;
+	for (auto& sceneContext : sceneContexts) {
+		frames += sceneContext->frames;
+	}
+
+	std::cout << "Batch renderer:\n";
+	std::cout << "\tContexts: " << sceneContexts.size() << " on " << queues.size() << " queue(s), " << extent.width << "x" << extent.height << "\n";
+	std::cout << "\tJobs: " << jobsFinished << ", frames: " << frames << " in " << seconds << " s";
+	if (seconds > 0.0) {
+		std::cout << " (" << jobsFinished / seconds << " jobs/s, " << frames / seconds << " frames/s)";
+	}
+	std::cout << "\n";
+	for (uint i = 0; i < queues.size(); i++) {
+		std::cout << "\tQueue " << i << ": " << queues[i]->submits << " submits\n";
+	}
+	for (uint i = 0; i < sceneContexts.size(); i++) {
+		const SceneContext& sceneContext = *sceneContexts[i];
+		std::cout << "\tContext " << i << ": " << sceneContext.jobs << " jobs, " << sceneContext.frames << " frames";
+		if (seconds > 0.0) {
+			std::cout << ", busy " << sceneContext.busySeconds / seconds * 100.0 << "%";
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::endl;
+}
+
+void BatchRenderer::RenderJob(SceneContext& sceneContext, const BatchJob& job) {
+	auto start = Clock::now();
+
+	for (uint frame = 0; frame < job.frames; frame++) {
+		uint slot = frame % 2;
+		//? The slot's previous frame has to be done before its pool is reset
+		vkWaitForFences(context.device, 1, &sceneContext.fences[slot], VK_TRUE, UINT64_MAX);
+		vkResetFences(context.device, 1, &sceneContext.fences[slot]);
+		vkResetCommandPool(context.device, sceneContext.commandPools[slot], 0);
+
+		VkCommandBuffer commandBuffer = sceneContext.commandBuffers[slot];
+		bool readback = frame + 1 == job.frames and job.onFinished;
+		RecordFrame(sceneContext, commandBuffer, job, frame, readback);
+
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		std::lock_guard<std::mutex> lock(sceneContext.queue->mutex);
+		if (vkQueueSubmit(sceneContext.queue->queue, 1, &submitInfo, sceneContext.fences[slot]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't submit a command buffer.");
+		}
+		sceneContext.queue->submits++;
+	}
+
+	vkWaitForFences(context.device, sceneContext.fences.size(), sceneContext.fences.data(), VK_TRUE, UINT64_MAX);
+	if (job.onFinished) {
+		job.onFinished(job, static_cast<const uint8*>(sceneContext.readbackMapped), extent);
+	}
+
+	sceneContext.jobs++;
+	sceneContext.frames += job.frames;
+	sceneContext.busySeconds += std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void BatchRenderer::RecordFrame(SceneContext& sceneContext, VkCommandBuffer commandBuffer, const BatchJob& job, uint frame, bool readback) {
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't begin recording a command buffer.");
+	}
+
+	VkRenderPassBeginInfo renderPassInfo {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = sceneContext.framebuffer;
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = extent;
+
+	VkClearValue clearColor = {0.f, 0.f, 0.f, 1.f};
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearColor;
+
+	Parameters parameters {};
+	parameters.time = frame / 60.0f;
+	parameters.scene = job.scene;
+	parameters.instances = job.instances;
+	parameters.aspect = float(extent.width) / float(extent.height);
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Parameters), &parameters);
+	vkCmdDraw(commandBuffer, 3, job.instances, 0, 0);
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (readback) {
+		//? The render pass leaves the image in TRANSFER_SRC_OPTIMAL
+		VkBufferImageCopy region {};
+		region.bufferOffset = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent.width, extent.height, 1 };
+		vkCmdCopyImageToBuffer(commandBuffer, sceneContext.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, sceneContext.readbackBuffer, 1, &region);
+
+		VkBufferMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = sceneContext.readbackBuffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Coudln't record a command buffer.");
+	}
+}
+
+void BatchRenderer::CreateRenderPass() {
+	VkAttachmentDescription colorAttachment {};
+	colorAttachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	VkAttachmentReference attachmentReference {};
+	attachmentReference.attachment = 0;
+	attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &attachmentReference;
+
+	//? Consecutive frames of a context draw into the same image, and the last one is copied out
+	std::array<VkSubpassDependency, 2> dependencies {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = dependencies.size();
+	renderPassInfo.pDependencies = dependencies.data();
+
+	if (vkCreateRenderPass(context.device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a render pass.");
+	}
+}
+
+void BatchRenderer::CreatePipeline() {
+	VkShaderModule vertModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/batch.vert.spv"));
+	VkShaderModule fragModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/batch.frag.spv"));
+
+	VkPipelineShaderStageCreateInfo shaderStages[2] {};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertModule;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragModule;
+	shaderStages[1].pName = "main";
+
+	//? Geometry is generated from the vertex and instance indices
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo {};
+	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+
+	VkViewport viewport {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = float(extent.width);
+	viewport.height = float(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor {};
+	scissor.offset = {0, 0};
+	scissor.extent = extent;
+
+	VkPipelineViewportStateCreateInfo viewportInfo {};
+	viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportInfo.viewportCount = 1;
+	viewportInfo.pViewports = &viewport;
+	viewportInfo.scissorCount = 1;
+	viewportInfo.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
+	rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizerInfo.cullMode = VK_CULL_MODE_NONE;
+	rasterizerInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizerInfo.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisamplingInfo {};
+	multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisamplingInfo.minSampleShading = 1.0f;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_FALSE;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendInfo {};
+	colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendInfo.logicOpEnable = VK_FALSE;
+	colorBlendInfo.attachmentCount = 1;
+	colorBlendInfo.pAttachments = &colorBlendAttachment;
+
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(Parameters);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+
+	VkGraphicsPipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+	pipelineInfo.pViewportState = &viewportInfo;
+	pipelineInfo.pRasterizationState = &rasterizerInfo;
+	pipelineInfo.pMultisampleState = &multisamplingInfo;
+	pipelineInfo.pColorBlendState = &colorBlendInfo;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	//? Shared by every context, pipelines can be used from any thread
+	if (vkCreateGraphicsPipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a graphics pipeline");
+	}
+
+	vkDestroyShaderModule(context.device, vertModule, nullptr);
+	vkDestroyShaderModule(context.device, fragModule, nullptr);
+}
+
+void BatchRenderer::CreateSceneContext(SceneContext& sceneContext) {
+	context.CreateImage(extent, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, sceneContext.image, sceneContext.imageMemory);
+	sceneContext.view = context.CreateImageView(sceneContext.image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	VkFramebufferCreateInfo framebufferInfo {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &sceneContext.view;
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+
+	if (vkCreateFramebuffer(context.device, &framebufferInfo, nullptr, &sceneContext.framebuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a framebuffer.");
+	}
+
+	VkDeviceSize readbackSize = VkDeviceSize(extent.width) * extent.height * 4;
+	context.CreateBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, sceneContext.readbackBuffer, sceneContext.readbackMemory);
+	vkMapMemory(context.device, sceneContext.readbackMemory, 0, readbackSize, 0, &sceneContext.readbackMapped);
+
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = context.graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	VkFenceCreateInfo fenceInfo {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	for (uint i = 0; i < 2; i++) {
+		if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &sceneContext.commandPools[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a command pool.");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = sceneContext.commandPools[i];
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(context.device, &allocInfo, &sceneContext.commandBuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't allocate command buffers.");
+		}
+		if (vkCreateFence(context.device, &fenceInfo, nullptr, &sceneContext.fences[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a fence.");
+		}
+	}
+}
+
+void BatchRenderer::DestroySceneContext(SceneContext& sceneContext) {
+	for (uint i = 0; i < 2; i++) {
+		vkDestroyFence(context.device, sceneContext.fences[i], nullptr);
+		vkDestroyCommandPool(context.device, sceneContext.commandPools[i], nullptr);
+	}
+	vkUnmapMemory(context.device, sceneContext.readbackMemory);
+	context.DestroyBuffer(sceneContext.readbackBuffer, sceneContext.readbackMemory);
+	vkDestroyFramebuffer(context.device, sceneContext.framebuffer, nullptr);
+	vkDestroyImageView(context.device, sceneContext.view, nullptr);
+	context.DestroyImage(sceneContext.image, sceneContext.imageMemory);
+}
@@ -0,0 +1,638 @@
+#include "Bvh.hpp"
+#include <random>
+#include <limits>
+
+namespace {
+	const float infinity = std::numeric_limits<float>::infinity();
+	//? Past this depth splits go to the median, which bounds the depth and so the query stacks
+	const uint maxSahLevel = 32;
+	//? Visiting a node costs about as much as testing a primitive
+	const float traversalCost = 1.0f;
+
+	float HalfArea(const glm::vec3& min, const glm::vec3& max) {
+		glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	bool SphereOutside(const glm::vec4 planes[6], const glm::vec4& sphere) {
+		for (uint i = 0; i < 6; i++) {
+			if (glm::dot(glm::vec3(planes[i]), glm::vec3(sphere)) + planes[i].w < -sphere.w) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+void Bvh::FrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+	//? Rows of the view projection combined, with depth going from 0 to 1
+	glm::mat4 rows = glm::transpose(viewProjection);
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	planes[4] = rows[2];
+	planes[5] = rows[3] - rows[2];
+	for (uint i = 0; i < 6; i++) {
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+void Bvh::Build(const glm::vec4* source, uint count, ThreadPool* pool) {
+	nodes.clear();
+	parents.clear();
+	depth = 0;
+	order.resize(count);
+	spheres.resize(count);
+	positions.resize(count);
+	leafNodes.resize(count);
+	if (count == 0) {
+		nodeDirty.clear();
+		return;
+	}
+
+	references.resize(count);
+	for (uint i = 0; i < count; i++) {
+		references[i] = { glm::vec3(source[i]), source[i].w, i };
+	}
+	//? A binary tree with at least one primitive per leaf never has more nodes than this
+	buildNodes.resize(2 * count - 1);
+	buildNodeCount = 1;
+	workers = pool;
+	BuildRange(0, 0, count, 0);
+	if (workers != nullptr) {
+		workers->Wait();
+	}
+	workers = nullptr;
+
+	//? Spheres in leaf order, so a leaf reads them from one place
+	for (uint i = 0; i < count; i++) {
+		order[i] = references[i].primitive;
+		spheres[i] = source[order[i]];
+		positions[order[i]] = i;
+	}
+	Collapse(0, noChild, 1);
+
+	nodeDirty.assign(nodes.size(), 0);
+	std::vector<BuildNode>().swap(buildNodes);
+	std::vector<Reference>().swap(references);
+}
+
+void Bvh::BuildRange(uint node, uint begin, uint end, uint level) {
+	glm::vec3 boundsMin(infinity);
+	glm::vec3 boundsMax(-infinity);
+	glm::vec3 centerMin(infinity);
+	glm::vec3 centerMax(-infinity);
+	for (uint i = begin; i < end; i++) {
+		const Reference& reference = references[i];
+		boundsMin = glm::min(boundsMin, reference.center - reference.radius);
+		boundsMax = glm::max(boundsMax, reference.center + reference.radius);
+		centerMin = glm::min(centerMin, reference.center);
+		centerMax = glm::max(centerMax, reference.center);
+	}
+	BuildNode& build = buildNodes[node];
+	build.min = boundsMin;
+	build.max = boundsMax;
+	build.left = noChild;
+	build.first = begin;
+	build.count = end - begin;
+
+	uint count = end - begin;
+	if (count == 1) {
+		return;
+	}
+	glm::vec3 extent = centerMax - centerMin;
+	uint axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	bool binned = level < maxSahLevel and extent[axis] > 0.0f;
+	if (!binned and count <= maxLeafSize) {
+		return;
+	}
+
+	uint middle = begin;
+	if (binned) {
+		struct Bin {
+			glm::vec3 min = glm::vec3(infinity);
+			glm::vec3 max = glm::vec3(-infinity);
+			uint count = 0;
+		};
+		Bin bins[binCount];
+		float scale = binCount / extent[axis];
+		auto binOf = [&](const Reference& reference) {
+			return std::min(uint((reference.center[axis] - centerMin[axis]) * scale), binCount - 1);
+		};
+		for (uint i = begin; i < end; i++) {
+			const Reference& reference = references[i];
+			Bin& bin = bins[binOf(reference)];
+			bin.min = glm::min(bin.min, reference.center - reference.radius);
+			bin.max = glm::max(bin.max, reference.center + reference.radius);
+			bin.count++;
+		}
+
+		//? Split i puts bins below i on the left. Sweep from the right for the cost of the right side, then from the left
+		float rightCosts[binCount];
+		uint rightCounts[binCount];
+		glm::vec3 min(infinity);
+		glm::vec3 max(-infinity);
+		uint sideCount = 0;
+		for (uint i = binCount - 1; i > 0; i--) {
+			min = glm::min(min, bins[i].min);
+			max = glm::max(max, bins[i].max);
+			sideCount += bins[i].count;
+			rightCosts[i] = HalfArea(min, max) * sideCount;
+			rightCounts[i] = sideCount;
+		}
+		min = glm::vec3(infinity);
+		max = glm::vec3(-infinity);
+		sideCount = 0;
+		uint bestSplit = 0;
+		float bestCost = infinity;
+		for (uint i = 1; i < binCount; i++) {
+			min = glm::min(min, bins[i - 1].min);
+			max = glm::max(max, bins[i - 1].max);
+			sideCount += bins[i - 1].count;
+			if (sideCount == 0 or rightCounts[i] == 0) {
+				continue;
+			}
+			float cost = HalfArea(min, max) * sideCount + rightCosts[i];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		float splitCost = traversalCost + bestCost / std::max(HalfArea(boundsMin, boundsMax), 1e-20f);
+		if (count <= maxLeafSize and float(count) <= splitCost) {
+			return;
+		}
+		if (bestSplit > 0) {
+			middle = std::partition(references.begin() + begin, references.begin() + end, [&](const Reference& reference) {
+				return binOf(reference) < bestSplit;
+			}) - references.begin();
+		}
+	}
+	if (middle == begin or middle == end) {
+		//? Centers too close together to bin, or too deep: split at the median
+		middle = begin + count / 2;
+		std::nth_element(references.begin() + begin, references.begin() + middle, references.begin() + end, [&](const Reference& a, const Reference& b) {
+			return a.center[axis] < b.center[axis];
+		});
+	}
+
+	uint left = buildNodeCount.fetch_add(2);
+	build.left = left;
+	if (workers != nullptr and count >= Settings::bvhParallelThreshold) {
+		workers->Submit([this, left, begin, middle, level] {
+			BuildRange(left, begin, middle, level + 1);
+		});
+	} else {
+		BuildRange(left, begin, middle, level + 1);
+	}
+	BuildRange(left + 1, middle, end, level + 1);
+}
+
+uint Bvh::Collapse(uint buildNode, uint parent, uint level) {
+	uint index = nodes.size();
+	nodes.emplace_back();
+	parents.push_back(parent);
+	depth = std::max(depth, level);
+
+	//? Children of the binary node, then the largest inner one opened until the node is full
+	uint children[Width];
+	uint childCount = 0;
+	if (buildNodes[buildNode].left == noChild) {
+		children[childCount++] = buildNode;
+	} else {
+		children[childCount++] = buildNodes[buildNode].left;
+		children[childCount++] = buildNodes[buildNode].left + 1;
+	}
+	while (childCount < Width) {
+		uint largest = noChild;
+		float largestArea = -1.0f;
+		for (uint i = 0; i < childCount; i++) {
+			const BuildNode& child = buildNodes[children[i]];
+			float area = HalfArea(child.min, child.max);
+			if (child.left != noChild and area > largestArea) {
+				largest = i;
+				largestArea = area;
+			}
+		}
+		if (largest == noChild) {
+			break;
+		}
+		uint opened = children[largest];
+		children[largest] = buildNodes[opened].left;
+		children[childCount++] = buildNodes[opened].left + 1;
+	}
+
+	for (uint i = 0; i < Width; i++) {
+		//? Empty slots get inverted boxes, so unions and overlap tests pass over them
+		BuildNode empty { glm::vec3(infinity), glm::vec3(-infinity), noChild, 0, 0 };
+		const BuildNode& child = i < childCount ? buildNodes[children[i]] : empty;
+		uint childIndex = noChild;
+		if (child.left != noChild) {
+			childIndex = Collapse(children[i], index, level + 1);
+		} else {
+			for (uint j = child.first; j < child.first + child.count; j++) {
+				leafNodes[order[j]] = index;
+			}
+		}
+		//? Collapse may have moved the nodes
+		Node& node = nodes[index];
+		node.minX[i] = child.min.x;
+		node.minY[i] = child.min.y;
+		node.minZ[i] = child.min.z;
+		node.maxX[i] = child.max.x;
+		node.maxY[i] = child.max.y;
+		node.maxZ[i] = child.max.z;
+		node.child[i] = childIndex;
+		node.first[i] = child.first;
+		node.count[i] = child.count;
+	}
+	return index;
+}
+
+void Bvh::Refit(const glm::vec4* source) {
+	for (uint i = 0; i < order.size(); i++) {
+		spheres[i] = source[order[i]];
+	}
+	//? Children always come after their parent
+	for (uint node = nodes.size(); node-- > 0;) {
+		RefitNode(node);
+	}
+}
+
+void Bvh::Refit(const glm::vec4* source, const uint* moved, uint count) {
+	dirtyNodes.clear();
+	for (uint i = 0; i < count; i++) {
+		uint primitive = moved[i];
+		spheres[positions[primitive]] = source[primitive];
+		for (uint node = leafNodes[primitive]; node != noChild and !nodeDirty[node]; node = parents[node]) {
+			nodeDirty[node] = 1;
+			dirtyNodes.push_back(node);
+		}
+	}
+	std::sort(dirtyNodes.begin(), dirtyNodes.end(), std::greater<uint>());
+	for (uint node : dirtyNodes) {
+		RefitNode(node);
+		nodeDirty[node] = 0;
+	}
+}
+
+void Bvh::RefitNode(uint index) {
+	Node& node = nodes[index];
+	for (uint i = 0; i < Width; i++) {
+		if (node.count[i] == 0) {
+			continue;
+		}
+		glm::vec3 min(infinity);
+		glm::vec3 max(-infinity);
+		if (node.child[i] == noChild) {
+			for (uint j = node.first[i]; j < node.first[i] + node.count[i]; j++) {
+				glm::vec3 center = spheres[j];
+				min = glm::min(min, center - spheres[j].w);
+				max = glm::max(max, center + spheres[j].w);
+			}
+		} else {
+			const Node& child = nodes[node.child[i]];
+			for (uint j = 0; j < Width; j++) {
+				min = glm::min(min, glm::vec3(child.minX[j], child.minY[j], child.minZ[j]));
+				max = glm::max(max, glm::vec3(child.maxX[j], child.maxY[j], child.maxZ[j]));
+			}
+		}
+		node.minX[i] = min.x;
+		node.minY[i] = min.y;
+		node.minZ[i] = min.z;
+		node.maxX[i] = max.x;
+		node.maxY[i] = max.y;
+		node.maxZ[i] = max.z;
+	}
+}
+
+void Bvh::QueryFrustum(const glm::vec4 planes[6], std::vector<uint>& results) const {
+	if (nodes.empty()) {
+		return;
+	}
+	uint stack[maxStack];
+	uint stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const Node& node = nodes[stack[--stackSize]];
+
+		//? A child is outside when the corner of its box farthest along a normal is behind that plane,
+		//? and entirely inside when the opposite corner is in front of every plane
+		uint outside[Width] = {};
+		uint crossing[Width] = {};
+		for (uint p = 0; p < 6; p++) {
+			const glm::vec4& plane = planes[p];
+			const float* farX = plane.x > 0.0f ? node.maxX : node.minX;
+			const float* farY = plane.y > 0.0f ? node.maxY : node.minY;
+			const float* farZ = plane.z > 0.0f ? node.maxZ : node.minZ;
+			const float* nearX = plane.x > 0.0f ? node.minX : node.maxX;
+			const float* nearY = plane.y > 0.0f ? node.minY : node.maxY;
+			const float* nearZ = plane.z > 0.0f ? node.minZ : node.maxZ;
+			for (uint i = 0; i < Width; i++) {
+				float front = plane.x * farX[i] + plane.y * farY[i] + plane.z * farZ[i] + plane.w;
+				float back = plane.x * nearX[i] + plane.y * nearY[i] + plane.z * nearZ[i] + plane.w;
+				outside[i] |= front < 0.0f;
+				crossing[i] |= back < 0.0f;
+			}
+		}
+
+		for (uint i = 0; i < Width; i++) {
+			if (node.count[i] == 0 or outside[i]) {
+				continue;
+			}
+			if (!crossing[i]) {
+				results.insert(results.end(), order.begin() + node.first[i], order.begin() + node.first[i] + node.count[i]);
+			} else if (node.child[i] != noChild) {
+				stack[stackSize++] = node.child[i];
+			} else {
+				for (uint j = node.first[i]; j < node.first[i] + node.count[i]; j++) {
+					if (!SphereOutside(planes, spheres[j])) {
+						results.push_back(order[j]);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const {
+	hit.primitive = noChild;
+	hit.distance = maxDistance;
+	if (nodes.empty()) {
+		return false;
+	}
+	glm::vec3 inverse = 1.0f / direction;
+
+	struct Entry {
+		uint node;
+		float distance;
+	};
+	Entry stack[maxStack];
+	uint stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+	while (stackSize > 0) {
+		Entry entry = stack[--stackSize];
+		//? Something closer turned up after this was pushed
+		if (entry.distance >= hit.distance) {
+			continue;
+		}
+		const Node& node = nodes[entry.node];
+
+		//? Slab test, where the ray enters each child's box or infinity if it misses
+		float enter[Width];
+		for (uint i = 0; i < Width; i++) {
+			float x0 = (node.minX[i] - origin.x) * inverse.x;
+			float x1 = (node.maxX[i] - origin.x) * inverse.x;
+			float y0 = (node.minY[i] - origin.y) * inverse.y;
+			float y1 = (node.maxY[i] - origin.y) * inverse.y;
+			float z0 = (node.minZ[i] - origin.z) * inverse.z;
+			float z1 = (node.maxZ[i] - origin.z) * inverse.z;
+			float entering = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), 0.0f));
+			float leaving = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), hit.distance));
+			enter[i] = entering <= leaving ? entering : infinity;
+		}
+
+		//? Inner children sorted farthest first, so the nearest one is popped next
+		uint inner[Width];
+		uint innerCount = 0;
+		for (uint i = 0; i < Width; i++) {
+			//? Missed boxes enter at infinity, which is never below the distance
+			if (node.count[i] == 0 or enter[i] >= hit.distance) {
+				continue;
+			}
+			if (node.child[i] == noChild) {
+				for (uint j = node.first[i]; j < node.first[i] + node.count[i]; j++) {
+					glm::vec3 toCenter = glm::vec3(spheres[j]) - origin;
+					float along = glm::dot(toCenter, direction);
+					float outsideBy = glm::dot(toCenter, toCenter) - spheres[j].w * spheres[j].w;
+					float distance;
+					if (outsideBy <= 0.0f) {
+						distance = 0.0f;
+					} else {
+						float discriminant = along * along - outsideBy;
+						if (along < 0.0f or discriminant < 0.0f) {
+							continue;
+						}
+						distance = along - std::sqrt(discriminant);
+					}
+					if (distance < hit.distance) {
+						hit.distance = distance;
+						hit.primitive = order[j];
+					}
+				}
+				continue;
+			}
+			uint slot = innerCount++;
+			for (; slot > 0 and enter[inner[slot - 1]] < enter[i]; slot--) {
+				inner[slot] = inner[slot - 1];
+			}
+			inner[slot] = i;
+		}
+		for (uint i = 0; i < innerCount; i++) {
+			stack[stackSize++] = { node.child[inner[i]], enter[inner[i]] };
+		}
+	}
+	return hit.primitive != noChild;
+}
+
+bool Bvh::Nearest(const glm::vec3& point, float maxDistance, RayHit& hit) const {
+	hit.primitive = noChild;
+	hit.distance = maxDistance;
+	if (nodes.empty()) {
+		return false;
+	}
+
+	//? Squared distances to the boxes, a box is never farther than the spheres inside it
+	struct Entry {
+		uint node;
+		float distanceSquared;
+	};
+	Entry stack[maxStack];
+	uint stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+	while (stackSize > 0) {
+		Entry entry = stack[--stackSize];
+		if (entry.distanceSquared > hit.distance * hit.distance) {
+			continue;
+		}
+		const Node& node = nodes[entry.node];
+
+		float distances[Width];
+		for (uint i = 0; i < Width; i++) {
+			float x = std::max(std::max(node.minX[i] - point.x, point.x - node.maxX[i]), 0.0f);
+			float y = std::max(std::max(node.minY[i] - point.y, point.y - node.maxY[i]), 0.0f);
+			float z = std::max(std::max(node.minZ[i] - point.z, point.z - node.maxZ[i]), 0.0f);
+			distances[i] = x * x + y * y + z * z;
+		}
+
+		uint inner[Width];
+		uint innerCount = 0;
+		for (uint i = 0; i < Width; i++) {
+			if (node.count[i] == 0 or distances[i] > hit.distance * hit.distance) {
+				continue;
+			}
+			if (node.child[i] == noChild) {
+				for (uint j = node.first[i]; j < node.first[i] + node.count[i]; j++) {
+					float distance = std::max(glm::length(glm::vec3(spheres[j]) - point) - spheres[j].w, 0.0f);
+					if (distance < hit.distance) {
+						hit.distance = distance;
+						hit.primitive = order[j];
+					}
+				}
+				continue;
+			}
+			uint slot = innerCount++;
+			for (; slot > 0 and distances[inner[slot - 1]] < distances[i]; slot--) {
+				inner[slot] = inner[slot - 1];
+			}
+			inner[slot] = i;
+		}
+		for (uint i = 0; i < innerCount; i++) {
+			stack[stackSize++] = { node.child[inner[i]], distances[inner[i]] };
+		}
+	}
+	return hit.primitive != noChild;
+}
+
+uint Bvh::NodeCount() const {
+	return nodes.size();
+}
+
+uint Bvh::Depth() const {
+	return depth;
+}
+
+float Bvh::SahCost() const {
+	if (nodes.empty()) {
+		return 0.0f;
+	}
+	//? Every visited node tests all its children, a child is visited as often as its area allows
+	glm::vec3 rootMin(infinity);
+	glm::vec3 rootMax(-infinity);
+	float cost = 0.0f;
+	for (uint index = 0; index < nodes.size(); index++) {
+		const Node& node = nodes[index];
+		for (uint i = 0; i < Width; i++) {
+			if (node.count[i] == 0) {
+				continue;
+			}
+			glm::vec3 min(node.minX[i], node.minY[i], node.minZ[i]);
+			glm::vec3 max(node.maxX[i], node.maxY[i], node.maxZ[i]);
+			cost += HalfArea(min, max) * (node.child[i] == noChild ? float(node.count[i]) : traversalCost);
+			if (index == 0) {
+				rootMin = glm::min(rootMin, min);
+				rootMax = glm::max(rootMax, max);
+			}
+		}
+	}
+	return traversalCost + cost / std::max(HalfArea(rootMin, rootMax), 1e-20f);
+}
+
+void Bvh::Benchmark(uint count) {
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+	auto rate = [](double items, double ms) {
+		return ms > 0.0 ? items / ms / 1000.0 : 0.0;
+	};
+
+	//? About as dense as the scene's grid, a few units between neighbours
+	std::mt19937 random(13);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float side = std::cbrt(float(count)) * 4.0f;
+	std::vector<glm::vec4> source(count);
+	for (glm::vec4& sphere : source) {
+		sphere = glm::vec4(unit(random) * side, unit(random) * side, unit(random) * side, 0.5f + unit(random));
+	}
+
+	Bvh bvh;
+	Clock::time_point start = Clock::now();
+	bvh.Build(source.data(), count);
+	double serialMs = milliseconds(start);
+	ThreadPool pool(Settings::bvhBuildThreads);
+	start = Clock::now();
+	bvh.Build(source.data(), count, &pool);
+	double parallelMs = milliseconds(start);
+	float builtCost = bvh.SahCost();
+
+	//? Everything drifts a little, then 1% moves again
+	for (glm::vec4& sphere : source) {
+		sphere += glm::vec4(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f);
+	}
+	start = Clock::now();
+	bvh.Refit(source.data());
+	double refitMs = milliseconds(start);
+	std::vector<uint> moved(std::max(count / 100, 1u));
+	for (uint& primitive : moved) {
+		primitive = random() % count;
+		source[primitive] += glm::vec4(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f);
+	}
+	start = Clock::now();
+	bvh.Refit(source.data(), moved.data(), moved.size());
+	double partialRefitMs = milliseconds(start);
+	float refitCost = bvh.SahCost();
+
+	//? Cameras inside the volume looking every which way, the scene's field of view and a quarter of the volume deep
+	const uint frustumCount = 256;
+	std::vector<std::array<glm::vec4, 6>> frusta(frustumCount);
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, side * 0.25f);
+	for (std::array<glm::vec4, 6>& planes : frusta) {
+		glm::vec3 eye = glm::vec3(unit(random), unit(random), unit(random)) * side;
+		glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random)) * side;
+		FrustumPlanes(projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)), planes.data());
+	}
+	std::vector<uint> results;
+	results.reserve(count);
+	uint64 bvhVisible = 0;
+	start = Clock::now();
+	for (const std::array<glm::vec4, 6>& planes : frusta) {
+		results.clear();
+		bvh.QueryFrustum(planes.data(), results);
+		bvhVisible += results.size();
+	}
+	double frustumMs = milliseconds(start);
+	uint64 scanVisible = 0;
+	start = Clock::now();
+	for (const std::array<glm::vec4, 6>& planes : frusta) {
+		for (uint i = 0; i < count; i++) {
+			scanVisible += !SphereOutside(planes.data(), source[i]);
+		}
+	}
+	double scanMs = milliseconds(start);
+
+	const uint rayCount = 100000;
+	uint rayHits = 0;
+	std::vector<glm::vec3> origins(rayCount);
+	std::vector<glm::vec3> directions(rayCount);
+	for (uint i = 0; i < rayCount; i++) {
+		origins[i] = glm::vec3(unit(random), unit(random), unit(random)) * side;
+		directions[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f);
+	}
+	RayHit hit;
+	start = Clock::now();
+	for (uint i = 0; i < rayCount; i++) {
+		rayHits += bvh.Raycast(origins[i], directions[i], infinity, hit);
+	}
+	double rayMs = milliseconds(start);
+	start = Clock::now();
+	for (uint i = 0; i < rayCount; i++) {
+		bvh.Nearest(origins[i], infinity, hit);
+	}
+	double nearestMs = milliseconds(start);
+
+	std::cout << "BVH, " << count << " spheres, " << Width << " wide:\n";
+	std::cout << "\tNodes: " << bvh.NodeCount() << ", depth " << bvh.Depth() << "\n";
+	std::cout << "\tBuild on one thread: " << serialMs << " ms (" << rate(count, serialMs) << " M spheres/s)\n";
+	std::cout << "\tBuild on " << pool.ThreadCount() << " threads: " << parallelMs << " ms (" << rate(count, parallelMs) << " M spheres/s)\n";
+	std::cout << "\tFull refit: " << refitMs << " ms (" << rate(count, refitMs) << " M spheres/s)\n";
+	std::cout << "\tRefit of 1%: " << partialRefitMs << " ms (" << rate(moved.size(), partialRefitMs) << " M spheres/s)\n";
+	std::cout << "\tSAH cost: " << builtCost << " built, " << refitCost << " after refits\n";
+	std::cout << "\tFrustum query: " << frustumMs / frustumCount << " ms, " << bvhVisible / frustumCount << " visible ";
+	std::cout << "(linear scan " << scanMs / frustumCount << " ms, " << scanVisible / frustumCount << " visible)\n";
+	std::cout << "\tRaycast: " << rate(rayCount, rayMs) << " M rays/s, " << rayHits * 100 / rayCount << "% hit\n";
+	std::cout << "\tNearest: " << rate(rayCount, nearestMs) << " M queries/s\n";
+	std::cout << std::endl;
+}
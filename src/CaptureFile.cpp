@@ -0,0 +1,711 @@
+#include "CaptureFile.hpp"
+#include <type_traits>
+
+namespace {
+	class Writer {
+	public:
+		std::string bytes;
+
+		//? LEB128, most values here are small indices and counts
+		void Varint(uint64 value) {
+			while (value >= 0x80) {
+				bytes.push_back(char(value | 0x80));
+				value >>= 7;
+			}
+			bytes.push_back(char(value));
+		}
+
+		void Float(float value) {
+			Raw(&value, sizeof(float));
+		}
+
+		void Raw(const void* data, size_t size) {
+			bytes.append(static_cast<const char*>(data), size);
+		}
+
+		void Blob(const std::string& data) {
+			Varint(data.size());
+			bytes += data;
+		}
+
+		//? Only for Vulkan structs without pointers, they're written as they are in memory
+		template<typename T>
+		void Pods(const std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable<T>::value, "Pods takes plain structs only");
+			Varint(values.size());
+			Raw(values.data(), values.size() * sizeof(T));
+		}
+
+		template<typename T>
+		void Pod(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "Pod takes plain structs only");
+			Raw(&value, sizeof(T));
+		}
+	};
+
+	class Reader {
+	public:
+		Reader(const std::string& bytes) : bytes(bytes) {}
+
+		uint64 Varint() {
+			uint64 value = 0;
+			for (uint shift = 0; shift < 64; shift += 7) {
+				Check(1);
+				uint8 byte = uint8(bytes[position++]);
+				value |= uint64(byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0) {
+					return value;
+				}
+			}
+			throw std::runtime_error("Couldn't read the capture, a varint is too long.");
+		}
+
+		template<typename T>
+		T Enum() {
+			return static_cast<T>(Varint());
+		}
+
+		float Float() {
+			float value;
+			Raw(&value, sizeof(float));
+			return value;
+		}
+
+		void Raw(void* data, size_t size) {
+			Check(size);
+			memcpy(data, bytes.data() + position, size);
+			position += size;
+		}
+
+		std::string Blob() {
+			size_t size = Count(1);
+			std::string data = bytes.substr(position, size);
+			position += size;
+			return data;
+		}
+
+		template<typename T>
+		std::vector<T> Pods() {
+			std::vector<T> values(Count(sizeof(T)));
+			Raw(values.data(), values.size() * sizeof(T));
+			return values;
+		}
+
+		template<typename T>
+		T Pod() {
+			T value;
+			Raw(&value, sizeof(T));
+			return value;
+		}
+
+		//? A list length, checked against what's left so a corrupt file can't ask for gigabytes
+		size_t Count(size_t elementSize) {
+			uint64 count = Varint();
+			if (elementSize > 0 and count > (bytes.size() - position) / elementSize) {
+				throw std::runtime_error("Couldn't read the capture, it's truncated.");
+			}
+			return size_t(count);
+		}
+
+		bool AtEnd() const {
+			return position == bytes.size();
+		}
+
+	private:
+		const std::string& bytes;
+		size_t position = 0;
+
+		void Check(size_t size) {
+			if (size > bytes.size() - position) {
+				throw std::runtime_error("Couldn't read the capture, it's truncated.");
+			}
+		}
+	};
+
+	void WriteIndices(Writer& writer, const std::vector<uint64>& indices) {
+		writer.Varint(indices.size());
+		for (uint64 index : indices) {
+			writer.Varint(index);
+		}
+	}
+
+	std::vector<uint64> ReadIndices(Reader& reader) {
+		std::vector<uint64> indices(reader.Count(1));
+		for (uint64& index : indices) {
+			index = reader.Varint();
+		}
+		return indices;
+	}
+
+	void WriteSampler(Writer& writer, const VkSamplerCreateInfo& info) {
+		writer.Varint(info.magFilter);
+		writer.Varint(info.minFilter);
+		writer.Varint(info.mipmapMode);
+		writer.Varint(info.addressModeU);
+		writer.Varint(info.addressModeV);
+		writer.Varint(info.addressModeW);
+		writer.Float(info.mipLodBias);
+		writer.Varint(info.anisotropyEnable);
+		writer.Float(info.maxAnisotropy);
+		writer.Varint(info.compareEnable);
+		writer.Varint(info.compareOp);
+		writer.Float(info.minLod);
+		writer.Float(info.maxLod);
+		writer.Varint(info.borderColor);
+		writer.Varint(info.unnormalizedCoordinates);
+	}
+
+	VkSamplerCreateInfo ReadSampler(Reader& reader) {
+		VkSamplerCreateInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		info.magFilter = reader.Enum<VkFilter>();
+		info.minFilter = reader.Enum<VkFilter>();
+		info.mipmapMode = reader.Enum<VkSamplerMipmapMode>();
+		info.addressModeU = reader.Enum<VkSamplerAddressMode>();
+		info.addressModeV = reader.Enum<VkSamplerAddressMode>();
+		info.addressModeW = reader.Enum<VkSamplerAddressMode>();
+		info.mipLodBias = reader.Float();
+		info.anisotropyEnable = VkBool32(reader.Varint());
+		info.maxAnisotropy = reader.Float();
+		info.compareEnable = VkBool32(reader.Varint());
+		info.compareOp = reader.Enum<VkCompareOp>();
+		info.minLod = reader.Float();
+		info.maxLod = reader.Float();
+		info.borderColor = reader.Enum<VkBorderColor>();
+		info.unnormalizedCoordinates = VkBool32(reader.Varint());
+		return info;
+	}
+
+	void WritePipeline(Writer& writer, const CaptureFile::Pipeline& pipeline) {
+		writer.Varint(pipeline.layout);
+		writer.Varint(pipeline.renderPass);
+		writer.Varint(pipeline.subpass);
+
+		writer.Varint(pipeline.stages.size());
+		for (const CaptureFile::ShaderStage& stage : pipeline.stages) {
+			writer.Varint(stage.stage);
+			writer.Varint(stage.module);
+			writer.Blob(stage.entry);
+			writer.Pods(stage.specializationEntries);
+			writer.Blob(stage.specializationData);
+		}
+		writer.Pods(pipeline.vertexBindings);
+		writer.Pods(pipeline.vertexAttributes);
+
+		writer.Varint(pipeline.inputAssembly.topology);
+		writer.Varint(pipeline.inputAssembly.primitiveRestartEnable);
+		writer.Varint(pipeline.viewportCount);
+		writer.Varint(pipeline.scissorCount);
+		writer.Pods(pipeline.viewports);
+		writer.Pods(pipeline.scissors);
+
+		const VkPipelineRasterizationStateCreateInfo& rasterization = pipeline.rasterization;
+		writer.Varint(rasterization.depthClampEnable);
+		writer.Varint(rasterization.rasterizerDiscardEnable);
+		writer.Varint(rasterization.polygonMode);
+		writer.Varint(rasterization.cullMode);
+		writer.Varint(rasterization.frontFace);
+		writer.Varint(rasterization.depthBiasEnable);
+		writer.Float(rasterization.depthBiasConstantFactor);
+		writer.Float(rasterization.depthBiasClamp);
+		writer.Float(rasterization.depthBiasSlopeFactor);
+		writer.Float(rasterization.lineWidth);
+
+		const VkPipelineMultisampleStateCreateInfo& multisample = pipeline.multisample;
+		writer.Varint(multisample.rasterizationSamples);
+		writer.Varint(multisample.sampleShadingEnable);
+		writer.Float(multisample.minSampleShading);
+		writer.Varint(multisample.alphaToCoverageEnable);
+		writer.Varint(multisample.alphaToOneEnable);
+
+		writer.Varint(pipeline.depthStencilEnabled);
+		if (pipeline.depthStencilEnabled) {
+			const VkPipelineDepthStencilStateCreateInfo& depthStencil = pipeline.depthStencil;
+			writer.Varint(depthStencil.depthTestEnable);
+			writer.Varint(depthStencil.depthWriteEnable);
+			writer.Varint(depthStencil.depthCompareOp);
+			writer.Varint(depthStencil.depthBoundsTestEnable);
+			writer.Varint(depthStencil.stencilTestEnable);
+			writer.Pod(depthStencil.front);
+			writer.Pod(depthStencil.back);
+			writer.Float(depthStencil.minDepthBounds);
+			writer.Float(depthStencil.maxDepthBounds);
+		}
+
+		writer.Varint(pipeline.colorBlend.logicOpEnable);
+		writer.Varint(pipeline.colorBlend.logicOp);
+		for (float constant : pipeline.colorBlend.blendConstants) {
+			writer.Float(constant);
+		}
+		writer.Pods(pipeline.blendAttachments);
+		writer.Pods(pipeline.dynamicStates);
+	}
+
+	CaptureFile::Pipeline ReadPipeline(Reader& reader) {
+		CaptureFile::Pipeline pipeline;
+		pipeline.layout = reader.Varint();
+		pipeline.renderPass = reader.Varint();
+		pipeline.subpass = uint(reader.Varint());
+
+		pipeline.stages.resize(reader.Count(1));
+		for (CaptureFile::ShaderStage& stage : pipeline.stages) {
+			stage.stage = reader.Enum<VkShaderStageFlagBits>();
+			stage.module = reader.Varint();
+			stage.entry = reader.Blob();
+			stage.specializationEntries = reader.Pods<VkSpecializationMapEntry>();
+			stage.specializationData = reader.Blob();
+		}
+		pipeline.vertexBindings = reader.Pods<VkVertexInputBindingDescription>();
+		pipeline.vertexAttributes = reader.Pods<VkVertexInputAttributeDescription>();
+
+		pipeline.inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		pipeline.inputAssembly.topology = reader.Enum<VkPrimitiveTopology>();
+		pipeline.inputAssembly.primitiveRestartEnable = VkBool32(reader.Varint());
+		pipeline.viewportCount = uint(reader.Varint());
+		pipeline.scissorCount = uint(reader.Varint());
+		pipeline.viewports = reader.Pods<VkViewport>();
+		pipeline.scissors = reader.Pods<VkRect2D>();
+
+		VkPipelineRasterizationStateCreateInfo& rasterization = pipeline.rasterization;
+		rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterization.depthClampEnable = VkBool32(reader.Varint());
+		rasterization.rasterizerDiscardEnable = VkBool32(reader.Varint());
+		rasterization.polygonMode = reader.Enum<VkPolygonMode>();
+		rasterization.cullMode = VkCullModeFlags(reader.Varint());
+		rasterization.frontFace = reader.Enum<VkFrontFace>();
+		rasterization.depthBiasEnable = VkBool32(reader.Varint());
+		rasterization.depthBiasConstantFactor = reader.Float();
+		rasterization.depthBiasClamp = reader.Float();
+		rasterization.depthBiasSlopeFactor = reader.Float();
+		rasterization.lineWidth = reader.Float();
+
+		VkPipelineMultisampleStateCreateInfo& multisample = pipeline.multisample;
+		multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisample.rasterizationSamples = reader.Enum<VkSampleCountFlagBits>();
+		multisample.sampleShadingEnable = VkBool32(reader.Varint());
+		multisample.minSampleShading = reader.Float();
+		multisample.alphaToCoverageEnable = VkBool32(reader.Varint());
+		multisample.alphaToOneEnable = VkBool32(reader.Varint());
+
+		pipeline.depthStencilEnabled = reader.Varint() != 0;
+		pipeline.depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		if (pipeline.depthStencilEnabled) {
+			VkPipelineDepthStencilStateCreateInfo& depthStencil = pipeline.depthStencil;
+			depthStencil.depthTestEnable = VkBool32(reader.Varint());
+			depthStencil.depthWriteEnable = VkBool32(reader.Varint());
+			depthStencil.depthCompareOp = reader.Enum<VkCompareOp>();
+			depthStencil.depthBoundsTestEnable = VkBool32(reader.Varint());
+			depthStencil.stencilTestEnable = VkBool32(reader.Varint());
+			depthStencil.front = reader.Pod<VkStencilOpState>();
+			depthStencil.back = reader.Pod<VkStencilOpState>();
+			depthStencil.minDepthBounds = reader.Float();
+			depthStencil.maxDepthBounds = reader.Float();
+		}
+
+		pipeline.colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		pipeline.colorBlend.logicOpEnable = VkBool32(reader.Varint());
+		pipeline.colorBlend.logicOp = reader.Enum<VkLogicOp>();
+		for (float& constant : pipeline.colorBlend.blendConstants) {
+			constant = reader.Float();
+		}
+		pipeline.blendAttachments = reader.Pods<VkPipelineColorBlendAttachmentState>();
+		pipeline.dynamicStates = reader.Pods<VkDynamicState>();
+		return pipeline;
+	}
+
+	//? Replay indexes its object lists with these directly, so a corrupt file has to stop here
+	void CheckIndex(uint64 index, size_t count, bool optional = false) {
+		if (index >= count and !(optional and index == CaptureFile::none)) {
+			throw std::runtime_error("Couldn't read the capture, an object index is out of range.");
+		}
+	}
+
+	void CheckIndices(const std::vector<uint64>& indices, size_t count) {
+		for (uint64 index : indices) {
+			CheckIndex(index, count);
+		}
+	}
+
+	void CheckAttachment(uint attachment, size_t count) {
+		if (attachment != VK_ATTACHMENT_UNUSED and attachment >= count) {
+			throw std::runtime_error("Couldn't read the capture, an attachment reference is out of range.");
+		}
+	}
+
+	//? Argument counts as listed at Op, BindDescriptorSets and BindVertexBuffers take a variable tail
+	void CheckArguments(const CaptureFile::Command& command, size_t count, bool exact = true) {
+		if (command.args.size() < count or (exact and command.args.size() != count)) {
+			throw std::runtime_error("Couldn't read the capture, a command has the wrong number of arguments.");
+		}
+	}
+
+	void Validate(const CaptureFile& capture) {
+		for (const CaptureFile::ImageView& view : capture.imageViews) {
+			CheckIndex(view.image, capture.images.size());
+		}
+		for (const CaptureFile::PipelineLayout& layout : capture.pipelineLayouts) {
+			CheckIndices(layout.setLayouts, capture.setLayouts.size());
+		}
+		for (const CaptureFile::RenderPass& renderPass : capture.renderPasses) {
+			for (const VkAttachmentReference& reference : renderPass.colorReferences) {
+				CheckAttachment(reference.attachment, renderPass.attachments.size());
+			}
+			CheckAttachment(renderPass.depthReference.attachment, renderPass.attachments.size());
+		}
+		for (const CaptureFile::Framebuffer& framebuffer : capture.framebuffers) {
+			CheckIndex(framebuffer.renderPass, capture.renderPasses.size());
+			CheckIndices(framebuffer.attachments, capture.imageViews.size());
+			if (framebuffer.attachments.size() != capture.renderPasses[framebuffer.renderPass].attachments.size()) {
+				throw std::runtime_error("Couldn't read the capture, a framebuffer doesn't match its render pass.");
+			}
+		}
+		for (const CaptureFile::Pipeline& pipeline : capture.pipelines) {
+			CheckIndex(pipeline.layout, capture.pipelineLayouts.size());
+			CheckIndex(pipeline.renderPass, capture.renderPasses.size());
+			for (const CaptureFile::ShaderStage& stage : pipeline.stages) {
+				CheckIndex(stage.module, capture.shaderModules.size());
+			}
+		}
+		for (const CaptureFile::DescriptorSet& set : capture.descriptorSets) {
+			CheckIndex(set.layout, capture.setLayouts.size());
+			for (const CaptureFile::Descriptor& descriptor : set.descriptors) {
+				CheckIndex(descriptor.buffer, capture.buffers.size(), true);
+				CheckIndex(descriptor.sampler, capture.samplers.size(), true);
+				CheckIndex(descriptor.view, capture.imageViews.size(), true);
+			}
+		}
+
+		for (const CaptureFile::Command& command : capture.commands) {
+			const std::vector<uint64>& args = command.args;
+			switch (command.op) {
+				case CaptureFile::Op::BeginRenderPass:
+					CheckArguments(command, 6);
+					CheckIndex(args[0], capture.renderPasses.size());
+					CheckIndex(args[1], capture.framebuffers.size());
+					break;
+				case CaptureFile::Op::EndRenderPass:
+					CheckArguments(command, 0);
+					break;
+				case CaptureFile::Op::BindPipeline:
+					CheckArguments(command, 2);
+					CheckIndex(args[1], capture.pipelines.size());
+					break;
+				case CaptureFile::Op::BindDescriptorSets:
+					CheckArguments(command, 3, false);
+					CheckIndex(args[1], capture.pipelineLayouts.size());
+					for (size_t i = 3; i < args.size(); i++) {
+						CheckIndex(args[i], capture.descriptorSets.size());
+					}
+					break;
+				case CaptureFile::Op::BindVertexBuffers:
+					CheckArguments(command, 1, false);
+					if (args.size() % 2 == 0) {
+						throw std::runtime_error("Couldn't read the capture, a command has the wrong number of arguments.");
+					}
+					for (size_t i = 1; i < args.size(); i += 2) {
+						CheckIndex(args[i], capture.buffers.size());
+					}
+					break;
+				case CaptureFile::Op::BindIndexBuffer:
+					CheckArguments(command, 3);
+					CheckIndex(args[0], capture.buffers.size());
+					break;
+				case CaptureFile::Op::PushConstants:
+					CheckArguments(command, 3);
+					CheckIndex(args[0], capture.pipelineLayouts.size());
+					break;
+				case CaptureFile::Op::SetViewport:
+				case CaptureFile::Op::SetScissor:
+					CheckArguments(command, 1);
+					break;
+				case CaptureFile::Op::Draw:
+					CheckArguments(command, 4);
+					break;
+				case CaptureFile::Op::DrawIndexed:
+					CheckArguments(command, 5);
+					break;
+				case CaptureFile::Op::DrawIndexedIndirect:
+					CheckArguments(command, 4);
+					CheckIndex(args[0], capture.buffers.size());
+					break;
+				case CaptureFile::Op::DrawIndexedIndirectCount:
+					CheckArguments(command, 6);
+					CheckIndex(args[0], capture.buffers.size());
+					CheckIndex(args[2], capture.buffers.size());
+					break;
+				case CaptureFile::Op::ExecuteCommands:
+					throw std::runtime_error("Couldn't read the capture, it has an unknown command.");
+			}
+		}
+	}
+}
+
+void CaptureFile::Save(const std::string& path) const {
+	Writer writer;
+	writer.Pod(magic);
+	writer.Pod(version);
+	writer.Blob(deviceName);
+	writer.Varint(frame);
+	writer.Varint(multiDrawIndirect);
+	writer.Varint(drawIndirectFirstInstance);
+	writer.Varint(drawIndirectCount);
+	writer.Varint(descriptorIndexing);
+
+	writer.Varint(buffers.size());
+	for (const Buffer& buffer : buffers) {
+		writer.Varint(buffer.size);
+		writer.Varint(buffer.usage);
+		writer.Blob(buffer.data);
+	}
+
+	writer.Varint(images.size());
+	for (const Image& image : images) {
+		writer.Varint(image.format);
+		writer.Varint(image.extent.width);
+		writer.Varint(image.extent.height);
+		writer.Varint(image.mipLevels);
+		writer.Varint(image.usage);
+		writer.Varint(image.layout);
+		writer.Varint(image.levels.size());
+		for (const std::string& level : image.levels) {
+			writer.Blob(level);
+		}
+	}
+
+	writer.Varint(imageViews.size());
+	for (const ImageView& view : imageViews) {
+		writer.Varint(view.image);
+		writer.Varint(view.format);
+		writer.Varint(view.aspect);
+		writer.Varint(view.mipLevels);
+	}
+
+	writer.Varint(samplers.size());
+	for (const Sampler& sampler : samplers) {
+		WriteSampler(writer, sampler.info);
+	}
+
+	writer.Varint(shaderModules.size());
+	for (const ShaderModule& module : shaderModules) {
+		writer.Blob(module.code);
+	}
+
+	writer.Varint(setLayouts.size());
+	for (const SetLayout& layout : setLayouts) {
+		writer.Varint(layout.flags);
+		writer.Varint(layout.bindings.size());
+		for (const SetLayoutBinding& binding : layout.bindings) {
+			writer.Varint(binding.binding);
+			writer.Varint(binding.type);
+			writer.Varint(binding.count);
+			writer.Varint(binding.stages);
+			writer.Varint(binding.flags);
+		}
+	}
+
+	writer.Varint(pipelineLayouts.size());
+	for (const PipelineLayout& layout : pipelineLayouts) {
+		WriteIndices(writer, layout.setLayouts);
+		writer.Pods(layout.pushConstants);
+	}
+
+	writer.Varint(renderPasses.size());
+	for (const RenderPass& renderPass : renderPasses) {
+		writer.Pods(renderPass.attachments);
+		writer.Pods(renderPass.colorReferences);
+		writer.Pod(renderPass.depthReference);
+		writer.Pods(renderPass.dependencies);
+	}
+
+	writer.Varint(framebuffers.size());
+	for (const Framebuffer& framebuffer : framebuffers) {
+		writer.Varint(framebuffer.renderPass);
+		WriteIndices(writer, framebuffer.attachments);
+		writer.Varint(framebuffer.extent.width);
+		writer.Varint(framebuffer.extent.height);
+	}
+
+	writer.Varint(pipelines.size());
+	for (const Pipeline& pipeline : pipelines) {
+		WritePipeline(writer, pipeline);
+	}
+
+	writer.Varint(descriptorSets.size());
+	for (const DescriptorSet& set : descriptorSets) {
+		writer.Varint(set.layout);
+		writer.Varint(set.descriptors.size());
+		for (const Descriptor& descriptor : set.descriptors) {
+			writer.Varint(descriptor.binding);
+			writer.Varint(descriptor.arrayElement);
+			writer.Varint(descriptor.type);
+			writer.Varint(descriptor.buffer);
+			writer.Varint(descriptor.offset);
+			writer.Varint(descriptor.range);
+			writer.Varint(descriptor.sampler);
+			writer.Varint(descriptor.view);
+			writer.Varint(descriptor.layout);
+		}
+	}
+
+	writer.Varint(commands.size());
+	for (const Command& command : commands) {
+		writer.Varint(uint64(command.op));
+		WriteIndices(writer, command.args);
+		writer.Blob(command.data);
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(writer.bytes.data(), writer.bytes.size());
+	if (!file) {
+		throw std::runtime_error("Couldn't write the capture " + path + ".");
+	}
+}
+
+CaptureFile CaptureFile::Load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Couldn't open the capture " + path + ".");
+	}
+	std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Reader reader(bytes);
+	if (reader.Pod<uint>() != magic) {
+		throw std::runtime_error("Couldn't read the capture, " + path + " isn't one.");
+	}
+	if (reader.Pod<uint>() != version) {
+		throw std::runtime_error("Couldn't read the capture, it was written by another version.");
+	}
+
+	CaptureFile capture;
+	capture.deviceName = reader.Blob();
+	capture.frame = reader.Varint();
+	capture.multiDrawIndirect = reader.Varint() != 0;
+	capture.drawIndirectFirstInstance = reader.Varint() != 0;
+	capture.drawIndirectCount = reader.Varint() != 0;
+	capture.descriptorIndexing = reader.Varint() != 0;
+
+	capture.buffers.resize(reader.Count(1));
+	for (Buffer& buffer : capture.buffers) {
+		buffer.size = reader.Varint();
+		buffer.usage = VkBufferUsageFlags(reader.Varint());
+		buffer.data = reader.Blob();
+	}
+
+	capture.images.resize(reader.Count(1));
+	for (Image& image : capture.images) {
+		image.format = reader.Enum<VkFormat>();
+		image.extent.width = uint(reader.Varint());
+		image.extent.height = uint(reader.Varint());
+		image.mipLevels = uint(reader.Varint());
+		image.usage = VkImageUsageFlags(reader.Varint());
+		image.layout = reader.Enum<VkImageLayout>();
+		image.levels.resize(reader.Count(1));
+		for (std::string& level : image.levels) {
+			level = reader.Blob();
+		}
+	}
+
+	capture.imageViews.resize(reader.Count(1));
+	for (ImageView& view : capture.imageViews) {
+		view.image = reader.Varint();
+		view.format = reader.Enum<VkFormat>();
+		view.aspect = VkImageAspectFlags(reader.Varint());
+		view.mipLevels = uint(reader.Varint());
+	}
+
+	capture.samplers.resize(reader.Count(1));
+	for (Sampler& sampler : capture.samplers) {
+		sampler.info = ReadSampler(reader);
+	}
+
+	capture.shaderModules.resize(reader.Count(1));
+	for (ShaderModule& module : capture.shaderModules) {
+		module.code = reader.Blob();
+	}
+
+	capture.setLayouts.resize(reader.Count(1));
+	for (SetLayout& layout : capture.setLayouts) {
+		layout.flags = VkDescriptorSetLayoutCreateFlags(reader.Varint());
+		layout.bindings.resize(reader.Count(1));
+		for (SetLayoutBinding& binding : layout.bindings) {
+			binding.binding = uint(reader.Varint());
+			binding.type = reader.Enum<VkDescriptorType>();
+			binding.count = uint(reader.Varint());
+			binding.stages = VkShaderStageFlags(reader.Varint());
+			binding.flags = VkDescriptorBindingFlags(reader.Varint());
+		}
+	}
+
+	capture.pipelineLayouts.resize(reader.Count(1));
+	for (PipelineLayout& layout : capture.pipelineLayouts) {
+		layout.setLayouts = ReadIndices(reader);
+		layout.pushConstants = reader.Pods<VkPushConstantRange>();
+	}
+
+	capture.renderPasses.resize(reader.Count(1));
+	for (RenderPass& renderPass : capture.renderPasses) {
+		renderPass.attachments = reader.Pods<VkAttachmentDescription>();
+		renderPass.colorReferences = reader.Pods<VkAttachmentReference>();
+		renderPass.depthReference = reader.Pod<VkAttachmentReference>();
+		renderPass.dependencies = reader.Pods<VkSubpassDependency>();
+	}
+
+	capture.framebuffers.resize(reader.Count(1));
+	for (Framebuffer& framebuffer : capture.framebuffers) {
+		framebuffer.renderPass = reader.Varint();
+		framebuffer.attachments = ReadIndices(reader);
+		framebuffer.extent.width = uint(reader.Varint());
+		framebuffer.extent.height = uint(reader.Varint());
+	}
+
+	capture.pipelines.resize(reader.Count(1));
+	for (Pipeline& pipeline : capture.pipelines) {
+		pipeline = ReadPipeline(reader);
+	}
+
+	capture.descriptorSets.resize(reader.Count(1));
+	for (DescriptorSet& set : capture.descriptorSets) {
+		set.layout = reader.Varint();
+		set.descriptors.resize(reader.Count(1));
+		for (Descriptor& descriptor : set.descriptors) {
+			descriptor.binding = uint(reader.Varint());
+			descriptor.arrayElement = uint(reader.Varint());
+			descriptor.type = reader.Enum<VkDescriptorType>();
+			descriptor.buffer = reader.Varint();
+			descriptor.offset = reader.Varint();
+			descriptor.range = reader.Varint();
+			descriptor.sampler = reader.Varint();
+			descriptor.view = reader.Varint();
+			descriptor.layout = reader.Enum<VkImageLayout>();
+		}
+	}
+
+	capture.commands.resize(reader.Count(1));
+	for (Command& command : capture.commands) {
+		command.op = reader.Enum<Op>();
+		if (command.op > Op::DrawIndexedIndirectCount) {
+			throw std::runtime_error("Couldn't read the capture, it has an unknown command.");
+		}
+		command.args = ReadIndices(reader);
+		command.data = reader.Blob();
+	}
+
+	if (!reader.AtEnd()) {
+		throw std::runtime_error("Couldn't read the capture, it has trailing data.");
+	}
+	Validate(capture);
+	return capture;
+}
+
+VkDeviceSize CaptureFile::ContentBytes() const {
+	VkDeviceSize bytes = 0;
+	for (const Buffer& buffer : buffers) {
+		bytes += buffer.data.size();
+	}
+	for (const Image& image : images) {
+		for (const std::string& level : image.levels) {
+			bytes += level.size();
+		}
+	}
+	return bytes;
+}
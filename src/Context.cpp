@@ -0,0 +1,243 @@
+#include "Context.hpp"
+#include "FrameCapture.hpp"
+
+bool Context::HasExtension(const std::string& name) const {
+	return enabledExtensions.count(name) > 0;
+}
+
+uint Context::FindMemoryType(uint typeFilter, VkMemoryPropertyFlags flags) const {
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	for (uint i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		bool correctBit = typeFilter & (1 << i);
+		bool flagsPresent = (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags;
+		if (correctBit and flagsPresent) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Couldn't find a suitable memory type.");
+}
+
+VkDeviceMemory Context::AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, VkDeviceSize requested, const std::string& tag) const {
+	VkMemoryAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = requirements.size;
+	allocInfo.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+
+	VkDeviceMemory memory;
+	VkResult result;
+	if (memoryTracker != nullptr) {
+		result = memoryTracker->Allocate(device, allocInfo, requested, tag, memory);
+	} else {
+		result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+	}
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate memory for " + tag + ".");
+	}
+	return memory;
+}
+
+void Context::FreeMemory(VkDeviceMemory memory) const {
+	if (memoryTracker != nullptr) {
+		memoryTracker->Free(device, memory);
+	} else {
+		vkFreeMemory(device, memory, nullptr);
+	}
+}
+
+void Context::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory, const std::vector<uint>& queueFamilies) const {
+	std::set<uint> uniqueFamilies(queueFamilies.begin(), queueFamilies.end());
+	std::vector<uint> families(uniqueFamilies.begin(), uniqueFamilies.end());
+
+	VkBufferCreateInfo bufferInfo {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	//? So a capture can copy the contents out
+	bufferInfo.usage = FrameCapture::Enabled() ? usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT : usage;
+	if (families.size() > 1) {
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = uint(families.size());
+		bufferInfo.pQueueFamilyIndices = families.data();
+	} else {
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	bufferInfo.flags = 0;
+
+	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a buffer.");
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+	std::stringstream tag;
+	tag << "buffer of " << size << " bytes, usage 0x" << std::hex << usage;
+	memory = AllocateMemory(requirements, properties, size, tag.str());
+
+	vkBindBufferMemory(device, buffer, memory, 0);
+	FrameCapture::AddBuffer(buffer, size, usage);
+}
+
+void Context::DestroyBuffer(VkBuffer buffer, VkDeviceMemory memory) const {
+	FrameCapture::RemoveBuffer(buffer);
+	vkDestroyBuffer(device, buffer, nullptr);
+	FreeMemory(memory);
+}
+
+void Context::CreateImage(VkExtent2D extent, uint mipLevels, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory) const {
+	VkImageCreateInfo imageInfo {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent = { extent.width, extent.height, 1 };
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = FrameCapture::Enabled() ? usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT : usage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create an image.");
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image, &requirements);
+
+	std::stringstream tag;
+	tag << "image " << extent.width << "x" << extent.height << ", " << mipLevels << " levels, format " << format;
+	//? Image sizes aren't known up front, so requirements count as requested
+	memory = AllocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, requirements.size, tag.str());
+
+	vkBindImageMemory(device, image, memory, 0);
+	FrameCapture::AddImage(image, extent, mipLevels, format, usage);
+}
+
+VkImageView Context::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect, uint mipLevels) const {
+	VkImageViewCreateInfo viewInfo {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspect;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView imageView;
+	if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create an image view.");
+	}
+	FrameCapture::AddImageView(imageView, image, format, aspect, mipLevels);
+	return imageView;
+}
+
+void Context::DestroyImage(VkImage image, VkDeviceMemory memory) const {
+	FrameCapture::RemoveImage(image);
+	vkDestroyImage(device, image, nullptr);
+	FreeMemory(memory);
+}
+
+void Context::UploadBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize offset) const {
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
+
+	void* mapped;
+	vkMapMemory(device, stagingMemory, 0, size, 0, &mapped);
+	memcpy(mapped, data, size);
+	vkUnmapMemory(device, stagingMemory);
+
+	ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+		VkBufferCopy region {};
+		region.srcOffset = 0;
+		region.dstOffset = offset;
+		region.size = size;
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffer, 1, &region);
+	});
+
+	DestroyBuffer(stagingBuffer, stagingMemory);
+}
+
+void Context::ImmediateSubmit(const std::function<void(VkCommandBuffer)>& record) const {
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	VkCommandPool commandPool;
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a command pool.");
+	}
+
+	VkCommandBufferAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate command buffers.");
+	}
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	record(commandBuffer);
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Coudln't record a command buffer.");
+	}
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't submit a command buffer.");
+	}
+	vkQueueWaitIdle(graphicsQueue);
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+}
+
+VkShaderModule Context::CreateShaderModule(const std::string& code) const {
+	VkShaderModuleCreateInfo createInfo {};
+
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32*>(code.data());
+	
+	VkShaderModule module;
+	if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a shader module.");
+	}
+	FrameCapture::AddShaderModule(module, code);
+	return module;
+}
+
+std::string Context::ReadFile(const std::string& path) {
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	
+	if (!file.is_open()) {
+		throw std::runtime_error("Couldn't open the shader.");
+	}
+
+	uint fileSize = file.tellg();
+
+	std::string res;
+	res.resize(fileSize);
+
+	file.seekg(0);
+	file.read(res.data(), fileSize);
+	file.close();
+
+	return res;
+}
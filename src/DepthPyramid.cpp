@@ -0,0 +1,234 @@
+#include "DepthPyramid.hpp"
+
+namespace {
+	//? Has to match the local size in depthreduce.comp
+	const uint reduceGroupSize = 8;
+
+	uint PreviousPowerOfTwo(uint value) {
+		uint result = 1;
+		while (result * 2 <= value) {
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+void DepthPyramid::Init(const Context& context, DescriptorLayoutCache& layoutCache, VkImageView depthView, VkExtent2D depthExtent) {
+	this->context = context;
+	this->depthExtent = depthExtent;
+
+	//? A power of two keeps every reduction after the first an exact 2x2
+	extent = { PreviousPowerOfTwo(depthExtent.width), PreviousPowerOfTwo(depthExtent.height) };
+	levels = 1;
+	while ((extent.width >> levels) > 0 or (extent.height >> levels) > 0) {
+		levels++;
+	}
+
+	CreateImage();
+	CreateDescriptors(layoutCache, depthView);
+	CreatePipeline();
+}
+
+void DepthPyramid::CleanUp() {
+	vkDestroyPipeline(context.device, pipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+	descriptorAllocator.CleanUp();
+	vkDestroySampler(context.device, sampler, nullptr);
+	for (VkImageView levelView : levelViews) {
+		vkDestroyImageView(context.device, levelView, nullptr);
+	}
+	vkDestroyImageView(context.device, view, nullptr);
+	context.DestroyImage(image, memory);
+}
+
+void DepthPyramid::CreateImage() {
+	context.CreateImage(extent, levels, VK_FORMAT_R32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, image, memory);
+	view = context.CreateImageView(image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, levels);
+
+	levelViews.resize(levels);
+	for (uint i = 0; i < levels; i++) {
+		VkImageViewCreateInfo viewInfo {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = i;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(context.device, &viewInfo, nullptr, &levelViews[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create an image view.");
+		}
+	}
+
+	//? Only ever read with texelFetch, filtering doesn't matter
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = float(levels);
+
+	if (vkCreateSampler(context.device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a sampler.");
+	}
+
+	//? Cleared to the far plane, so a pyramid read before its first build hides nothing
+	context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+		VkImageMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkClearColorValue far {};
+		far.float32[0] = 1.0f;
+		vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, &far, 1, &barrier.subresourceRange);
+	});
+}
+
+void DepthPyramid::CreateDescriptors(DescriptorLayoutCache& layoutCache, VkImageView depthView) {
+	std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	setLayout = layoutCache.Get(bindings);
+
+	descriptorAllocator.Init(context.device, levels);
+	sets.resize(levels);
+	for (uint i = 0; i < levels; i++) {
+		sets[i] = descriptorAllocator.Allocate(setLayout);
+
+		VkDescriptorImageInfo sourceInfo {};
+		sourceInfo.sampler = sampler;
+		sourceInfo.imageView = i == 0 ? depthView : levelViews[i - 1];
+		sourceInfo.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo destinationInfo {};
+		destinationInfo.imageView = levelViews[i];
+		destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		std::array<VkWriteDescriptorSet, 2> writes {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = sets[i];
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &sourceInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = sets[i];
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &destinationInfo;
+		vkUpdateDescriptorSets(context.device, writes.size(), writes.data(), 0, nullptr);
+	}
+}
+
+void DepthPyramid::CreatePipeline() {
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(ReduceConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+	pipeline = BuildPipeline();
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline DepthPyramid::BuildPipeline() const {
+	VkShaderModule module = context.CreateShaderModule(Context::ReadFile("src/Shaders/depthreduce.comp.spv"));
+
+	VkComputePipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+
+	VkPipeline built;
+	VkResult result = vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built);
+	vkDestroyShaderModule(context.device, module, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a compute pipeline.");
+	}
+	return built;
+}
+
+void DepthPyramid::RegisterShaders(ShaderReloader& reloader) {
+	reloader.Register("depth pyramid", { "src/Shaders/depthreduce.comp" }, pipeline, [this] { return BuildPipeline(); });
+}
+
+void DepthPyramid::Build(VkCommandBuffer commandBuffer) {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+	for (uint i = 0; i < levels; i++) {
+		VkExtent2D source = i == 0 ? depthExtent : LevelExtent(i - 1);
+		VkExtent2D destination = LevelExtent(i);
+
+		ReduceConstants constants {};
+		constants.sourceSize = glm::ivec2(source.width, source.height);
+		constants.destinationSize = glm::ivec2(destination.width, destination.height);
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &sets[i], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReduceConstants), &constants);
+		vkCmdDispatch(commandBuffer, (destination.width + reduceGroupSize - 1) / reduceGroupSize, (destination.height + reduceGroupSize - 1) / reduceGroupSize, 1);
+
+		//? The next level reads this one
+		VkMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+VkImageView DepthPyramid::View() const {
+	return view;
+}
+
+VkSampler DepthPyramid::Sampler() const {
+	return sampler;
+}
+
+VkExtent2D DepthPyramid::Extent() const {
+	return extent;
+}
+
+uint DepthPyramid::Levels() const {
+	return levels;
+}
+
+VkExtent2D DepthPyramid::LevelExtent(uint level) const {
+	return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+}
@@ -0,0 +1,314 @@
+#include "Descriptors.hpp"
+#include "FrameCapture.hpp"
+
+void DescriptorAllocator::Init(VkDevice device, uint setsPerPool) {
+	this->device = device;
+	this->setsPerPool = setsPerPool;
+}
+
+void DescriptorAllocator::CleanUp() {
+	for (VkDescriptorPool pool : usedPools) {
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	}
+	for (VkDescriptorPool pool : freePools) {
+		vkDestroyDescriptorPool(device, pool, nullptr);
+	}
+	usedPools.clear();
+	freePools.clear();
+	currentPool = VK_NULL_HANDLE;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+	if (currentPool == VK_NULL_HANDLE) {
+		currentPool = GrabPool();
+		usedPools.push_back(currentPool);
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = currentPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet set;
+	VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+
+	//? The pool ran dry, move on to a fresh one and retry once
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY or result == VK_ERROR_FRAGMENTED_POOL) {
+		currentPool = GrabPool();
+		usedPools.push_back(currentPool);
+		allocInfo.descriptorPool = currentPool;
+		result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+	}
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate a descriptor set.");
+	}
+
+	setsAllocated++;
+	FrameCapture::AddDescriptorSet(set, layout);
+	return set;
+}
+
+void DescriptorAllocator::Reset() {
+	for (VkDescriptorPool pool : usedPools) {
+		vkResetDescriptorPool(device, pool, 0);
+		freePools.push_back(pool);
+	}
+	usedPools.clear();
+	currentPool = VK_NULL_HANDLE;
+	setsAllocated = 0;
+}
+
+uint DescriptorAllocator::SetsAllocated() const {
+	return setsAllocated;
+}
+
+uint DescriptorAllocator::PoolCount() const {
+	return uint(usedPools.size() + freePools.size());
+}
+
+VkDescriptorPool DescriptorAllocator::GrabPool() {
+	if (!freePools.empty()) {
+		VkDescriptorPool pool = freePools.back();
+		freePools.pop_back();
+		return pool;
+	}
+
+	//? Descriptors per set, on average, for each type
+	const std::array<std::pair<VkDescriptorType, float>, 6> ratios = {{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	}};
+
+	std::array<VkDescriptorPoolSize, ratios.size()> poolSizes {};
+	for (uint i = 0; i < ratios.size(); i++) {
+		poolSizes[i].type = ratios[i].first;
+		poolSizes[i].descriptorCount = uint(ratios[i].second * setsPerPool);
+	}
+
+	VkDescriptorPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = 0;
+	poolInfo.maxSets = setsPerPool;
+	poolInfo.poolSizeCount = poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	VkDescriptorPool pool;
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a descriptor pool.");
+	}
+	return pool;
+}
+
+void DescriptorLayoutCache::Init(VkDevice device) {
+	this->device = device;
+}
+
+void DescriptorLayoutCache::CleanUp() {
+	for (auto& [key, layout] : layouts) {
+		vkDestroyDescriptorSetLayout(device, layout, nullptr);
+	}
+	layouts.clear();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::Get(std::vector<VkDescriptorSetLayoutBinding> bindings) {
+	std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+		return a.binding < b.binding;
+	});
+
+	LayoutKey key { bindings };
+	auto found = layouts.find(key);
+	if (found != layouts.end()) {
+		return found->second;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a descriptor set layout.");
+	}
+	FrameCapture::AddSetLayout(layout, layoutInfo);
+
+	layouts.emplace(std::move(key), layout);
+	return layout;
+}
+
+uint DescriptorLayoutCache::Size() const {
+	return uint(layouts.size());
+}
+
+bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const {
+	if (bindings.size() != other.bindings.size()) {
+		return false;
+	}
+	for (uint i = 0; i < bindings.size(); i++) {
+		const VkDescriptorSetLayoutBinding& a = bindings[i];
+		const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+		if (a.binding != b.binding or a.descriptorType != b.descriptorType or a.descriptorCount != b.descriptorCount or a.stageFlags != b.stageFlags) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const {
+	size_t hash = std::hash<size_t>()(key.bindings.size());
+	for (const VkDescriptorSetLayoutBinding& binding : key.bindings) {
+		size_t packed = binding.binding | (uint64(binding.descriptorType) << 8) | (uint64(binding.descriptorCount) << 16) | (uint64(binding.stageFlags) << 40);
+		hash ^= std::hash<size_t>()(packed) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+void BindlessTable::Init(const Context& context, uint maxBuffers, uint maxImages) {
+	device = context.device;
+
+	//? Update-after-bind sets have their own, usually far higher, limits
+	VkPhysicalDeviceDescriptorIndexingProperties indexingProperties {};
+	indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties2 {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(context.physicalDevice, &properties2);
+
+	this->maxBuffers = std::min({maxBuffers, indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers, indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers});
+	this->maxImages = std::min({maxImages, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages, indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages});
+
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+	bindings[0].binding = bufferBinding;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[0].descriptorCount = this->maxBuffers;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].binding = imageBinding;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].descriptorCount = this->maxImages;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	//? Slots are filled as resources get registered, and may change while the set is bound.
+	//? A slot can even be rewritten while frames are in flight, as long as they don't use it.
+	VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	std::array<VkDescriptorBindingFlags, 2> bindingFlags = { flags, flags };
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = bindingFlags.size();
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create the bindless descriptor set layout.");
+	}
+	FrameCapture::AddSetLayout(layout, layoutInfo);
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes {};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount = this->maxBuffers;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount = this->maxImages;
+
+	VkDescriptorPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create the bindless descriptor pool.");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate the bindless descriptor set.");
+	}
+	FrameCapture::AddDescriptorSet(set, layout);
+}
+
+void BindlessTable::CleanUp() {
+	if (layout == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroyDescriptorPool(device, pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, layout, nullptr);
+	layout = VK_NULL_HANDLE;
+}
+
+VkDescriptorSetLayout BindlessTable::Layout() const {
+	return layout;
+}
+
+VkDescriptorSet BindlessTable::Set() const {
+	return set;
+}
+
+uint BindlessTable::AddBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+	if (bufferCount >= maxBuffers) {
+		throw std::runtime_error("The bindless table is out of buffer slots.");
+	}
+
+	VkDescriptorBufferInfo bufferInfo {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = bufferBinding;
+	write.dstArrayElement = bufferCount;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+	FrameCapture::UpdateDescriptorSets(1, &write);
+	return bufferCount++;
+}
+
+uint BindlessTable::AddImage(VkImageView imageView, VkSampler sampler) {
+	if (imageCount >= maxImages) {
+		throw std::runtime_error("The bindless table is out of image slots.");
+	}
+	SetImage(imageCount, imageView, sampler);
+	return imageCount++;
+}
+
+void BindlessTable::SetImage(uint index, VkImageView imageView, VkSampler sampler) {
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = set;
+	write.dstBinding = imageBinding;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+	FrameCapture::UpdateDescriptorSets(1, &write);
+}
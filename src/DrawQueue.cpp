@@ -0,0 +1,234 @@
+#include "DrawQueue.hpp"
+#include "FrameCapture.hpp"
+
+namespace {
+	const uint depthBits = 24;
+	const uint idBits = 12;
+	const uint passBits = 4;
+}
+
+uint64 DrawQueue::Key(uint pass, uint pipeline, uint descriptorSet, uint vertexBuffer, float depth) {
+	uint64 idMask = (1ull << idBits) - 1;
+	uint64 quantized = uint64(glm::clamp(depth, 0.0f, 1.0f) * float((1u << depthBits) - 1));
+	uint64 key = uint64(pass & ((1u << passBits) - 1)) << (depthBits + 3 * idBits);
+	key |= (pipeline & idMask) << (depthBits + 2 * idBits);
+	key |= (descriptorSet & idMask) << (depthBits + idBits);
+	key |= (vertexBuffer & idMask) << depthBits;
+	return key | quantized;
+}
+
+void DrawQueue::Init(uint capacity) {
+	this->capacity = capacity;
+	if (Settings::drawSortThreads > 1 and capacity >= Settings::drawSortParallelThreshold) {
+		workers = std::make_unique<ThreadPool>(Settings::drawSortThreads);
+		histograms.resize(workers->ThreadCount());
+	}
+}
+
+void DrawQueue::Begin(FrameArena& arena) {
+	packets = ArenaVector<Packet>(arena);
+	keys = ArenaVector<uint64>(arena);
+	order = ArenaVector<uint>(arena);
+	scratchKeys = ArenaVector<uint64>(arena);
+	scratchOrder = ArenaVector<uint>(arena);
+	packets.reserve(capacity);
+	keys.reserve(capacity);
+	order.reserve(capacity);
+	scratchKeys.reserve(capacity);
+	scratchOrder.reserve(capacity);
+}
+
+void DrawQueue::Add(uint64 key, const Packet& packet) {
+	order.push_back(packets.size());
+	keys.push_back(key);
+	packets.push_back(packet);
+}
+
+void DrawQueue::Sort() {
+	auto start = std::chrono::steady_clock::now();
+
+	scratchKeys.resize(keys.size());
+	scratchOrder.resize(order.size());
+	if (!keys.empty()) {
+		if (workers != nullptr and keys.size() >= Settings::drawSortParallelThreshold) {
+			SortParallel();
+			parallelSorts++;
+		} else {
+			SortSerial();
+		}
+	}
+
+	frames++;
+	sortSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//? Least significant digit first, every pass is stable so the earlier digits stay ordered
+void DrawQueue::SortSerial() {
+	uint count = keys.size();
+	//? All the passes' histograms in one sweep, the counts don't depend on the order
+	std::array<std::array<uint, radixBuckets>, radixPasses> counts {};
+	for (uint i = 0; i < count; i++) {
+		uint64 key = keys[i];
+		for (uint pass = 0; pass < radixPasses; pass++) {
+			counts[pass][(key >> (pass * radixBits)) & (radixBuckets - 1)]++;
+		}
+	}
+
+	for (uint pass = 0; pass < radixPasses; pass++) {
+		uint shift = pass * radixBits;
+		//? Every key has the same digit here, usually the pass and pipeline bits
+		if (counts[pass][(keys[0] >> shift) & (radixBuckets - 1)] == count) {
+			continue;
+		}
+
+		uint running = 0;
+		for (uint& bucket : counts[pass]) {
+			uint size = bucket;
+			bucket = running;
+			running += size;
+		}
+		Scatter(0, count, shift, counts[pass]);
+		std::swap(keys, scratchKeys);
+		std::swap(order, scratchOrder);
+		radixPassesRun++;
+	}
+}
+
+//? Each worker histograms and scatters its own chunk, the offsets go bucket by bucket
+//? and chunk by chunk inside a bucket, which keeps the passes stable
+void DrawQueue::SortParallel() {
+	uint chunks = histograms.size();
+	for (uint pass = 0; pass < radixPasses; pass++) {
+		uint shift = pass * radixBits;
+
+		for (uint chunk = 0; chunk < chunks; chunk++) {
+			workers->Submit([this, chunk, shift] {
+				uint chunkSize = (keys.size() + histograms.size() - 1) / histograms.size();
+				uint begin = std::min(chunk * chunkSize, uint(keys.size()));
+				uint end = std::min(begin + chunkSize, uint(keys.size()));
+				std::array<uint, radixBuckets>& histogram = histograms[chunk];
+				histogram.fill(0);
+				for (uint i = begin; i < end; i++) {
+					histogram[(keys[i] >> shift) & (radixBuckets - 1)]++;
+				}
+			});
+		}
+		workers->Wait();
+
+		uint digit = (keys[0] >> shift) & (radixBuckets - 1);
+		uint matching = 0;
+		for (const std::array<uint, radixBuckets>& histogram : histograms) {
+			matching += histogram[digit];
+		}
+		if (matching == keys.size()) {
+			continue;
+		}
+
+		uint running = 0;
+		for (uint bucket = 0; bucket < radixBuckets; bucket++) {
+			for (std::array<uint, radixBuckets>& histogram : histograms) {
+				uint size = histogram[bucket];
+				histogram[bucket] = running;
+				running += size;
+			}
+		}
+
+		for (uint chunk = 0; chunk < chunks; chunk++) {
+			workers->Submit([this, chunk, shift] {
+				uint chunkSize = (keys.size() + histograms.size() - 1) / histograms.size();
+				uint begin = std::min(chunk * chunkSize, uint(keys.size()));
+				uint end = std::min(begin + chunkSize, uint(keys.size()));
+				Scatter(begin, end, shift, histograms[chunk]);
+			});
+		}
+		workers->Wait();
+
+		std::swap(keys, scratchKeys);
+		std::swap(order, scratchOrder);
+		radixPassesRun++;
+	}
+}
+
+void DrawQueue::Scatter(uint begin, uint end, uint shift, std::array<uint, radixBuckets>& offsets) {
+	for (uint i = begin; i < end; i++) {
+		uint slot = offsets[(keys[i] >> shift) & (radixBuckets - 1)]++;
+		scratchKeys[slot] = keys[i];
+		scratchOrder[slot] = order[i];
+	}
+}
+
+void DrawQueue::Record(VkCommandBuffer commandBuffer, FrameStats& stats) {
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+	VkDescriptorSet sets[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+	uint setCount = 0;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+
+	FrameStats recorded {};
+	for (uint index : order) {
+		const Packet& packet = packets[index];
+
+		if (packet.pipeline != pipeline) {
+			FrameCapture::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+			pipeline = packet.pipeline;
+			recorded.pipelineBinds++;
+		} else {
+			skipped.pipelineBinds++;
+		}
+
+		//? Sets bound with another layout may not be compatible, those are bound again regardless
+		bool setsMatch = packet.layout == layout and packet.setCount == setCount;
+		for (uint i = 0; setsMatch and i < setCount; i++) {
+			setsMatch = packet.sets[i] == sets[i];
+		}
+		if (!setsMatch) {
+			FrameCapture::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.layout, 0, packet.setCount, packet.sets, 0, nullptr);
+			layout = packet.layout;
+			setCount = packet.setCount;
+			std::copy(packet.sets, packet.sets + packet.setCount, sets);
+			recorded.descriptorSetBinds++;
+		} else {
+			skipped.descriptorSetBinds++;
+		}
+
+		//? Vertex and index buffer count as one bind, like everywhere else
+		if (packet.vertexBuffer != vertexBuffer or packet.indexBuffer != indexBuffer) {
+			if (packet.vertexBuffer != vertexBuffer) {
+				VkDeviceSize offset = 0;
+				FrameCapture::CmdBindVertexBuffers(commandBuffer, 0, 1, &packet.vertexBuffer, &offset);
+				vertexBuffer = packet.vertexBuffer;
+			}
+			if (packet.indexBuffer != indexBuffer and packet.indexBuffer != VK_NULL_HANDLE) {
+				FrameCapture::CmdBindIndexBuffer(commandBuffer, packet.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				indexBuffer = packet.indexBuffer;
+			}
+			recorded.vertexBufferBinds++;
+		} else {
+			skipped.vertexBufferBinds++;
+		}
+
+		if (packet.indexBuffer != VK_NULL_HANDLE) {
+			FrameCapture::CmdDrawIndexed(commandBuffer, packet.count, 1, packet.first, packet.vertexOffset, packet.firstInstance);
+		} else {
+			FrameCapture::CmdDraw(commandBuffer, packet.count, 1, packet.first, packet.firstInstance);
+		}
+		recorded.draws++;
+	}
+
+	packetsRecorded += packets.size();
+	binds += recorded;
+	stats += recorded;
+}
+
+void DrawQueue::PrintStats(const std::string& name) {
+	double frameCount = double(std::max(frames, uint64(1)));
+	std::cout << name << " draw queue:\n";
+	std::cout << "\tPackets per frame: " << packetsRecorded / frameCount << "\n";
+	std::cout << "\tBinds per frame: " << binds.pipelineBinds / frameCount << " pipeline (" << skipped.pipelineBinds / frameCount << " skipped), ";
+	std::cout << binds.descriptorSetBinds / frameCount << " descriptor set (" << skipped.descriptorSetBinds / frameCount << " skipped), ";
+	std::cout << binds.vertexBufferBinds / frameCount << " vertex buffer (" << skipped.vertexBufferBinds / frameCount << " skipped)\n";
+	std::cout << "\tSort: " << sortSeconds / frameCount * 1000000.0 << " us per frame, " << radixPassesRun / frameCount << " of " << radixPasses << " radix passes";
+	std::cout << ", " << double(parallelSorts) / frameCount * 100.0 << "% on " << (workers != nullptr ? workers->ThreadCount() : 1) << " threads\n";
+	std::cout << std::endl;
+}
@@ -0,0 +1,221 @@
+#include "DrawStreamCache.hpp"
+#include "FrameCapture.hpp"
+
+namespace {
+	//? Enough for every stream of a frame, so queueing never allocates
+	const uint maxQueued = 16;
+	const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo DynamicStateInfo() {
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
+		dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicStateInfo.dynamicStateCount = 2;
+		dynamicStateInfo.pDynamicStates = dynamicStates;
+		return dynamicStateInfo;
+	}
+}
+
+const VkPipelineDynamicStateCreateInfo DrawStreamCache::dynamicState = DynamicStateInfo();
+
+void DrawStreamCache::Init(const Context& context) {
+	this->context = context;
+
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = context.graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &staticPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a command pool.");
+	}
+
+	//? Dynamic buffers live for one frame, the driver can allocate them accordingly
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	dynamicPools.resize(Settings::maxFramesInFlight);
+	for (VkCommandPool& pool : dynamicPools) {
+		if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a command pool.");
+		}
+	}
+	dynamicEntries.resize(Settings::maxFramesInFlight);
+	dynamicUsed.assign(Settings::maxFramesInFlight, 0);
+	queued.reserve(maxQueued);
+}
+
+void DrawStreamCache::CleanUp() {
+	for (VkCommandPool pool : dynamicPools) {
+		vkDestroyCommandPool(context.device, pool, nullptr);
+	}
+	vkDestroyCommandPool(context.device, staticPool, nullptr);
+}
+
+uint DrawStreamCache::AddStream(const std::string& name) {
+	names.push_back(name);
+	streamRecords.push_back(0);
+	for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+		Entry entry {};
+		entry.commandBuffer = AllocateSecondary(staticPool);
+		staticEntries.push_back(entry);
+	}
+	return names.size() - 1;
+}
+
+uint64 DrawStreamCache::Hash(uint64 seed, uint64 value) {
+	//? boost::hash_combine, widened to 64 bits
+	return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+}
+
+void DrawStreamCache::Invalidate() {
+	for (Entry& entry : staticEntries) {
+		entry.valid = false;
+	}
+}
+
+void DrawStreamCache::SetViewport(VkExtent2D extent) {
+	viewport = extent;
+}
+
+void DrawStreamCache::BeginFrame(uint frameIndex) {
+	currentFrame = frameIndex;
+	if (dynamicUsed[frameIndex] > 0) {
+		vkResetCommandPool(context.device, dynamicPools[frameIndex], 0);
+	}
+	dynamicUsed[frameIndex] = 0;
+	frames++;
+}
+
+DrawStreamCache::Recording DrawStreamCache::BeginStatic(uint stream, uint frameIndex, uint64 key, VkRenderPass renderPass) {
+	uint index = stream * Settings::maxFramesInFlight + frameIndex;
+	Entry& entry = staticEntries[index];
+
+	Recording recording {};
+	recording.commandBuffer = entry.commandBuffer;
+	recording.dynamic = false;
+	recording.entry = index;
+	//? The render pass and viewport are part of the key too, a recording only works inside a compatible pass
+	key = Hash(key, uint64(renderPass));
+	key = Hash(key, uint64(viewport.width) << 32 | viewport.height);
+	recording.record = !entry.valid or entry.key != key;
+	if (!recording.record) {
+		hits++;
+		return recording;
+	}
+
+	misses++;
+	streamRecords[stream]++;
+	entry.key = key;
+	//? The slot's fence has signaled, so the buffer isn't pending anymore
+	vkResetCommandBuffer(entry.commandBuffer, 0);
+	Begin(entry.commandBuffer, renderPass);
+	return recording;
+}
+
+DrawStreamCache::Recording DrawStreamCache::BeginDynamic(uint frameIndex, VkRenderPass renderPass) {
+	std::vector<Entry>& entries = dynamicEntries[frameIndex];
+	if (dynamicUsed[frameIndex] == entries.size()) {
+		Entry entry {};
+		entry.commandBuffer = AllocateSecondary(dynamicPools[frameIndex]);
+		entries.push_back(entry);
+	}
+
+	Recording recording {};
+	recording.entry = dynamicUsed[frameIndex]++;
+	recording.commandBuffer = entries[recording.entry].commandBuffer;
+	recording.dynamic = true;
+	recording.record = true;
+
+	dynamicRecords++;
+	Begin(recording.commandBuffer, renderPass);
+	return recording;
+}
+
+void DrawStreamCache::Begin(VkCommandBuffer commandBuffer, VkRenderPass renderPass) {
+	recordStart = std::chrono::steady_clock::now();
+
+	VkCommandBufferInheritanceInfo inheritanceInfo {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = VK_NULL_HANDLE;
+
+	//? No ONE_TIME_SUBMIT, static buffers run again every time their slot comes around
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't begin recording a command buffer.");
+	}
+	FrameCapture::BeginSecondary(commandBuffer);
+
+	//? Secondaries don't inherit dynamic state from the primary. The frame renders at a size that
+	//? changes with dynamic resolution, so the pipelines take both as dynamic state, see dynamicState
+	VkViewport viewportRect {};
+	viewportRect.width = float(viewport.width);
+	viewportRect.height = float(viewport.height);
+	viewportRect.minDepth = 0.0f;
+	viewportRect.maxDepth = 1.0f;
+	FrameCapture::CmdSetViewport(commandBuffer, 0, 1, &viewportRect);
+
+	VkRect2D scissor {};
+	scissor.offset = {0, 0};
+	scissor.extent = viewport;
+	FrameCapture::CmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void DrawStreamCache::End(const Recording& recording) {
+	Entry& entry = recording.dynamic ? dynamicEntries[currentFrame][recording.entry] : staticEntries[recording.entry];
+	if (recording.record) {
+		if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Coudln't record a command buffer.");
+		}
+		entry.stats = recording.stats;
+		entry.valid = true;
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - recordStart).count();
+		(recording.dynamic ? dynamicSeconds : staticSeconds) += seconds;
+	}
+
+	if (queued.size() == maxQueued) {
+		throw std::runtime_error("Too many draw streams queued.");
+	}
+	queued.push_back(recording.commandBuffer);
+	queuedStats += entry.stats;
+}
+
+void DrawStreamCache::Execute(VkCommandBuffer commandBuffer, FrameStats& stats) {
+	if (!queued.empty()) {
+		FrameCapture::CmdExecuteCommands(commandBuffer, queued.size(), queued.data());
+	}
+	stats += queuedStats;
+	queued.clear();
+	queuedStats = {};
+}
+
+VkCommandBuffer DrawStreamCache::AllocateSecondary(VkCommandPool pool) {
+	VkCommandBufferAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = pool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(context.device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate command buffers.");
+	}
+	return commandBuffer;
+}
+
+void DrawStreamCache::PrintStats() {
+	double frameCount = double(std::max(frames, uint64(1)));
+	uint64 lookups = std::max(hits + misses, uint64(1));
+	std::cout << "Draw streams:\n";
+	std::cout << "\tStatic per frame: " << hits / frameCount << " cached, " << misses / frameCount << " recorded (" << double(hits) / lookups * 100.0 << "% hits)\n";
+	std::cout << "\tDynamic per frame: " << dynamicRecords / frameCount << " recorded\n";
+	std::cout << "\tRecording per frame: " << staticSeconds / frameCount * 1000000.0 << " us static, " << dynamicSeconds / frameCount * 1000000.0 << " us dynamic\n";
+	for (uint i = 0; i < names.size(); i++) {
+		std::cout << "\t" << names[i] << ": recorded " << streamRecords[i] << " times\n";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,363 @@
+#include "EntityStore.hpp"
+#include <random>
+
+void EntityStore::Reserve(uint count) {
+	positions.reserve(count);
+	rotations.reserve(count);
+	scales.reserve(count);
+	localBounds.reserve(count);
+	bounds.reserve(count);
+	meshes.reserve(count);
+	materials.reserve(count);
+	flags.reserve(count);
+	dirty.reserve((count + 63) / 64);
+	rowSlots.reserve(count);
+	slotRows.reserve(count);
+	generations.reserve(count);
+}
+
+void EntityStore::Create(const Desc* descs, uint count, Entity* handles) {
+	uint first = Size();
+	Resize(first + count);
+
+	for (uint i = 0; i < count; i++) {
+		uint row = first + i;
+		const Desc& desc = descs[i];
+		positions[row] = desc.position;
+		rotations[row] = desc.rotation;
+		scales[row] = desc.scale;
+		localBounds[row] = desc.localBounds;
+		meshes[row] = desc.mesh;
+		materials[row] = desc.material;
+		flags[row] = desc.flags;
+
+		uint slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		} else {
+			slot = slotRows.size();
+			slotRows.push_back(0);
+			generations.push_back(0);
+		}
+		slotRows[slot] = row;
+		rowSlots[row] = slot;
+		handles[i] = { slot, generations[slot] };
+	}
+
+	UpdateBounds(first, first + count);
+	MarkDirty(first, first + count);
+}
+
+void EntityStore::Destroy(const Entity* handles, uint count) {
+	for (uint i = 0; i < count; i++) {
+		if (!Alive(handles[i])) {
+			continue;
+		}
+		uint row = slotRows[handles[i].slot];
+		uint last = Size() - 1;
+		//? The moved row has to go up again at its new place
+		if (row != last) {
+			MoveRow(last, row);
+			SetDirty(row, true);
+		}
+		SetDirty(last, false);
+		Resize(last);
+
+		generations[handles[i].slot]++;
+		freeSlots.push_back(handles[i].slot);
+	}
+}
+
+bool EntityStore::Alive(Entity entity) const {
+	return entity.slot < generations.size() and generations[entity.slot] == entity.generation;
+}
+
+uint EntityStore::Row(Entity entity) const {
+	return slotRows[entity.slot];
+}
+
+EntityStore::Entity EntityStore::Handle(uint row) const {
+	uint slot = rowSlots[row];
+	return { slot, generations[slot] };
+}
+
+uint EntityStore::Size() const {
+	return positions.size();
+}
+
+glm::vec3* EntityStore::Positions() {
+	return positions.data();
+}
+
+glm::quat* EntityStore::Rotations() {
+	return rotations.data();
+}
+
+float* EntityStore::Scales() {
+	return scales.data();
+}
+
+uint* EntityStore::Meshes() {
+	return meshes.data();
+}
+
+uint* EntityStore::Materials() {
+	return materials.data();
+}
+
+uint8* EntityStore::EntityFlags() {
+	return flags.data();
+}
+
+const glm::vec3* EntityStore::Positions() const {
+	return positions.data();
+}
+
+const glm::quat* EntityStore::Rotations() const {
+	return rotations.data();
+}
+
+const float* EntityStore::Scales() const {
+	return scales.data();
+}
+
+const glm::vec4* EntityStore::Bounds() const {
+	return bounds.data();
+}
+
+const uint* EntityStore::Meshes() const {
+	return meshes.data();
+}
+
+const uint* EntityStore::Materials() const {
+	return materials.data();
+}
+
+const uint8* EntityStore::EntityFlags() const {
+	return flags.data();
+}
+
+void EntityStore::MarkDirty(uint begin, uint end) {
+	//? A word at a time, the first and last ones partially
+	for (uint row = begin; row < end;) {
+		uint bit = row % 64;
+		uint span = std::min(64 - bit, end - row);
+		uint64 mask = span == 64 ? ~0ull : ((1ull << span) - 1) << bit;
+		dirty[row / 64] |= mask;
+		row += span;
+	}
+}
+
+void EntityStore::UpdateBounds(uint begin, uint end) {
+	for (uint row = begin; row < end; row++) {
+		glm::vec3 center = glm::mat3_cast(rotations[row]) * (glm::vec3(localBounds[row]) * scales[row]);
+		bounds[row] = glm::vec4(positions[row] + center, localBounds[row].w * scales[row]);
+	}
+}
+
+glm::mat4 EntityStore::Model(uint row) const {
+	glm::mat4 model = glm::mat4(glm::mat3_cast(rotations[row]) * scales[row]);
+	model[3] = glm::vec4(positions[row], 1.0f);
+	return model;
+}
+
+void EntityStore::CollectDirtyRanges(uint mergeGap, std::vector<Range>& ranges) {
+	uint first = ranges.size();
+	for (uint word = 0; word < dirty.size(); word++) {
+		uint64 bits = dirty[word];
+		if (bits == 0) {
+			continue;
+		}
+		dirty[word] = 0;
+
+		//? Each run of set bits is a range, clean words are skipped whole
+		while (bits != 0) {
+			uint bit = __builtin_ctzll(bits);
+			uint64 shifted = ~(bits >> bit);
+			uint run = shifted == 0 ? 64 - bit : std::min(uint(__builtin_ctzll(shifted)), 64 - bit);
+			bits &= run == 64 ? 0 : ~(((1ull << run) - 1) << bit);
+
+			uint begin = word * 64 + bit;
+			uint end = begin + run;
+			if (ranges.size() > first and begin <= ranges.back().end + mergeGap) {
+				ranges.back().end = end;
+			} else {
+				ranges.push_back({ begin, end });
+			}
+		}
+	}
+}
+
+void EntityStore::Resize(uint count) {
+	positions.resize(count);
+	rotations.resize(count);
+	scales.resize(count);
+	localBounds.resize(count);
+	bounds.resize(count);
+	meshes.resize(count);
+	materials.resize(count);
+	flags.resize(count);
+	rowSlots.resize(count);
+	dirty.resize((count + 63) / 64, 0);
+}
+
+void EntityStore::MoveRow(uint from, uint to) {
+	positions[to] = positions[from];
+	rotations[to] = rotations[from];
+	scales[to] = scales[from];
+	localBounds[to] = localBounds[from];
+	bounds[to] = bounds[from];
+	meshes[to] = meshes[from];
+	materials[to] = materials[from];
+	flags[to] = flags[from];
+	rowSlots[to] = rowSlots[from];
+	slotRows[rowSlots[to]] = to;
+}
+
+void EntityStore::SetDirty(uint row, bool value) {
+	uint64 mask = 1ull << (row % 64);
+	if (value) {
+		dirty[row / 64] |= mask;
+	} else {
+		dirty[row / 64] &= ~mask;
+	}
+}
+
+void EntityStore::Benchmark(const Context& context, uint count) {
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Desc> descs(count);
+	for (Desc& desc : descs) {
+		desc.position = glm::vec3(unit(random), unit(random), unit(random)) * 1000.0f;
+		desc.rotation = glm::angleAxis(unit(random) * 2.0f * glm::pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f));
+		desc.scale = 0.5f + unit(random);
+		desc.localBounds = glm::vec4(0.0f, 0.1f, 0.0f, 1.0f);
+		desc.mesh = random() % 3;
+		desc.material = random() % 16;
+	}
+
+	EntityStore store;
+	std::vector<Entity> handles(count);
+	Clock::time_point start = Clock::now();
+	store.Reserve(count);
+	store.Create(descs.data(), count, handles.data());
+	double createMs = milliseconds(start);
+
+	//? What the scene does to its spinning objects, for every row
+	glm::quat spin = glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+	auto rotateAll = [&store, spin] {
+		glm::quat* rotations = store.Rotations();
+		for (uint row = 0; row < store.Size(); row++) {
+			rotations[row] = spin * rotations[row];
+		}
+		store.UpdateBounds(0, store.Size());
+		store.MarkDirty(0, store.Size());
+	};
+	start = Clock::now();
+	rotateAll();
+	double rotateMs = milliseconds(start);
+
+	//? Model matrices through host visible staging into a device local buffer, like the scene's uploads
+	VkDeviceSize size = sizeof(glm::mat4) * count;
+	VkBuffer staging;
+	VkDeviceMemory stagingMemory;
+	VkBuffer target;
+	VkDeviceMemory targetMemory;
+	context.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMemory);
+	context.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target, targetMemory);
+	void* mapped;
+	vkMapMemory(context.device, stagingMemory, 0, size, 0, &mapped);
+	glm::mat4* models = static_cast<glm::mat4*>(mapped);
+
+	struct Upload {
+		uint ranges = 0;
+		uint rows = 0;
+		double collectMs = 0.0;
+		double packMs = 0.0;
+		double copyMs = 0.0;
+	};
+	std::vector<Range> ranges;
+	std::vector<VkBufferCopy> copies;
+	auto upload = [&](uint mergeGap) {
+		Upload result;
+		Clock::time_point start = Clock::now();
+		ranges.clear();
+		store.CollectDirtyRanges(mergeGap, ranges);
+		result.collectMs = milliseconds(start);
+
+		//? Dirty rows packed to the front of the staging buffer, one copy per range
+		start = Clock::now();
+		copies.clear();
+		uint packed = 0;
+		for (const Range& range : ranges) {
+			for (uint row = range.begin; row < range.end; row++) {
+				models[packed + row - range.begin] = store.Model(row);
+			}
+			copies.push_back({ sizeof(glm::mat4) * packed, sizeof(glm::mat4) * range.begin, sizeof(glm::mat4) * (range.end - range.begin) });
+			packed += range.end - range.begin;
+		}
+		result.packMs = milliseconds(start);
+
+		start = Clock::now();
+		context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+			vkCmdCopyBuffer(commandBuffer, staging, target, copies.size(), copies.data());
+		});
+		result.copyMs = milliseconds(start);
+		result.ranges = ranges.size();
+		result.rows = packed;
+		return result;
+	};
+
+	Upload full = upload(0);
+
+	//? Scattered writes, every row has the same chance
+	uint sparseRows = std::max(count / 100, 1u);
+	for (uint i = 0; i < sparseRows; i++) {
+		uint row = random() % count;
+		store.Rotations()[row] = spin * store.Rotations()[row];
+		store.UpdateBounds(row, row + 1);
+		store.MarkDirty(row, row + 1);
+	}
+	Upload sparse = upload(8);
+
+	std::vector<Entity> doomed;
+	for (uint i = 0; i < count; i += 2) {
+		doomed.push_back(handles[i]);
+	}
+	start = Clock::now();
+	store.Destroy(doomed.data(), doomed.size());
+	double destroyMs = milliseconds(start);
+	start = Clock::now();
+	rotateAll();
+	double rotateHalfMs = milliseconds(start);
+
+	vkUnmapMemory(context.device, stagingMemory);
+	context.DestroyBuffer(staging, stagingMemory);
+	context.DestroyBuffer(target, targetMemory);
+
+	auto rate = [](double items, double ms) {
+		return ms > 0.0 ? items / ms / 1000.0 : 0.0;
+	};
+	auto bandwidth = [](double rows, double ms) {
+		return ms > 0.0 ? rows * sizeof(glm::mat4) / ms / 1e6 : 0.0;
+	};
+	auto print = [&](const char* name, const Upload& upload) {
+		std::cout << "\t" << name << ": " << upload.rows << " rows in " << upload.ranges << " ranges, collect " << upload.collectMs << " ms, ";
+		std::cout << "pack " << upload.packMs << " ms (" << bandwidth(upload.rows, upload.packMs) << " GB/s), ";
+		std::cout << "copy " << upload.copyMs << " ms (" << bandwidth(upload.rows, upload.copyMs) << " GB/s)\n";
+	};
+	std::cout << "Entity store, " << count << " entities:\n";
+	std::cout << "\tBulk create: " << createMs << " ms (" << rate(count, createMs) << " M entities/s)\n";
+	std::cout << "\tRotate and update bounds: " << rotateMs << " ms (" << rate(count, rotateMs) << " M entities/s)\n";
+	print("All dirty", full);
+	print("1% dirty", sparse);
+	std::cout << "\tBulk destroy of every other entity: " << destroyMs << " ms (" << rate(doomed.size(), destroyMs) << " M entities/s)\n";
+	std::cout << "\tRotate the rest: " << rotateHalfMs << " ms (" << rate(store.Size(), rotateHalfMs) << " M entities/s)\n";
+	std::cout << std::endl;
+}
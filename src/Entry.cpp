@@ -1,6 +1,24 @@
 #include "System.hpp"
 #include "Settings.hpp"
 #include "Types.hpp"
+#include "Context.hpp"
+#include "FrameExporter.hpp"
+#include "GpuTimer.hpp"
+#include "ParticleSystem.hpp"
+#include "Descriptors.hpp"
+#include "FrameStats.hpp"
+#include "TextureManager.hpp"
+#include "BatchRenderer.hpp"
+#include "MemoryTracker.hpp"
+#include "Scene.hpp"
+#include "DrawStreamCache.hpp"
+#include "FrameArena.hpp"
+#include "AllocationCounter.hpp"
+#include "ResolutionController.hpp"
+#include "FrameCapture.hpp"
+#include "PostProcess.hpp"
+#include "ShaderReloader.hpp"
+#include "Hud.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #define GLFW_DLL
@@ -27,14 +45,36 @@ private:
 	VkDevice device;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
+	VkQueue computeQueue;
+	uint instanceApiVersion = VK_API_VERSION_1_0;
 	VkSwapchainKHR swapchain;
 	std::vector<VkImage> swapchainImages;
 	VkFormat swapchainImageFormat;
 	VkExtent2D swapchainExtent;
 	std::vector<VkImageView> swapchainImageViews;
+	VkFormat depthFormat;
+	VkImage depthImage;
+	VkDeviceMemory depthMemory;
+	VkImageView depthImageView;
+	//? Dynamic resolution or post-processing: frames render into the top left of this and are blitted into the swap chain image
+	bool dynamicResolution = false;
+	bool postProcessing = false;
+	bool offscreen = false;
+	VkImage renderImage;
+	VkDeviceMemory renderMemory;
+	VkImageView renderImageView;
+	//? What the frame renders, all of the swap chain image without dynamic resolution
+	VkExtent2D renderExtent;
+	ResolutionController resolution;
+	PostProcess postProcess;
 	VkRenderPass renderPass;
+	//? Occlusion culling only: picks up where renderPass stopped once the depth pyramid is built
+	VkRenderPass lateRenderPass = VK_NULL_HANDLE;
 	VkPipelineLayout pipelineLayout;
 	VkPipeline graphicsPipeline;
+	//? Swaps graphicsPipeline for one built from edited shaders, see Settings::hotReloadShaders
+	ShaderReloader shaderReloader;
+	bool reloadingShaders = false;
 	std::vector<VkFramebuffer> swapchainFramebuffers;
 	VkCommandPool commandPool;
 	std::vector<VkCommandBuffer> commandBuffers;
@@ -42,13 +82,70 @@ private:
 	std::vector<VkSemaphore> renderFinished;
 	std::vector<VkFence> inflightFence;
 	std::vector<VkFence> imagesInFlight;
-	uint frameIndex;
+	uint frameIndex = 0;
 	VkBuffer vertexBuffer;
 	VkDeviceMemory vertexBufferMemory;
+	Context context;
+	MemoryTracker memoryTracker;
+	FrameExporter frameExporter;
+	ParticleSystem particleSystem;
+	GpuTimer frameTimer;
+	uint frameScope = 0;
+	double previousFrameStartMs = 0.0;
+	double previousFrameEndMs = 0.0;
+	std::chrono::steady_clock::time_point lastFrameTime;
+	DescriptorLayoutCache layoutCache;
+	//? One per frame in flight, reset once the frame's fence has signaled
+	std::vector<DescriptorAllocator> frameDescriptors;
+	VkDescriptorSetLayout frameSetLayout;
+	//? Kept while the texture view they point at stays the same, cached draw streams bind them
+	std::vector<VkDescriptorSet> frameSets;
+	std::vector<VkImageView> frameSetViews;
+	BindlessTable bindlessTable;
+	std::vector<VkBuffer> frameDataBuffers;
+	std::vector<VkDeviceMemory> frameDataMemory;
+	std::vector<void*> frameDataMapped;
+	float time = 0.0f;
+	FrameStats frameStats;
+	FrameStats totalStats;
+	DrawStreamCache drawStreams;
+	uint triangleStream;
+	uint sceneStream;
+	uint sceneLateStream;
+	uint64 frameCount = 0;
+	//? One per frame in flight, reset once the frame's fence has signaled
+	std::vector<FrameArena> frameArenas;
+	//? Device and swap chain queries while setting up, dropped once everything exists
+	FrameArena scratchArena;
+	uint64 warmupAllocations = 0;
+	uint64 steadyAllocations = 0;
+	uint64 steadyAllocationFrames = 0;
+	uint64 worstFrameAllocations = 0;
+	TextureManager textureManager;
+	uint triangleTexture = 0;
+	Scene scene;
+	Hud hud;
+	//? From the frame slot's fence to present, shown on the HUD the next frame
+	double lastCpuMs = 0.0;
+	std::vector<MemoryTracker::HeapStats> hudHeaps;
+
+	//? Set 0, written once per frame
+	struct FrameData {
+		glm::mat4 viewProjection;
+		glm::vec4 time;
+	};
+
+	//? Push constants, per draw
+	struct DrawData {
+		glm::mat4 model;
+		//? Bindless image slot, only read with descriptor indexing
+		uint texture;
+	};
 
 	struct Vertex {
 		glm::vec3 position;
 		glm::vec3 color;
+		glm::vec2 texCoord;
 
 		static VkVertexInputBindingDescription GetBindingDescription() {
 			VkVertexInputBindingDescription bindingDescription {};
@@ -59,8 +156,8 @@ private:
 			return bindingDescription;
 		}
 
-		static std::array<VkVertexInputAttributeDescription, 2> GetAttributeDescriptions() {
-			std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
+		static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions() {
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions {};
 
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
@@ -72,6 +169,11 @@ private:
 			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
 			attributeDescriptions[1].offset = offsetof(Vertex, color);
 
+			attributeDescriptions[2].binding = 0;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+
 			return attributeDescriptions;
 		}
 	};
@@ -79,93 +181,242 @@ private:
 	struct QueueFamilyIndices {
 		std::optional<uint> graphicsFamily;
 		std::optional<uint> presentFamily;
+		//? Prefers a family without graphics so simulation runs asynchronously
+		std::optional<uint> computeFamily;
 
 		bool IsComplete() {
 			return graphicsFamily.has_value() and presentFamily.has_value();
 		}
 	};
 
+	//? The lists live in the scratch arena
 	struct SwapChainSupportDetails {
 		VkSurfaceCapabilitiesKHR capabilities;
-		std::vector<VkSurfaceFormatKHR> surfaceFormats;
-		std::vector<VkPresentModeKHR> presentModes;
+		ArenaVector<VkSurfaceFormatKHR> surfaceFormats;
+		ArenaVector<VkPresentModeKHR> presentModes;
 	};
 
 	const std::vector<Vertex> triangleVertices = {
-		{{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-		{{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
-		{{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}}
+		{{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.5f, 0.0f}},
+		{{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}},
+		{{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}}
 	};
 
 	void InitWindow() {
 		glfwInit();
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		if (Settings::exportFrames or Settings::batchRender or Settings::benchmarkEntities or Settings::benchmarkBvh or Settings::benchmarkMeshLoading) {
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		}
 		window = glfwCreateWindow(Settings::windowWidth, Settings::windowHeight, Settings::windowTitle.c_str(), nullptr, nullptr);
 	}
 
 	void InitVulkan() {
+		scratchArena.Init(Settings::frameArenaSize);
+		frameArenas.resize(Settings::maxFramesInFlight);
+		for (FrameArena& arena : frameArenas) {
+			arena.Init(Settings::frameArenaSize);
+		}
+
 		CreateInstance();
 		CreateSurface();
 		PickPhysicalDevice();
 		CreateLogicalDevice();
 		CreateSwapChain();
 		CreateImageViews();
+		CreateDepthResources();
+		CreateRenderTarget();
 		CreateRenderPass();
+		CreateDescriptorObjects();
 		CreateGraphicsPipeline();
 		CreateFramebuffers();
 		CreateCommandPool();
 		CreateVertexBuffer();
+		CreateFrameDataBuffers();
+		CreateTextures();
 		CreateCommandBuffers();
 		CreateSyncObjects();
-	}
 
-	void CreateVertexBuffer() {
-		VkBufferCreateInfo bufferInfo {};
-		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferInfo.size = sizeof(Vertex) * triangleVertices.size();
-		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		bufferInfo.flags = 0;
-
-		if (vkCreateBuffer(device, &bufferInfo, nullptr, &vertexBuffer) != VK_SUCCESS) {
-			throw std::runtime_error("Couldn't create a vertex buffer.");
+		frameTimer.Init(context, context.graphicsFamily, 1);
+		frameScope = frameTimer.AddScope("frame");
+		if (dynamicResolution and !frameTimer.Enabled()) {
+			std::cout << "Dynamic resolution: no timestamps on the graphics queue, the scale stays at " << resolution.Scale() << std::endl;
 		}
 
-		VkMemoryRequirements requirements;
-		vkGetBufferMemoryRequirements(device, vertexBuffer, &requirements);
-
-		VkMemoryAllocateInfo allocInfo {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = requirements.size;
-		allocInfo.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		if (postProcessing) {
+			postProcess.Init(context, layoutCache, renderImage, renderImageView, swapchainExtent);
+		}
+		if (Settings::showHud) {
+			hud.Init(context, swapchainImageFormat, swapchainImageViews, swapchainExtent);
+		}
+		drawStreams.Init(context);
+		triangleStream = drawStreams.AddStream("triangle");
+		sceneStream = drawStreams.AddStream("scene");
+		sceneLateStream = drawStreams.AddStream("scene, second phase");
+		drawStreams.SetViewport(renderExtent);
+
+		if (Settings::exportFrames) {
+			frameExporter.Init(context, swapchainExtent, swapchainImageFormat);
+		}
+		if (Settings::simulateParticles) {
+			particleSystem.Init(context, layoutCache, renderPass, Settings::particleCount);
+		}
+		if (Settings::renderScene) {
+			scene.Init(context, layoutCache, frameSetLayout, renderPass, swapchainExtent, depthImageView);
+			scene.SetRenderExtent(renderExtent);
+		}
 
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &vertexBufferMemory) != VK_SUCCESS) {
-			throw std::runtime_error("Couldn't allocate memory for a vertex buffer.");
+		//? After every subsystem, each registers the pipelines it created
+		reloadingShaders = Settings::hotReloadShaders and !Settings::captureFrame;
+		if (reloadingShaders) {
+			shaderReloader.Init(context, Settings::shaderDirectory);
+			shaderReloader.Register("triangle", { "src/Shaders/first.vert", TriangleFragmentShader() }, graphicsPipeline, [this] { return BuildGraphicsPipeline(); });
+			if (postProcessing) {
+				postProcess.RegisterShaders(shaderReloader);
+			}
+			if (Settings::showHud) {
+				hud.RegisterShaders(shaderReloader);
+			}
+			if (Settings::simulateParticles) {
+				particleSystem.RegisterShaders(shaderReloader);
+			}
+			if (Settings::renderScene) {
+				scene.RegisterShaders(shaderReloader);
+			}
 		}
+		scratchArena.CleanUp();
+	}
 
-		vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0);
+	void CreateVertexBuffer() {
+		VkDeviceSize size = sizeof(Vertex) * triangleVertices.size();
+		context.CreateBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBuffer, vertexBufferMemory);
 
 		void* data;
-		vkMapMemory(device, vertexBufferMemory, 0, bufferInfo.size, 0, &data);
-		memcpy(data, triangleVertices.data(), sizeof(Vertex) * triangleVertices.size());
+		vkMapMemory(device, vertexBufferMemory, 0, size, 0, &data);
+		memcpy(data, triangleVertices.data(), size);
 		vkUnmapMemory(device, vertexBufferMemory);
 	}
 
-	uint FindMemoryType(uint typeFilter, VkMemoryPropertyFlags flags) {
-		VkPhysicalDeviceMemoryProperties memoryProperties;
-		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	void CreateDescriptorObjects() {
+		layoutCache.Init(device);
+		frameDescriptors.resize(Settings::maxFramesInFlight);
+		for (DescriptorAllocator& allocator : frameDescriptors) {
+			allocator.Init(device);
+		}
+		frameSets.assign(Settings::maxFramesInFlight, VK_NULL_HANDLE);
+		frameSetViews.assign(Settings::maxFramesInFlight, VK_NULL_HANDLE);
+
+		//? With descriptor indexing draws sample from the bindless table instead of binding 1
+		std::vector<VkDescriptorSetLayoutBinding> frameBindings(context.descriptorIndexing ? 1 : 2);
+		frameBindings[0].binding = 0;
+		frameBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		frameBindings[0].descriptorCount = 1;
+		frameBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		if (!context.descriptorIndexing) {
+			frameBindings[1].binding = 1;
+			frameBindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			frameBindings[1].descriptorCount = 1;
+			frameBindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		}
+		frameSetLayout = layoutCache.Get(frameBindings);
+
+		if (context.descriptorIndexing) {
+			bindlessTable.Init(context, Settings::bindlessMaxBuffers, Settings::bindlessMaxImages);
+		}
+	}
+
+	void CreateFrameDataBuffers() {
+		frameDataBuffers.resize(Settings::maxFramesInFlight);
+		frameDataMemory.resize(Settings::maxFramesInFlight);
+		frameDataMapped.resize(Settings::maxFramesInFlight);
+		for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+			context.CreateBuffer(sizeof(FrameData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameDataBuffers[i], frameDataMemory[i]);
+			//? Stays mapped, the buffer of a frame slot is only written after its fence
+			vkMapMemory(device, frameDataMemory[i], 0, sizeof(FrameData), 0, &frameDataMapped[i]);
+		}
+	}
 
-		for (uint i = 0; i < memoryProperties.memoryTypeCount; i++) {
-			bool correctBit = typeFilter & (1 << i);
-			bool flagsPresent = (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags;
-			if (correctBit and flagsPresent) {
-				return i;
+	void CreateTextures() {
+		textureManager.Init(context, Settings::textureBudget, context.descriptorIndexing ? &bindlessTable : nullptr);
+
+		if (std::ifstream(Settings::triangleTexturePath).good()) {
+			triangleTexture = textureManager.Load(Settings::triangleTexturePath);
+			return;
+		}
+
+		//? No texture shipped, a checkerboard still goes through the GPU mip generation
+		const uint size = 256;
+		std::vector<uint8> pixels(size * size * 4);
+		for (uint y = 0; y < size; y++) {
+			for (uint x = 0; x < size; x++) {
+				uint8 value = ((x / 32 + y / 32) % 2) ? 255 : 160;
+				uint8* pixel = &pixels[(y * size + x) * 4];
+				pixel[0] = value;
+				pixel[1] = value;
+				pixel[2] = value;
+				pixel[3] = 255;
 			}
 		}
+		triangleTexture = textureManager.Create("checkerboard", std::move(pixels), { size, size });
+	}
+
+	VkDescriptorSet UpdateFrameData(float deltaTime) {
+		time += deltaTime;
+		FrameData frameData {};
+		frameData.viewProjection = glm::mat4(1.0f);
+		if (Settings::renderScene) {
+			scene.Update(frameIndex, time);
+			frameData.viewProjection = scene.ViewProjection();
+		}
+		frameData.time = glm::vec4(time, deltaTime, 0.0f, 0.0f);
+		memcpy(frameDataMapped[frameIndex], &frameData, sizeof(FrameData));
+
+		textureManager.BeginFrame(frameCount);
+		textureManager.Use(triangleTexture);
+
+		//? Rewriting a set would invalidate the draw streams recorded with it, so it's only replaced when the view changes.
+		//? With the bindless table the set never holds the texture, the view only goes into the draw stream keys
+		VkImageView textureView = textureManager.View(triangleTexture);
+		if (frameSets[frameIndex] != VK_NULL_HANDLE and (context.descriptorIndexing or frameSetViews[frameIndex] == textureView)) {
+			frameSetViews[frameIndex] = textureView;
+			return frameSets[frameIndex];
+		}
 
-		throw std::runtime_error("Couldn't find a suitable memory type.");
-		// return 0;
+		//? Sets handed out last time this slot was used are no longer referenced by the GPU
+		frameDescriptors[frameIndex].Reset();
+		VkDescriptorSet frameSet = frameDescriptors[frameIndex].Allocate(frameSetLayout);
+		frameSets[frameIndex] = frameSet;
+		frameSetViews[frameIndex] = textureView;
+
+		VkDescriptorBufferInfo bufferInfo {};
+		bufferInfo.buffer = frameDataBuffers[frameIndex];
+		bufferInfo.offset = 0;
+		bufferInfo.range = sizeof(FrameData);
+
+		VkDescriptorImageInfo imageInfo {};
+		imageInfo.sampler = textureManager.Sampler();
+		imageInfo.imageView = textureView;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		std::array<VkWriteDescriptorSet, 2> writes {};
+		writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[0].dstSet = frameSet;
+		writes[0].dstBinding = 0;
+		writes[0].descriptorCount = 1;
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		writes[0].pBufferInfo = &bufferInfo;
+		writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[1].dstSet = frameSet;
+		writes[1].dstBinding = 1;
+		writes[1].descriptorCount = 1;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[1].pImageInfo = &imageInfo;
+		uint writeCount = context.descriptorIndexing ? 1 : writes.size();
+		vkUpdateDescriptorSets(device, writeCount, writes.data(), 0, nullptr);
+		FrameCapture::UpdateDescriptorSets(writeCount, writes.data());
+
+		return frameSet;
 	}
 
 	void CreateSyncObjects() {
@@ -196,7 +447,8 @@ private:
 	}
 
 	void CreateCommandBuffers() {
-		commandBuffers.resize(swapchainFramebuffers.size());
+		//? One per frame in flight, re-recorded every frame so per-frame work (like the export copy) can vary
+		commandBuffers.resize(Settings::maxFramesInFlight);
 		VkCommandBufferAllocateInfo allocInfo {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = commandPool;
@@ -206,43 +458,198 @@ private:
 		if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
 			throw std::runtime_error("Couldn't allocate command buffers.");
 		}
+	}
+
+	void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint imageIndex, uint exportSlot, VkDescriptorSet frameSet, float deltaTime) {
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr; // Optional
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't begin recording a command buffer.");
+		}
+
+		frameTimer.Reset(commandBuffer, frameIndex);
+		frameTimer.Begin(commandBuffer, frameIndex, frameScope);
+
+		if (Settings::renderScene) {
+			scene.RecordCulling(commandBuffer, frameIndex);
+		}
 
-		for (uint i = 0; i < commandBuffers.size(); i++) {
-			VkCommandBufferBeginInfo beginInfo {};
-			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = 0; // Optional
-			beginInfo.pInheritanceInfo = nullptr; // Optional
+		VkRenderPassBeginInfo renderPassInfo {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = swapchainFramebuffers[imageIndex];
+		renderPassInfo.renderArea.offset = {0, 0};
+		renderPassInfo.renderArea.extent = renderExtent;
+		
+		std::array<VkClearValue, 2> clearValues {};
+		clearValues[0].color = {{0.f, 0.f, 0.f, 1.f}};
+		clearValues[1].depthStencil = {1.f, 0};
+		renderPassInfo.clearValueCount = clearValues.size();
+		renderPassInfo.pClearValues = clearValues.data();
+
+		//? Everything a static stream binds goes into its key
+		uint64 frameKey = DrawStreamCache::Hash(uint64(frameSet), uint64(frameSetViews[frameIndex]));
+
+		DrawStreamCache::Recording recording = drawStreams.BeginStatic(triangleStream, frameIndex, DrawStreamCache::Hash(frameKey, uint64(graphicsPipeline)), renderPass);
+		if (recording.record) {
+			RecordTriangle(recording.commandBuffer, frameSet, recording.stats);
+		}
+		drawStreams.End(recording);
 
-			if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-				throw std::runtime_error("Couldn't begin recording a command buffer.");
+		if (Settings::renderScene) {
+			//? The CPU path bakes this frame's levels of detail into its draws
+			recording = scene.DrawsChange() ? drawStreams.BeginDynamic(frameIndex, renderPass) : drawStreams.BeginStatic(sceneStream, frameIndex, frameKey, renderPass);
+			if (recording.record) {
+				scene.Draw(recording.commandBuffer, frameIndex, frameSet, frameArenas[frameIndex], recording.stats);
 			}
+			drawStreams.End(recording);
+		}
 
-			VkRenderPassBeginInfo renderPassInfo {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = renderPass;
-			renderPassInfo.framebuffer = swapchainFramebuffers[i];
-			renderPassInfo.renderArea.offset = {0, 0};
-			renderPassInfo.renderArea.extent = swapchainExtent;
-			
-			VkClearValue clearColor = {0.f, 0.f, 0.f, 1.f};
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
+		bool latePass = lateRenderPass != VK_NULL_HANDLE;
+		if (Settings::simulateParticles and !latePass) {
+			recording = drawStreams.BeginDynamic(frameIndex, renderPass);
+			particleSystem.Draw(recording.commandBuffer, recording.stats);
+			drawStreams.End(recording);
+		}
 
-			vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		FrameCapture::CmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		drawStreams.Execute(commandBuffer, frameStats);
+		FrameCapture::CmdEndRenderPass(commandBuffer);
 
-			VkBuffer vertexBuffers[] = { vertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+		//? The scene's second phase needs the depth of everything drawn so far, outside of a render pass
+		if (latePass) {
+			scene.RecordOcclusion(commandBuffer, frameIndex);
 
-			vkCmdDraw(commandBuffers[i], triangleVertices.size(), 1, 0, 0);
-			// vkCmdDraw(commandBuffers[i], 3, 1, 0, 0);
-			vkCmdEndRenderPass(commandBuffers[i]);
+			recording = drawStreams.BeginStatic(sceneLateStream, frameIndex, frameKey, lateRenderPass);
+			if (recording.record) {
+				scene.DrawLate(recording.commandBuffer, frameIndex, frameSet, recording.stats);
+			}
+			drawStreams.End(recording);
+			if (Settings::simulateParticles) {
+				recording = drawStreams.BeginDynamic(frameIndex, lateRenderPass);
+				particleSystem.Draw(recording.commandBuffer, recording.stats);
+				drawStreams.End(recording);
+			}
 
-			if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-				throw std::runtime_error("Coudln't record a command buffer.");
+			renderPassInfo.renderPass = lateRenderPass;
+			renderPassInfo.clearValueCount = 0;
+			renderPassInfo.pClearValues = nullptr;
+			FrameCapture::CmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			drawStreams.Execute(commandBuffer, frameStats);
+			FrameCapture::CmdEndRenderPass(commandBuffer);
+		}
+		if (Settings::renderScene) {
+			scene.EndFrame(commandBuffer, frameIndex);
+		}
+		if (postProcessing) {
+			postProcess.Record(commandBuffer, frameIndex, renderExtent, deltaTime);
+		}
+		if (offscreen) {
+			RecordUpscale(commandBuffer, imageIndex);
+		}
+
+		if (Settings::exportFrames) {
+			//? Offscreen frames reach the swap chain image through the upscale blit, not the render pass
+			if (offscreen) {
+				frameExporter.RecordCopy(commandBuffer, swapchainImages[imageIndex], exportSlot, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+			} else {
+				frameExporter.RecordCopy(commandBuffer, swapchainImages[imageIndex], exportSlot, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
 			}
 		}
+		//? After the export copy, exported frames stay clean
+		if (Settings::showHud) {
+			hud.Record(commandBuffer, imageIndex);
+		}
+		frameTimer.End(commandBuffer, frameIndex, frameScope);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Coudln't record a command buffer.");
+		}
+	}
+
+	//? Stretches what the frame rendered over the whole swap chain image and leaves it ready to present.
+	//? With post-processing that's the composite's output, which stays in GENERAL
+	void RecordUpscale(VkCommandBuffer commandBuffer, uint imageIndex) {
+		VkImage source = postProcessing ? postProcess.Output() : renderImage;
+		VkImageLayout sourceLayout = postProcessing ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		std::array<VkImageMemoryBarrier, 2> barriers {};
+		barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[0].srcAccessMask = postProcessing ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[0].oldLayout = postProcessing ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		barriers[0].newLayout = sourceLayout;
+		barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[0].image = source;
+		barriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barriers[0].subresourceRange.levelCount = 1;
+		barriers[0].subresourceRange.layerCount = 1;
+
+		//? The whole image is overwritten, what it held doesn't matter. The acquire semaphore is waited on at the transfer stage
+		barriers[1] = barriers[0];
+		barriers[1].srcAccessMask = 0;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].image = swapchainImages[imageIndex];
+		VkPipelineStageFlags sourceStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		if (postProcessing) {
+			sourceStage |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		}
+		vkCmdPipelineBarrier(commandBuffer, sourceStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+
+		VkImageBlit region {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.srcOffsets[1] = { int32(renderExtent.width), int32(renderExtent.height), 1 };
+		region.dstSubresource = region.srcSubresource;
+		region.dstOffsets[1] = { int32(swapchainExtent.width), int32(swapchainExtent.height), 1 };
+		vkCmdBlitImage(commandBuffer, source, sourceLayout, swapchainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+
+		VkImageMemoryBarrier toPresent = barriers[1];
+		toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		toPresent.dstAccessMask = 0;
+		toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
+	}
+
+	void SetRenderExtent(VkExtent2D extent) {
+		renderExtent = extent;
+		drawStreams.SetViewport(extent);
+		if (Settings::renderScene) {
+			scene.SetRenderExtent(extent);
+		}
+	}
+
+	void RecordTriangle(VkCommandBuffer commandBuffer, VkDescriptorSet frameSet, FrameStats& stats) {
+		FrameCapture::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		stats.pipelineBinds++;
+
+		//? Every set is bound once per frame, draws only push their own constants
+		VkDescriptorSet descriptorSets[] = { frameSet, VK_NULL_HANDLE };
+		uint descriptorSetCount = 1;
+		if (context.descriptorIndexing) {
+			descriptorSets[descriptorSetCount++] = bindlessTable.Set();
+		}
+		FrameCapture::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, descriptorSetCount, descriptorSets, 0, nullptr);
+		stats.descriptorSetBinds++;
+
+		VkBuffer vertexBuffers[] = { vertexBuffer };
+		VkDeviceSize offsets[] = { 0 };
+		FrameCapture::CmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		stats.vertexBufferBinds++;
+
+		DrawData drawData {};
+		drawData.model = glm::mat4(1.0f);
+		drawData.texture = textureManager.BindlessIndex(triangleTexture);
+		FrameCapture::CmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(DrawData), &drawData);
+		FrameCapture::CmdDraw(commandBuffer, triangleVertices.size(), 1, 0, 0);
+		stats.draws++;
 	}
 
 	void CreateCommandPool() {
@@ -251,7 +658,7 @@ private:
 		VkCommandPoolCreateInfo poolInfo {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		poolInfo.queueFamilyIndex = indices.graphicsFamily.value();
-		poolInfo.flags = 0; // Optional
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
 		if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
 			throw std::runtime_error("Couldn't create a command pool.");
@@ -262,11 +669,13 @@ private:
 		swapchainFramebuffers.resize(swapchainImages.size());
 		
 		for (uint i = 0; i < swapchainFramebuffers.size(); i++) {
-			VkImageView attachments[] = { swapchainImageViews[i] };
+			//? Frames in flight share the depth image, the render pass orders their depth writes.
+			//? Rendering offscreen they share the render target the same way, only the upscale touches the swap chain image
+			VkImageView attachments[] = { offscreen ? renderImageView : swapchainImageViews[i], depthImageView };
 			VkFramebufferCreateInfo framebufferInfo {};
 			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 			framebufferInfo.renderPass = renderPass;
-			framebufferInfo.attachmentCount = 1;
+			framebufferInfo.attachmentCount = 2;
 			framebufferInfo.pAttachments = attachments;
 			framebufferInfo.width = swapchainExtent.width;
 			framebufferInfo.height = swapchainExtent.height;
@@ -275,57 +684,167 @@ private:
 			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapchainFramebuffers[i]) != VK_SUCCESS) {
 				throw std::runtime_error("Couldn't create a framebuffer.");
 			}
+			FrameCapture::AddFramebuffer(swapchainFramebuffers[i], framebufferInfo);
 		}
 	}
 
 	void CreateRenderPass() {
+		//? The upscale moves the render target on from where the frame's last pass leaves it
+		VkImageLayout colorFinalLayout = offscreen ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
 		VkAttachmentDescription colorAttachment {};
-		colorAttachment.format = swapchainImageFormat;
+		colorAttachment.format = postProcessing ? PostProcess::sceneFormat : swapchainImageFormat;
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		colorAttachment.finalLayout = colorFinalLayout;
+
+		VkAttachmentDescription depthAttachment {};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference attachmentReference {};
 		attachmentReference.attachment = 0;
 		attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+		VkAttachmentReference depthReference {};
+		depthReference.attachment = 1;
+		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
 		VkSubpassDescription subpass {};
 		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 		subpass.colorAttachmentCount = 1;
 		subpass.pColorAttachments = &attachmentReference;
+		subpass.pDepthStencilAttachment = &depthReference;
 
+		//? Also waits for the previous frame's depth writes, the depth image isn't per frame
 		VkSubpassDependency dependency {};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		if (offscreen) {
+			//? And for the previous frame's upscale to stop reading the shared render target
+			dependency.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		if (postProcessing) {
+			//? Or its post-processing, which reads the target instead
+			dependency.srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		}
 
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
 		VkRenderPassCreateInfo renderPassInfo {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = 1;
-		renderPassInfo.pAttachments = &colorAttachment;
+		renderPassInfo.attachmentCount = attachments.size();
+		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpass;
 		renderPassInfo.dependencyCount = 1;
 		renderPassInfo.pDependencies = &dependency;
 
+		if (!Scene::UsesOcclusionCulling(context)) {
+			if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't create a render pass.");
+			}
+			FrameCapture::AddRenderPass(renderPass, renderPassInfo);
+			return;
+		}
+
+		//? With occlusion culling the frame is split in two passes around the depth pyramid build.
+		//? The first one keeps the depth for the compute reduction and leaves the color for the second
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		std::array<VkSubpassDependency, 2> dependencies = { dependency, {} };
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		renderPassInfo.dependencyCount = dependencies.size();
+		renderPassInfo.pDependencies = dependencies.data();
+
 		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
 			throw std::runtime_error("Couldn't create a render pass.");
 		}
+		FrameCapture::AddRenderPass(renderPass, renderPassInfo);
+
+		//? Same formats and subpass, so pipelines and framebuffers made for renderPass work with it
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[0].finalLayout = colorFinalLayout;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		//? Waits for the first pass' color and for the pyramid build to stop reading the depth
+		VkSubpassDependency lateDependency {};
+		lateDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		lateDependency.dstSubpass = 0;
+		lateDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		lateDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		lateDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		lateDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &lateDependency;
+
+		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &lateRenderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a render pass.");
+		}
+		FrameCapture::AddRenderPass(lateRenderPass, renderPassInfo);
 	}
 
 	void CreateGraphicsPipeline() {
-		std::string vertCode = ReadFile("src/Shaders/first.vert.spv");
-		std::string fragCode = ReadFile("src/Shaders/first.frag.spv");
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(DrawData);
+
+		VkPipelineLayoutCreateInfo layoutInfo {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		std::vector<VkDescriptorSetLayout> setLayouts = { frameSetLayout };
+		if (context.descriptorIndexing) {
+			setLayouts.push_back(bindlessTable.Layout());
+		}
+		layoutInfo.setLayoutCount = uint(setLayouts.size());
+		layoutInfo.pSetLayouts = setLayouts.data();
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a pipeline layout.");
+		}
+		FrameCapture::AddPipelineLayout(pipelineLayout, layoutInfo);
+
+		graphicsPipeline = BuildGraphicsPipeline();
+	}
+
+	//? GLSL source of the triangle's fragment stage, the .spv sits next to it
+	std::string TriangleFragmentShader() const {
+		return context.descriptorIndexing ? "src/Shaders/firstbindless.frag" : "src/Shaders/first.frag";
+	}
 
-		VkShaderModule vertModule = CreateShaderModule(vertCode);
-		VkShaderModule fragModule = CreateShaderModule(fragCode);
+	//? Also run on the shader reload thread, so it only reads what stays put after startup
+	VkPipeline BuildGraphicsPipeline() {
+		std::string vertCode = Context::ReadFile("src/Shaders/first.vert.spv");
+		std::string fragCode = Context::ReadFile(TriangleFragmentShader() + ".spv");
+
+		VkShaderModule vertModule = context.CreateShaderModule(vertCode);
+		VkShaderModule fragModule = context.CreateShaderModule(fragCode);
 
 		VkPipelineShaderStageCreateInfo vertStageInfo {};
 		vertStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -360,24 +879,10 @@ private:
 		inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = float(swapchainExtent.width);
-		viewport.height = float(swapchainExtent.height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor {};
-		scissor.offset = {0, 0};
-		scissor.extent = swapchainExtent;
-
 		VkPipelineViewportStateCreateInfo viewportInfo {};
 		viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportInfo.viewportCount = 1;
-		viewportInfo.pViewports = &viewport;
 		viewportInfo.scissorCount = 1;
-		viewportInfo.pScissors = &scissor;
 
 		VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
 		rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -401,7 +906,13 @@ private:
 		multisamplingInfo.alphaToCoverageEnable = VK_FALSE; // Optional
 		multisamplingInfo.alphaToOneEnable = VK_FALSE; // Optional
 
-		// VkPipelineDepthStencilStateCreateInfo depthStencilInfo {};
+		VkPipelineDepthStencilStateCreateInfo depthStencilInfo {};
+		depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencilInfo.depthTestEnable = VK_TRUE;
+		depthStencilInfo.depthWriteEnable = VK_TRUE;
+		depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		depthStencilInfo.depthBoundsTestEnable = VK_FALSE;
+		depthStencilInfo.stencilTestEnable = VK_FALSE;
 
 		VkPipelineColorBlendAttachmentState colorBlendAttachment {};
 		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -424,22 +935,6 @@ private:
 		colorBlendInfo.blendConstants[2] = 0.0f; // Optional
 		colorBlendInfo.blendConstants[3] = 0.0f; // Optional
 
-		// VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_LINE_WIDTH};
-		// VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
-		// dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		// dynamicStateInfo.dynamicStateCount = 2;
-		// dynamicStateInfo.pDynamicStates = dynamicStates;
-
-		VkPipelineLayoutCreateInfo layoutInfo {};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutInfo.setLayoutCount = 0; // Optional
-		layoutInfo.pSetLayouts = nullptr; // Optional
-		layoutInfo.pushConstantRangeCount = 0; // Optional
-		layoutInfo.pPushConstantRanges = nullptr; // Optional
-
-		if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-			throw std::runtime_error("Couldn't create a pipeline layout.");
-		}
 
 		VkGraphicsPipelineCreateInfo pipelineInfo {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -451,9 +946,9 @@ private:
 		pipelineInfo.pViewportState = &viewportInfo;
 		pipelineInfo.pRasterizationState = &rasterizerInfo;
 		pipelineInfo.pMultisampleState = &multisamplingInfo;
-		pipelineInfo.pDepthStencilState = nullptr;
+		pipelineInfo.pDepthStencilState = &depthStencilInfo;
 		pipelineInfo.pColorBlendState = &colorBlendInfo;
-		pipelineInfo.pDynamicState = nullptr;
+		pipelineInfo.pDynamicState = &DrawStreamCache::dynamicState;
 
 		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
@@ -461,46 +956,15 @@ private:
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 		pipelineInfo.basePipelineIndex = -1; // Optional
 
-		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-			throw std::runtime_error("Couldn't create a graphics pipeline");
-		}
-
-
+		VkPipeline pipeline;
+		VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
 		vkDestroyShaderModule(device, vertModule, nullptr);
 		vkDestroyShaderModule(device, fragModule, nullptr);
-	}
-
-	VkShaderModule CreateShaderModule(const std::string& code) {
-		VkShaderModuleCreateInfo createInfo {};
-
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-		createInfo.pCode = reinterpret_cast<const uint32*>(code.data());
-		
-		VkShaderModule module;
-		if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS) {
-			throw std::runtime_error("Couldn't create a shader module.");
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a graphics pipeline");
 		}
-		return module;
-	}
-
-	std::string ReadFile(const std::string& path) {
-		std::ifstream file(path, std::ios::ate | std::ios::binary);
-		
-		if (!file.is_open()) {
-			throw std::runtime_error("Couldn't open the shader.");
-		}
-
-		uint fileSize = file.tellg();
-
-		std::string res;
-		res.resize(fileSize);
-
-		file.seekg(0);
-		file.read(res.data(), fileSize);
-		file.close();
-
-		return res;
+		FrameCapture::AddGraphicsPipeline(pipeline, pipelineInfo);
+		return pipeline;
 	}
 
 	void CreateImageViews() {
@@ -528,7 +992,66 @@ private:
 			if (vkCreateImageView(device, &createInfo, nullptr, &swapchainImageViews[i]) != VK_SUCCESS) {
 				throw std::runtime_error("Failed to create image views.");
 			}
+			//? Swap chain images aren't created through Context, a replay makes its own
+			FrameCapture::AddImage(swapchainImages[i], swapchainExtent, 1, swapchainImageFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+			FrameCapture::AddImageView(swapchainImageViews[i], swapchainImages[i], swapchainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		}
+	}
+
+	void CreateDepthResources() {
+		depthFormat = FindDepthFormat();
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		//? The scene reduces it into its depth pyramid
+		if (Scene::UsesOcclusionCulling(context)) {
+			usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
+		context.CreateImage(swapchainExtent, 1, depthFormat, usage, depthImage, depthMemory);
+		depthImageView = context.CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+	}
+
+	void CreateRenderTarget() {
+		renderExtent = swapchainExtent;
+		if (!offscreen) {
+			return;
+		}
+		if (dynamicResolution) {
+			resolution.Init(Settings::resolutionMinScale, std::min(Settings::resolutionMaxScale, 1.0f), Settings::resolutionTargetMs);
+			renderExtent = resolution.Extent(swapchainExtent);
+		}
+		//? Allocated at the largest scale, frames render into its top left. Post-processing samples it
+		VkFormat format = swapchainImageFormat;
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		if (postProcessing) {
+			format = PostProcess::sceneFormat;
+			usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		}
+		context.CreateImage(swapchainExtent, 1, format, usage, renderImage, renderMemory);
+		renderImageView = context.CreateImageView(renderImage, format, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+
+	//? The upscale is a linear blit from an image of the swap chain's format into a swap chain image
+	bool SupportsUpscale(const VkSurfaceCapabilitiesKHR& capabilities, VkFormat format) {
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+		VkFormatFeatureFlags features = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) and (properties.optimalTilingFeatures & features) == features;
+	}
+
+	VkFormat FindDepthFormat() {
+		//? D32_SFLOAT is the common case, one of the packed ones is guaranteed to exist otherwise
+		const std::array<VkFormat, 3> candidates = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+		VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		if (Scene::UsesOcclusionCulling(context)) {
+			features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+		}
+		for (VkFormat format : candidates) {
+			VkFormatProperties properties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+			if ((properties.optimalTilingFeatures & features) == features) {
+				return format;
+			}
 		}
+		throw std::runtime_error("Couldn't find a depth format.");
 	}
 
 	void CreateSwapChain() {
@@ -552,9 +1075,28 @@ private:
 		createInfo.imageExtent = extent;
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		if (Settings::exportFrames) {
+			if (!(swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+				throw std::runtime_error("Swap chain images can't be copied from, frame export is unavailable.");
+			}
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
+		bool blittable = SupportsUpscale(swapChainSupport.capabilities, surfaceFormat.format);
+		dynamicResolution = Settings::dynamicResolution and !Settings::exportFrames and blittable;
+		if (Settings::dynamicResolution and !Settings::exportFrames and !blittable) {
+			std::cout << "Dynamic resolution: swap chain images can't be blitted into, rendering at full size" << std::endl;
+		}
+		postProcessing = Settings::postProcess and blittable and PostProcess::Supported(context);
+		if (Settings::postProcess and !postProcessing) {
+			std::cout << "Post-processing: needs Vulkan 1.1 subgroup arithmetic in compute and a swap chain to blit into, presenting the scene as is" << std::endl;
+		}
+		offscreen = dynamicResolution or postProcessing;
+		if (offscreen) {
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		}
 
 		QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
-		std::vector<uint> queueFamilyIndices = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+		uint queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
 		if (indices.graphicsFamily == indices.presentFamily) {
 			createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -562,8 +1104,8 @@ private:
 			createInfo.pQueueFamilyIndices = nullptr;
 		} else {
 			createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-			createInfo.queueFamilyIndexCount = queueFamilyIndices.size();
-			createInfo.pQueueFamilyIndices = queueFamilyIndices.data();
+			createInfo.queueFamilyIndexCount = 2;
+			createInfo.pQueueFamilyIndices = queueFamilyIndices;
 		}
 
 		createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
@@ -585,7 +1127,7 @@ private:
 		swapchainExtent = extent;
 	}
 
-	VkSurfaceFormatKHR BestSwapSurfaceFormatAvailable(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+	VkSurfaceFormatKHR BestSwapSurfaceFormatAvailable(const ArenaVector<VkSurfaceFormatKHR>& availableFormats) {
 		for (const VkSurfaceFormatKHR& format : availableFormats) {
 			if (format.format == VK_FORMAT_B8G8R8A8_SRGB and format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
 				return format;
@@ -596,12 +1138,16 @@ private:
 		return availableFormats[0];
 	}
 
-	VkPresentModeKHR BestSwapPresentMode(const std::vector<VkPresentModeKHR>& availableModes) {
+	VkPresentModeKHR BestSwapPresentMode(const ArenaVector<VkPresentModeKHR>& availableModes) {
 		for (const auto& presentMode : availableModes) {
 			if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
 				return presentMode;
 			}
 		}
+		//? Exporting shouldn't be throttled to the display refresh rate
+		if (Settings::exportFrames and std::find(availableModes.begin(), availableModes.end(), VK_PRESENT_MODE_IMMEDIATE_KHR) != availableModes.end()) {
+			return VK_PRESENT_MODE_IMMEDIATE_KHR;
+		}
 		return VK_PRESENT_MODE_FIFO_KHR; //? This mode is guaranteed to be available
 	}
 
@@ -622,12 +1168,12 @@ private:
 
 		uint formatCount = 0;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
-		details.surfaceFormats.resize(formatCount);
+		details.surfaceFormats = ArenaVector<VkSurfaceFormatKHR>(formatCount, scratchArena);
 		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.surfaceFormats.data());
 
 		uint presentModeCount = 0;
 		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
-		details.presentModes.resize(presentModeCount);
+		details.presentModes = ArenaVector<VkPresentModeKHR>(presentModeCount, scratchArena);
 		vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
 
 		return details;
@@ -643,19 +1189,48 @@ private:
 		QueueFamilyIndices indices = FindQueueFamilies(physicalDevice);
 
 		std::vector<VkDeviceQueueCreateInfo> queues;
-		std::set<uint> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+		std::set<uint> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value(), indices.computeFamily.value()};
+
+		//? Batch rendering spreads its contexts over as many graphics queues as it can get
+		uint graphicsQueueCount = 1;
+		if (Settings::batchRender) {
+			uint familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+			graphicsQueueCount = std::min(Settings::batchMaxQueues, families[indices.graphicsFamily.value()].queueCount);
+		}
 
+		//? Outlives the loop, vkCreateDevice reads it through the create infos
+		std::vector<float> queuePriorities(graphicsQueueCount, 1.0f);
 		for (uint uniqueQueueFamily : uniqueQueueFamilies) {
 			VkDeviceQueueCreateInfo queueCreateInfo {};
 			queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			queueCreateInfo.queueFamilyIndex = uniqueQueueFamily;
-			queueCreateInfo.queueCount = 1;
-			float queuePriority = 1.0;
-			queueCreateInfo.pQueuePriorities = &queuePriority;
+			queueCreateInfo.queueCount = uniqueQueueFamily == indices.graphicsFamily.value() ? graphicsQueueCount : 1;
+			queueCreateInfo.pQueuePriorities = queuePriorities.data();
 			queues.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
 		VkPhysicalDeviceFeatures deviceFeatures{};
+		deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+		context.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+		context.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		context.apiVersion = std::min(instanceApiVersion, deviceProperties.apiVersion);
+
+		std::vector<const char*> extensions = Settings::deviceExtensions;
+		for (const char* extension : Settings::optionalDeviceExtensions) {
+			if (DeviceExtensionSupported(physicalDevice, extension)) {
+				extensions.push_back(extension);
+			}
+		}
+		context.enabledExtensions = std::set<std::string>(extensions.begin(), extensions.end());
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -663,8 +1238,41 @@ private:
 		createInfo.pQueueCreateInfos = queues.data();
 		createInfo.pEnabledFeatures = &deviceFeatures;
 
-		createInfo.enabledExtensionCount = uint(Settings::deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = Settings::deviceExtensions.data();
+		createInfo.enabledExtensionCount = uint(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
+
+		//? Core in 1.2, an extension on 1.1 devices. Querying needs vkGetPhysicalDeviceFeatures2 either way
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		bool indexingAvailable = context.apiVersion >= VK_API_VERSION_1_2 or context.HasExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		if (Settings::useBindless and context.apiVersion >= VK_API_VERSION_1_1 and indexingAvailable) {
+			VkPhysicalDeviceFeatures2 features2 {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &indexingFeatures;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+			context.descriptorIndexing = indexingFeatures.runtimeDescriptorArray
+				and indexingFeatures.descriptorBindingPartiallyBound
+				and indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+				and indexingFeatures.shaderStorageBufferArrayNonUniformIndexing
+				and indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+				and indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind
+				and indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+		}
+		if (context.descriptorIndexing) {
+			//? Only what BindlessTable relies on
+			VkPhysicalDeviceDescriptorIndexingFeatures supported = indexingFeatures;
+			indexingFeatures = {};
+			indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+			indexingFeatures.runtimeDescriptorArray = supported.runtimeDescriptorArray;
+			indexingFeatures.descriptorBindingPartiallyBound = supported.descriptorBindingPartiallyBound;
+			indexingFeatures.shaderSampledImageArrayNonUniformIndexing = supported.shaderSampledImageArrayNonUniformIndexing;
+			indexingFeatures.shaderStorageBufferArrayNonUniformIndexing = supported.shaderStorageBufferArrayNonUniformIndexing;
+			indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = supported.descriptorBindingSampledImageUpdateAfterBind;
+			indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = supported.descriptorBindingStorageBufferUpdateAfterBind;
+			indexingFeatures.descriptorBindingUpdateUnusedWhilePending = supported.descriptorBindingUpdateUnusedWhilePending;
+			createInfo.pNext = &indexingFeatures;
+		}
 
 		if (Settings::useValidationLayers) {
 			createInfo.enabledLayerCount = uint(Settings::validationLayers.size());
@@ -679,6 +1287,25 @@ private:
 
 		vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+		vkGetDeviceQueue(device, indices.computeFamily.value(), 0, &computeQueue);
+
+		context.physicalDevice = physicalDevice;
+		context.device = device;
+		context.graphicsFamily = indices.graphicsFamily.value();
+		context.graphicsQueue = graphicsQueue;
+		context.graphicsQueueCount = graphicsQueueCount;
+
+		//? The budget extension reports through vkGetPhysicalDeviceMemoryProperties2
+		bool budgetExtension = context.HasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) and context.apiVersion >= VK_API_VERSION_1_1;
+		memoryTracker.Init(physicalDevice, budgetExtension);
+		context.memoryTracker = &memoryTracker;
+		context.computeFamily = indices.computeFamily.value();
+		context.computeQueue = computeQueue;
+
+		//? Before anything that could end up in the captured frame is created
+		if (Settings::captureFrame) {
+			FrameCapture::Enable();
+		}
 	}
 
 	void PickPhysicalDevice() {
@@ -727,26 +1354,32 @@ private:
 
 		uint queueFamilyCount = 0;
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		ArenaVector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount, scratchArena);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
 		int i = 0;
 		for (VkQueueFamilyProperties& queueFamilyProperties : queueFamilies) {
-			if (queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+			bool graphics = queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+			bool compute = queueFamilyProperties.queueFlags & VK_QUEUE_COMPUTE_BIT;
+			if (graphics and !indices.graphicsFamily.has_value()) {
 				indices.graphicsFamily = i;
 			}
+			if (compute and !graphics and !indices.computeFamily.has_value()) {
+				indices.computeFamily = i;
+			}
 			VkBool32 presentSuppot = false;
 			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSuppot);
-			if (presentSuppot) {
+			if (presentSuppot and !indices.presentFamily.has_value()) {
 				indices.presentFamily = i;
 			}
-
-			if (indices.IsComplete()) {
-				return indices;
-			}
 			i++;
 		}
 
+		//? A graphics family always supports compute too
+		if (!indices.computeFamily.has_value()) {
+			indices.computeFamily = indices.graphicsFamily;
+		}
+
 		return indices;
 	}
 
@@ -780,16 +1413,33 @@ private:
 	bool DeviceExtensionsSupported(VkPhysicalDevice device) {
 		uint availableExtensionCount;
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtensionCount, nullptr);
-		std::vector<VkExtensionProperties> availableExtensions(availableExtensionCount);
+		ArenaVector<VkExtensionProperties> availableExtensions(availableExtensionCount, scratchArena);
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtensionCount, availableExtensions.data());
 
-		std::set<std::string> requiredExtensions(Settings::deviceExtensions.begin(), Settings::deviceExtensions.end());
+		for (const char* requiredExtension : Settings::deviceExtensions) {
+			bool found = false;
+			for (const VkExtensionProperties& availableExtension : availableExtensions) {
+				found = found or strcmp(requiredExtension, availableExtension.extensionName) == 0;
+			}
+			if (!found) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool DeviceExtensionSupported(VkPhysicalDevice device, const std::string& extension) {
+		uint availableExtensionCount;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtensionCount, nullptr);
+		ArenaVector<VkExtensionProperties> availableExtensions(availableExtensionCount, scratchArena);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &availableExtensionCount, availableExtensions.data());
 
 		for (VkExtensionProperties availableExtension : availableExtensions) {
-			requiredExtensions.erase(availableExtension.extensionName);
+			if (extension == availableExtension.extensionName) {
+				return true;
+			}
 		}
-
-		return requiredExtensions.empty();
+		return false;
 	}
 
 	uint DeviceRating(VkPhysicalDevice device) {
@@ -881,6 +1531,14 @@ private:
 			std::cout << "\tMax Image Dimension 2D: " << deviceProperties.limits.maxImageDimension2D << "\n";
 			std::cout << "\tMax Memory Allocation Count: " << deviceProperties.limits.maxMemoryAllocationCount << "\n";
 			std::cout << "\tMax Compute Shared Memory Size: " << deviceProperties.limits.maxComputeSharedMemorySize << "\n";
+
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+			std::cout << "Memory heaps:\n";
+			for (uint i = 0; i < memoryProperties.memoryHeapCount; i++) {
+				bool deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+				std::cout << "\t" << i << ": " << memoryProperties.memoryHeaps[i].size / (1024 * 1024) << " MiB" << (deviceLocal ? ", device local" : "") << "\n";
+			}
 		}
 		std::cout << std::endl;
 	}
@@ -897,7 +1555,13 @@ private:
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		//? vkEnumerateInstanceVersion only exists on 1.1+ loaders
+		auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		if (enumerateInstanceVersion != nullptr) {
+			enumerateInstanceVersion(&instanceApiVersion);
+		}
+		instanceApiVersion = std::min(instanceApiVersion, uint(VK_API_VERSION_1_2));
+		appInfo.apiVersion = instanceApiVersion;
 
 		VkInstanceCreateInfo createInfo {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -1022,15 +1686,91 @@ private:
 	}
 
 	void MainLoop() {
+		if (Settings::batchRender) {
+			RunBatch();
+			return;
+		}
+		if (Settings::benchmarkEntities) {
+			for (uint count : Settings::entityBenchmarkCounts) {
+				EntityStore::Benchmark(context, count);
+			}
+			return;
+		}
+		if (Settings::benchmarkBvh) {
+			for (uint count : Settings::bvhBenchmarkCounts) {
+				Bvh::Benchmark(count);
+			}
+			return;
+		}
+		if (Settings::benchmarkMeshLoading) {
+			for (const std::string& source : Settings::meshBenchmarkSources) {
+				MeshLibrary::Benchmark(source);
+			}
+			return;
+		}
+		lastFrameTime = std::chrono::steady_clock::now();
 		while (!glfwWindowShouldClose(window)) {
+			if (Settings::exportFrames and frameExporter.FramesSubmitted() >= Settings::exportFrameCount) {
+				break;
+			}
+			uint64 allocations = AllocationCounter::ThreadAllocations();
 			glfwPollEvents();
 			DrawFrame();
+			CountFrameAllocations(AllocationCounter::ThreadAllocations() - allocations);
 		}
 
 		vkDeviceWaitIdle(device);
 	}
 
+	//? Only this thread's, workers like the export encoders allocate as they please
+	void CountFrameAllocations(uint64 allocations) {
+		if (Settings::captureFrame and frameCount == Settings::captureFrameNumber + 1) {
+			return;
+		}
+		if (frameCount <= Settings::allocationWarmupFrames) {
+			warmupAllocations += allocations;
+			return;
+		}
+		if (allocations == 0) {
+			return;
+		}
+		steadyAllocations += allocations;
+		steadyAllocationFrames++;
+		worstFrameAllocations = std::max(worstFrameAllocations, allocations);
+		if (Settings::assertNoFrameAllocations) {
+			throw std::runtime_error("Frame " + std::to_string(frameCount) + " allocated on the heap " + std::to_string(allocations) + " times after the warmup.");
+		}
+	}
+
+	void RunBatch() {
+		BatchRenderer batchRenderer;
+		batchRenderer.Init(context, Settings::batchContexts, Settings::batchExtent);
+
+		//? Results are only checksummed, a real job would store or stream them
+		std::atomic<uint64> checksum {0};
+		for (uint i = 0; i < Settings::batchJobs; i++) {
+			BatchJob job {};
+			job.scene = i;
+			job.frames = Settings::batchFramesPerJob;
+			job.instances = Settings::batchInstances;
+			job.onFinished = [&checksum](const BatchJob& job, const uint8* pixels, VkExtent2D extent) {
+				uint64 sum = 0;
+				for (size_t p = 0; p < size_t(extent.width) * extent.height * 4; p += 4) {
+					sum += pixels[p] + pixels[p + 1] + pixels[p + 2];
+				}
+				checksum += sum * (job.scene + 1);
+			};
+			batchRenderer.Submit(std::move(job));
+		}
+		batchRenderer.Wait();
+
+		batchRenderer.PrintStats();
+		std::cout << "Batch checksum: " << checksum << "\n" << std::endl;
+		batchRenderer.CleanUp();
+	}
+
 	void DrawFrame() {
+		auto waitStart = std::chrono::steady_clock::now();
 		vkWaitForFences(device, 1, &inflightFence[frameIndex], VK_TRUE, UINT64_MAX);
 
 		uint imageIndex;
@@ -1040,19 +1780,89 @@ private:
 			vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
 		}
 		imagesInFlight[imageIndex] = inflightFence[frameIndex];
+		auto cpuStart = std::chrono::steady_clock::now();
+		if (Settings::exportFrames) {
+			frameExporter.AddGpuWait(std::chrono::duration<double>(cpuStart - waitStart).count());
+		}
+
+		frameTimer.Resolve(frameIndex);
+		if (postProcessing) {
+			postProcess.Resolve(frameIndex);
+		}
+		//? Before anything records, streams and the scene pick up the new size together
+		if (dynamicResolution and frameTimer.Valid(frameScope) and resolution.Update(frameTimer.Milliseconds(frameScope))) {
+			SetRenderExtent(resolution.Extent(swapchainExtent));
+		}
+		drawStreams.BeginFrame(frameIndex);
+		//? Handles of destroyed pipelines get reused, keys alone can't tell a swapped pipeline apart
+		if (reloadingShaders and shaderReloader.Update(frameCount)) {
+			drawStreams.Invalidate();
+		}
+		frameArenas[frameIndex].Reset();
+		if (Settings::simulateParticles) {
+			particleSystem.Resolve(frameIndex);
+			//? The step can run alongside both the previous frame and its own frame's graphics work
+			particleSystem.AddOverlap(previousFrameStartMs, previousFrameEndMs);
+			if (frameTimer.Valid(frameScope)) {
+				particleSystem.AddOverlap(frameTimer.StartMilliseconds(frameScope), frameTimer.EndMilliseconds(frameScope));
+			}
+		}
+		if (frameTimer.Valid(frameScope)) {
+			previousFrameStartMs = frameTimer.StartMilliseconds(frameScope);
+			previousFrameEndMs = frameTimer.EndMilliseconds(frameScope);
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		float deltaTime = std::chrono::duration<float>(now - lastFrameTime).count();
+		lastFrameTime = now;
+
+		uint exportSlot = 0;
+		if (Settings::exportFrames) {
+			frameExporter.Collect();
+			exportSlot = frameExporter.AcquireSlot();
+		}
+
+		if (Settings::simulateParticles) {
+			particleSystem.Simulate(frameIndex, deltaTime);
+		}
+
+		VkDescriptorSet frameSet = UpdateFrameData(deltaTime);
+
+		bool capture = Settings::captureFrame and frameCount == Settings::captureFrameNumber;
+		if (capture) {
+			//? Static streams recorded in earlier frames weren't seen, this frame records them again
+			drawStreams.Invalidate();
+			FrameCapture::Begin(commandBuffers[frameIndex], frameCount);
+		}
+		vkResetCommandBuffer(commandBuffers[frameIndex], 0);
+		if (Settings::showHud) {
+			UpdateHud();
+		}
+		frameStats = {};
+		RecordCommandBuffer(commandBuffers[frameIndex], imageIndex, exportSlot, frameSet, deltaTime);
+		totalStats += frameStats;
+		if (capture) {
+			FrameCapture::End();
+		}
 
 		VkSubmitInfo submitInfo {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { imageAvailable[frameIndex] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		VkSemaphore waitSemaphores[] = { imageAvailable[frameIndex], VK_NULL_HANDLE };
+		//? Rendering offscreen the swap chain image is first written by the upscale's blit
+		VkPipelineStageFlags imageStage = offscreen ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkPipelineStageFlags waitStages[] = { imageStage, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT };
+		uint waitSemaphoreCount = 1;
+		if (Settings::simulateParticles) {
+			waitSemaphores[waitSemaphoreCount++] = particleSystem.SimulationFinished(frameIndex);
+		}
 		
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.waitSemaphoreCount = waitSemaphoreCount;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+		submitInfo.pCommandBuffers = &commandBuffers[frameIndex];
 
 		VkSemaphore signalSemaphores[] = { renderFinished[frameIndex] };
 		submitInfo.signalSemaphoreCount = 1;
@@ -1063,6 +1873,14 @@ private:
 		if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inflightFence[frameIndex]) != VK_SUCCESS) {
 			throw std::runtime_error("Couldn't submit a command buffer.");
 		}
+		if (Settings::exportFrames) {
+			frameExporter.Submitted(exportSlot, inflightFence[frameIndex]);
+		}
+		if (capture) {
+			//? Buffer contents are read back as the frame left them, before the next one writes
+			vkDeviceWaitIdle(device);
+			FrameCapture::Save(context, Settings::capturePath);
+		}
 
 		VkPresentInfoKHR presentInfo {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1076,11 +1894,127 @@ private:
 		presentInfo.pResults = nullptr; // Optional
 
 		vkQueuePresentKHR(presentQueue, &presentInfo);
+		lastCpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
 
 		frameIndex = (frameIndex + 1) % Settings::maxFramesInFlight;
+		frameCount++;
+	}
+
+	//? Before frameStats is cleared, the counts shown are the previous frame's
+	void UpdateHud() {
+		hud.BeginFrame(frameIndex, lastCpuMs, frameTimer.Valid(frameScope) ? frameTimer.Milliseconds(frameScope) : -1.0);
+		hud.Line("Render %ux%u of %ux%u", renderExtent.width, renderExtent.height, swapchainExtent.width, swapchainExtent.height);
+		hud.Line("Draws %u, binds: %u pipeline %u set %u vertex", frameStats.draws, frameStats.pipelineBinds, frameStats.descriptorSetBinds, frameStats.vertexBufferBinds);
+		hud.Timings(frameTimer);
+		if (Settings::renderScene) {
+			hud.Timings(scene.Timer());
+		}
+		if (postProcessing) {
+			hud.Timings(postProcess.Timer());
+		}
+		if (Settings::simulateParticles) {
+			hud.Timings(particleSystem.Timer());
+		}
+		memoryTracker.HeapStatistics(hudHeaps);
+		for (uint i = 0; i < hudHeaps.size(); i++) {
+			const MemoryTracker::HeapStats& heap = hudHeaps[i];
+			hud.Line("Heap %u %s: %.1f / %.1f MiB", i, heap.deviceLocal ? "device" : "host", heap.usage / double(1 << 20), heap.budget / double(1 << 20));
+		}
+	}
+
+	void PrintDescriptorStats() {
+		uint pools = 0;
+		for (const DescriptorAllocator& allocator : frameDescriptors) {
+			pools += allocator.PoolCount();
+		}
+		double frames = double(std::max(frameCount, uint64(1)));
+		std::cout << "Descriptors:\n";
+		std::cout << "\tBindless: " << (context.descriptorIndexing ? "enabled" : "unsupported or disabled") << "\n";
+		std::cout << "\tCached set layouts: " << layoutCache.Size() << ", frame pools: " << pools << "\n";
+		std::cout << "\tPer frame: " << totalStats.pipelineBinds / frames << " pipeline binds, ";
+		std::cout << totalStats.descriptorSetBinds / frames << " descriptor set binds, ";
+		std::cout << totalStats.vertexBufferBinds / frames << " vertex buffer binds, ";
+		std::cout << totalStats.draws / frames << " draws\n";
+		std::cout << std::endl;
+	}
+
+	void PrintAllocationStats() {
+		uint64 warmupFrames = std::min(frameCount, uint64(Settings::allocationWarmupFrames));
+		size_t highWater = 0;
+		size_t capacity = 0;
+		uint64 overflows = 0;
+		uint grows = 0;
+		for (const FrameArena& arena : frameArenas) {
+			highWater = std::max(highWater, arena.HighWater());
+			capacity = std::max(capacity, arena.Capacity());
+			overflows += arena.Overflows();
+			grows += arena.Grows();
+		}
+		std::cout << "Heap allocations:\n";
+		std::cout << "\tWarmup: " << warmupAllocations << " in " << warmupFrames << " frames\n";
+		std::cout << "\tSteady state: " << steadyAllocations << " in " << frameCount - warmupFrames << " frames, ";
+		std::cout << steadyAllocationFrames << " frames allocated, worst " << worstFrameAllocations << "\n";
+		std::cout << "\tFrame arenas: peak " << highWater / 1024 << " of " << capacity / 1024 << " KiB, " << overflows << " overflows, grown " << grows << " times\n";
+		std::cout << "\tWhole process: " << AllocationCounter::TotalAllocations() << "\n";
+		std::cout << std::endl;
 	}
 
 	void CleanUp() {
+		if (Settings::exportFrames) {
+			frameExporter.Flush();
+			frameExporter.PrintStats();
+			frameExporter.CleanUp();
+		}
+		if (Settings::simulateParticles) {
+			particleSystem.PrintStats();
+			particleSystem.CleanUp();
+		}
+		frameTimer.CleanUp();
+		if (reloadingShaders) {
+			shaderReloader.PrintStats();
+			shaderReloader.CleanUp();
+		}
+		if (dynamicResolution) {
+			resolution.PrintStats();
+		}
+		if (postProcessing) {
+			postProcess.PrintStats();
+			postProcess.CleanUp();
+		}
+		if (Settings::showHud) {
+			hud.PrintStats();
+			hud.CleanUp();
+		}
+		drawStreams.PrintStats();
+		drawStreams.CleanUp();
+		if (Settings::renderScene) {
+			scene.PrintStats();
+			scene.CleanUp();
+		}
+
+		PrintDescriptorStats();
+		PrintAllocationStats();
+		if (Settings::captureFrame) {
+			FrameCapture::PrintStats();
+		}
+		for (FrameArena& arena : frameArenas) {
+			arena.CleanUp();
+		}
+		textureManager.PrintStats();
+		memoryTracker.PrintStats();
+		textureManager.CleanUp();
+		if (context.descriptorIndexing) {
+			bindlessTable.CleanUp();
+		}
+		for (DescriptorAllocator& allocator : frameDescriptors) {
+			allocator.CleanUp();
+		}
+		layoutCache.CleanUp();
+		for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+			vkUnmapMemory(device, frameDataMemory[i]);
+			context.DestroyBuffer(frameDataBuffers[i], frameDataMemory[i]);
+		}
+
 		for (uint i = 0; i < Settings::maxFramesInFlight; i++)
 		{
 			vkDestroySemaphore(device, imageAvailable[i], nullptr);
@@ -1094,14 +2028,23 @@ private:
 		vkDestroyPipeline(device, graphicsPipeline, nullptr);
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyRenderPass(device, renderPass, nullptr);
+		if (lateRenderPass != VK_NULL_HANDLE) {
+			vkDestroyRenderPass(device, lateRenderPass, nullptr);
+		}
+		vkDestroyImageView(device, depthImageView, nullptr);
+		context.DestroyImage(depthImage, depthMemory);
+		if (offscreen) {
+			vkDestroyImageView(device, renderImageView, nullptr);
+			context.DestroyImage(renderImage, renderMemory);
+		}
 		for (VkImageView imageView : swapchainImageViews) {
 			vkDestroyImageView(device, imageView, nullptr);
 		}
 		vkDestroySwapchainKHR(device, swapchain, nullptr);
 
-		vkDestroyBuffer(device, vertexBuffer, nullptr);
-		vkFreeMemory(device, vertexBufferMemory, nullptr);
+		context.DestroyBuffer(vertexBuffer, vertexBufferMemory);
 
+		memoryTracker.ReportLeaks();
 		vkDestroyDevice(device, nullptr);
 		vkDestroySurfaceKHR(instance, surface, nullptr);
 		vkDestroyInstance(instance, nullptr);
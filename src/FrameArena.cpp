@@ -0,0 +1,65 @@
+#include "FrameArena.hpp"
+
+void FrameArena::Init(size_t capacity) {
+	this->capacity = capacity;
+	block = std::make_unique<uint8[]>(capacity);
+	offset = 0;
+}
+
+void FrameArena::CleanUp() {
+	block.reset();
+	overflowBlocks.clear();
+	capacity = 0;
+	offset = 0;
+	overflowBytes = 0;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+	uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+	uintptr_t aligned = (base + offset + alignment - 1) & ~uintptr_t(alignment - 1);
+	size_t end = aligned - base + size;
+	if (block != nullptr and end <= capacity) {
+		offset = end;
+		highWater = std::max(highWater, offset);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	//? Kept until the next reset, which makes room for all of them in the block
+	size_t padded = size + alignment;
+	overflowBlocks.push_back(std::make_unique<uint8[]>(padded));
+	overflowBytes += padded;
+	overflows++;
+	highWater = std::max(highWater, offset + overflowBytes);
+	uintptr_t overflow = reinterpret_cast<uintptr_t>(overflowBlocks.back().get());
+	return reinterpret_cast<void*>((overflow + alignment - 1) & ~uintptr_t(alignment - 1));
+}
+
+void FrameArena::Reset() {
+	if (overflowBytes > 0) {
+		overflowBlocks.clear();
+		Init(std::max(capacity * 2, offset + overflowBytes));
+		overflowBytes = 0;
+		grows++;
+	}
+	offset = 0;
+}
+
+size_t FrameArena::Used() const {
+	return offset + overflowBytes;
+}
+
+size_t FrameArena::Capacity() const {
+	return capacity;
+}
+
+size_t FrameArena::HighWater() const {
+	return highWater;
+}
+
+uint64 FrameArena::Overflows() const {
+	return overflows;
+}
+
+uint FrameArena::Grows() const {
+	return grows;
+}
@@ -0,0 +1,855 @@
+#include "FrameCapture.hpp"
+#include "TextureManager.hpp"
+#include <unordered_map>
+
+namespace {
+	using Op = CaptureFile::Op;
+	using Command = CaptureFile::Command;
+
+	//? Offsets into the readback buffer, multiples of every texel block size
+	const VkDeviceSize readbackAlignment = 16;
+
+	struct DescriptorSetState {
+		uint64 layout = 0;
+		//? By binding and array element, a later write replaces an earlier one
+		std::map<std::pair<uint, uint>, CaptureFile::Descriptor> descriptors;
+	};
+
+	//? Objects hold handles where the file holds indices, Save translates them
+	struct Registry {
+		std::mutex mutex;
+		bool enabled = false;
+		std::unordered_map<uint64, CaptureFile::Buffer> buffers;
+		std::unordered_map<uint64, CaptureFile::Image> images;
+		std::unordered_map<uint64, CaptureFile::ImageView> imageViews;
+		std::unordered_map<uint64, CaptureFile::Sampler> samplers;
+		std::unordered_map<uint64, CaptureFile::ShaderModule> shaderModules;
+		std::unordered_map<uint64, CaptureFile::SetLayout> setLayouts;
+		std::unordered_map<uint64, CaptureFile::PipelineLayout> pipelineLayouts;
+		std::unordered_map<uint64, CaptureFile::RenderPass> renderPasses;
+		std::unordered_map<uint64, CaptureFile::Framebuffer> framebuffers;
+		std::unordered_map<uint64, CaptureFile::Pipeline> pipelines;
+		std::unordered_map<uint64, DescriptorSetState> descriptorSets;
+	};
+
+	//? Only touched by the thread recording the frame
+	struct Recording {
+		bool active = false;
+		uint64 primary = 0;
+		uint64 frame = 0;
+		//? By command buffer, secondaries are recorded before the primary executes them
+		std::unordered_map<uint64, std::vector<Command>> streams;
+	};
+
+	struct Stats {
+		bool saved = false;
+		std::string path;
+		uint64 frame = 0;
+		VkDeviceSize fileBytes = 0;
+		VkDeviceSize contentBytes = 0;
+		double seconds = 0.0;
+		size_t buffers = 0;
+		size_t images = 0;
+		size_t pipelines = 0;
+		size_t descriptorSets = 0;
+		size_t commands = 0;
+		uint draws = 0;
+		uint droppedDescriptors = 0;
+		uint imagesWithoutContents = 0;
+	};
+
+	Registry registry;
+	Recording recording;
+	Stats stats;
+
+	template<typename Handle>
+	uint64 Key(Handle handle) {
+		return uint64(handle);
+	}
+
+	void Record(VkCommandBuffer commandBuffer, Op op, std::vector<uint64> args, std::string data = {}) {
+		Command command;
+		command.op = op;
+		command.args = std::move(args);
+		command.data = std::move(data);
+		recording.streams[Key(commandBuffer)].push_back(std::move(command));
+	}
+
+	//? Pulls the objects the commands use out of the registry, in the order they're first needed,
+	//? and rewrites every handle into an index. Called with the registry locked
+	class Collector {
+	public:
+		CaptureFile& capture;
+		//? What the readback has to copy, in the same order as capture.buffers and capture.images
+		std::vector<VkBuffer> buffers;
+		std::vector<VkImage> images;
+		uint droppedDescriptors = 0;
+		//? Indirect draws may rely on their firstInstance, the capturing device decides
+		bool firstInstance = false;
+
+		Collector(CaptureFile& capture) : capture(capture) {}
+
+		void Add(Command command) {
+			std::vector<uint64>& args = command.args;
+			switch (command.op) {
+				case Op::BeginRenderPass:
+					args[0] = RenderPass(args[0]);
+					args[1] = Framebuffer(args[1]);
+					break;
+				case Op::BindPipeline:
+					args[1] = Pipeline(args[1]);
+					break;
+				case Op::BindDescriptorSets:
+					args[1] = PipelineLayout(args[1]);
+					for (size_t i = 3; i < args.size(); i++) {
+						args[i] = DescriptorSet(args[i]);
+					}
+					break;
+				case Op::BindVertexBuffers:
+					for (size_t i = 1; i < args.size(); i += 2) {
+						args[i] = Buffer(args[i]);
+					}
+					break;
+				case Op::BindIndexBuffer:
+					args[0] = Buffer(args[0]);
+					break;
+				case Op::PushConstants:
+					args[0] = PipelineLayout(args[0]);
+					break;
+				case Op::DrawIndexedIndirect:
+					args[0] = Buffer(args[0]);
+					capture.multiDrawIndirect = capture.multiDrawIndirect or args[2] > 1;
+					capture.drawIndirectFirstInstance = firstInstance;
+					break;
+				case Op::DrawIndexedIndirectCount:
+					args[0] = Buffer(args[0]);
+					args[2] = Buffer(args[2]);
+					capture.multiDrawIndirect = capture.multiDrawIndirect or args[4] > 1;
+					capture.drawIndirectFirstInstance = firstInstance;
+					capture.drawIndirectCount = true;
+					break;
+				case Op::ExecuteCommands:
+					throw std::runtime_error("Couldn't capture the frame, a secondary executes commands.");
+				default:
+					break;
+			}
+			capture.commands.push_back(std::move(command));
+		}
+
+	private:
+		std::unordered_map<uint64, uint64> bufferIndices;
+		std::unordered_map<uint64, uint64> imageIndices;
+		std::unordered_map<uint64, uint64> imageViewIndices;
+		std::unordered_map<uint64, uint64> samplerIndices;
+		std::unordered_map<uint64, uint64> shaderModuleIndices;
+		std::unordered_map<uint64, uint64> setLayoutIndices;
+		std::unordered_map<uint64, uint64> pipelineLayoutIndices;
+		std::unordered_map<uint64, uint64> renderPassIndices;
+		std::unordered_map<uint64, uint64> framebufferIndices;
+		std::unordered_map<uint64, uint64> pipelineIndices;
+		std::unordered_map<uint64, uint64> descriptorSetIndices;
+
+		//? Copies a registered object into the file once, translated by remap
+		template<typename T, typename Remap>
+		uint64 Index(uint64 key, std::unordered_map<uint64, uint64>& indices, const std::unordered_map<uint64, T>& registered, std::vector<T>& out, const char* kind, Remap remap) {
+			if (key == 0) {
+				return CaptureFile::none;
+			}
+			auto found = indices.find(key);
+			if (found != indices.end()) {
+				return found->second;
+			}
+			auto object = registered.find(key);
+			if (object == registered.end()) {
+				throw std::runtime_error(std::string("Couldn't capture the frame, it uses a ") + kind + " created without FrameCapture seeing it.");
+			}
+			T copy = object->second;
+			remap(copy);
+			out.push_back(std::move(copy));
+			indices[key] = out.size() - 1;
+			return out.size() - 1;
+		}
+
+		uint64 Buffer(uint64 key) {
+			bool added = key != 0 and bufferIndices.count(key) == 0;
+			uint64 index = Index(key, bufferIndices, registry.buffers, capture.buffers, "buffer", [](CaptureFile::Buffer&) {});
+			if (added) {
+				buffers.push_back(VkBuffer(key));
+			}
+			return index;
+		}
+
+		uint64 Image(uint64 key) {
+			bool added = key != 0 and imageIndices.count(key) == 0;
+			uint64 index = Index(key, imageIndices, registry.images, capture.images, "image", [](CaptureFile::Image&) {});
+			if (added) {
+				images.push_back(VkImage(key));
+			}
+			return index;
+		}
+
+		uint64 ImageView(uint64 key) {
+			return Index(key, imageViewIndices, registry.imageViews, capture.imageViews, "image view", [this](CaptureFile::ImageView& view) {
+				view.image = Image(view.image);
+			});
+		}
+
+		uint64 Sampler(uint64 key) {
+			return Index(key, samplerIndices, registry.samplers, capture.samplers, "sampler", [](CaptureFile::Sampler&) {});
+		}
+
+		uint64 ShaderModule(uint64 key) {
+			return Index(key, shaderModuleIndices, registry.shaderModules, capture.shaderModules, "shader module", [](CaptureFile::ShaderModule&) {});
+		}
+
+		uint64 SetLayout(uint64 key) {
+			return Index(key, setLayoutIndices, registry.setLayouts, capture.setLayouts, "descriptor set layout", [this](CaptureFile::SetLayout& layout) {
+				for (const CaptureFile::SetLayoutBinding& binding : layout.bindings) {
+					capture.descriptorIndexing = capture.descriptorIndexing or binding.flags != 0;
+				}
+			});
+		}
+
+		uint64 PipelineLayout(uint64 key) {
+			return Index(key, pipelineLayoutIndices, registry.pipelineLayouts, capture.pipelineLayouts, "pipeline layout", [this](CaptureFile::PipelineLayout& layout) {
+				for (uint64& setLayout : layout.setLayouts) {
+					setLayout = SetLayout(setLayout);
+				}
+			});
+		}
+
+		uint64 RenderPass(uint64 key) {
+			return Index(key, renderPassIndices, registry.renderPasses, capture.renderPasses, "render pass", [](CaptureFile::RenderPass&) {});
+		}
+
+		uint64 Framebuffer(uint64 key) {
+			return Index(key, framebufferIndices, registry.framebuffers, capture.framebuffers, "framebuffer", [this](CaptureFile::Framebuffer& framebuffer) {
+				framebuffer.renderPass = RenderPass(framebuffer.renderPass);
+				for (uint64& attachment : framebuffer.attachments) {
+					attachment = ImageView(attachment);
+				}
+			});
+		}
+
+		uint64 Pipeline(uint64 key) {
+			return Index(key, pipelineIndices, registry.pipelines, capture.pipelines, "pipeline", [this](CaptureFile::Pipeline& pipeline) {
+				pipeline.layout = PipelineLayout(pipeline.layout);
+				pipeline.renderPass = RenderPass(pipeline.renderPass);
+				for (CaptureFile::ShaderStage& stage : pipeline.stages) {
+					stage.module = ShaderModule(stage.module);
+				}
+			});
+		}
+
+		uint64 DescriptorSet(uint64 key) {
+			if (key == 0) {
+				return CaptureFile::none;
+			}
+			auto found = descriptorSetIndices.find(key);
+			if (found != descriptorSetIndices.end()) {
+				return found->second;
+			}
+			auto state = registry.descriptorSets.find(key);
+			if (state == registry.descriptorSets.end()) {
+				throw std::runtime_error("Couldn't capture the frame, it uses a descriptor set allocated without FrameCapture seeing it.");
+			}
+
+			CaptureFile::DescriptorSet set;
+			set.layout = SetLayout(state->second.layout);
+			for (const auto& entry : state->second.descriptors) {
+				CaptureFile::Descriptor descriptor = entry.second;
+				//? Slots still pointing at destroyed objects, the frame can't have used them
+				bool bufferGone = descriptor.buffer != CaptureFile::none and registry.buffers.count(descriptor.buffer) == 0;
+				bool viewGone = descriptor.view != CaptureFile::none and (registry.imageViews.count(descriptor.view) == 0 or registry.images.count(registry.imageViews.at(descriptor.view).image) == 0);
+				if (bufferGone or viewGone) {
+					droppedDescriptors++;
+					continue;
+				}
+				descriptor.buffer = descriptor.buffer == CaptureFile::none ? CaptureFile::none : Buffer(descriptor.buffer);
+				descriptor.sampler = descriptor.sampler == CaptureFile::none ? CaptureFile::none : Sampler(descriptor.sampler);
+				if (descriptor.view != CaptureFile::none) {
+					descriptor.view = ImageView(descriptor.view);
+					//? Sampled images get their contents captured, in the layout the descriptor expects
+					capture.images[capture.imageViews[descriptor.view].image].layout = descriptor.layout;
+				}
+				set.descriptors.push_back(descriptor);
+			}
+			capture.descriptorSets.push_back(std::move(set));
+			descriptorSetIndices[key] = capture.descriptorSets.size() - 1;
+			return capture.descriptorSets.size() - 1;
+		}
+	};
+
+	//? Copies every buffer and sampled image the capture holds into one host visible buffer
+	void ReadContents(const Context& context, CaptureFile& capture, const std::vector<VkBuffer>& buffers, const std::vector<VkImage>& images) {
+		struct ImageCopy {
+			uint image;
+			TextureManager::FormatInfo format;
+			std::vector<VkDeviceSize> offsets;
+		};
+
+		VkDeviceSize size = 0;
+		std::vector<VkDeviceSize> bufferOffsets;
+		for (const CaptureFile::Buffer& buffer : capture.buffers) {
+			bufferOffsets.push_back(size);
+			size += (buffer.size + readbackAlignment - 1) / readbackAlignment * readbackAlignment;
+		}
+		std::vector<ImageCopy> imageCopies;
+		for (uint i = 0; i < capture.images.size(); i++) {
+			const CaptureFile::Image& image = capture.images[i];
+			ImageCopy copy {};
+			copy.image = i;
+			if (image.layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+				continue;
+			}
+			if (!TextureManager::GetFormatInfo(image.format, copy.format)) {
+				stats.imagesWithoutContents++;
+				continue;
+			}
+			for (uint level = 0; level < image.mipLevels; level++) {
+				copy.offsets.push_back(size);
+				size += (TextureManager::LevelSize(copy.format, image.extent, level) + readbackAlignment - 1) / readbackAlignment * readbackAlignment;
+			}
+			imageCopies.push_back(std::move(copy));
+		}
+		if (size == 0) {
+			return;
+		}
+
+		VkBuffer readbackBuffer;
+		VkDeviceMemory readbackMemory;
+		context.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackMemory);
+
+		context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+			//? The frame's writes have finished, they still have to be made visible to the copies
+			VkMemoryBarrier memoryBarrier {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			std::vector<VkImageMemoryBarrier> toTransfer;
+			for (const ImageCopy& copy : imageCopies) {
+				const CaptureFile::Image& image = capture.images[copy.image];
+				VkImageMemoryBarrier barrier {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+				barrier.oldLayout = image.layout;
+				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = images[copy.image];
+				barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				barrier.subresourceRange.levelCount = image.mipLevels;
+				barrier.subresourceRange.layerCount = 1;
+				toTransfer.push_back(barrier);
+			}
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, uint(toTransfer.size()), toTransfer.data());
+
+			for (uint i = 0; i < capture.buffers.size(); i++) {
+				VkBufferCopy region {};
+				region.dstOffset = bufferOffsets[i];
+				region.size = capture.buffers[i].size;
+				vkCmdCopyBuffer(commandBuffer, buffers[i], readbackBuffer, 1, &region);
+			}
+			for (const ImageCopy& copy : imageCopies) {
+				const CaptureFile::Image& image = capture.images[copy.image];
+				for (uint level = 0; level < image.mipLevels; level++) {
+					VkBufferImageCopy region {};
+					region.bufferOffset = copy.offsets[level];
+					region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					region.imageSubresource.mipLevel = level;
+					region.imageSubresource.layerCount = 1;
+					region.imageExtent = { std::max(image.extent.width >> level, 1u), std::max(image.extent.height >> level, 1u), 1 };
+					vkCmdCopyImageToBuffer(commandBuffer, images[copy.image], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+				}
+			}
+
+			//? The app keeps using the images, they go back to where they were
+			for (VkImageMemoryBarrier& barrier : toTransfer) {
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				std::swap(barrier.oldLayout, barrier.newLayout);
+			}
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, uint(toTransfer.size()), toTransfer.data());
+		});
+
+		void* mapped;
+		vkMapMemory(context.device, readbackMemory, 0, size, 0, &mapped);
+		const char* bytes = static_cast<const char*>(mapped);
+		for (uint i = 0; i < capture.buffers.size(); i++) {
+			capture.buffers[i].data.assign(bytes + bufferOffsets[i], capture.buffers[i].size);
+		}
+		for (const ImageCopy& copy : imageCopies) {
+			CaptureFile::Image& image = capture.images[copy.image];
+			for (uint level = 0; level < image.mipLevels; level++) {
+				image.levels.emplace_back(bytes + copy.offsets[level], TextureManager::LevelSize(copy.format, image.extent, level));
+			}
+		}
+		vkUnmapMemory(context.device, readbackMemory);
+		context.DestroyBuffer(readbackBuffer, readbackMemory);
+	}
+}
+
+void FrameCapture::Enable() {
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.enabled = true;
+}
+
+bool FrameCapture::Enabled() {
+	return registry.enabled;
+}
+
+void FrameCapture::Begin(VkCommandBuffer primary, uint64 frame) {
+	if (!registry.enabled) {
+		throw std::runtime_error("Couldn't begin a capture, FrameCapture isn't enabled.");
+	}
+	recording.streams.clear();
+	recording.active = true;
+	recording.primary = Key(primary);
+	recording.frame = frame;
+}
+
+void FrameCapture::End() {
+	recording.active = false;
+}
+
+void FrameCapture::Save(const Context& context, const std::string& path) {
+	auto start = std::chrono::steady_clock::now();
+
+	CaptureFile capture;
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+	capture.deviceName = properties.deviceName;
+	capture.frame = recording.frame;
+
+	Collector collector(capture);
+	collector.firstInstance = context.drawIndirectFirstInstance;
+	{
+		//? Creating the readback buffer registers it, so the lock is let go before that
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (const Command& command : recording.streams[recording.primary]) {
+			if (command.op != Op::ExecuteCommands) {
+				collector.Add(command);
+				continue;
+			}
+			for (uint64 secondary : command.args) {
+				auto stream = recording.streams.find(secondary);
+				if (stream == recording.streams.end()) {
+					throw std::runtime_error("Couldn't capture the frame, it executes a secondary recorded before the capture began.");
+				}
+				for (const Command& inlined : stream->second) {
+					collector.Add(inlined);
+				}
+			}
+		}
+	}
+	recording.streams.clear();
+
+	ReadContents(context, capture, collector.buffers, collector.images);
+	capture.Save(path);
+
+	stats.saved = true;
+	stats.path = path;
+	stats.frame = capture.frame;
+	stats.fileBytes = std::ifstream(path, std::ios::binary | std::ios::ate).tellg();
+	stats.contentBytes = capture.ContentBytes();
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats.buffers = capture.buffers.size();
+	stats.images = capture.images.size();
+	stats.pipelines = capture.pipelines.size();
+	stats.descriptorSets = capture.descriptorSets.size();
+	stats.commands = capture.commands.size();
+	for (const Command& command : capture.commands) {
+		stats.draws += command.op == Op::Draw or command.op == Op::DrawIndexed or command.op == Op::DrawIndexedIndirect or command.op == Op::DrawIndexedIndirectCount;
+	}
+	stats.droppedDescriptors = collector.droppedDescriptors;
+	std::cout << "Captured frame " << capture.frame << " to " << path << std::endl;
+}
+
+void FrameCapture::PrintStats() {
+	std::cout << "Frame capture:\n";
+	if (!stats.saved) {
+		std::cout << "\tNothing captured\n";
+		std::cout << std::endl;
+		return;
+	}
+	std::cout << "\tFrame " << stats.frame << " to " << stats.path << ": " << stats.fileBytes / 1024 << " KiB, " << stats.contentBytes / 1024 << " KiB of it contents, in " << stats.seconds * 1000.0 << " ms\n";
+	std::cout << "\tObjects: " << stats.buffers << " buffers, " << stats.images << " images, " << stats.pipelines << " pipelines, " << stats.descriptorSets << " descriptor sets\n";
+	std::cout << "\tCommands: " << stats.commands << ", " << stats.draws << " draws\n";
+	std::cout << "\tLeft out: " << stats.droppedDescriptors << " descriptors of destroyed objects, " << stats.imagesWithoutContents << " sampled images in formats that can't be read back\n";
+	std::cout << std::endl;
+}
+
+void FrameCapture::AddBuffer(VkBuffer buffer, VkDeviceSize size, VkBufferUsageFlags usage) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::Buffer captured;
+	captured.size = size;
+	captured.usage = usage;
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.buffers[Key(buffer)] = captured;
+}
+
+void FrameCapture::AddImage(VkImage image, VkExtent2D extent, uint mipLevels, VkFormat format, VkImageUsageFlags usage) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::Image captured;
+	captured.format = format;
+	captured.extent = extent;
+	captured.mipLevels = mipLevels;
+	captured.usage = usage;
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.images[Key(image)] = captured;
+}
+
+void FrameCapture::AddImageView(VkImageView view, VkImage image, VkFormat format, VkImageAspectFlags aspect, uint mipLevels) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::ImageView captured;
+	captured.image = Key(image);
+	captured.format = format;
+	captured.aspect = aspect;
+	captured.mipLevels = mipLevels;
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.imageViews[Key(view)] = captured;
+}
+
+void FrameCapture::RemoveBuffer(VkBuffer buffer) {
+	if (!registry.enabled) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.buffers.erase(Key(buffer));
+}
+
+void FrameCapture::RemoveImage(VkImage image) {
+	if (!registry.enabled) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.images.erase(Key(image));
+}
+
+void FrameCapture::AddShaderModule(VkShaderModule module, const std::string& code) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::ShaderModule captured;
+	captured.code = code;
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.shaderModules[Key(module)] = std::move(captured);
+}
+
+void FrameCapture::AddSampler(VkSampler sampler, const VkSamplerCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	//? Extensions like reduction modes are dropped, samplers the draws use don't have any
+	CaptureFile::Sampler captured;
+	captured.info = info;
+	captured.info.pNext = nullptr;
+	captured.info.flags = 0;
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.samplers[Key(sampler)] = captured;
+}
+
+void FrameCapture::AddSetLayout(VkDescriptorSetLayout layout, const VkDescriptorSetLayoutCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	const VkDescriptorSetLayoutBindingFlagsCreateInfo* bindingFlags = nullptr;
+	for (const VkBaseInStructure* next = static_cast<const VkBaseInStructure*>(info.pNext); next != nullptr; next = next->pNext) {
+		if (next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+			bindingFlags = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo*>(next);
+		}
+	}
+
+	CaptureFile::SetLayout captured;
+	captured.flags = info.flags;
+	for (uint i = 0; i < info.bindingCount; i++) {
+		CaptureFile::SetLayoutBinding binding;
+		binding.binding = info.pBindings[i].binding;
+		binding.type = info.pBindings[i].descriptorType;
+		binding.count = info.pBindings[i].descriptorCount;
+		binding.stages = info.pBindings[i].stageFlags;
+		if (bindingFlags != nullptr and i < bindingFlags->bindingCount) {
+			binding.flags = bindingFlags->pBindingFlags[i];
+		}
+		captured.bindings.push_back(binding);
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.setLayouts[Key(layout)] = std::move(captured);
+}
+
+void FrameCapture::AddPipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::PipelineLayout captured;
+	for (uint i = 0; i < info.setLayoutCount; i++) {
+		captured.setLayouts.push_back(Key(info.pSetLayouts[i]));
+	}
+	captured.pushConstants.assign(info.pPushConstantRanges, info.pPushConstantRanges + info.pushConstantRangeCount);
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.pipelineLayouts[Key(layout)] = std::move(captured);
+}
+
+void FrameCapture::AddRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	if (info.subpassCount != 1) {
+		throw std::runtime_error("Couldn't register a render pass for capturing, only passes with one subpass can be replayed.");
+	}
+	const VkSubpassDescription& subpass = info.pSubpasses[0];
+	CaptureFile::RenderPass captured;
+	captured.attachments.assign(info.pAttachments, info.pAttachments + info.attachmentCount);
+	captured.colorReferences.assign(subpass.pColorAttachments, subpass.pColorAttachments + subpass.colorAttachmentCount);
+	if (subpass.pDepthStencilAttachment != nullptr) {
+		captured.depthReference = *subpass.pDepthStencilAttachment;
+	}
+	captured.dependencies.assign(info.pDependencies, info.pDependencies + info.dependencyCount);
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.renderPasses[Key(renderPass)] = std::move(captured);
+}
+
+void FrameCapture::AddFramebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::Framebuffer captured;
+	captured.renderPass = Key(info.renderPass);
+	for (uint i = 0; i < info.attachmentCount; i++) {
+		captured.attachments.push_back(Key(info.pAttachments[i]));
+	}
+	captured.extent = { info.width, info.height };
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.framebuffers[Key(framebuffer)] = std::move(captured);
+}
+
+void FrameCapture::AddGraphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo& info) {
+	if (!registry.enabled) {
+		return;
+	}
+	CaptureFile::Pipeline captured;
+	captured.layout = Key(info.layout);
+	captured.renderPass = Key(info.renderPass);
+	captured.subpass = info.subpass;
+
+	for (uint i = 0; i < info.stageCount; i++) {
+		const VkPipelineShaderStageCreateInfo& stageInfo = info.pStages[i];
+		CaptureFile::ShaderStage stage;
+		stage.stage = stageInfo.stage;
+		stage.module = Key(stageInfo.module);
+		stage.entry = stageInfo.pName;
+		if (stageInfo.pSpecializationInfo != nullptr) {
+			const VkSpecializationInfo& specialization = *stageInfo.pSpecializationInfo;
+			stage.specializationEntries.assign(specialization.pMapEntries, specialization.pMapEntries + specialization.mapEntryCount);
+			stage.specializationData.assign(static_cast<const char*>(specialization.pData), specialization.dataSize);
+		}
+		captured.stages.push_back(std::move(stage));
+	}
+
+	const VkPipelineVertexInputStateCreateInfo& vertexInput = *info.pVertexInputState;
+	captured.vertexBindings.assign(vertexInput.pVertexBindingDescriptions, vertexInput.pVertexBindingDescriptions + vertexInput.vertexBindingDescriptionCount);
+	captured.vertexAttributes.assign(vertexInput.pVertexAttributeDescriptions, vertexInput.pVertexAttributeDescriptions + vertexInput.vertexAttributeDescriptionCount);
+	captured.inputAssembly = *info.pInputAssemblyState;
+	captured.inputAssembly.pNext = nullptr;
+
+	const VkPipelineViewportStateCreateInfo& viewport = *info.pViewportState;
+	captured.viewportCount = viewport.viewportCount;
+	captured.scissorCount = viewport.scissorCount;
+	if (viewport.pViewports != nullptr) {
+		captured.viewports.assign(viewport.pViewports, viewport.pViewports + viewport.viewportCount);
+	}
+	if (viewport.pScissors != nullptr) {
+		captured.scissors.assign(viewport.pScissors, viewport.pScissors + viewport.scissorCount);
+	}
+
+	captured.rasterization = *info.pRasterizationState;
+	captured.rasterization.pNext = nullptr;
+	captured.multisample = *info.pMultisampleState;
+	captured.multisample.pNext = nullptr;
+	captured.multisample.pSampleMask = nullptr;
+	captured.depthStencilEnabled = info.pDepthStencilState != nullptr;
+	if (captured.depthStencilEnabled) {
+		captured.depthStencil = *info.pDepthStencilState;
+		captured.depthStencil.pNext = nullptr;
+	}
+	captured.colorBlend = *info.pColorBlendState;
+	captured.colorBlend.pNext = nullptr;
+	captured.colorBlend.pAttachments = nullptr;
+	captured.blendAttachments.assign(info.pColorBlendState->pAttachments, info.pColorBlendState->pAttachments + info.pColorBlendState->attachmentCount);
+	if (info.pDynamicState != nullptr) {
+		captured.dynamicStates.assign(info.pDynamicState->pDynamicStates, info.pDynamicState->pDynamicStates + info.pDynamicState->dynamicStateCount);
+	}
+
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.pipelines[Key(pipeline)] = std::move(captured);
+}
+
+void FrameCapture::AddDescriptorSet(VkDescriptorSet set, VkDescriptorSetLayout layout) {
+	if (!registry.enabled) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	DescriptorSetState& state = registry.descriptorSets[Key(set)];
+	state.layout = Key(layout);
+	state.descriptors.clear();
+}
+
+void FrameCapture::UpdateDescriptorSets(uint writeCount, const VkWriteDescriptorSet* writes) {
+	if (!registry.enabled) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (uint i = 0; i < writeCount; i++) {
+		const VkWriteDescriptorSet& write = writes[i];
+		DescriptorSetState& state = registry.descriptorSets[Key(write.dstSet)];
+		for (uint element = 0; element < write.descriptorCount; element++) {
+			CaptureFile::Descriptor descriptor;
+			descriptor.binding = write.dstBinding;
+			descriptor.arrayElement = write.dstArrayElement + element;
+			descriptor.type = write.descriptorType;
+			if (write.pBufferInfo != nullptr) {
+				const VkDescriptorBufferInfo& bufferInfo = write.pBufferInfo[element];
+				descriptor.buffer = Key(bufferInfo.buffer);
+				descriptor.offset = bufferInfo.offset;
+				descriptor.range = bufferInfo.range;
+			} else if (write.pImageInfo != nullptr) {
+				const VkDescriptorImageInfo& imageInfo = write.pImageInfo[element];
+				descriptor.sampler = imageInfo.sampler == VK_NULL_HANDLE ? CaptureFile::none : Key(imageInfo.sampler);
+				descriptor.view = imageInfo.imageView == VK_NULL_HANDLE ? CaptureFile::none : Key(imageInfo.imageView);
+				descriptor.layout = imageInfo.imageLayout;
+			} else {
+				throw std::runtime_error("Couldn't register a descriptor write for capturing, texel buffers aren't supported.");
+			}
+			state.descriptors[{ descriptor.binding, descriptor.arrayElement }] = descriptor;
+		}
+	}
+}
+
+void FrameCapture::BeginSecondary(VkCommandBuffer commandBuffer) {
+	if (recording.active) {
+		recording.streams[Key(commandBuffer)].clear();
+	}
+}
+
+void FrameCapture::CmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* beginInfo, VkSubpassContents contents) {
+	vkCmdBeginRenderPass(commandBuffer, beginInfo, contents);
+	if (recording.active) {
+		const VkRect2D& area = beginInfo->renderArea;
+		std::string clearValues(reinterpret_cast<const char*>(beginInfo->pClearValues), beginInfo->clearValueCount * sizeof(VkClearValue));
+		Record(commandBuffer, Op::BeginRenderPass, { Key(beginInfo->renderPass), Key(beginInfo->framebuffer), uint(area.offset.x), uint(area.offset.y), area.extent.width, area.extent.height }, std::move(clearValues));
+	}
+}
+
+void FrameCapture::CmdEndRenderPass(VkCommandBuffer commandBuffer) {
+	vkCmdEndRenderPass(commandBuffer);
+	if (recording.active) {
+		Record(commandBuffer, Op::EndRenderPass, {});
+	}
+}
+
+void FrameCapture::CmdExecuteCommands(VkCommandBuffer commandBuffer, uint count, const VkCommandBuffer* secondaries) {
+	vkCmdExecuteCommands(commandBuffer, count, secondaries);
+	if (recording.active) {
+		std::vector<uint64> args;
+		for (uint i = 0; i < count; i++) {
+			args.push_back(Key(secondaries[i]));
+		}
+		Record(commandBuffer, Op::ExecuteCommands, std::move(args));
+	}
+}
+
+void FrameCapture::CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline) {
+	vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+	if (recording.active) {
+		Record(commandBuffer, Op::BindPipeline, { uint64(bindPoint), Key(pipeline) });
+	}
+}
+
+void FrameCapture::CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint firstSet, uint setCount, const VkDescriptorSet* sets, uint dynamicOffsetCount, const uint* dynamicOffsets) {
+	vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+	if (recording.active) {
+		std::vector<uint64> args = { uint64(bindPoint), Key(layout), firstSet };
+		for (uint i = 0; i < setCount; i++) {
+			args.push_back(Key(sets[i]));
+		}
+		Record(commandBuffer, Op::BindDescriptorSets, std::move(args), std::string(reinterpret_cast<const char*>(dynamicOffsets), dynamicOffsetCount * sizeof(uint)));
+	}
+}
+
+void FrameCapture::CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint firstBinding, uint bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets) {
+	vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+	if (recording.active) {
+		std::vector<uint64> args = { firstBinding };
+		for (uint i = 0; i < bindingCount; i++) {
+			args.push_back(Key(buffers[i]));
+			args.push_back(offsets[i]);
+		}
+		Record(commandBuffer, Op::BindVertexBuffers, std::move(args));
+	}
+}
+
+void FrameCapture::CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+	vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+	if (recording.active) {
+		Record(commandBuffer, Op::BindIndexBuffer, { Key(buffer), offset, uint64(indexType) });
+	}
+}
+
+void FrameCapture::CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stages, uint offset, uint size, const void* values) {
+	vkCmdPushConstants(commandBuffer, layout, stages, offset, size, values);
+	if (recording.active) {
+		Record(commandBuffer, Op::PushConstants, { Key(layout), stages, offset }, std::string(static_cast<const char*>(values), size));
+	}
+}
+
+void FrameCapture::CmdSetViewport(VkCommandBuffer commandBuffer, uint firstViewport, uint viewportCount, const VkViewport* viewports) {
+	vkCmdSetViewport(commandBuffer, firstViewport, viewportCount, viewports);
+	if (recording.active) {
+		Record(commandBuffer, Op::SetViewport, { firstViewport }, std::string(reinterpret_cast<const char*>(viewports), viewportCount * sizeof(VkViewport)));
+	}
+}
+
+void FrameCapture::CmdSetScissor(VkCommandBuffer commandBuffer, uint firstScissor, uint scissorCount, const VkRect2D* scissors) {
+	vkCmdSetScissor(commandBuffer, firstScissor, scissorCount, scissors);
+	if (recording.active) {
+		Record(commandBuffer, Op::SetScissor, { firstScissor }, std::string(reinterpret_cast<const char*>(scissors), scissorCount * sizeof(VkRect2D)));
+	}
+}
+
+void FrameCapture::CmdDraw(VkCommandBuffer commandBuffer, uint vertexCount, uint instanceCount, uint firstVertex, uint firstInstance) {
+	vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	if (recording.active) {
+		Record(commandBuffer, Op::Draw, { vertexCount, instanceCount, firstVertex, firstInstance });
+	}
+}
+
+void FrameCapture::CmdDrawIndexed(VkCommandBuffer commandBuffer, uint indexCount, uint instanceCount, uint firstIndex, int32 vertexOffset, uint firstInstance) {
+	vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	if (recording.active) {
+		Record(commandBuffer, Op::DrawIndexed, { indexCount, instanceCount, firstIndex, uint(vertexOffset), firstInstance });
+	}
+}
+
+void FrameCapture::CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint drawCount, uint stride) {
+	vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
+	if (recording.active) {
+		Record(commandBuffer, Op::DrawIndexedIndirect, { Key(buffer), offset, drawCount, stride });
+	}
+}
+
+void FrameCapture::CmdDrawIndexedIndirectCount(PFN_vkCmdDrawIndexedIndirectCountKHR function, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint maxDrawCount, uint stride) {
+	function(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+	if (recording.active) {
+		Record(commandBuffer, Op::DrawIndexedIndirectCount, { Key(buffer), offset, Key(countBuffer), countOffset, maxDrawCount, stride });
+	}
+}
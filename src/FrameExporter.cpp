@@ -0,0 +1,362 @@
+#include "FrameExporter.hpp"
+#include <filesystem>
+#include <cstdio>
+
+//? Tightly packed RGB rows, dropping alpha and undoing BGRA ordering
+static std::vector<uint8> ToRgb(const uint8* pixels, uint width, uint height, bool swizzleBgr) {
+	std::vector<uint8> rgb(size_t(width) * height * 3);
+	uint8* out = rgb.data();
+	const uint8* end = pixels + size_t(width) * height * 4;
+
+	for (const uint8* in = pixels; in != end; in += 4, out += 3) {
+		out[0] = swizzleBgr ? in[2] : in[0];
+		out[1] = in[1];
+		out[2] = swizzleBgr ? in[0] : in[2];
+	}
+	return rgb;
+}
+
+static uint Crc32(const uint8* data, size_t size, uint crc = 0) {
+	static const std::array<uint, 256> table = [] {
+		std::array<uint, 256> t {};
+		for (uint n = 0; n < 256; n++) {
+			uint c = n;
+			for (uint k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			t[n] = c;
+		}
+		return t;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void PushBigEndian(std::vector<uint8>& out, uint value) {
+	out.push_back(uint8(value >> 24));
+	out.push_back(uint8(value >> 16));
+	out.push_back(uint8(value >> 8));
+	out.push_back(uint8(value));
+}
+
+static void WritePngChunk(std::ofstream& file, const char* type, const std::vector<uint8>& data) {
+	std::vector<uint8> chunk;
+	chunk.reserve(data.size() + 12);
+	PushBigEndian(chunk, uint(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	PushBigEndian(chunk, Crc32(chunk.data() + 4, data.size() + 4));
+	file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+//? Uses stored (uncompressed) deflate blocks: no zlib dependency, and the
+//? encode cost stays a memcpy plus two checksums per frame.
+static void WritePng(std::ofstream& file, const std::vector<uint8>& rgb, uint width, uint height) {
+	const uint8 signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	std::vector<uint8> header;
+	PushBigEndian(header, width);
+	PushBigEndian(header, height);
+	header.insert(header.end(), {8, 2, 0, 0, 0}); //? 8 bit RGB, no interlace
+	WritePngChunk(file, "IHDR", header);
+
+	size_t rowSize = size_t(width) * 3;
+	std::vector<uint8> filtered;
+	filtered.reserve((rowSize + 1) * height);
+	for (uint y = 0; y < height; y++) {
+		filtered.push_back(0); //? Filter type: none
+		filtered.insert(filtered.end(), rgb.begin() + y * rowSize, rgb.begin() + (y + 1) * rowSize);
+	}
+
+	std::vector<uint8> zlib;
+	zlib.reserve(filtered.size() + filtered.size() / 65535 * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+
+	const size_t maxBlock = 65535;
+	size_t offset = 0;
+	do {
+		size_t blockSize = std::min(maxBlock, filtered.size() - offset);
+		bool last = offset + blockSize == filtered.size();
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back(uint8(blockSize));
+		zlib.push_back(uint8(blockSize >> 8));
+		zlib.push_back(uint8(~blockSize));
+		zlib.push_back(uint8(~blockSize >> 8));
+		zlib.insert(zlib.end(), filtered.begin() + offset, filtered.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < filtered.size());
+
+	uint a = 1, b = 0;
+	for (uint8 byte : filtered) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	PushBigEndian(zlib, (b << 16) | a);
+
+	WritePngChunk(file, "IDAT", zlib);
+	WritePngChunk(file, "IEND", {});
+}
+
+void FrameExporter::Init(const Context& context, VkExtent2D extent, VkFormat format) {
+	this->context = context;
+	this->extent = extent;
+	this->format = format;
+	frameSize = VkDeviceSize(extent.width) * extent.height * 4;
+
+	switch (format) {
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+			swizzleBgr = true;
+			break;
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+			swizzleBgr = false;
+			break;
+		default:
+			throw std::runtime_error("Frame export only supports 8 bit RGBA/BGRA swapchains.");
+	}
+
+	//? Readback wants cached memory, uncached reads are painfully slow on most hosts
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(context.physicalDevice, &memoryProperties);
+	VkMemoryPropertyFlags cachedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	bool cachedAvailable = false;
+	for (uint i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((memoryProperties.memoryTypes[i].propertyFlags & cachedFlags) == cachedFlags) {
+			cachedAvailable = true;
+			break;
+		}
+	}
+	VkMemoryPropertyFlags properties = cachedAvailable ? cachedFlags : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	memoryCoherent = !cachedAvailable;
+
+	slots.resize(Settings::exportRingSize);
+	for (Slot& slot : slots) {
+		context.CreateBuffer(frameSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, properties, slot.buffer, slot.memory);
+		if (vkMapMemory(context.device, slot.memory, 0, frameSize, 0, &slot.mapped) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't map a readback buffer.");
+		}
+	}
+
+	std::filesystem::create_directories(Settings::exportDirectory);
+	encoders = std::make_unique<ThreadPool>(Settings::exportEncoderThreads);
+	startTime = Clock::now();
+}
+
+void FrameExporter::CleanUp() {
+	encoders.reset();
+	for (Slot& slot : slots) {
+		vkUnmapMemory(context.device, slot.memory);
+		context.DestroyBuffer(slot.buffer, slot.memory);
+	}
+	slots.clear();
+}
+
+void FrameExporter::Collect() {
+	std::lock_guard<std::mutex> lock(mutex);
+	CollectLocked();
+}
+
+void FrameExporter::CollectLocked() {
+	for (uint i = 0; i < slots.size(); i++) {
+		Slot& slot = slots[i];
+		if (slot.state != SlotState::Copying or vkGetFenceStatus(context.device, slot.fence) != VK_SUCCESS) {
+			continue;
+		}
+
+		if (!memoryCoherent) {
+			VkMappedMemoryRange range {};
+			range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+			range.memory = slot.memory;
+			range.offset = 0;
+			range.size = VK_WHOLE_SIZE;
+			vkInvalidateMappedMemoryRanges(context.device, 1, &range);
+		}
+
+		slot.state = SlotState::Encoding;
+		slot.fence = VK_NULL_HANDLE;
+		encoders->Submit([this, i] { Encode(i); });
+	}
+}
+
+uint FrameExporter::AcquireSlot() {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (slots[nextSlot].state != SlotState::Free) {
+		SlotState blocking = slots[nextSlot].state;
+		Clock::time_point stallStart = Clock::now();
+
+		if (blocking == SlotState::Copying) {
+			CollectLocked();
+		}
+		if (slots[nextSlot].state != SlotState::Free) {
+			slotFreed.wait_for(lock, std::chrono::milliseconds(1));
+		}
+
+		double stall = std::chrono::duration<double>(Clock::now() - stallStart).count();
+		if (blocking == SlotState::Copying) {
+			copyStallSeconds += stall;
+		} else {
+			encodeStallSeconds += stall;
+		}
+	}
+
+	uint slot = nextSlot;
+	nextSlot = (nextSlot + 1) % slots.size();
+	slots[slot].state = SlotState::Recorded;
+	slots[slot].frameNumber = nextFrameNumber++;
+	return slot;
+}
+
+void FrameExporter::RecordCopy(VkCommandBuffer commandBuffer, VkImage image, uint slot, VkPipelineStageFlags writerStage, VkAccessFlags writerAccess) {
+	VkImageMemoryBarrier toTransfer {};
+	toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	toTransfer.srcAccessMask = writerAccess;
+	toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	toTransfer.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toTransfer.image = image;
+	toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	toTransfer.subresourceRange.baseMipLevel = 0;
+	toTransfer.subresourceRange.levelCount = 1;
+	toTransfer.subresourceRange.baseArrayLayer = 0;
+	toTransfer.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer, writerStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+	VkBufferImageCopy region {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0; //? Tightly packed
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = {0, 0, 0};
+	region.imageExtent = {extent.width, extent.height, 1};
+
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slots[slot].buffer, 1, &region);
+
+	VkImageMemoryBarrier toPresent = toTransfer;
+	toPresent.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	toPresent.dstAccessMask = 0;
+	toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+	VkBufferMemoryBarrier toHost {};
+	toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	toHost.buffer = slots[slot].buffer;
+	toHost.offset = 0;
+	toHost.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &toHost, 1, &toPresent);
+}
+
+void FrameExporter::Submitted(uint slot, VkFence fence) {
+	std::lock_guard<std::mutex> lock(mutex);
+	slots[slot].fence = fence;
+	slots[slot].state = SlotState::Copying;
+}
+
+void FrameExporter::AddGpuWait(double seconds) {
+	gpuWaitSeconds += seconds;
+}
+
+void FrameExporter::Flush() {
+	if (slots.empty()) {
+		return;
+	}
+
+	//? Only called once the device is idle, so every pending copy is complete
+	Collect();
+	encoders->Wait();
+}
+
+uint FrameExporter::FramesSubmitted() const {
+	return nextFrameNumber;
+}
+
+void FrameExporter::PrintStats() {
+	double elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+	uint frames = framesExported;
+
+	std::cout << "Frame export:\n";
+	std::cout << "\tFrames: " << frames << " in " << elapsed << " s (" << (elapsed > 0.0 ? frames / elapsed : 0.0) << " frames/s)\n";
+	std::cout << "\tGPU wait: " << gpuWaitSeconds << " s\n";
+	std::cout << "\tCopy stall: " << copyStallSeconds << " s\n";
+	std::cout << "\tEncode stall: " << encodeStallSeconds << " s\n";
+	std::cout << "\tEncode time: " << (frames > 0 ? encodeSeconds / frames * 1000.0 : 0.0) << " ms/frame on " << encoders->ThreadCount() << " threads\n";
+
+	//? Whatever the frame loop waited on the longest is the bottleneck.
+	//? If it barely waited at all, recording and submission are the limit.
+	double longest = std::max({gpuWaitSeconds, copyStallSeconds, encodeStallSeconds});
+	std::cout << "\tBound by: ";
+	if (longest < elapsed * 0.05) {
+		std::cout << "CPU (frame loop)";
+	} else if (longest == encodeStallSeconds) {
+		std::cout << "encode";
+	} else if (longest == copyStallSeconds) {
+		std::cout << "copy";
+	} else {
+		std::cout << "GPU";
+	}
+	std::cout << "\n" << std::endl;
+}
+
+void FrameExporter::Encode(uint slotIndex) {
+	Clock::time_point encodeStart = Clock::now();
+	Slot& slot = slots[slotIndex];
+	const uint8* pixels = static_cast<const uint8*>(slot.mapped);
+	std::string path = FramePath(slot.frameNumber);
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Couldn't open " << path << " for writing." << std::endl;
+	} else if (Settings::exportFormat == ExportFormat::Raw) {
+		file.write(reinterpret_cast<const char*>(pixels), frameSize);
+	} else {
+		std::vector<uint8> rgb = ToRgb(pixels, extent.width, extent.height, swizzleBgr);
+		if (Settings::exportFormat == ExportFormat::Ppm) {
+			std::string header = "P6\n" + std::to_string(extent.width) + " " + std::to_string(extent.height) + "\n255\n";
+			file.write(header.data(), header.size());
+			file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+		} else {
+			WritePng(file, rgb, extent.width, extent.height);
+		}
+	}
+	file.close();
+
+	double seconds = std::chrono::duration<double>(Clock::now() - encodeStart).count();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		encodeSeconds += seconds;
+		slot.state = SlotState::Free;
+	}
+	framesExported++;
+	slotFreed.notify_one();
+}
+
+std::string FrameExporter::FramePath(uint frameNumber) const {
+	const char* extension = ".raw";
+	if (Settings::exportFormat == ExportFormat::Ppm) {
+		extension = ".ppm";
+	} else if (Settings::exportFormat == ExportFormat::Png) {
+		extension = ".png";
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), "frame_%06u", frameNumber);
+	return Settings::exportDirectory + name + extension;
+}
@@ -0,0 +1,128 @@
+#include "GpuTimer.hpp"
+
+void GpuTimer::Init(const Context& context, uint queueFamily, uint maxScopes) {
+	device = context.device;
+	this->maxScopes = maxScopes;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+	timestampPeriod = properties.limits.timestampPeriod;
+
+	uint queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(context.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	uint validBits = queueFamilies[queueFamily].timestampValidBits;
+	if (validBits == 0) {
+		return;
+	}
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = maxScopes * 2 * Settings::maxFramesInFlight;
+
+	if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a query pool.");
+	}
+
+	results.resize(maxScopes);
+	written.resize(maxScopes * Settings::maxFramesInFlight, false);
+}
+
+void GpuTimer::CleanUp() {
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+}
+
+uint GpuTimer::AddScope(const std::string& name) {
+	if (names.size() >= maxScopes) {
+		throw std::runtime_error("Too many GPU timer scopes.");
+	}
+	names.push_back(name);
+	return uint(names.size() - 1);
+}
+
+bool GpuTimer::Enabled() const {
+	return queryPool != VK_NULL_HANDLE;
+}
+
+void GpuTimer::Resolve(uint frameIndex) {
+	if (!Enabled()) {
+		return;
+	}
+
+	for (uint scope = 0; scope < names.size(); scope++) {
+		if (!written[frameIndex * maxScopes + scope]) {
+			continue;
+		}
+
+		uint64 timestamps[2];
+		VkResult result = vkGetQueryPoolResults(device, queryPool, QueryIndex(frameIndex, scope), 2, sizeof(timestamps), timestamps, sizeof(uint64), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) {
+			continue;
+		}
+
+		results[scope].startMs = double(timestamps[0] & timestampMask) * timestampPeriod / 1e6;
+		results[scope].endMs = double(timestamps[1] & timestampMask) * timestampPeriod / 1e6;
+		results[scope].valid = true;
+	}
+}
+
+void GpuTimer::Reset(VkCommandBuffer commandBuffer, uint frameIndex) {
+	if (!Enabled()) {
+		return;
+	}
+
+	vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * maxScopes * 2, maxScopes * 2);
+	for (uint scope = 0; scope < maxScopes; scope++) {
+		written[frameIndex * maxScopes + scope] = false;
+	}
+}
+
+void GpuTimer::Begin(VkCommandBuffer commandBuffer, uint frameIndex, uint scope) {
+	if (!Enabled()) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, QueryIndex(frameIndex, scope));
+}
+
+void GpuTimer::End(VkCommandBuffer commandBuffer, uint frameIndex, uint scope) {
+	if (!Enabled()) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, QueryIndex(frameIndex, scope) + 1);
+	written[frameIndex * maxScopes + scope] = true;
+}
+
+uint GpuTimer::ScopeCount() const {
+	return uint(names.size());
+}
+
+const std::string& GpuTimer::Name(uint scope) const {
+	return names[scope];
+}
+
+bool GpuTimer::Valid(uint scope) const {
+	return Enabled() and results[scope].valid;
+}
+
+double GpuTimer::Milliseconds(uint scope) const {
+	return Valid(scope) ? results[scope].endMs - results[scope].startMs : 0.0;
+}
+
+double GpuTimer::StartMilliseconds(uint scope) const {
+	return results[scope].startMs;
+}
+
+double GpuTimer::EndMilliseconds(uint scope) const {
+	return results[scope].endMs;
+}
+
+uint GpuTimer::QueryIndex(uint frameIndex, uint scope) const {
+	return (frameIndex * maxScopes + scope) * 2;
+}
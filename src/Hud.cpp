@@ -0,0 +1,451 @@
+#include "Hud.hpp"
+#include <cstdarg>
+
+namespace {
+	//? Printable ASCII from space to tilde, five columns each, bit 0 at the top
+	const uint8 font[95][5] = {
+		{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7f, 0x14, 0x7f, 0x14 },
+		{ 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+		{ 0x00, 0x1c, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x14, 0x08, 0x3e, 0x08, 0x14 }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+		{ 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+		{ 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 },
+		{ 0x18, 0x14, 0x12, 0x7f, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+		{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+		{ 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+		{ 0x32, 0x49, 0x79, 0x41, 0x3e }, { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+		{ 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 }, { 0x3e, 0x41, 0x49, 0x49, 0x7a },
+		{ 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 },
+		{ 0x7f, 0x40, 0x40, 0x40, 0x40 }, { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+		{ 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+		{ 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f }, { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f },
+		{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 },
+		{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+		{ 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+		{ 0x38, 0x44, 0x44, 0x48, 0x7f }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x0c, 0x52, 0x52, 0x52, 0x3e },
+		{ 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3d, 0x00 }, { 0x7f, 0x10, 0x28, 0x44, 0x00 },
+		{ 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 }, { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+		{ 0x7c, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7c }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+		{ 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c }, { 0x3c, 0x40, 0x30, 0x40, 0x3c },
+		{ 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0c, 0x50, 0x50, 0x50, 0x3c }, { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+		{ 0x00, 0x00, 0x7f, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+	};
+	const uint32 solid[2] = { 0xffffffff, 0xff };
+
+	const float margin = 8.0f;
+	//? In glyph texels, scaled by Settings::hudScale
+	const float padding = 4.0f;
+	const float advance = 6.0f;
+	const float lineHeight = 9.0f;
+	const float graphHeight = 40.0f;
+	const double targetMs = 1000.0 / 60.0;
+
+	constexpr uint32 Color(uint r, uint g, uint b, uint a) {
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+	const uint32 backdropColor = Color(0, 0, 0, 160);
+	const uint32 textColor = Color(235, 235, 235, 255);
+	const uint32 cpuColor = Color(80, 160, 255, 255);
+	const uint32 gpuColor = Color(255, 150, 60, 255);
+	const uint32 targetColor = Color(90, 220, 90, 200);
+}
+
+void Hud::Init(const Context& context, VkFormat format, const std::vector<VkImageView>& imageViews, VkExtent2D extent) {
+	this->context = context;
+	this->extent = extent;
+	cpuHistory.assign(Settings::hudGraphFrames, 0.0f);
+	gpuHistory.assign(Settings::hudGraphFrames, -1.0f);
+
+	CreateRenderPass(format);
+	CreateFramebuffers(imageViews);
+	CreatePipeline();
+	CreateBuffers();
+}
+
+void Hud::CleanUp() {
+	for (FrameBuffer& frame : frameBuffers) {
+		vkUnmapMemory(context.device, frame.memory);
+		context.DestroyBuffer(frame.buffer, frame.memory);
+	}
+	vkDestroyPipeline(context.device, pipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+	for (VkFramebuffer framebuffer : framebuffers) {
+		vkDestroyFramebuffer(context.device, framebuffer, nullptr);
+	}
+	vkDestroyRenderPass(context.device, renderPass, nullptr);
+}
+
+void Hud::CreateRenderPass(VkFormat format) {
+	//? Drawn over whatever the frame left in the image
+	VkAttachmentDescription colorAttachment {};
+	colorAttachment.format = format;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+	VkAttachmentReference attachmentReference {};
+	attachmentReference.attachment = 0;
+	attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &attachmentReference;
+
+	//? Whatever came last, the frame's own pass, the upscale blit or an export copy's transition back to
+	//? PRESENT_SRC_KHR made at the bottom of the pipe. It's the tail of the frame, waiting on all of it costs nothing
+	VkSubpassDependency dependency {};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	if (vkCreateRenderPass(context.device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a render pass.");
+	}
+}
+
+void Hud::CreateFramebuffers(const std::vector<VkImageView>& imageViews) {
+	framebuffers.resize(imageViews.size());
+	for (uint i = 0; i < imageViews.size(); i++) {
+		VkFramebufferCreateInfo framebufferInfo {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &imageViews[i];
+		framebufferInfo.width = extent.width;
+		framebufferInfo.height = extent.height;
+		framebufferInfo.layers = 1;
+
+		if (vkCreateFramebuffer(context.device, &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a framebuffer.");
+		}
+	}
+}
+
+void Hud::CreatePipeline() {
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::vec2);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+
+	pipeline = BuildPipeline();
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline Hud::BuildPipeline() const {
+	VkShaderModule vertModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/hud.vert.spv"));
+	VkShaderModule fragModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/hud.frag.spv"));
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> stages {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertModule;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragModule;
+	stages[1].pName = "main";
+
+	VkVertexInputBindingDescription binding {};
+	binding.binding = 0;
+	binding.stride = sizeof(Vertex);
+	binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	std::array<VkVertexInputAttributeDescription, 4> attributes {};
+	attributes[0].location = 0;
+	attributes[0].format = VK_FORMAT_R32G32_SFLOAT;
+	attributes[0].offset = offsetof(Vertex, position);
+	attributes[1].location = 1;
+	attributes[1].format = VK_FORMAT_R32G32_SFLOAT;
+	attributes[1].offset = offsetof(Vertex, cell);
+	attributes[2].location = 2;
+	attributes[2].format = VK_FORMAT_R32G32_UINT;
+	attributes[2].offset = offsetof(Vertex, glyph);
+	attributes[3].location = 3;
+	attributes[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+	attributes[3].offset = offsetof(Vertex, color);
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &binding;
+	vertexInputInfo.vertexAttributeDescriptionCount = attributes.size();
+	vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo {};
+	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	//? The swap chain never changes size, the whole image is the viewport
+	VkViewport viewport {};
+	viewport.width = float(extent.width);
+	viewport.height = float(extent.height);
+	viewport.maxDepth = 1.0f;
+	VkRect2D scissor {};
+	scissor.extent = extent;
+
+	VkPipelineViewportStateCreateInfo viewportInfo {};
+	viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportInfo.viewportCount = 1;
+	viewportInfo.pViewports = &viewport;
+	viewportInfo.scissorCount = 1;
+	viewportInfo.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
+	rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizerInfo.cullMode = VK_CULL_MODE_NONE;
+	rasterizerInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizerInfo.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisamplingInfo {};
+	multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_TRUE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendInfo {};
+	colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendInfo.attachmentCount = 1;
+	colorBlendInfo.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = stages.size();
+	pipelineInfo.pStages = stages.data();
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+	pipelineInfo.pViewportState = &viewportInfo;
+	pipelineInfo.pRasterizationState = &rasterizerInfo;
+	pipelineInfo.pMultisampleState = &multisamplingInfo;
+	pipelineInfo.pColorBlendState = &colorBlendInfo;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	VkPipeline built;
+	if (vkCreateGraphicsPipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a graphics pipeline");
+	}
+	vkDestroyShaderModule(context.device, vertModule, nullptr);
+	vkDestroyShaderModule(context.device, fragModule, nullptr);
+	return built;
+}
+
+void Hud::CreateBuffers() {
+	//? Written by the CPU every frame and read once by the GPU, staging would only add a copy
+	VkDeviceSize size = VkDeviceSize(Settings::hudMaxQuads) * 6 * sizeof(Vertex);
+	frameBuffers.resize(Settings::maxFramesInFlight);
+	for (FrameBuffer& frame : frameBuffers) {
+		context.CreateBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.buffer, frame.memory);
+		void* mapped;
+		vkMapMemory(context.device, frame.memory, 0, size, 0, &mapped);
+		frame.vertices = static_cast<Vertex*>(mapped);
+	}
+}
+
+void Hud::BeginFrame(uint frameIndex, double cpuMs, double gpuMs) {
+	currentFrame = frameIndex;
+	quads = 0;
+
+	cpuHistory[historyHead] = float(cpuMs);
+	gpuHistory[historyHead] = float(gpuMs);
+	historyHead = (historyHead + 1) % cpuHistory.size();
+	historyCount = std::min(historyCount + 1, uint(cpuHistory.size()));
+
+	//? The backdrop goes first so it's drawn under everything, Record sizes it once the lines are in
+	Rectangle(0.0f, 0.0f, 0.0f, 0.0f, backdropColor);
+	Graph();
+
+	double cpuSum = 0.0;
+	double gpuSum = 0.0;
+	uint gpuFrames = 0;
+	for (uint i = 0; i < historyCount; i++) {
+		cpuSum += cpuHistory[i];
+		if (gpuHistory[i] >= 0.0f) {
+			gpuSum += gpuHistory[i];
+			gpuFrames++;
+		}
+	}
+	if (gpuFrames > 0) {
+		Line("CPU %.2f ms  GPU %.2f ms  (%u frames)", cpuSum / historyCount, gpuSum / gpuFrames, historyCount);
+	} else {
+		Line("CPU %.2f ms  GPU untimed  (%u frames)", cpuSum / historyCount, historyCount);
+	}
+}
+
+void Hud::Line(const char* format, ...) {
+	char text[256];
+	va_list arguments;
+	va_start(arguments, format);
+	vsnprintf(text, sizeof(text), format, arguments);
+	va_end(arguments);
+	text[std::min<size_t>(Settings::hudColumns, sizeof(text) - 1)] = '\0';
+
+	float scale = float(Settings::hudScale);
+	float x = margin + padding * scale;
+	Text(x, cursorY, text, textColor);
+	panelWidth = std::max(panelWidth, float(strlen(text)) * advance * scale);
+	cursorY += lineHeight * scale;
+}
+
+void Hud::Timings(const GpuTimer& timer) {
+	for (uint scope = 0; scope < timer.ScopeCount(); scope++) {
+		if (timer.Valid(scope)) {
+			Line("  %-26s %6.3f ms", timer.Name(scope).c_str(), timer.Milliseconds(scope));
+		}
+	}
+}
+
+void Hud::Record(VkCommandBuffer commandBuffer, uint imageIndex) {
+	float scale = float(Settings::hudScale);
+	uint drawn = quads;
+	quads = 0;
+	Rectangle(margin, margin, panelWidth + 2.0f * padding * scale, cursorY - margin + (padding - (lineHeight - 7.0f)) * scale, backdropColor);
+	quads = drawn;
+
+	frames++;
+	totalQuads += quads;
+	peakQuads = std::max(peakQuads, quads);
+
+	VkRenderPassBeginInfo renderPassInfo {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffers[imageIndex];
+	renderPassInfo.renderArea.extent = extent;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	glm::vec2 pixelToClip(2.0f / extent.width, 2.0f / extent.height);
+	VkDeviceSize offset = 0;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &frameBuffers[currentFrame].buffer, &offset);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::vec2), &pixelToClip);
+	vkCmdDraw(commandBuffer, quads * 6, 1, 0, 0);
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	cursorY = 0.0f;
+	panelWidth = 0.0f;
+}
+
+void Hud::RegisterShaders(ShaderReloader& reloader) {
+	reloader.Register("hud", { "src/Shaders/hud.vert", "src/Shaders/hud.frag" }, pipeline, [this] { return BuildPipeline(); });
+}
+
+void Hud::PrintStats() {
+	std::cout << "HUD:\n";
+	if (frames == 0) {
+		std::cout << "\tNo frames drawn\n" << std::endl;
+		return;
+	}
+	double averageQuads = double(totalQuads) / frames;
+	std::cout << "\tQuads: " << averageQuads << " per frame, peak " << peakQuads << " of " << Settings::hudMaxQuads << "\n";
+	std::cout << "\tVertex data: " << averageQuads * 6 * sizeof(Vertex) / 1024.0 << " KiB per frame, one draw\n";
+	if (droppedQuads > 0) {
+		std::cout << "\tDropped: " << droppedQuads << " quads over the limit\n";
+	}
+	std::cout << std::endl;
+}
+
+void Hud::Quad(float x, float y, float width, float height, const uint32 glyph[2], uint32 color) {
+	if (quads >= Settings::hudMaxQuads) {
+		droppedQuads++;
+		return;
+	}
+	const glm::vec2 corners[6] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+	Vertex* vertices = frameBuffers[currentFrame].vertices + quads * 6;
+	for (uint i = 0; i < 6; i++) {
+		vertices[i].position = glm::vec2(x + corners[i].x * width, y + corners[i].y * height);
+		vertices[i].cell = corners[i] * glm::vec2(5.0f, 7.0f);
+		vertices[i].glyph[0] = glyph[0];
+		vertices[i].glyph[1] = glyph[1];
+		vertices[i].color = color;
+	}
+	quads++;
+}
+
+void Hud::Rectangle(float x, float y, float width, float height, uint32 color) {
+	Quad(x, y, width, height, solid, color);
+}
+
+void Hud::Text(float x, float y, const char* text, uint32 color) {
+	float scale = float(Settings::hudScale);
+	for (uint i = 0; text[i] != '\0'; i++) {
+		uint character = uint8(text[i]);
+		if (character == ' ') {
+			continue;
+		}
+		if (character < 32 or character > 126) {
+			character = '?';
+		}
+		const uint8* columns = font[character - 32];
+		uint32 glyph[2] = { columns[0] | (uint32(columns[1]) << 8) | (uint32(columns[2]) << 16) | (uint32(columns[3]) << 24), columns[4] };
+		Quad(x + i * advance * scale, y, 5.0f * scale, 7.0f * scale, glyph, color);
+	}
+}
+
+void Hud::Graph() {
+	float scale = float(Settings::hudScale);
+	float left = margin + padding * scale;
+	float top = margin + padding * scale;
+	float height = graphHeight * scale;
+	float barWidth = scale;
+
+	//? Two frames of the target at the top unless something took longer
+	float topMs = float(2.0 * targetMs);
+	for (uint i = 0; i < historyCount; i++) {
+		topMs = std::max({ topMs, cpuHistory[i], gpuHistory[i] });
+	}
+
+	//? Oldest on the left, CPU and GPU side by side
+	uint size = cpuHistory.size();
+	for (uint i = 0; i < historyCount; i++) {
+		uint index = (historyHead + size - historyCount + i) % size;
+		float x = left + i * 2.0f * barWidth;
+		float cpuHeight = std::min(cpuHistory[index] / topMs, 1.0f) * height;
+		Rectangle(x, top + height - cpuHeight, barWidth, cpuHeight, cpuColor);
+		if (gpuHistory[index] >= 0.0f) {
+			float gpuHeight = std::min(gpuHistory[index] / topMs, 1.0f) * height;
+			Rectangle(x + barWidth, top + height - gpuHeight, barWidth, gpuHeight, gpuColor);
+		}
+	}
+
+	float graphWidth = size * 2.0f * barWidth;
+	float targetY = top + height - float(targetMs / topMs) * height;
+	Rectangle(left, targetY, graphWidth, scale * 0.5f, targetColor);
+
+	panelWidth = std::max(panelWidth, graphWidth);
+	cursorY = top + height + padding * scale;
+}
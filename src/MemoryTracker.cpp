@@ -0,0 +1,233 @@
+#include "MemoryTracker.hpp"
+
+namespace {
+	//? Without VK_EXT_memory_budget, leave headroom for other processes and the driver
+	const double estimatedBudgetShare = 0.8;
+}
+
+void MemoryTracker::Init(VkPhysicalDevice physicalDevice, bool budgetExtension) {
+	this->physicalDevice = physicalDevice;
+	this->budgetExtension = budgetExtension;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	maxAllocations = properties.limits.maxMemoryAllocationCount;
+
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+	heaps.resize(memoryProperties.memoryHeapCount);
+	for (uint i = 0; i < heaps.size(); i++) {
+		heaps[i].size = memoryProperties.memoryHeaps[i].size;
+		heaps[i].deviceLocal = memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	}
+	types.resize(memoryProperties.memoryTypeCount);
+	for (uint i = 0; i < types.size(); i++) {
+		types[i].heap = memoryProperties.memoryTypes[i].heapIndex;
+		types[i].flags = memoryProperties.memoryTypes[i].propertyFlags;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	QueryBudgetLocked();
+}
+
+VkResult MemoryTracker::Allocate(VkDevice device, const VkMemoryAllocateInfo& allocInfo, VkDeviceSize requested, const std::string& tag, VkDeviceMemory& memory) {
+	uint type = allocInfo.memoryTypeIndex;
+	uint heap = memoryProperties.memoryTypes[type].heapIndex;
+
+	if (OverBudget(heap, allocInfo.allocationSize)) {
+		RelievePressure(heap, allocInfo.allocationSize);
+	}
+
+	VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+	if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY or result == VK_ERROR_OUT_OF_HOST_MEMORY) {
+		//? The budget is only a hint, the driver can still run out first
+		RelievePressure(heap, allocInfo.allocationSize);
+		result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (result != VK_SUCCESS) {
+		failedAllocations++;
+		return result;
+	}
+
+	allocations[memory] = { allocInfo.allocationSize, requested, type, tag };
+	types[type].allocated += allocInfo.allocationSize;
+	types[type].requested += requested;
+	types[type].allocations++;
+	heaps[heap].allocated += allocInfo.allocationSize;
+	heaps[heap].peakAllocated = std::max(heaps[heap].peakAllocated, heaps[heap].allocated);
+	heaps[heap].allocations++;
+	return result;
+}
+
+void MemoryTracker::Free(VkDevice device, VkDeviceMemory memory) {
+	if (memory == VK_NULL_HANDLE) {
+		return;
+	}
+	vkFreeMemory(device, memory, nullptr);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = allocations.find(memory);
+	if (found == allocations.end()) {
+		return;
+	}
+	const Allocation& allocation = found->second;
+	TypeStats& type = types[allocation.type];
+	type.allocated -= allocation.size;
+	type.requested -= allocation.requested;
+	type.allocations--;
+	heaps[type.heap].allocated -= allocation.size;
+	heaps[type.heap].allocations--;
+	allocations.erase(found);
+}
+
+uint MemoryTracker::AddPressureHandler(uint priority, PressureHandler handler) {
+	std::lock_guard<std::mutex> lock(mutex);
+	uint id = nextHandlerId++;
+	handlers.push_back({ id, priority, std::move(handler) });
+	std::stable_sort(handlers.begin(), handlers.end(), [](const Handler& a, const Handler& b) {
+		return a.priority < b.priority;
+	});
+	return id;
+}
+
+void MemoryTracker::RemovePressureHandler(uint id) {
+	std::lock_guard<std::mutex> lock(mutex);
+	handlers.erase(std::remove_if(handlers.begin(), handlers.end(), [&](const Handler& handler) {
+		return handler.id == id;
+	}), handlers.end());
+}
+
+bool MemoryTracker::DeviceLocal(uint heap) const {
+	return memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+}
+
+std::vector<MemoryTracker::HeapStats> MemoryTracker::HeapStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	QueryBudgetLocked();
+	return heaps;
+}
+
+void MemoryTracker::HeapStatistics(std::vector<HeapStats>& stats) {
+	std::lock_guard<std::mutex> lock(mutex);
+	QueryBudgetLocked();
+	stats.assign(heaps.begin(), heaps.end());
+}
+
+std::vector<MemoryTracker::TypeStats> MemoryTracker::TypeStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return types;
+}
+
+double MemoryTracker::PaddingOverhead() {
+	std::lock_guard<std::mutex> lock(mutex);
+	VkDeviceSize allocated = 0;
+	VkDeviceSize requested = 0;
+	for (const TypeStats& type : types) {
+		allocated += type.allocated;
+		requested += type.requested;
+	}
+	return allocated > 0 ? 1.0 - double(requested) / double(allocated) : 0.0;
+}
+
+uint MemoryTracker::AllocationCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return allocations.size();
+}
+
+void MemoryTracker::PrintStats() {
+	std::vector<HeapStats> heapStats = HeapStatistics();
+	std::vector<TypeStats> typeStats = TypeStatistics();
+	double paddingOverhead = PaddingOverhead();
+	uint allocationCount = AllocationCount();
+
+	std::cout << "GPU memory:\n";
+	std::cout << "\tBudget source: " << (budgetExtension ? "VK_EXT_memory_budget" : "estimated from heap sizes") << "\n";
+	std::cout << "\tAllocations: " << allocationCount << " of " << maxAllocations << ", padding overhead " << paddingOverhead * 100.0 << "%\n";
+	for (uint i = 0; i < heapStats.size(); i++) {
+		const HeapStats& heap = heapStats[i];
+		std::cout << "\tHeap " << i << (heap.deviceLocal ? " (device local)" : "") << ": ";
+		std::cout << heap.allocated / 1024 << " KiB in " << heap.allocations << " allocations, peak " << heap.peakAllocated / 1024 << " KiB, ";
+		std::cout << "usage " << heap.usage / (1024 * 1024) << " of " << heap.budget / (1024 * 1024) << " MiB budget (" << heap.size / (1024 * 1024) << " MiB heap)\n";
+	}
+	for (uint i = 0; i < typeStats.size(); i++) {
+		const TypeStats& type = typeStats[i];
+		if (type.allocations == 0) {
+			continue;
+		}
+		std::cout << "\tType " << i << " (heap " << type.heap << ", flags 0x" << std::hex << type.flags << std::dec << "): ";
+		std::cout << type.allocated / 1024 << " KiB in " << type.allocations << " allocations\n";
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::cout << "\tPressure events: " << pressureEvents << ", released " << pressureReleased / 1024 << " KiB, failed allocations: " << failedAllocations << "\n";
+	std::cout << std::endl;
+}
+
+uint MemoryTracker::ReportLeaks() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (allocations.empty()) {
+		return 0;
+	}
+
+	std::cout << "GPU memory leaks:\n";
+	VkDeviceSize total = 0;
+	for (const auto& entry : allocations) {
+		const Allocation& allocation = entry.second;
+		std::cout << "\t" << allocation.tag << ": " << allocation.size << " bytes, type " << allocation.type << "\n";
+		total += allocation.size;
+	}
+	std::cout << "\t" << allocations.size() << " allocations, " << total << " bytes\n";
+	std::cout << std::endl;
+	return allocations.size();
+}
+
+void MemoryTracker::QueryBudgetLocked() {
+	if (!budgetExtension) {
+		for (HeapStats& heap : heaps) {
+			heap.budget = VkDeviceSize(heap.size * estimatedBudgetShare);
+			heap.usage = heap.allocated;
+		}
+		return;
+	}
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	VkPhysicalDeviceMemoryProperties2 properties2 {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	properties2.pNext = &budgetProperties;
+	vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties2);
+
+	for (uint i = 0; i < heaps.size(); i++) {
+		heaps[i].budget = budgetProperties.heapBudget[i];
+		heaps[i].usage = budgetProperties.heapUsage[i];
+	}
+}
+
+bool MemoryTracker::OverBudget(uint heap, VkDeviceSize size) {
+	std::lock_guard<std::mutex> lock(mutex);
+	QueryBudgetLocked();
+	return heaps[heap].usage + size > heaps[heap].budget;
+}
+
+void MemoryTracker::RelievePressure(uint heap, VkDeviceSize needed) {
+	//? Handlers free memory through Free, so they run without the lock held
+	std::vector<Handler> current;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		current = handlers;
+		pressureEvents++;
+	}
+
+	VkDeviceSize released = 0;
+	for (const Handler& handler : current) {
+		if (released >= needed) {
+			break;
+		}
+		released += handler.release(heap, needed - released);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	pressureReleased += released;
+}
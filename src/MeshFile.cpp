@@ -0,0 +1,222 @@
+#include "MeshFile.hpp"
+#include <type_traits>
+#if WINDOWS
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+	uint64 AlignUp(uint64 value) {
+		return (value + MeshFile::sectionAlignment - 1) / MeshFile::sectionAlignment * MeshFile::sectionAlignment;
+	}
+
+	template<typename T>
+	MeshFile::Section Append(std::string& bytes, const T* values, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "Sections take plain structs only");
+		bytes.resize(AlignUp(bytes.size()), '\0');
+		MeshFile::Section section { bytes.size(), count * sizeof(T) };
+		bytes.append(reinterpret_cast<const char*>(values), section.size);
+		return section;
+	}
+
+	bool InRange(uint offset, uint count, uint64 total) {
+		return uint64(offset) + count <= total;
+	}
+}
+
+void MeshFile::Write(const std::string& path, const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, const std::vector<Mesh>& meshes, const std::vector<Lod>& lods, const std::vector<Meshlet>& meshlets, const std::string& names) {
+	Header header {};
+	header.magic = magic;
+	header.version = version;
+	header.vertexStride = sizeof(MeshVertex);
+	header.indexSize = sizeof(uint);
+
+	std::string bytes(sizeof(Header), '\0');
+	header.vertices = Append(bytes, vertices.data(), vertices.size());
+	header.indices = Append(bytes, indices.data(), indices.size());
+	header.meshes = Append(bytes, meshes.data(), meshes.size());
+	header.lods = Append(bytes, lods.data(), lods.size());
+	header.meshlets = Append(bytes, meshlets.data(), meshlets.size());
+	header.names = Append(bytes, names.data(), names.size());
+	memcpy(bytes.data(), &header, sizeof(Header));
+
+	std::ofstream file(path, std::ios::binary);
+	file.write(bytes.data(), bytes.size());
+	if (!file) {
+		throw std::runtime_error("Couldn't write the mesh file " + path + ".");
+	}
+}
+
+void MeshFile::Open(const std::string& path) {
+	Close();
+
+	#if WINDOWS
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error("Couldn't open the mesh file " + path + ".");
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = uint64(fileSize.QuadPart);
+		if (size >= sizeof(Header)) {
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr) {
+				data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+		}
+		//? The view keeps the file open
+		CloseHandle(file);
+	#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			throw std::runtime_error("Couldn't open the mesh file " + path + ".");
+		}
+		struct stat status;
+		fstat(file, &status);
+		size = uint64(status.st_size);
+		if (size >= sizeof(Header)) {
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED) {
+				data = static_cast<const char*>(mapped);
+				//? Every page is about to be copied into staging memory, start reading ahead now
+				madvise(mapped, size, MADV_WILLNEED);
+			}
+		}
+		//? The mapping keeps the file open
+		close(file);
+	#endif
+
+	if (size < sizeof(Header)) {
+		size = 0;
+		throw std::runtime_error("Couldn't read the mesh file " + path + ", it's truncated.");
+	}
+	if (data == nullptr) {
+		size = 0;
+		throw std::runtime_error("Couldn't map the mesh file " + path + ".");
+	}
+
+	const Header& header = GetHeader();
+	std::string problem;
+	if (header.magic != magic) {
+		problem = "it isn't a mesh file";
+	} else if (header.version != version) {
+		problem = "it's version " + std::to_string(header.version) + ", this build reads " + std::to_string(version);
+	} else if (header.vertexStride != sizeof(MeshVertex) or header.indexSize != sizeof(uint)) {
+		problem = "its vertex layout doesn't match this build";
+	}
+	const Section* sections[] = { &header.vertices, &header.indices, &header.meshes, &header.lods, &header.meshlets, &header.names };
+	for (const Section* section : sections) {
+		if (problem.empty() and (section->offset % sectionAlignment != 0 or section->offset > size or section->size > size - section->offset)) {
+			problem = "a section is out of bounds";
+		}
+	}
+	if (problem.empty() and (header.vertices.size % sizeof(MeshVertex) != 0 or header.indices.size % sizeof(uint) != 0 or header.meshes.size % sizeof(Mesh) != 0
+		or header.lods.size % sizeof(Lod) != 0 or header.meshlets.size % sizeof(Meshlet) != 0)) {
+		problem = "a section's size isn't a whole number of records";
+	}
+	if (problem.empty()) {
+		uint lodCount = header.lods.size / sizeof(Lod);
+		uint meshletCount = header.meshlets.size / sizeof(Meshlet);
+		for (uint i = 0; i < MeshCount(); i++) {
+			const Mesh& mesh = Meshes()[i];
+			bool valid = mesh.lodCount > 0 and InRange(mesh.vertexOffset, mesh.vertexCount, VertexCount()) and InRange(mesh.lodOffset, mesh.lodCount, lodCount)
+				and InRange(mesh.meshletOffset, mesh.meshletCount, meshletCount) and InRange(mesh.nameOffset, mesh.nameLength, header.names.size);
+			for (uint lod = 0; valid and lod < mesh.lodCount; lod++) {
+				valid = InRange(Lods()[mesh.lodOffset + lod].indexOffset, Lods()[mesh.lodOffset + lod].indexCount, IndexCount());
+			}
+			//? Meshlets index into the finest level
+			for (uint meshlet = 0; valid and meshlet < mesh.meshletCount; meshlet++) {
+				const Meshlet& record = Meshlets()[mesh.meshletOffset + meshlet];
+				valid = uint64(record.triangleCount) * 3 <= Lods()[mesh.lodOffset].indexCount and InRange(record.indexOffset, record.triangleCount * 3, Lods()[mesh.lodOffset].indexCount);
+			}
+			if (!valid) {
+				problem = "mesh " + std::to_string(i) + " has a range out of bounds";
+				break;
+			}
+			//? Indices are relative to the mesh's first vertex, the draws pass vertexOffset as the base.
+			//? One pass over them is cheap next to copying them into the index buffer
+			for (uint lod = 0; valid and lod < mesh.lodCount; lod++) {
+				const Lod& range = Lods()[mesh.lodOffset + lod];
+				const uint* indices = Indices() + range.indexOffset;
+				for (uint index = 0; valid and index < range.indexCount; index++) {
+					valid = indices[index] < mesh.vertexCount;
+				}
+			}
+			if (!valid) {
+				problem = "mesh " + std::to_string(i) + " has an index past its vertices";
+				break;
+			}
+		}
+	}
+	if (!problem.empty()) {
+		Close();
+		throw std::runtime_error("Couldn't read the mesh file " + path + ", " + problem + ".");
+	}
+}
+
+void MeshFile::Close() {
+	if (data != nullptr) {
+		#if WINDOWS
+			UnmapViewOfFile(data);
+		#else
+			munmap(const_cast<char*>(data), size);
+		#endif
+	}
+	data = nullptr;
+	size = 0;
+}
+
+uint64 MeshFile::Bytes() const {
+	return size;
+}
+
+uint MeshFile::VertexCount() const {
+	return GetHeader().vertices.size / sizeof(MeshVertex);
+}
+
+uint MeshFile::IndexCount() const {
+	return GetHeader().indices.size / sizeof(uint);
+}
+
+uint MeshFile::MeshCount() const {
+	return GetHeader().meshes.size / sizeof(Mesh);
+}
+
+const MeshVertex* MeshFile::Vertices() const {
+	return static_cast<const MeshVertex*>(GetSection(GetHeader().vertices));
+}
+
+const uint* MeshFile::Indices() const {
+	return static_cast<const uint*>(GetSection(GetHeader().indices));
+}
+
+const MeshFile::Mesh* MeshFile::Meshes() const {
+	return static_cast<const Mesh*>(GetSection(GetHeader().meshes));
+}
+
+const MeshFile::Lod* MeshFile::Lods() const {
+	return static_cast<const Lod*>(GetSection(GetHeader().lods));
+}
+
+const MeshFile::Meshlet* MeshFile::Meshlets() const {
+	return static_cast<const Meshlet*>(GetSection(GetHeader().meshlets));
+}
+
+std::string MeshFile::Name(const Mesh& mesh) const {
+	return std::string(static_cast<const char*>(GetSection(GetHeader().names)) + mesh.nameOffset, mesh.nameLength);
+}
+
+const MeshFile::Header& MeshFile::GetHeader() const {
+	return *reinterpret_cast<const Header*>(data);
+}
+
+const void* MeshFile::GetSection(const Section& section) const {
+	return data + section.offset;
+}
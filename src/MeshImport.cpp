@@ -0,0 +1,610 @@
+#include "MeshImport.hpp"
+#include <unordered_map>
+#include <numeric>
+#include <cctype>
+
+namespace {
+	const uint gltfTriangles = 4;
+	const uint gltfFloat = 5126;
+	const uint gltfUnsignedByte = 5121;
+	const uint gltfUnsignedShort = 5123;
+	const uint gltfUnsignedInt = 5125;
+	const uint glbMagic = 0x46546c67;
+	const uint glbJsonChunk = 0x4e4f534a;
+	const uint glbBinaryChunk = 0x004e4942;
+
+	std::string ReadBytes(const std::string& path) {
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("Couldn't open " + path + ".");
+		}
+		std::string bytes;
+		bytes.resize(size_t(file.tellg()));
+		file.seekg(0);
+		file.read(bytes.data(), bytes.size());
+		return bytes;
+	}
+
+	std::string Directory(const std::string& path) {
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	}
+
+	std::string Stem(const std::string& path) {
+		std::string name = path.substr(Directory(path).size());
+		return name.substr(0, name.find_last_of('.'));
+	}
+
+	std::string Extension(const std::string& path) {
+		size_t dot = path.find_last_of('.');
+		std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(std::tolower(c)); });
+		return extension;
+	}
+
+	//? The OBJ readers stay on their line, strtof and strtol would skip a newline as whitespace
+	void SkipBlanks(const char*& cursor, const char* lineEnd) {
+		while (cursor < lineEnd and (*cursor == ' ' or *cursor == '\t' or *cursor == '\r')) {
+			cursor++;
+		}
+	}
+
+	bool ReadFloat(const char*& cursor, const char* lineEnd, float& value) {
+		SkipBlanks(cursor, lineEnd);
+		char* next;
+		value = std::strtof(cursor, &next);
+		if (next == cursor or next > lineEnd) {
+			return false;
+		}
+		cursor = next;
+		return true;
+	}
+
+	bool ReadInt(const char*& cursor, const char* lineEnd, long& value) {
+		char* next;
+		value = std::strtol(cursor, &next, 10);
+		if (next == cursor or next > lineEnd) {
+			return false;
+		}
+		cursor = next;
+		return true;
+	}
+
+	//? 1 based, negative counts back from the last one read
+	bool Resolve(long index, size_t count, uint& resolved) {
+		long value = index < 0 ? long(count) + index : index - 1;
+		resolved = uint(value);
+		return value >= 0 and size_t(value) < count;
+	}
+
+	//? Enough JSON for glTF: objects keep their members in order, numbers are doubles
+	struct Json {
+		enum class Type { Null, Boolean, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<Json> items;
+		std::vector<std::pair<std::string, Json>> members;
+
+		const Json& operator[](const std::string& key) const {
+			static const Json null;
+			for (const auto& member : members) {
+				if (member.first == key) {
+					return member.second;
+				}
+			}
+			return null;
+		}
+
+		const Json& operator[](size_t index) const {
+			static const Json null;
+			return index < items.size() ? items[index] : null;
+		}
+
+		bool Has(const std::string& key) const {
+			return (*this)[key].type != Type::Null;
+		}
+
+		uint64 Integer(uint64 fallback) const {
+			return type == Type::Number ? uint64(number) : fallback;
+		}
+	};
+
+	class JsonParser {
+	public:
+		JsonParser(const std::string& text, const std::string& path) : text(text), path(path) {}
+
+		Json Parse() {
+			Json value = Value();
+			Skip();
+			if (position != text.size()) {
+				Fail("trailing characters");
+			}
+			return value;
+		}
+
+	private:
+		const std::string& text;
+		const std::string& path;
+		size_t position = 0;
+
+		[[noreturn]] void Fail(const std::string& problem) {
+			throw std::runtime_error("Couldn't read " + path + ", " + problem + " at byte " + std::to_string(position) + ".");
+		}
+
+		void Skip() {
+			while (position < text.size() and std::isspace(uint8(text[position]))) {
+				position++;
+			}
+		}
+
+		char Peek() {
+			Skip();
+			if (position >= text.size()) {
+				Fail("unexpected end");
+			}
+			return text[position];
+		}
+
+		void Expect(char c) {
+			if (Peek() != c) {
+				Fail(std::string("expected '") + c + "'");
+			}
+			position++;
+		}
+
+		bool Literal(const char* word) {
+			size_t length = strlen(word);
+			if (text.compare(position, length, word) != 0) {
+				return false;
+			}
+			position += length;
+			return true;
+		}
+
+		Json Value() {
+			Json value;
+			char c = Peek();
+			if (c == '{') {
+				value.type = Json::Type::Object;
+				position++;
+				while (Peek() != '}') {
+					std::string key = String();
+					Expect(':');
+					value.members.emplace_back(std::move(key), Value());
+					if (Peek() != ',') {
+						break;
+					}
+					position++;
+				}
+				Expect('}');
+			} else if (c == '[') {
+				value.type = Json::Type::Array;
+				position++;
+				while (Peek() != ']') {
+					value.items.push_back(Value());
+					if (Peek() != ',') {
+						break;
+					}
+					position++;
+				}
+				Expect(']');
+			} else if (c == '"') {
+				value.type = Json::Type::String;
+				value.string = String();
+			} else if (Literal("true")) {
+				value.type = Json::Type::Boolean;
+				value.boolean = true;
+			} else if (Literal("false")) {
+				value.type = Json::Type::Boolean;
+			} else if (Literal("null")) {
+				value.type = Json::Type::Null;
+			} else {
+				char* end;
+				value.type = Json::Type::Number;
+				value.number = std::strtod(text.c_str() + position, &end);
+				if (end == text.c_str() + position) {
+					Fail("unexpected character");
+				}
+				position = end - text.c_str();
+			}
+			return value;
+		}
+
+		std::string String() {
+			Expect('"');
+			std::string value;
+			while (position < text.size() and text[position] != '"') {
+				char c = text[position++];
+				if (c != '\\') {
+					value.push_back(c);
+					continue;
+				}
+				if (position >= text.size()) {
+					break;
+				}
+				char escaped = text[position++];
+				switch (escaped) {
+					case 'b': value.push_back('\b'); break;
+					case 'f': value.push_back('\f'); break;
+					case 'n': value.push_back('\n'); break;
+					case 'r': value.push_back('\r'); break;
+					case 't': value.push_back('\t'); break;
+					case 'u': {
+						if (position + 4 > text.size()) {
+							Fail("truncated escape");
+						}
+						uint code = std::stoul(text.substr(position, 4), nullptr, 16);
+						position += 4;
+						//? UTF-8, surrogate pairs aren't joined, names are all they could be in
+						if (code < 0x80) {
+							value.push_back(char(code));
+						} else if (code < 0x800) {
+							value.push_back(char(0xc0 | (code >> 6)));
+							value.push_back(char(0x80 | (code & 0x3f)));
+						} else {
+							value.push_back(char(0xe0 | (code >> 12)));
+							value.push_back(char(0x80 | ((code >> 6) & 0x3f)));
+							value.push_back(char(0x80 | (code & 0x3f)));
+						}
+						break;
+					}
+					default: value.push_back(escaped); break;
+				}
+			}
+			Expect('"');
+			return value;
+		}
+	};
+
+	std::string DecodeBase64(const std::string& text, size_t start, const std::string& path) {
+		auto digit = [](char c) -> int {
+			if (c >= 'A' and c <= 'Z') return c - 'A';
+			if (c >= 'a' and c <= 'z') return c - 'a' + 26;
+			if (c >= '0' and c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+		std::string bytes;
+		bytes.reserve((text.size() - start) / 4 * 3);
+		uint bits = 0;
+		uint bitCount = 0;
+		for (size_t i = start; i < text.size() and text[i] != '='; i++) {
+			int value = digit(text[i]);
+			if (value < 0) {
+				throw std::runtime_error("Couldn't read " + path + ", a data URI isn't base64.");
+			}
+			bits = (bits << 6) | uint(value);
+			bitCount += 6;
+			if (bitCount >= 8) {
+				bitCount -= 8;
+				bytes.push_back(char((bits >> bitCount) & 0xff));
+			}
+		}
+		return bytes;
+	}
+
+	class Gltf {
+	public:
+		Json root;
+		std::vector<std::string> buffers;
+		std::string path;
+
+		//? Checks the accessor fits its view and buffer, returns where its first element starts
+		const char* Element(uint64 accessorIndex, uint componentType, uint componentCount, uint64& count, uint64& stride) const {
+			const Json& accessor = root["accessors"][accessorIndex];
+			static const std::map<std::string, uint> components = { {"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4} };
+			auto type = components.find(accessor["type"].string);
+			if (accessor.type != Json::Type::Object or type == components.end()) {
+				Fail("accessor " + std::to_string(accessorIndex) + " is missing or has an unknown type");
+			}
+			if (accessor.Has("sparse") or !accessor.Has("bufferView")) {
+				Fail("accessor " + std::to_string(accessorIndex) + " is sparse, that isn't supported");
+			}
+			uint64 storedType = accessor["componentType"].Integer(0);
+			if ((componentType != 0 and storedType != componentType) or type->second != componentCount) {
+				Fail("accessor " + std::to_string(accessorIndex) + " isn't in a supported format");
+			}
+			uint64 componentSize = storedType == gltfUnsignedByte ? 1 : storedType == gltfUnsignedShort ? 2 : 4;
+			uint64 elementSize = componentSize * componentCount;
+
+			const Json& view = root["bufferViews"][accessor["bufferView"].Integer(0)];
+			uint64 bufferIndex = view["buffer"].Integer(~0ull);
+			if (bufferIndex >= buffers.size()) {
+				Fail("a buffer view refers to a missing buffer");
+			}
+			const std::string& buffer = buffers[bufferIndex];
+			uint64 viewOffset = view["byteOffset"].Integer(0);
+			uint64 viewLength = view["byteLength"].Integer(0);
+			uint64 offset = accessor["byteOffset"].Integer(0);
+			count = accessor["count"].Integer(0);
+			stride = view["byteStride"].Integer(elementSize);
+			if (viewOffset + viewLength > buffer.size() or (count > 0 and offset + stride * (count - 1) + elementSize > viewLength)) {
+				Fail("accessor " + std::to_string(accessorIndex) + " reads past its buffer");
+			}
+			return buffer.data() + viewOffset + offset;
+		}
+
+		std::vector<glm::vec3> ReadVec3(uint64 accessor) const {
+			uint64 count, stride;
+			const char* element = Element(accessor, gltfFloat, 3, count, stride);
+			std::vector<glm::vec3> values(count);
+			for (uint64 i = 0; i < count; i++) {
+				memcpy(&values[i], element + i * stride, sizeof(glm::vec3));
+			}
+			return values;
+		}
+
+		std::vector<uint> ReadIndices(uint64 accessor) const {
+			uint64 count, stride;
+			const char* element = Element(accessor, 0, 1, count, stride);
+			uint64 componentType = root["accessors"][accessor]["componentType"].Integer(0);
+			std::vector<uint> values(count);
+			for (uint64 i = 0; i < count; i++) {
+				if (componentType == gltfUnsignedByte) {
+					values[i] = uint8(element[i * stride]);
+				} else if (componentType == gltfUnsignedShort) {
+					uint16 value;
+					memcpy(&value, element + i * stride, sizeof(uint16));
+					values[i] = value;
+				} else if (componentType == gltfUnsignedInt) {
+					memcpy(&values[i], element + i * stride, sizeof(uint));
+				} else {
+					Fail("accessor " + std::to_string(accessor) + " has indices that aren't unsigned integers");
+				}
+			}
+			return values;
+		}
+
+		[[noreturn]] void Fail(const std::string& problem) const {
+			throw std::runtime_error("Couldn't read " + path + ", " + problem + ".");
+		}
+	};
+}
+
+std::vector<MeshImport::Mesh> MeshImport::Load(const std::string& path) {
+	std::string extension = Extension(path);
+	if (extension == "obj") {
+		return LoadObj(path);
+	}
+	if (extension == "gltf" or extension == "glb") {
+		return LoadGltf(path);
+	}
+	throw std::runtime_error("Couldn't import " + path + ", only .obj, .gltf and .glb are supported.");
+}
+
+std::vector<MeshImport::Mesh> MeshImport::LoadObj(const std::string& path) {
+	std::string text = ReadBytes(path);
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<Mesh> meshes;
+
+	Mesh mesh;
+	mesh.name = Stem(path);
+	//? Position and normal index pairs to vertices, normals past the end mean none
+	std::unordered_map<uint64, uint> remap;
+	bool missingNormals = false;
+	auto finish = [&]() {
+		if (!mesh.indices.empty()) {
+			if (missingNormals) {
+				ComputeNormals(mesh.vertices, mesh.indices);
+			}
+			meshes.push_back(std::move(mesh));
+		}
+		mesh = Mesh {};
+		remap.clear();
+		missingNormals = false;
+	};
+
+	std::vector<uint> face;
+	const char* cursor = text.c_str();
+	const char* end = cursor + text.size();
+	uint line = 0;
+	while (cursor < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		lineEnd = lineEnd == nullptr ? end : lineEnd;
+		line++;
+		auto fail = [&](const std::string& problem) {
+			throw std::runtime_error("Couldn't read " + path + ", line " + std::to_string(line) + " " + problem + ".");
+		};
+
+		SkipBlanks(cursor, lineEnd);
+		if (lineEnd - cursor > 2 and cursor[0] == 'v' and (cursor[1] == ' ' or cursor[1] == '\t')) {
+			cursor += 2;
+			glm::vec3 position;
+			if (!ReadFloat(cursor, lineEnd, position.x) or !ReadFloat(cursor, lineEnd, position.y) or !ReadFloat(cursor, lineEnd, position.z)) {
+				fail("has a position without three coordinates");
+			}
+			positions.push_back(position);
+		} else if (lineEnd - cursor > 3 and cursor[0] == 'v' and cursor[1] == 'n' and (cursor[2] == ' ' or cursor[2] == '\t')) {
+			cursor += 3;
+			glm::vec3 normal;
+			if (!ReadFloat(cursor, lineEnd, normal.x) or !ReadFloat(cursor, lineEnd, normal.y) or !ReadFloat(cursor, lineEnd, normal.z)) {
+				fail("has a normal without three coordinates");
+			}
+			normals.push_back(normal);
+		} else if (lineEnd - cursor > 2 and cursor[0] == 'f' and (cursor[1] == ' ' or cursor[1] == '\t')) {
+			cursor += 2;
+			face.clear();
+			SkipBlanks(cursor, lineEnd);
+			while (cursor < lineEnd) {
+				//? v, v/vt, v//vn or v/vt/vn, texture coordinates are skipped
+				long positionIndex;
+				long normalIndex = 0;
+				long unused;
+				if (!ReadInt(cursor, lineEnd, positionIndex)) {
+					fail("has a face corner without a position");
+				}
+				if (cursor < lineEnd and *cursor == '/') {
+					cursor++;
+					if (cursor < lineEnd and *cursor != '/') {
+						ReadInt(cursor, lineEnd, unused);
+					}
+					if (cursor < lineEnd and *cursor == '/') {
+						cursor++;
+						ReadInt(cursor, lineEnd, normalIndex);
+					}
+				}
+				uint position;
+				if (!Resolve(positionIndex, positions.size(), position)) {
+					fail("refers to a missing position");
+				}
+				uint normal = uint(normals.size());
+				if (normalIndex != 0 and !Resolve(normalIndex, normals.size(), normal)) {
+					fail("refers to a missing normal");
+				}
+
+				uint64 key = (uint64(position) << 32) | normal;
+				auto found = remap.find(key);
+				if (found == remap.end()) {
+					found = remap.emplace(key, uint(mesh.vertices.size())).first;
+					bool hasNormal = normal < normals.size();
+					missingNormals = missingNormals or !hasNormal;
+					mesh.vertices.push_back({ positions[position], hasNormal ? normals[normal] : glm::vec3(0.0f) });
+				}
+				face.push_back(found->second);
+				SkipBlanks(cursor, lineEnd);
+			}
+			for (uint i = 2; i < face.size(); i++) {
+				mesh.indices.insert(mesh.indices.end(), { face[0], face[i - 1], face[i] });
+			}
+		} else if (lineEnd - cursor > 2 and cursor[0] == 'o' and (cursor[1] == ' ' or cursor[1] == '\t')) {
+			finish();
+			cursor += 2;
+			SkipBlanks(cursor, lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > cursor and std::isspace(uint8(nameEnd[-1]))) {
+				nameEnd--;
+			}
+			mesh.name.assign(cursor, nameEnd);
+		}
+		cursor = lineEnd + 1;
+	}
+	finish();
+
+	if (meshes.empty()) {
+		throw std::runtime_error("Couldn't import " + path + ", it has no faces.");
+	}
+	return meshes;
+}
+
+std::vector<MeshImport::Mesh> MeshImport::LoadGltf(const std::string& path) {
+	std::string bytes = ReadBytes(path);
+	Gltf gltf;
+	gltf.path = path;
+
+	std::string json;
+	std::string binaryChunk;
+	if (bytes.size() >= 12 and *reinterpret_cast<const uint*>(bytes.data()) == glbMagic) {
+		//? Header, then chunks of a length, a type and the data padded to 4 bytes
+		size_t position = 12;
+		while (position + 8 <= bytes.size()) {
+			uint length = *reinterpret_cast<const uint*>(bytes.data() + position);
+			uint type = *reinterpret_cast<const uint*>(bytes.data() + position + 4);
+			position += 8;
+			if (position + length > bytes.size()) {
+				gltf.Fail("a chunk is truncated");
+			}
+			if (type == glbJsonChunk and json.empty()) {
+				json = bytes.substr(position, length);
+			} else if (type == glbBinaryChunk and binaryChunk.empty()) {
+				binaryChunk = bytes.substr(position, length);
+			}
+			position += length;
+		}
+	} else {
+		json = std::move(bytes);
+	}
+	gltf.root = JsonParser(json, path).Parse();
+
+	for (const Json& buffer : gltf.root["buffers"].items) {
+		const std::string& uri = buffer["uri"].string;
+		if (!buffer.Has("uri")) {
+			gltf.buffers.push_back(binaryChunk);
+		} else if (uri.compare(0, 5, "data:") == 0) {
+			size_t comma = uri.find(',');
+			if (comma == std::string::npos or uri.rfind(";base64", comma) == std::string::npos) {
+				gltf.Fail("a data URI isn't base64");
+			}
+			gltf.buffers.push_back(DecodeBase64(uri, comma + 1, path));
+		} else {
+			gltf.buffers.push_back(ReadBytes(Directory(path) + uri));
+		}
+		if (gltf.buffers.back().size() < buffer["byteLength"].Integer(0)) {
+			gltf.Fail("a buffer is shorter than its byteLength");
+		}
+	}
+
+	std::vector<Mesh> meshes;
+	const std::vector<Json>& sourceMeshes = gltf.root["meshes"].items;
+	for (uint i = 0; i < sourceMeshes.size(); i++) {
+		Mesh mesh;
+		mesh.name = sourceMeshes[i].Has("name") ? sourceMeshes[i]["name"].string : Stem(path) + std::to_string(i);
+		bool missingNormals = false;
+		for (const Json& primitive : sourceMeshes[i]["primitives"].items) {
+			if (primitive["mode"].Integer(gltfTriangles) != gltfTriangles or !primitive["attributes"].Has("POSITION")) {
+				continue;
+			}
+			std::vector<glm::vec3> positions = gltf.ReadVec3(primitive["attributes"]["POSITION"].Integer(0));
+			std::vector<glm::vec3> normals;
+			if (primitive["attributes"].Has("NORMAL")) {
+				normals = gltf.ReadVec3(primitive["attributes"]["NORMAL"].Integer(0));
+			}
+			missingNormals = missingNormals or normals.size() != positions.size();
+
+			uint base = mesh.vertices.size();
+			for (uint v = 0; v < positions.size(); v++) {
+				mesh.vertices.push_back({ positions[v], v < normals.size() ? normals[v] : glm::vec3(0.0f) });
+			}
+			std::vector<uint> indices;
+			if (primitive.Has("indices")) {
+				indices = gltf.ReadIndices(primitive["indices"].Integer(0));
+			} else {
+				indices.resize(positions.size());
+				std::iota(indices.begin(), indices.end(), 0);
+			}
+			for (uint t = 0; t + 2 < indices.size(); t += 3) {
+				if (indices[t] >= positions.size() or indices[t + 1] >= positions.size() or indices[t + 2] >= positions.size()) {
+					gltf.Fail("mesh " + mesh.name + " has an index past its vertices");
+				}
+				mesh.indices.insert(mesh.indices.end(), { base + indices[t], base + indices[t + 1], base + indices[t + 2] });
+			}
+		}
+		if (mesh.indices.empty()) {
+			continue;
+		}
+		if (missingNormals) {
+			ComputeNormals(mesh.vertices, mesh.indices);
+		}
+		meshes.push_back(std::move(mesh));
+	}
+
+	if (meshes.empty()) {
+		throw std::runtime_error("Couldn't import " + path + ", it has no triangle meshes.");
+	}
+	return meshes;
+}
+
+void MeshImport::ComputeNormals(std::vector<MeshVertex>& vertices, const std::vector<uint>& indices) {
+	for (MeshVertex& vertex : vertices) {
+		vertex.normal = glm::vec3(0.0f);
+	}
+	//? Unnormalized face normals, so larger triangles weigh more
+	for (uint i = 0; i < indices.size(); i += 3) {
+		MeshVertex& a = vertices[indices[i]];
+		MeshVertex& b = vertices[indices[i + 1]];
+		MeshVertex& c = vertices[indices[i + 2]];
+		glm::vec3 normal = glm::cross(b.position - a.position, c.position - a.position);
+		a.normal += normal;
+		b.normal += normal;
+		c.normal += normal;
+	}
+	//? Vertices no triangle uses keep some normal rather than NaNs
+	for (MeshVertex& vertex : vertices) {
+		float length = glm::length(vertex.normal);
+		vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
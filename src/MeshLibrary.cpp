@@ -0,0 +1,390 @@
+#include "MeshLibrary.hpp"
+#include "MeshImport.hpp"
+#include "Settings.hpp"
+
+namespace {
+	//? A level that keeps more than this share of its parent's triangles isn't worth a slot
+	const float minReduction = 0.85f;
+	const uint minLodIndices = 3 * 16;
+
+	//? Greedy in index order: a meshlet closes once the next triangle would take it past either limit
+	void BuildMeshlets(const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, std::vector<MeshLibrary::Meshlet>& meshlets) {
+		//? The last meshlet each vertex was counted in
+		std::vector<uint> owner(vertices.size(), ~0u);
+		std::vector<uint> used;
+		uint current = 0;
+		MeshLibrary::Meshlet meshlet {};
+
+		auto close = [&]() {
+			if (meshlet.triangleCount == 0) {
+				return;
+			}
+			glm::vec3 low = vertices[used[0]].position;
+			glm::vec3 high = low;
+			for (uint vertex : used) {
+				low = glm::min(low, vertices[vertex].position);
+				high = glm::max(high, vertices[vertex].position);
+			}
+			meshlet.center = (low + high) * 0.5f;
+			for (uint vertex : used) {
+				meshlet.radius = std::max(meshlet.radius, glm::length(vertices[vertex].position - meshlet.center));
+			}
+			meshlet.vertexCount = used.size();
+			meshlets.push_back(meshlet);
+			used.clear();
+			current++;
+		};
+
+		for (uint i = 0; i + 2 < indices.size(); i += 3) {
+			uint fresh = 0;
+			for (uint corner = 0; corner < 3; corner++) {
+				fresh += owner[indices[i + corner]] != current;
+			}
+			if (used.size() + fresh > MeshFile::maxMeshletVertices or meshlet.triangleCount == MeshFile::maxMeshletTriangles) {
+				close();
+				meshlet = {};
+				meshlet.indexOffset = i;
+			}
+			for (uint corner = 0; corner < 3; corner++) {
+				uint vertex = indices[i + corner];
+				if (owner[vertex] != current) {
+					owner[vertex] = current;
+					used.push_back(vertex);
+				}
+			}
+			meshlet.triangleCount++;
+		}
+		close();
+	}
+
+	//? From /proc/self/status in KiB, 0 where there's no such file
+	uint64 StatusKiB(const std::string& field) {
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line)) {
+			if (line.compare(0, field.size(), field) == 0 and line.size() > field.size() and line[field.size()] == ':') {
+				return std::stoull(line.substr(field.size() + 1));
+			}
+		}
+		return 0;
+	}
+
+	//? Linux only, resets VmHWM to what's resident now. Elsewhere peaks can't be measured per run
+	bool ResetPeakResident() {
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		clearRefs << "5";
+		clearRefs.flush();
+		return bool(clearRefs);
+	}
+}
+
+void MeshLibrary::Init(const Context& context) {
+	this->context = context;
+}
+
+void MeshLibrary::CleanUp() {
+	if (vertexBuffer != VK_NULL_HANDLE) {
+		context.DestroyBuffer(vertexBuffer, vertexMemory);
+		context.DestroyBuffer(indexBuffer, indexMemory);
+	}
+	for (Source& source : files) {
+		source.file.Close();
+	}
+	files.clear();
+}
+
+uint MeshLibrary::Add(const std::string& name, const std::vector<MeshVertex>& meshVertices, const std::vector<uint>& meshIndices, uint maxLods) {
+	if (vertexBuffer != VK_NULL_HANDLE) {
+		throw std::runtime_error("Meshes can't be added after the library was uploaded.");
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	Mesh mesh {};
+	mesh.vertexOffset = int32(vertices.size());
+	mesh.vertexCount = meshVertices.size();
+
+	glm::vec3 low = meshVertices[0].position;
+	glm::vec3 high = meshVertices[0].position;
+	for (const MeshVertex& vertex : meshVertices) {
+		low = glm::min(low, vertex.position);
+		high = glm::max(high, vertex.position);
+	}
+	mesh.center = (low + high) * 0.5f;
+	mesh.radius = 0.0f;
+	for (const MeshVertex& vertex : meshVertices) {
+		mesh.radius = std::max(mesh.radius, glm::length(vertex.position - mesh.center));
+	}
+
+	mesh.lods.push_back({ uint(indices.size()), uint(meshIndices.size()), 0.0f });
+	indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+	mesh.meshletOffset = meshlets.size();
+	BuildMeshlets(meshVertices, meshIndices, meshlets);
+	mesh.meshletCount = meshlets.size() - mesh.meshletOffset;
+
+	//? Every level starts again from the full mesh, so errors are measured against the original surface
+	while (mesh.lods.size() < maxLods) {
+		const Lod& previous = mesh.lods.back();
+		uint target = previous.indexCount / 6 * 3;
+		if (target < minLodIndices) {
+			break;
+		}
+		float error = 0.0f;
+		std::vector<uint> lodIndices = MeshSimplifier::Simplify(meshVertices, meshIndices, target, error);
+		if (lodIndices.empty() or lodIndices.size() > previous.indexCount * minReduction) {
+			break;
+		}
+		mesh.lods.push_back({ uint(indices.size()), uint(lodIndices.size()), std::max(error, previous.error) });
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+
+	vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+	meshes.push_back(mesh);
+	names.push_back(name);
+
+	buildSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return meshes.size() - 1;
+}
+
+uint MeshLibrary::Load(const std::string& path) {
+	if (vertexBuffer != VK_NULL_HANDLE) {
+		throw std::runtime_error("Meshes can't be added after the library was uploaded.");
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	Source source {};
+	source.file.Open(path);
+	source.firstMesh = meshes.size();
+	const MeshFile& file = source.file;
+
+	//? Only the small per mesh records are read, vertices and indices stay in the mapping
+	const MeshFile::Meshlet* fileMeshlets = file.Meshlets();
+	for (uint i = 0; i < file.MeshCount(); i++) {
+		const MeshFile::Mesh& record = file.Meshes()[i];
+		Mesh mesh {};
+		mesh.vertexOffset = int32(record.vertexOffset);
+		mesh.vertexCount = record.vertexCount;
+		mesh.lods.assign(file.Lods() + record.lodOffset, file.Lods() + record.lodOffset + record.lodCount);
+		mesh.meshletOffset = meshlets.size();
+		mesh.meshletCount = record.meshletCount;
+		meshlets.insert(meshlets.end(), fileMeshlets + record.meshletOffset, fileMeshlets + record.meshletOffset + record.meshletCount);
+		mesh.center = record.center;
+		mesh.radius = record.radius;
+		meshes.push_back(mesh);
+		names.push_back(file.Name(record));
+	}
+	fileVertices += file.VertexCount();
+	fileIndices += file.IndexCount();
+	fileBytes += file.Bytes();
+	files.push_back(source);
+
+	loadSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return source.firstMesh;
+}
+
+void MeshLibrary::Save(const std::string& path) const {
+	if (fileBytes > 0) {
+		throw std::runtime_error("Couldn't save the meshes, some of them were loaded from a file.");
+	}
+	std::vector<MeshFile::Mesh> records;
+	std::vector<Lod> lods;
+	std::string allNames;
+	for (uint i = 0; i < meshes.size(); i++) {
+		const Mesh& mesh = meshes[i];
+		MeshFile::Mesh record {};
+		record.vertexOffset = uint(mesh.vertexOffset);
+		record.vertexCount = mesh.vertexCount;
+		record.lodOffset = lods.size();
+		record.lodCount = mesh.lods.size();
+		record.meshletOffset = mesh.meshletOffset;
+		record.meshletCount = mesh.meshletCount;
+		record.nameOffset = allNames.size();
+		record.nameLength = names[i].size();
+		record.center = mesh.center;
+		record.radius = mesh.radius;
+		records.push_back(record);
+		lods.insert(lods.end(), mesh.lods.begin(), mesh.lods.end());
+		allNames += names[i];
+	}
+	MeshFile::Write(path, vertices, indices, records, lods, meshlets, allNames);
+}
+
+void MeshLibrary::Upload() {
+	//? Files go after the meshes built here, in the order they were loaded
+	uint64 vertexBase = vertices.size();
+	uint64 indexBase = indices.size();
+	for (uint i = 0; i < files.size(); i++) {
+		uint lastMesh = i + 1 < files.size() ? files[i + 1].firstMesh : meshes.size();
+		for (uint mesh = files[i].firstMesh; mesh < lastMesh; mesh++) {
+			meshes[mesh].vertexOffset += int32(vertexBase);
+			for (Lod& lod : meshes[mesh].lods) {
+				lod.indexOffset += uint(indexBase);
+			}
+		}
+		vertexBase += files[i].file.VertexCount();
+		indexBase += files[i].file.IndexCount();
+	}
+
+	VkDeviceSize vertexSize = VertexBytes();
+	VkDeviceSize indexSize = IndexBytes();
+	context.CreateBuffer(vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexMemory);
+	context.CreateBuffer(indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexMemory);
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	context.CreateBuffer(vertexSize + indexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
+	void* mapped;
+	vkMapMemory(context.device, stagingMemory, 0, vertexSize + indexSize, 0, &mapped);
+	WriteStaging(static_cast<char*>(mapped));
+	vkUnmapMemory(context.device, stagingMemory);
+
+	context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+		VkBufferCopy vertexRegion {};
+		vertexRegion.srcOffset = 0;
+		vertexRegion.dstOffset = 0;
+		vertexRegion.size = vertexSize;
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, vertexBuffer, 1, &vertexRegion);
+		VkBufferCopy indexRegion {};
+		indexRegion.srcOffset = vertexSize;
+		indexRegion.dstOffset = 0;
+		indexRegion.size = indexSize;
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, indexBuffer, 1, &indexRegion);
+	});
+	context.DestroyBuffer(stagingBuffer, stagingMemory);
+
+	//? Everything the mappings held is on the device now
+	for (Source& source : files) {
+		source.file.Close();
+	}
+	files.clear();
+}
+
+VkDeviceSize MeshLibrary::VertexBytes() const {
+	return sizeof(MeshVertex) * (vertices.size() + fileVertices);
+}
+
+VkDeviceSize MeshLibrary::IndexBytes() const {
+	return sizeof(uint) * (indices.size() + fileIndices);
+}
+
+void MeshLibrary::WriteStaging(char* destination) const {
+	char* vertexCursor = destination;
+	char* indexCursor = destination + VertexBytes();
+	memcpy(vertexCursor, vertices.data(), sizeof(MeshVertex) * vertices.size());
+	vertexCursor += sizeof(MeshVertex) * vertices.size();
+	memcpy(indexCursor, indices.data(), sizeof(uint) * indices.size());
+	indexCursor += sizeof(uint) * indices.size();
+	//? Straight from the mapping, the sections are already in the buffers' layout
+	for (const Source& source : files) {
+		memcpy(vertexCursor, source.file.Vertices(), sizeof(MeshVertex) * source.file.VertexCount());
+		vertexCursor += sizeof(MeshVertex) * source.file.VertexCount();
+		memcpy(indexCursor, source.file.Indices(), sizeof(uint) * source.file.IndexCount());
+		indexCursor += sizeof(uint) * source.file.IndexCount();
+	}
+}
+
+const MeshLibrary::Mesh& MeshLibrary::Get(uint mesh) const {
+	return meshes[mesh];
+}
+
+uint MeshLibrary::Count() const {
+	return meshes.size();
+}
+
+VkBuffer MeshLibrary::VertexBuffer() const {
+	return vertexBuffer;
+}
+
+VkBuffer MeshLibrary::IndexBuffer() const {
+	return indexBuffer;
+}
+
+const std::vector<MeshLibrary::Meshlet>& MeshLibrary::Meshlets() const {
+	return meshlets;
+}
+
+void MeshLibrary::PrintStats() {
+	uint64 vertexCount = vertices.size() + fileVertices;
+	uint64 indexCount = indices.size() + fileIndices;
+	std::cout << "Meshes:\n";
+	std::cout << "\tVertices: " << vertexCount << ", indices: " << indexCount << " (" << (sizeof(MeshVertex) * vertexCount + sizeof(uint) * indexCount) / 1024 << " KiB)\n";
+	std::cout << "\tMeshlets: " << meshlets.size() << "\n";
+	std::cout << "\tLevel of detail build: " << buildSeconds * 1000.0 << " ms\n";
+	if (fileBytes > 0) {
+		std::cout << "\tMesh files: " << fileBytes / 1024 << " KiB mapped in " << loadSeconds * 1000.0 << " ms\n";
+	}
+	for (uint i = 0; i < meshes.size(); i++) {
+		std::cout << "\t" << names[i] << ":";
+		for (const Lod& lod : meshes[i].lods) {
+			std::cout << " " << lod.indexCount / 3 << " (" << lod.error << ")";
+		}
+		std::cout << "\n";
+	}
+	std::cout << std::endl;
+}
+
+void MeshLibrary::Benchmark(const std::string& sourcePath) {
+	using Clock = std::chrono::steady_clock;
+	auto milliseconds = [](Clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+	std::string containerPath = sourcePath + ".vkmesh";
+	//? Both end with the bytes in memory laid out like staging, an allocation standing in for the mapped staging buffer
+	bool peaksReset = ResetPeakResident();
+
+	uint64 residentBefore = StatusKiB("VmRSS");
+	Clock::time_point start = Clock::now();
+	double parseMs;
+	double textMs;
+	uint64 textPeak;
+	uint64 triangles = 0;
+	uint meshCount;
+	{
+		std::vector<MeshImport::Mesh> imported = MeshImport::Load(sourcePath);
+		parseMs = milliseconds(start);
+		MeshLibrary library;
+		for (const MeshImport::Mesh& mesh : imported) {
+			library.Add(mesh.name, mesh.vertices, mesh.indices, Settings::lodLevels);
+			triangles += mesh.indices.size() / 3;
+		}
+		std::vector<char> staging(library.VertexBytes() + library.IndexBytes());
+		library.WriteStaging(staging.data());
+		textMs = milliseconds(start);
+		textPeak = StatusKiB("VmHWM") - std::min(residentBefore, StatusKiB("VmHWM"));
+		meshCount = library.Count();
+		library.Save(containerPath);
+	}
+
+	ResetPeakResident();
+	residentBefore = StatusKiB("VmRSS");
+	start = Clock::now();
+	double mapMs;
+	uint64 containerBytes;
+	{
+		MeshLibrary library;
+		library.Load(containerPath);
+		mapMs = milliseconds(start);
+		std::vector<char> staging(library.VertexBytes() + library.IndexBytes());
+		library.WriteStaging(staging.data());
+		containerBytes = library.fileBytes;
+		library.CleanUp();
+	}
+	double containerMs = milliseconds(start);
+	uint64 containerPeak = StatusKiB("VmHWM") - std::min(residentBefore, StatusKiB("VmHWM"));
+
+	std::cout << "Mesh loading, " << sourcePath << " (" << meshCount << " meshes, " << triangles << " triangles):\n";
+	std::cout << "\tText: parse " << parseMs << " ms, levels of detail " << textMs - parseMs << " ms, total " << textMs << " ms";
+	if (peaksReset) {
+		std::cout << ", peak resident +" << textPeak / 1024.0 << " MiB";
+	}
+	std::cout << "\n";
+	std::cout << "\tContainer (" << containerBytes / 1024 << " KiB): map " << mapMs << " ms, copy to staging " << containerMs - mapMs << " ms, total " << containerMs << " ms";
+	if (peaksReset) {
+		std::cout << ", peak resident +" << containerPeak / 1024.0 << " MiB";
+	}
+	std::cout << "\n";
+	std::cout << "\tSpeedup: " << (containerMs > 0.0 ? textMs / containerMs : 0.0) << "x";
+	if (!peaksReset) {
+		std::cout << ", peak resident memory isn't available here";
+	}
+	std::cout << "\n" << std::endl;
+}
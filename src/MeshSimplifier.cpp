@@ -0,0 +1,224 @@
+#include "MeshSimplifier.hpp"
+#include <queue>
+#include <unordered_map>
+
+namespace {
+	//? Open borders get a steep wall of planes along them, so they stay in place
+	const double borderWeight = 10.0;
+	//? Collapses that would turn a triangle's normal further than this (cosine) are rejected
+	const double minNormalDot = 0.25;
+
+	uint64 EdgeKey(uint a, uint b) {
+		return a < b ? (uint64(a) << 32 | b) : (uint64(b) << 32 | a);
+	}
+}
+
+void MeshSimplifier::Quadric::AddPlane(const glm::dvec3& normal, double distance, double weight) {
+	a00 += weight * normal.x * normal.x;
+	a01 += weight * normal.x * normal.y;
+	a02 += weight * normal.x * normal.z;
+	a03 += weight * normal.x * distance;
+	a11 += weight * normal.y * normal.y;
+	a12 += weight * normal.y * normal.z;
+	a13 += weight * normal.y * distance;
+	a22 += weight * normal.z * normal.z;
+	a23 += weight * normal.z * distance;
+	a33 += weight * distance * distance;
+}
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& other) {
+	a00 += other.a00;
+	a01 += other.a01;
+	a02 += other.a02;
+	a03 += other.a03;
+	a11 += other.a11;
+	a12 += other.a12;
+	a13 += other.a13;
+	a22 += other.a22;
+	a23 += other.a23;
+	a33 += other.a33;
+	return *this;
+}
+
+double MeshSimplifier::Quadric::Evaluate(const glm::dvec3& p) const {
+	return a00 * p.x * p.x + 2.0 * a01 * p.x * p.y + 2.0 * a02 * p.x * p.z + 2.0 * a03 * p.x
+		+ a11 * p.y * p.y + 2.0 * a12 * p.y * p.z + 2.0 * a13 * p.y
+		+ a22 * p.z * p.z + 2.0 * a23 * p.z
+		+ a33;
+}
+
+std::vector<uint> MeshSimplifier::Simplify(const std::vector<MeshVertex>& vertices, const std::vector<uint>& indices, uint targetIndexCount, float& error) {
+	uint vertexCount = vertices.size();
+	uint triangleCount = indices.size() / 3;
+	std::vector<uint> triangles = indices;
+	std::vector<bool> triangleAlive(triangleCount, true);
+	uint aliveCount = triangleCount;
+
+	auto position = [&](uint vertex) {
+		return glm::dvec3(vertices[vertex].position);
+	};
+	auto faceNormal = [&](const glm::dvec3& p0, const glm::dvec3& p1, const glm::dvec3& p2) {
+		return glm::cross(p1 - p0, p2 - p0);
+	};
+
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<std::vector<uint>> vertexTriangles(vertexCount);
+	std::unordered_map<uint64, uint> edgeUse;
+	for (uint t = 0; t < triangleCount; t++) {
+		const uint* triangle = &triangles[t * 3];
+		glm::dvec3 normal = faceNormal(position(triangle[0]), position(triangle[1]), position(triangle[2]));
+		double length = glm::length(normal);
+		if (length > 0.0) {
+			normal /= length;
+			Quadric quadric;
+			quadric.AddPlane(normal, -glm::dot(normal, position(triangle[0])), 1.0);
+			for (uint i = 0; i < 3; i++) {
+				quadrics[triangle[i]] += quadric;
+			}
+		}
+		for (uint i = 0; i < 3; i++) {
+			vertexTriangles[triangle[i]].push_back(t);
+			edgeUse[EdgeKey(triangle[i], triangle[(i + 1) % 3])]++;
+		}
+	}
+
+	for (uint t = 0; t < triangleCount; t++) {
+		const uint* triangle = &triangles[t * 3];
+		glm::dvec3 normal = faceNormal(position(triangle[0]), position(triangle[1]), position(triangle[2]));
+		for (uint i = 0; i < 3; i++) {
+			uint a = triangle[i];
+			uint b = triangle[(i + 1) % 3];
+			if (edgeUse[EdgeKey(a, b)] != 1) {
+				continue;
+			}
+			glm::dvec3 wall = glm::cross(position(b) - position(a), normal);
+			double length = glm::length(wall);
+			if (length == 0.0) {
+				continue;
+			}
+			wall /= length;
+			Quadric quadric;
+			quadric.AddPlane(wall, -glm::dot(wall, position(a)), borderWeight);
+			quadrics[a] += quadric;
+			quadrics[b] += quadric;
+		}
+	}
+
+	std::vector<uint> version(vertexCount, 0);
+	std::vector<bool> removed(vertexCount, false);
+	std::priority_queue<Collapse> queue;
+
+	//? Each edge is queued in its cheaper direction
+	auto pushEdge = [&](uint a, uint b) {
+		Quadric quadric = quadrics[a];
+		quadric += quadrics[b];
+		double toB = quadric.Evaluate(position(b));
+		double toA = quadric.Evaluate(position(a));
+		if (toB <= toA) {
+			queue.push({ toB, a, b, version[a], version[b] });
+		} else {
+			queue.push({ toA, b, a, version[b], version[a] });
+		}
+	};
+	auto pushVertexEdges = [&](uint vertex) {
+		for (uint t : vertexTriangles[vertex]) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+			for (uint i = 0; i < 3; i++) {
+				uint other = triangles[t * 3 + i];
+				if (other != vertex) {
+					pushEdge(vertex, other);
+				}
+			}
+		}
+	};
+	//? Moving from onto to must not fold any of the triangles that survive the collapse
+	auto flips = [&](uint from, uint to) {
+		for (uint t : vertexTriangles[from]) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+			const uint* triangle = &triangles[t * 3];
+			if (triangle[0] == to or triangle[1] == to or triangle[2] == to) {
+				continue;
+			}
+			glm::dvec3 before[3];
+			glm::dvec3 after[3];
+			for (uint i = 0; i < 3; i++) {
+				before[i] = position(triangle[i]);
+				after[i] = triangle[i] == from ? position(to) : before[i];
+			}
+			glm::dvec3 normalBefore = faceNormal(before[0], before[1], before[2]);
+			glm::dvec3 normalAfter = faceNormal(after[0], after[1], after[2]);
+			double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+			if (lengths == 0.0 or glm::dot(normalBefore, normalAfter) < minNormalDot * lengths) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	for (uint t = 0; t < triangleCount; t++) {
+		for (uint i = 0; i < 3; i++) {
+			uint a = triangles[t * 3 + i];
+			uint b = triangles[t * 3 + (i + 1) % 3];
+			if (a < b or edgeUse[EdgeKey(a, b)] == 1) {
+				pushEdge(a, b);
+			}
+		}
+	}
+
+	double maxCost = 0.0;
+	while (aliveCount * 3 > targetIndexCount and !queue.empty()) {
+		Collapse collapse = queue.top();
+		queue.pop();
+
+		//? Stale entries, one of the vertices changed since they were queued
+		if (removed[collapse.from] or removed[collapse.to] or version[collapse.from] != collapse.fromVersion or version[collapse.to] != collapse.toVersion) {
+			continue;
+		}
+		if (flips(collapse.from, collapse.to)) {
+			continue;
+		}
+
+		for (uint t : vertexTriangles[collapse.from]) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+			uint* triangle = &triangles[t * 3];
+			if (triangle[0] == collapse.to or triangle[1] == collapse.to or triangle[2] == collapse.to) {
+				triangleAlive[t] = false;
+				aliveCount--;
+				continue;
+			}
+			for (uint i = 0; i < 3; i++) {
+				if (triangle[i] == collapse.from) {
+					triangle[i] = collapse.to;
+				}
+			}
+			vertexTriangles[collapse.to].push_back(t);
+		}
+
+		std::vector<uint>& toTriangles = vertexTriangles[collapse.to];
+		toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(), [&](uint t) { return !triangleAlive[t]; }), toTriangles.end());
+		vertexTriangles[collapse.from].clear();
+
+		removed[collapse.from] = true;
+		quadrics[collapse.to] += quadrics[collapse.from];
+		version[collapse.to]++;
+		maxCost = std::max(maxCost, collapse.cost);
+		pushVertexEdges(collapse.to);
+	}
+
+	std::vector<uint> result;
+	result.reserve(aliveCount * 3);
+	for (uint t = 0; t < triangleCount; t++) {
+		if (triangleAlive[t]) {
+			result.insert(result.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+		}
+	}
+
+	error = float(std::sqrt(std::max(maxCost, 0.0)));
+	return result;
+}
@@ -0,0 +1,488 @@
+#include "ParticleSystem.hpp"
+#include "FrameCapture.hpp"
+#include "DrawStreamCache.hpp"
+#include <random>
+
+//? Two frames in flight is what makes double buffering enough: by the time a
+//? step overwrites a state copy, the frame that drew it has passed its fence.
+static_assert(Settings::maxFramesInFlight <= 2, "ParticleSystem needs a state copy per frame in flight.");
+
+void ParticleSystem::Init(const Context& context, DescriptorLayoutCache& layoutCache, VkRenderPass renderPass, uint particleCount) {
+	this->context = context;
+	this->particleCount = particleCount;
+	workgroupSize = ChooseWorkgroupSize();
+
+	CreateBuffers();
+	CreateDescriptors(layoutCache);
+	CreateComputePipeline();
+	CreateRenderPipeline(renderPass);
+	CreateCommandObjects();
+
+	timer.Init(context, context.computeFamily, 1);
+	simulateScope = timer.AddScope("particles");
+}
+
+void ParticleSystem::CleanUp() {
+	timer.CleanUp();
+	for (VkSemaphore semaphore : simulationFinished) {
+		vkDestroySemaphore(context.device, semaphore, nullptr);
+	}
+	vkDestroyCommandPool(context.device, commandPool, nullptr);
+	vkDestroyPipeline(context.device, renderPipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, renderLayout, nullptr);
+	vkDestroyPipeline(context.device, computePipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, computeLayout, nullptr);
+	vkDestroyDescriptorPool(context.device, descriptorPool, nullptr);
+	for (uint i = 0; i < 2; i++) {
+		context.DestroyBuffer(positionBuffers[i], positionMemory[i]);
+		context.DestroyBuffer(velocityBuffers[i], velocityMemory[i]);
+	}
+}
+
+void ParticleSystem::Resolve(uint frameIndex) {
+	timer.Resolve(frameIndex);
+	if (timer.Valid(simulateScope)) {
+		simulationMs += timer.Milliseconds(simulateScope);
+		resolvedSteps++;
+	}
+}
+
+void ParticleSystem::AddOverlap(double graphicsStartMs, double graphicsEndMs) {
+	if (!timer.Valid(simulateScope)) {
+		return;
+	}
+	double start = std::max(graphicsStartMs, timer.StartMilliseconds(simulateScope));
+	double end = std::min(graphicsEndMs, timer.EndMilliseconds(simulateScope));
+	if (end > start) {
+		overlapMs += end - start;
+	}
+}
+
+void ParticleSystem::Simulate(uint frameIndex, float deltaTime) {
+	VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+	vkResetCommandBuffer(commandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't begin recording a command buffer.");
+	}
+
+	timer.Reset(commandBuffer, frameIndex);
+	timer.Begin(commandBuffer, frameIndex, simulateScope);
+
+	//? The previous step wrote the state this one reads
+	VkMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	time += deltaTime;
+	Parameters parameters {};
+	parameters.deltaTime = deltaTime;
+	parameters.time = time;
+	parameters.count = particleCount;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout, 0, 1, &descriptorSets[current], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, computeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Parameters), &parameters);
+	vkCmdDispatch(commandBuffer, (particleCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+	timer.End(commandBuffer, frameIndex, simulateScope);
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Coudln't record a command buffer.");
+	}
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &simulationFinished[frameIndex];
+
+	if (vkQueueSubmit(context.computeQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't submit a command buffer.");
+	}
+
+	current = 1 - current;
+}
+
+VkSemaphore ParticleSystem::SimulationFinished(uint frameIndex) const {
+	return simulationFinished[frameIndex];
+}
+
+void ParticleSystem::Draw(VkCommandBuffer commandBuffer, FrameStats& stats) {
+	FrameCapture::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipeline);
+
+	VkBuffer vertexBuffers[] = { positionBuffers[current], velocityBuffers[current] };
+	VkDeviceSize offsets[] = { 0, 0 };
+	FrameCapture::CmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+
+	FrameCapture::CmdDraw(commandBuffer, particleCount, 1, 0, 0);
+
+	stats.pipelineBinds++;
+	stats.vertexBufferBinds++;
+	stats.draws++;
+}
+
+const GpuTimer& ParticleSystem::Timer() const {
+	return timer;
+}
+
+void ParticleSystem::RegisterShaders(ShaderReloader& reloader) {
+	reloader.Register("particles", { "src/Shaders/particles.comp" }, computePipeline, [this] { return BuildComputePipeline(); });
+	reloader.Register("particle draw", { "src/Shaders/particles.vert", "src/Shaders/particles.frag" }, renderPipeline, [this] { return BuildRenderPipeline(); });
+}
+
+void ParticleSystem::PrintStats() {
+	std::cout << "Particles:\n";
+	std::cout << "\tCount: " << particleCount << ", workgroup size " << workgroupSize << "\n";
+	std::cout << "\tQueue: " << (context.computeFamily == context.graphicsFamily ? "graphics family" : "dedicated compute family") << "\n";
+	if (resolvedSteps == 0) {
+		std::cout << "\tNo timings (timestamps unsupported on the compute queue)\n" << std::endl;
+		return;
+	}
+	double averageMs = simulationMs / resolvedSteps;
+	std::cout << "\tSimulation: " << averageMs << " ms/step (" << particleCount / (averageMs * 1000.0) << " M particles/s)\n";
+	std::cout << "\tOverlap with graphics: " << overlapMs / resolvedSteps << " ms/step (" << (simulationMs > 0.0 ? overlapMs / simulationMs * 100.0 : 0.0) << "%)\n";
+	std::cout << std::endl;
+}
+
+void ParticleSystem::CreateBuffers() {
+	std::vector<glm::vec4> positions(particleCount);
+	std::vector<glm::vec4> velocities(particleCount);
+
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (uint i = 0; i < particleCount; i++) {
+		float angle = unit(random) * 6.2831853f;
+		float radius = 0.1f + 0.7f * std::sqrt(unit(random));
+		glm::vec2 position(std::cos(angle) * radius, std::sin(angle) * radius);
+		glm::vec2 tangent(-position.y, position.x);
+
+		//? w holds the age and a per particle seed
+		positions[i] = glm::vec4(position, 0.0f, unit(random) * 4.0f);
+		velocities[i] = glm::vec4(tangent * 0.6f, 0.0f, unit(random));
+	}
+
+	VkDeviceSize size = sizeof(glm::vec4) * particleCount;
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	//? Concurrent sharing instead of ownership transfers between the two families
+	std::vector<uint> families = { context.graphicsFamily, context.computeFamily };
+
+	for (uint i = 0; i < 2; i++) {
+		context.CreateBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positionBuffers[i], positionMemory[i], families);
+		context.CreateBuffer(size, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, velocityBuffers[i], velocityMemory[i], families);
+	}
+
+	context.UploadBuffer(positionBuffers[0], positions.data(), size);
+	context.UploadBuffer(velocityBuffers[0], velocities.data(), size);
+}
+
+void ParticleSystem::CreateDescriptors(DescriptorLayoutCache& layoutCache) {
+	std::vector<VkDescriptorSetLayoutBinding> bindings(4);
+	for (uint i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	descriptorSetLayout = layoutCache.Get(bindings);
+
+	VkDescriptorPoolSize poolSize {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 8;
+
+	VkDescriptorPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 2;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if (vkCreateDescriptorPool(context.device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a descriptor pool.");
+	}
+
+	std::array<VkDescriptorSetLayout, 2> layouts = { descriptorSetLayout, descriptorSetLayout };
+	VkDescriptorSetAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = descriptorPool;
+	allocInfo.descriptorSetCount = layouts.size();
+	allocInfo.pSetLayouts = layouts.data();
+
+	if (vkAllocateDescriptorSets(context.device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate descriptor sets.");
+	}
+
+	for (uint i = 0; i < 2; i++) {
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos {};
+		bufferInfos[0].buffer = positionBuffers[i];
+		bufferInfos[1].buffer = velocityBuffers[i];
+		bufferInfos[2].buffer = positionBuffers[1 - i];
+		bufferInfos[3].buffer = velocityBuffers[1 - i];
+
+		std::array<VkWriteDescriptorSet, 4> writes {};
+		for (uint binding = 0; binding < writes.size(); binding++) {
+			bufferInfos[binding].offset = 0;
+			bufferInfos[binding].range = VK_WHOLE_SIZE;
+
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = descriptorSets[i];
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[binding].pBufferInfo = &bufferInfos[binding];
+		}
+
+		vkUpdateDescriptorSets(context.device, writes.size(), writes.data(), 0, nullptr);
+	}
+}
+
+void ParticleSystem::CreateComputePipeline() {
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(Parameters);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &descriptorSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &computeLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+
+	computePipeline = BuildComputePipeline();
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline ParticleSystem::BuildComputePipeline() const {
+	std::string code = Context::ReadFile("src/Shaders/particles.comp.spv");
+	VkShaderModule module = context.CreateShaderModule(code);
+
+	VkSpecializationMapEntry workgroupEntry {};
+	workgroupEntry.constantID = 0;
+	workgroupEntry.offset = 0;
+	workgroupEntry.size = sizeof(uint);
+
+	VkSpecializationInfo specializationInfo {};
+	specializationInfo.mapEntryCount = 1;
+	specializationInfo.pMapEntries = &workgroupEntry;
+	specializationInfo.dataSize = sizeof(uint);
+	specializationInfo.pData = &workgroupSize;
+
+	VkPipelineShaderStageCreateInfo stageInfo {};
+	stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	stageInfo.module = module;
+	stageInfo.pName = "main";
+	stageInfo.pSpecializationInfo = &specializationInfo;
+
+	VkComputePipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = stageInfo;
+	pipelineInfo.layout = computeLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline built;
+	if (vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a compute pipeline.");
+	}
+
+	vkDestroyShaderModule(context.device, module, nullptr);
+	return built;
+}
+
+void ParticleSystem::CreateRenderPipeline(VkRenderPass renderPass) {
+	this->renderPass = renderPass;
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &renderLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+	FrameCapture::AddPipelineLayout(renderLayout, layoutInfo);
+
+	renderPipeline = BuildRenderPipeline();
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline ParticleSystem::BuildRenderPipeline() const {
+	VkShaderModule vertModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/particles.vert.spv"));
+	VkShaderModule fragModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/particles.frag.spv"));
+
+	VkPipelineShaderStageCreateInfo shaderStages[2] {};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertModule;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragModule;
+	shaderStages[1].pName = "main";
+
+	//? Separate streams, one binding each
+	std::array<VkVertexInputBindingDescription, 2> bindingDescriptions {};
+	std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
+	for (uint i = 0; i < 2; i++) {
+		bindingDescriptions[i].binding = i;
+		bindingDescriptions[i].stride = sizeof(glm::vec4);
+		bindingDescriptions[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		attributeDescriptions[i].binding = i;
+		attributeDescriptions[i].location = i;
+		attributeDescriptions[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		attributeDescriptions[i].offset = 0;
+	}
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo {};
+	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+	inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+
+	VkPipelineViewportStateCreateInfo viewportInfo {};
+	viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportInfo.viewportCount = 1;
+	viewportInfo.scissorCount = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
+	rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizerInfo.cullMode = VK_CULL_MODE_NONE;
+	rasterizerInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizerInfo.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisamplingInfo {};
+	multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisamplingInfo.minSampleShading = 1.0f;
+
+	//? Particles live in clip space on top of everything, depth is neither tested nor written
+	VkPipelineDepthStencilStateCreateInfo depthStencilInfo {};
+	depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilInfo.depthTestEnable = VK_FALSE;
+	depthStencilInfo.depthWriteEnable = VK_FALSE;
+	depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	//? Additive, so dense regions glow instead of depending on draw order
+	VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_TRUE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendInfo {};
+	colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendInfo.logicOpEnable = VK_FALSE;
+	colorBlendInfo.attachmentCount = 1;
+	colorBlendInfo.pAttachments = &colorBlendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+	pipelineInfo.pViewportState = &viewportInfo;
+	pipelineInfo.pDynamicState = &DrawStreamCache::dynamicState;
+	pipelineInfo.pRasterizationState = &rasterizerInfo;
+	pipelineInfo.pMultisampleState = &multisamplingInfo;
+	pipelineInfo.pDepthStencilState = &depthStencilInfo;
+	pipelineInfo.pColorBlendState = &colorBlendInfo;
+	pipelineInfo.layout = renderLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline built;
+	if (vkCreateGraphicsPipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a graphics pipeline");
+	}
+	FrameCapture::AddGraphicsPipeline(built, pipelineInfo);
+
+	vkDestroyShaderModule(context.device, vertModule, nullptr);
+	vkDestroyShaderModule(context.device, fragModule, nullptr);
+	return built;
+}
+
+void ParticleSystem::CreateCommandObjects() {
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = context.computeFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+	if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a command pool.");
+	}
+
+	commandBuffers.resize(Settings::maxFramesInFlight);
+	VkCommandBufferAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = commandBuffers.size();
+
+	if (vkAllocateCommandBuffers(context.device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't allocate command buffers.");
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	simulationFinished.resize(Settings::maxFramesInFlight);
+	for (VkSemaphore& semaphore : simulationFinished) {
+		if (vkCreateSemaphore(context.device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a semaphore.");
+		}
+	}
+}
+
+uint ParticleSystem::ChooseWorkgroupSize() {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+
+	//? Subgroup size is only queryable from 1.1, 32 is a safe guess below that
+	uint subgroupSize = 32;
+	if (context.apiVersion >= VK_API_VERSION_1_1) {
+		VkPhysicalDeviceSubgroupProperties subgroupProperties {};
+		subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties2 {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &subgroupProperties;
+		vkGetPhysicalDeviceProperties2(context.physicalDevice, &properties2);
+
+		subgroupSize = std::max(subgroupProperties.subgroupSize, 1u);
+	}
+
+	//? Largest multiple of the subgroup size up to 256, so no subgroup is left partially filled
+	uint limit = std::min({256u, properties.limits.maxComputeWorkGroupSize[0], properties.limits.maxComputeWorkGroupInvocations});
+	uint size = subgroupSize <= limit ? limit / subgroupSize * subgroupSize : limit;
+
+	if ((particleCount + size - 1) / size > properties.limits.maxComputeWorkGroupCount[0]) {
+		throw std::runtime_error("Too many particles for a single dispatch.");
+	}
+	return size;
+}
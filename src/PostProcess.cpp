@@ -0,0 +1,489 @@
+#include "PostProcess.hpp"
+#include <cctype>
+
+namespace {
+	//? Have to match the local sizes in postdown.comp, postup.comp and postcomposite.comp
+	const uint postGroupSize = 8;
+	const uint compositeGroupSize = 16;
+	//? Every image in the chain is RGBA16F
+	const double bytesPerTexel = 8.0;
+	const double mebibyte = 1024.0 * 1024.0;
+	//? Exposure buffer: logSum and samples, cleared every frame, then the two adapted slots
+	const VkDeviceSize exposureCounterBytes = 2 * sizeof(uint);
+	const VkDeviceSize exposureBytes = exposureCounterBytes + 2 * sizeof(float);
+
+	double Texels(VkExtent2D extent) {
+		return double(extent.width) * extent.height;
+	}
+
+	uint Groups(uint size, uint groupSize) {
+		return (size + groupSize - 1) / groupSize;
+	}
+}
+
+bool PostProcess::Supported(const Context& context) {
+	if (context.apiVersion < VK_API_VERSION_1_1) {
+		return false;
+	}
+	VkPhysicalDeviceSubgroupProperties subgroupProperties {};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties2 {};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &subgroupProperties;
+	vkGetPhysicalDeviceProperties2(context.physicalDevice, &properties2);
+
+	VkSubgroupFeatureFlags needed = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+	return (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) and (subgroupProperties.supportedOperations & needed) == needed;
+}
+
+void PostProcess::Init(const Context& context, DescriptorLayoutCache& layoutCache, VkImage sceneImage, VkImageView sceneView, VkExtent2D maxExtent) {
+	this->context = context;
+	this->sceneImage = sceneImage;
+	this->maxExtent = maxExtent;
+
+	//? Level i is the frame shifted down by i + 1, stop before it runs out of texels
+	levels = 0;
+	while (levels < std::max(Settings::bloomLevels, 1u) and (maxExtent.width >> (levels + 1)) > 0 and (maxExtent.height >> (levels + 1)) > 0) {
+		levels++;
+	}
+	if (levels == 0) {
+		throw std::runtime_error("Couldn't fit a bloom level into the frame.");
+	}
+
+	CreateImages();
+	CreateDescriptors(layoutCache, sceneView);
+	CreatePipelines();
+
+	timer.Init(context, context.graphicsFamily, ScopeCount);
+	scopes[DownScope] = timer.AddScope("luminance and bloom down");
+	scopes[UpScope] = timer.AddScope("bloom up");
+	scopes[CompositeScope] = timer.AddScope("composite");
+	frameTraffic.resize(Settings::maxFramesInFlight);
+}
+
+void PostProcess::CleanUp() {
+	timer.CleanUp();
+	vkDestroyPipeline(context.device, compositePipeline, nullptr);
+	vkDestroyPipeline(context.device, upPipeline, nullptr);
+	vkDestroyPipeline(context.device, downPipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+	descriptorAllocator.CleanUp();
+	vkDestroySampler(context.device, sampler, nullptr);
+	context.DestroyBuffer(exposureBuffer, exposureMemory);
+	vkDestroyImageView(context.device, outputView, nullptr);
+	context.DestroyImage(outputImage, outputMemory);
+	for (VkImageView levelView : bloomViews) {
+		vkDestroyImageView(context.device, levelView, nullptr);
+	}
+	context.DestroyImage(bloomImage, bloomMemory);
+}
+
+void PostProcess::CreateImages() {
+	VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT;
+	context.CreateImage(LevelExtent(maxExtent, 0), levels, format, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, bloomImage, bloomMemory);
+	bloomViews.resize(levels);
+	for (uint i = 0; i < levels; i++) {
+		VkImageViewCreateInfo viewInfo {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = bloomImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = i;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(context.device, &viewInfo, nullptr, &bloomViews[i]) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create an image view.");
+		}
+	}
+
+	//? The composite writes it directly, the caller copies it out from GENERAL
+	context.CreateImage(maxExtent, 1, format, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, outputImage, outputMemory);
+	outputView = context.CreateImageView(outputImage, format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	//? Bilinear taps do half the downsampling and upsampling work
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = 0.0f;
+
+	if (vkCreateSampler(context.device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a sampler.");
+	}
+
+	context.CreateBuffer(exposureBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, exposureBuffer, exposureMemory);
+
+	//? Both images stay in GENERAL from here on. Exposure starts adapted to a luminance of 1
+	context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+		std::array<VkImageMemoryBarrier, 2> barriers {};
+		for (VkImageMemoryBarrier& barrier : barriers) {
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+		}
+		barriers[0].image = bloomImage;
+		barriers[0].subresourceRange.levelCount = levels;
+		barriers[1].image = outputImage;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+
+		float one = 1.0f;
+		uint oneBits;
+		memcpy(&oneBits, &one, sizeof(uint));
+		vkCmdFillBuffer(commandBuffer, exposureBuffer, 0, exposureCounterBytes, 0);
+		vkCmdFillBuffer(commandBuffer, exposureBuffer, exposureCounterBytes, exposureBytes - exposureCounterBytes, oneBits);
+	});
+}
+
+void PostProcess::CreateDescriptors(DescriptorLayoutCache& layoutCache, VkImageView sceneView) {
+	std::vector<VkDescriptorSetLayoutBinding> bindings(4);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[2].binding = 2;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[3].binding = 3;
+	bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	for (VkDescriptorSetLayoutBinding& binding : bindings) {
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	setLayout = layoutCache.Get(bindings);
+
+	descriptorAllocator.Init(context.device, 2 * levels + 1);
+	downSets.resize(levels);
+	upSets.resize(levels - 1);
+	for (uint i = 0; i < levels; i++) {
+		downSets[i] = descriptorAllocator.Allocate(setLayout);
+		WriteSet(downSets[i], i == 0 ? sceneView : bloomViews[i - 1], bloomViews[i], i == 0);
+	}
+	for (uint i = 0; i + 1 < levels; i++) {
+		upSets[i] = descriptorAllocator.Allocate(setLayout);
+		WriteSet(upSets[i], bloomViews[i + 1], bloomViews[i], false);
+	}
+	compositeSet = descriptorAllocator.Allocate(setLayout);
+	WriteSet(compositeSet, sceneView, outputView, true);
+}
+
+void PostProcess::WriteSet(VkDescriptorSet set, VkImageView source, VkImageView destination, bool sourceIsScene) {
+	VkDescriptorImageInfo sourceInfo {};
+	sourceInfo.sampler = sampler;
+	sourceInfo.imageView = source;
+	sourceInfo.imageLayout = sourceIsScene ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo destinationInfo {};
+	destinationInfo.imageView = destination;
+	destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorBufferInfo exposureInfo {};
+	exposureInfo.buffer = exposureBuffer;
+	exposureInfo.offset = 0;
+	exposureInfo.range = exposureBytes;
+
+	//? Only the composite reads it, the other passes get it so every binding is valid
+	VkDescriptorImageInfo bloomInfo {};
+	bloomInfo.sampler = sampler;
+	bloomInfo.imageView = bloomViews[0];
+	bloomInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	std::array<VkWriteDescriptorSet, 4> writes {};
+	for (uint i = 0; i < writes.size(); i++) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+	}
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[0].pImageInfo = &sourceInfo;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	writes[1].pImageInfo = &destinationInfo;
+	writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writes[2].pBufferInfo = &exposureInfo;
+	writes[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[3].pImageInfo = &bloomInfo;
+	vkUpdateDescriptorSets(context.device, writes.size(), writes.data(), 0, nullptr);
+}
+
+void PostProcess::CreatePipelines() {
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PassConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+
+	downPipeline = BuildDownPipeline();
+	upPipeline = BuildUpPipeline();
+	compositePipeline = BuildCompositePipeline();
+}
+
+//? Settings are baked in as specialization constants, in constant_id order
+VkPipeline PostProcess::BuildDownPipeline() const {
+	return CreatePipeline("src/Shaders/postdown.comp.spv", { Settings::bloomThreshold });
+}
+
+VkPipeline PostProcess::BuildUpPipeline() const {
+	return CreatePipeline("src/Shaders/postup.comp.spv", {});
+}
+
+VkPipeline PostProcess::BuildCompositePipeline() const {
+	return CreatePipeline("src/Shaders/postcomposite.comp.spv", {
+		Settings::bloomIntensity, Settings::exposureKey, Settings::exposureAdaptRate, Settings::sharpenAmount,
+		Settings::gradeSaturation, Settings::gradeContrast, Settings::gradeTint[0], Settings::gradeTint[1], Settings::gradeTint[2],
+	});
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline PostProcess::CreatePipeline(const std::string& path, const std::vector<float>& constants) const {
+	std::vector<VkSpecializationMapEntry> entries(constants.size());
+	for (uint i = 0; i < entries.size(); i++) {
+		entries[i].constantID = i;
+		entries[i].offset = i * sizeof(float);
+		entries[i].size = sizeof(float);
+	}
+
+	VkSpecializationInfo specializationInfo {};
+	specializationInfo.mapEntryCount = entries.size();
+	specializationInfo.pMapEntries = entries.data();
+	specializationInfo.dataSize = constants.size() * sizeof(float);
+	specializationInfo.pData = constants.data();
+
+	VkShaderModule module = context.CreateShaderModule(Context::ReadFile(path));
+
+	VkComputePipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.stage.pSpecializationInfo = constants.empty() ? nullptr : &specializationInfo;
+	pipelineInfo.layout = pipelineLayout;
+
+	VkPipeline pipeline;
+	if (vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a compute pipeline.");
+	}
+	vkDestroyShaderModule(context.device, module, nullptr);
+	return pipeline;
+}
+
+void PostProcess::Resolve(uint frameIndex) {
+	timer.Resolve(frameIndex);
+	bool valid = true;
+	for (uint scope : scopes) {
+		valid = valid and timer.Valid(scope);
+	}
+	if (!valid) {
+		return;
+	}
+	for (uint i = 0; i < ScopeCount; i++) {
+		totalMs[i] += timer.Milliseconds(scopes[i]);
+	}
+	const Traffic& traffic = frameTraffic[frameIndex];
+	timedTraffic.down += traffic.down;
+	timedTraffic.up += traffic.up;
+	timedTraffic.composite += traffic.composite;
+	timedTraffic.naive += traffic.naive;
+	timedFrames++;
+}
+
+void PostProcess::Record(VkCommandBuffer commandBuffer, uint frameIndex, VkExtent2D extent, float deltaTime) {
+	timer.Reset(commandBuffer, frameIndex);
+
+	//? The last frame's passes are done with the bloom chain and the exposure counters before this one starts
+	VkMemoryBarrier previousFrame {};
+	previousFrame.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	previousFrame.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	previousFrame.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &previousFrame, 0, nullptr, 0, nullptr);
+	vkCmdFillBuffer(commandBuffer, exposureBuffer, 0, exposureCounterBytes, 0);
+
+	VkBufferMemoryBarrier counterBarrier {};
+	counterBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	counterBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counterBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	counterBarrier.buffer = exposureBuffer;
+	counterBarrier.offset = 0;
+	counterBarrier.size = exposureCounterBytes;
+
+	VkImageMemoryBarrier sceneBarrier {};
+	sceneBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	sceneBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	sceneBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	sceneBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	sceneBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	sceneBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	sceneBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	sceneBarrier.image = sceneImage;
+	sceneBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	sceneBarrier.subresourceRange.baseMipLevel = 0;
+	sceneBarrier.subresourceRange.levelCount = 1;
+	sceneBarrier.subresourceRange.baseArrayLayer = 0;
+	sceneBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &counterBarrier, 1, &sceneBarrier);
+
+	//? Each pass reads what the one before it wrote
+	VkMemoryBarrier passBarrier {};
+	passBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	passBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	passBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	VkExtent2D scene = extent;
+	VkExtent2D sceneFull = maxExtent;
+	auto Dispatch = [&](VkPipeline pipeline, VkDescriptorSet set, VkExtent2D source, VkExtent2D sourceFull, VkExtent2D destination, uint groupSize, uint mode) {
+		PassConstants constants {};
+		constants.sourceTexel = glm::vec2(1.0f / sourceFull.width, 1.0f / sourceFull.height);
+		constants.sourceMax = (glm::vec2(source.width, source.height) - 0.5f) * constants.sourceTexel;
+		VkExtent2D bloom = LevelExtent(extent, 0);
+		VkExtent2D bloomFull = LevelExtent(maxExtent, 0);
+		constants.bloomTexel = glm::vec2(1.0f / bloomFull.width, 1.0f / bloomFull.height);
+		constants.bloomMax = (glm::vec2(bloom.width, bloom.height) - 0.5f) * constants.bloomTexel;
+		constants.destinationSize = glm::ivec2(destination.width, destination.height);
+		constants.deltaTime = deltaTime;
+		constants.mode = mode;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PassConstants), &constants);
+		vkCmdDispatch(commandBuffer, Groups(destination.width, groupSize), Groups(destination.height, groupSize), 1);
+	};
+
+	timer.Begin(commandBuffer, frameIndex, scopes[DownScope]);
+	for (uint i = 0; i < levels; i++) {
+		VkExtent2D source = i == 0 ? scene : LevelExtent(extent, i - 1);
+		VkExtent2D sourceFull = i == 0 ? sceneFull : LevelExtent(maxExtent, i - 1);
+		Dispatch(downPipeline, downSets[i], source, sourceFull, LevelExtent(extent, i), postGroupSize, i == 0 ? 1 : 0);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+	}
+	timer.End(commandBuffer, frameIndex, scopes[DownScope]);
+
+	timer.Begin(commandBuffer, frameIndex, scopes[UpScope]);
+	for (uint i = levels - 1; i > 0; i--) {
+		Dispatch(upPipeline, upSets[i - 1], LevelExtent(extent, i), LevelExtent(maxExtent, i), LevelExtent(extent, i - 1), postGroupSize, 0);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &passBarrier, 0, nullptr, 0, nullptr);
+	}
+	timer.End(commandBuffer, frameIndex, scopes[UpScope]);
+
+	//? Frames alternate the adapted luminance slot they write, reading the one the frame before wrote
+	timer.Begin(commandBuffer, frameIndex, scopes[CompositeScope]);
+	Dispatch(compositePipeline, compositeSet, scene, sceneFull, extent, compositeGroupSize, uint(recordedFrames % 2));
+	timer.End(commandBuffer, frameIndex, scopes[CompositeScope]);
+
+	Traffic traffic = Estimate(extent);
+	frameTraffic[frameIndex] = traffic;
+	totalTraffic.down += traffic.down;
+	totalTraffic.up += traffic.up;
+	totalTraffic.composite += traffic.composite;
+	totalTraffic.naive += traffic.naive;
+	recordedFrames++;
+}
+
+VkImage PostProcess::Output() const {
+	return outputImage;
+}
+
+VkExtent2D PostProcess::LevelExtent(VkExtent2D extent, uint level) const {
+	return { std::max(extent.width >> (level + 1), 1u), std::max(extent.height >> (level + 1), 1u) };
+}
+
+PostProcess::Traffic PostProcess::Estimate(VkExtent2D extent) const {
+	double frame = Texels(extent) * bytesPerTexel;
+	Traffic traffic;
+
+	//? Fused: the first downsample reads the scene once for both the luminance sum and the
+	//? prefilter, every level is written once going down and read, added to and written going up
+	traffic.down = frame;
+	for (uint i = 0; i < levels; i++) {
+		double level = Texels(LevelExtent(extent, i)) * bytesPerTexel;
+		traffic.down += level;
+		if (i + 1 < levels) {
+			traffic.down += level;
+		}
+	}
+	for (uint i = 0; i + 1 < levels; i++) {
+		traffic.up += Texels(LevelExtent(extent, i + 1)) * bytesPerTexel + 2.0 * Texels(LevelExtent(extent, i)) * bytesPerTexel;
+	}
+	traffic.composite = frame + Texels(LevelExtent(extent, 0)) * bytesPerTexel + frame;
+
+	//? Naive: a luminance pass over the scene, a full size bright pass, the same bloom chain from
+	//? it, then bloom composite, tonemap, grade and sharpen each reading and writing the frame
+	traffic.naive = frame;
+	traffic.naive += 2.0 * frame;
+	traffic.naive += traffic.down + traffic.up;
+	traffic.naive += frame + Texels(LevelExtent(extent, 0)) * bytesPerTexel + frame;
+	traffic.naive += 3.0 * 2.0 * frame;
+	return traffic;
+}
+
+const GpuTimer& PostProcess::Timer() const {
+	return timer;
+}
+
+void PostProcess::RegisterShaders(ShaderReloader& reloader) {
+	reloader.Register("post down", { "src/Shaders/postdown.comp" }, downPipeline, [this] { return BuildDownPipeline(); });
+	reloader.Register("post up", { "src/Shaders/postup.comp" }, upPipeline, [this] { return BuildUpPipeline(); });
+	reloader.Register("post composite", { "src/Shaders/postcomposite.comp" }, compositePipeline, [this] { return BuildCompositePipeline(); });
+}
+
+void PostProcess::PrintStats() {
+	std::cout << "Post-processing:\n";
+	std::cout << "\tBloom: " << levels << " levels below " << maxExtent.width << "x" << maxExtent.height << "\n";
+	if (recordedFrames == 0) {
+		std::cout << "\tNo frames recorded\n" << std::endl;
+		return;
+	}
+
+	std::array<double, ScopeCount> bytes = { timedTraffic.down, timedTraffic.up, timedTraffic.composite };
+	std::array<double, ScopeCount> recordedBytes = { totalTraffic.down, totalTraffic.up, totalTraffic.composite };
+	double fusedBytes = 0.0;
+	for (uint i = 0; i < ScopeCount; i++) {
+		std::cout << "\t" << char(std::toupper(timer.Name(scopes[i])[0])) << timer.Name(scopes[i]).substr(1) << ": ";
+		if (timedFrames > 0) {
+			std::cout << totalMs[i] / timedFrames << " ms/frame, ";
+		}
+		std::cout << recordedBytes[i] / recordedFrames / mebibyte << " MiB/frame";
+		if (timedFrames > 0 and totalMs[i] > 0.0) {
+			std::cout << " (" << bytes[i] / (totalMs[i] / 1000.0) / 1e9 << " GB/s)";
+		}
+		std::cout << "\n";
+		fusedBytes += recordedBytes[i];
+	}
+	if (timedFrames == 0) {
+		std::cout << "\tNo timings (timestamps unsupported on the graphics queue)\n";
+	}
+
+	//? Estimates from texel counts, caches and compression make the real numbers lower for both
+	double naiveBytes = totalTraffic.naive;
+	std::cout << "\tEstimated traffic: " << fusedBytes / recordedFrames / mebibyte << " MiB/frame fused, " << naiveBytes / recordedFrames / mebibyte
+		<< " MiB/frame with one full screen pass per effect (" << (fusedBytes > 0.0 ? naiveBytes / fusedBytes : 0.0) << "x)\n";
+	std::cout << "\tDispatches: " << 2 * levels << " fused, " << 2 * levels + 5 << " with one pass per effect\n";
+	std::cout << std::endl;
+}
@@ -0,0 +1,105 @@
+#include "ResolutionController.hpp"
+
+namespace {
+	//? Weight of the newest sample in the smoothed time
+	const double smoothing = 0.1;
+	//? Raising needs the time predicted at the next step to stay this far under the target
+	const double raiseHeadroom = 0.85;
+	//? Lowering aims this far under the target, so the new scale isn't right at the edge
+	const double dropAim = 0.9;
+	//? Scales are multiples of this, small moves aren't worth re-recording the frame's streams
+	const float scaleStep = 1.0f / 32.0f;
+	const float maxDrop = 0.25f;
+	//? Past the frames in flight, samples from before a change are still being resolved
+	const uint settleExtra = 4;
+	const uint firstRaiseDelay = 30;
+	const uint maxRaiseDelay = 960;
+	//? A drop within this many frames of a raise undoes it
+	const uint undoWindow = 120;
+
+	float Quantize(float scale) {
+		return std::floor(scale / scaleStep + 0.5f) * scaleStep;
+	}
+}
+
+void ResolutionController::Init(float minScale, float maxScale, double targetMs) {
+	this->minScale = std::min(minScale, maxScale);
+	this->maxScale = maxScale;
+	this->targetMs = targetMs;
+	scale = maxScale;
+	raiseDelay = firstRaiseDelay;
+	settleFrames = Settings::maxFramesInFlight + settleExtra;
+}
+
+bool ResolutionController::Update(double gpuMs) {
+	frames++;
+	framesOver += gpuMs > targetMs;
+	scaleSum += scale;
+	gpuMsSum += gpuMs;
+	if (sinceRaise != UINT64_MAX) {
+		sinceRaise++;
+	}
+
+	if (settleFrames > 0) {
+		settleFrames--;
+		return false;
+	}
+	smoothedMs = smoothed ? smoothedMs + (gpuMs - smoothedMs) * smoothing : gpuMs;
+	smoothed = true;
+
+	if (smoothedMs > targetMs and scale > minScale) {
+		//? Pixel count goes with the square of the scale
+		float wanted = scale * float(std::sqrt(targetMs * dropAim / smoothedMs));
+		float lowered = std::min(std::floor(wanted / scaleStep) * scaleStep, scale - scaleStep);
+		lowered = std::max(lowered, std::max(scale - maxDrop, minScale));
+		if (sinceRaise < undoWindow) {
+			undoneRaises++;
+			raiseDelay = std::min(raiseDelay * 2, maxRaiseDelay);
+			sinceRaise = UINT64_MAX;
+		}
+		Change(lowered, "over the target");
+		drops++;
+		return true;
+	}
+
+	float raised = std::min(Quantize(scale + scaleStep), maxScale);
+	double predictedMs = smoothedMs * (raised * raised) / (scale * scale);
+	underFrames = raised > scale and predictedMs < targetMs * raiseHeadroom ? underFrames + 1 : 0;
+	if (underFrames >= raiseDelay) {
+		Change(raised, "under the target");
+		raises++;
+		sinceRaise = 0;
+		return true;
+	}
+	return false;
+}
+
+void ResolutionController::Change(float newScale, const char* reason) {
+	std::cout << "Dynamic resolution: " << scale << " -> " << newScale << ", GPU " << smoothedMs << " ms " << reason << " of " << targetMs << " ms";
+	std::cout << ", next raise after " << raiseDelay << " frames under" << std::endl;
+	scale = newScale;
+	smoothed = false;
+	underFrames = 0;
+	settleFrames = Settings::maxFramesInFlight + settleExtra;
+}
+
+float ResolutionController::Scale() const {
+	return scale;
+}
+
+VkExtent2D ResolutionController::Extent(VkExtent2D full) const {
+	VkExtent2D extent;
+	extent.width = std::max(uint(std::lround(full.width * scale)), 1u);
+	extent.height = std::max(uint(std::lround(full.height * scale)), 1u);
+	return extent;
+}
+
+void ResolutionController::PrintStats() {
+	double frameCount = double(std::max(frames, uint64(1)));
+	std::cout << "Dynamic resolution:\n";
+	std::cout << "\tTarget: " << targetMs << " ms GPU, scale " << minScale << " to " << maxScale << "\n";
+	std::cout << "\tScale: " << scale << " now, " << scaleSum / frameCount << " on average\n";
+	std::cout << "\tGPU time: " << gpuMsSum / frameCount << " ms on average, " << double(framesOver) / frameCount * 100.0 << "% of frames over the target\n";
+	std::cout << "\tChanges: " << drops << " down, " << raises << " up, " << undoneRaises << " raises undone\n";
+	std::cout << std::endl;
+}
@@ -0,0 +1,1022 @@
+#include "Scene.hpp"
+#include "FrameCapture.hpp"
+#include "DrawStreamCache.hpp"
+#include "MeshImport.hpp"
+#include <random>
+#include <unordered_map>
+
+namespace {
+	const float objectSpacing = 4.0f;
+	const float fieldOfView = glm::radians(60.0f);
+	const float nearPlane = 0.1f;
+	//? Has to match local_size_x in cull.comp
+	const uint cullWorkgroupSize = 64;
+	const uint materialCount = 16;
+	//? Radians per second
+	const float spinSpeed = 1.5f;
+	//? Clean rows between two dirty ones that still go up in a single copy
+	const uint uploadMergeGap = 4;
+
+	void Icosphere(uint subdivisions, std::vector<MeshVertex>& vertices, std::vector<uint>& indices) {
+		const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+		const std::vector<glm::vec3> corners = {
+			{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+			{0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+			{t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+		};
+		vertices.clear();
+		for (const glm::vec3& corner : corners) {
+			vertices.push_back({ glm::normalize(corner), glm::vec3(0.0f) });
+		}
+		indices = {
+			0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+			1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+			4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+		};
+
+		for (uint s = 0; s < subdivisions; s++) {
+			//? Edges are shared, so each midpoint is created once
+			std::unordered_map<uint64, uint> midpoints;
+			auto midpoint = [&](uint a, uint b) {
+				uint64 key = a < b ? (uint64(a) << 32 | b) : (uint64(b) << 32 | a);
+				auto found = midpoints.find(key);
+				if (found != midpoints.end()) {
+					return found->second;
+				}
+				glm::vec3 position = glm::normalize(vertices[a].position + vertices[b].position);
+				vertices.push_back({ position, glm::vec3(0.0f) });
+				midpoints[key] = vertices.size() - 1;
+				return uint(vertices.size() - 1);
+			};
+
+			std::vector<uint> subdivided;
+			subdivided.reserve(indices.size() * 4);
+			for (uint i = 0; i < indices.size(); i += 3) {
+				uint a = indices[i];
+				uint b = indices[i + 1];
+				uint c = indices[i + 2];
+				uint ab = midpoint(a, b);
+				uint bc = midpoint(b, c);
+				uint ca = midpoint(c, a);
+				subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+			}
+			indices = std::move(subdivided);
+		}
+		MeshImport::ComputeNormals(vertices, indices);
+	}
+
+	//? Seams wrap around instead of duplicating vertices, so the surface is closed
+	void Torus(float majorRadius, float minorRadius, uint rings, uint sides, std::vector<MeshVertex>& vertices, std::vector<uint>& indices) {
+		vertices.clear();
+		indices.clear();
+		for (uint i = 0; i < rings; i++) {
+			float a = 2.0f * glm::pi<float>() * i / rings;
+			for (uint j = 0; j < sides; j++) {
+				float b = 2.0f * glm::pi<float>() * j / sides;
+				float distance = majorRadius + minorRadius * std::cos(b);
+				vertices.push_back({ { distance * std::cos(a), minorRadius * std::sin(b), distance * std::sin(a) }, glm::vec3(0.0f) });
+			}
+		}
+		for (uint i = 0; i < rings; i++) {
+			for (uint j = 0; j < sides; j++) {
+				uint p00 = i * sides + j;
+				uint p10 = ((i + 1) % rings) * sides + j;
+				uint p01 = i * sides + (j + 1) % sides;
+				uint p11 = ((i + 1) % rings) * sides + (j + 1) % sides;
+				indices.insert(indices.end(), { p00, p11, p10, p00, p01, p11 });
+			}
+		}
+		MeshImport::ComputeNormals(vertices, indices);
+	}
+
+	//? A lumpy sphere, its bumps are what the coarse levels lose first
+	void Rock(uint subdivisions, std::vector<MeshVertex>& vertices, std::vector<uint>& indices) {
+		Icosphere(subdivisions, vertices, indices);
+		for (MeshVertex& vertex : vertices) {
+			glm::vec3 p = vertex.position;
+			float bumps = std::sin(5.0f * p.x) * std::sin(4.0f * p.y) * std::sin(6.0f * p.z);
+			float ridges = std::sin(13.0f * p.x + 7.0f * p.z) * 0.3f;
+			vertex.position = p * (1.0f + 0.18f * bumps + 0.04f * ridges);
+		}
+		MeshImport::ComputeNormals(vertices, indices);
+	}
+}
+
+static_assert(Settings::lodLevels <= 8, "cull.comp counts draws for at most 8 levels of detail.");
+
+bool Scene::UsesGpuCulling(const Context& context) {
+	//? Draws carry the object index in firstInstance, indirect ones can only do that with the feature
+	return Settings::gpuCulling and context.drawIndirectFirstInstance;
+}
+
+bool Scene::UsesOcclusionCulling(const Context& context) {
+	return Settings::renderScene and Settings::occlusionCulling and UsesGpuCulling(context);
+}
+
+void Scene::Init(const Context& context, DescriptorLayoutCache& layoutCache, VkDescriptorSetLayout frameSetLayout, VkRenderPass renderPass, VkExtent2D extent, VkImageView depthView) {
+	this->context = context;
+	this->extent = extent;
+	renderExtent = extent;
+	pixelsPerUnit = extent.height / (2.0f * std::tan(fieldOfView * 0.5f));
+
+	CreateMeshes();
+	CreateObjects();
+	CreateDescriptors(layoutCache);
+	CreatePipeline(frameSetLayout, renderPass);
+
+	gpuCulling = UsesGpuCulling(context);
+	occlusionCulling = UsesOcclusionCulling(context);
+	if (gpuCulling) {
+		CreateCulling(layoutCache, depthView);
+	} else {
+		drawQueue.Init(entities.Size());
+		bvh.Build(entities.Bounds(), entities.Size());
+		movedRows.reserve(spinning.size());
+		visibleRows.reserve(entities.Size());
+	}
+}
+
+void Scene::CleanUp() {
+	if (occlusionCulling) {
+		gpuTimer.CleanUp();
+		pyramid.CleanUp();
+		for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+			context.DestroyBuffer(visibilityBuffers[i], visibilityMemory[i]);
+			context.DestroyBuffer(lateDrawBuffers[i], lateDrawMemory[i]);
+		}
+	}
+	if (gpuCulling) {
+		vkDestroyPipeline(context.device, cullPipeline, nullptr);
+		vkDestroyPipelineLayout(context.device, cullLayout, nullptr);
+		for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+			vkUnmapMemory(context.device, cullDataMemory[i]);
+			context.DestroyBuffer(cullDataBuffers[i], cullDataMemory[i]);
+			vkUnmapMemory(context.device, countMemory[i]);
+			context.DestroyBuffer(countBuffers[i], countMemory[i]);
+			context.DestroyBuffer(drawBuffers[i], drawMemory[i]);
+		}
+		context.DestroyBuffer(lodInfoBuffer, lodInfoMemory);
+		context.DestroyBuffer(meshInfoBuffer, meshInfoMemory);
+		context.DestroyBuffer(boundsBuffer, boundsMemory);
+	}
+	vkDestroyPipeline(context.device, pipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+	descriptorAllocator.CleanUp();
+	for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+		vkUnmapMemory(context.device, uploadMemory[i]);
+		context.DestroyBuffer(uploadBuffers[i], uploadMemory[i]);
+	}
+	context.DestroyBuffer(objectBuffer, objectMemory);
+	meshes.CleanUp();
+}
+
+void Scene::CreateMeshes() {
+	meshes.Init(context);
+
+	std::vector<MeshVertex> vertices;
+	std::vector<uint> indices;
+	Icosphere(5, vertices, indices);
+	meshes.Add("sphere", vertices, indices, Settings::lodLevels);
+	Torus(1.0f, 0.35f, 128, 48, vertices, indices);
+	meshes.Add("torus", vertices, indices, Settings::lodLevels);
+	Rock(5, vertices, indices);
+	meshes.Add("rock", vertices, indices, Settings::lodLevels);
+	for (const std::string& path : Settings::sceneMeshFiles) {
+		meshes.Load(path);
+	}
+
+	meshes.Upload();
+}
+
+void Scene::CreateObjects() {
+	//? Fixed seed, every run draws the same scene
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	uint side = uint(std::ceil(std::sqrt(float(Settings::sceneObjects))));
+	float offset = (side - 1) * objectSpacing * 0.5f;
+
+	for (uint i = 0; i < materialCount; i++) {
+		materialColors.push_back(glm::vec4(0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random), 0.3f + 0.7f * unit(random), 1.0f));
+	}
+
+	std::vector<EntityStore::Desc> descs(Settings::sceneObjects);
+	for (uint i = 0; i < Settings::sceneObjects; i++) {
+		EntityStore::Desc& desc = descs[i];
+		desc.mesh = i % meshes.Count();
+		desc.position = glm::vec3((i % side) * objectSpacing - offset, 0.0f, (i / side) * objectSpacing - offset);
+		desc.scale = 0.6f + unit(random) * 0.8f;
+		desc.rotation = glm::angleAxis(unit(random) * 2.0f * glm::pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f));
+		desc.material = random() % materialCount;
+
+		const MeshLibrary::Mesh& mesh = meshes.Get(desc.mesh);
+		desc.localBounds = glm::vec4(mesh.center, mesh.radius);
+	}
+	std::vector<EntityStore::Entity> handles(descs.size());
+	entities.Reserve(descs.size());
+	entities.Create(descs.data(), descs.size(), handles.data());
+	lods.assign(entities.Size(), 0);
+
+	//? Spread over the grid, so their rows are scattered too
+	uint spinningCount = std::min(Settings::sceneSpinningObjects, entities.Size());
+	for (uint i = 0; i < spinningCount; i++) {
+		spinning.push_back(handles[uint(uint64(i) * handles.size() / spinningCount)]);
+	}
+
+	std::vector<ObjectData> objectData(entities.Size());
+	for (uint row = 0; row < entities.Size(); row++) {
+		objectData[row] = MakeObjectData(row);
+	}
+	VkDeviceSize size = sizeof(ObjectData) * objectData.size();
+	context.CreateBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, objectBuffer, objectMemory);
+	context.UploadBuffer(objectBuffer, objectData.data(), size);
+	//? Everything just went up whole
+	entities.CollectDirtyRanges(0, dirtyRanges);
+	dirtyRanges.clear();
+
+	//? Room for every row, in case all of them change in one frame
+	VkDeviceSize uploadSize = (sizeof(ObjectData) + sizeof(ObjectBounds)) * entities.Size();
+	uploadBuffers.resize(Settings::maxFramesInFlight);
+	uploadMemory.resize(Settings::maxFramesInFlight);
+	uploadMapped.resize(Settings::maxFramesInFlight);
+	for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+		context.CreateBuffer(uploadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uploadBuffers[i], uploadMemory[i]);
+		vkMapMemory(context.device, uploadMemory[i], 0, uploadSize, 0, &uploadMapped[i]);
+	}
+
+	uint lodCount = 0;
+	for (uint i = 0; i < meshes.Count(); i++) {
+		lodCount = std::max(lodCount, uint(meshes.Get(i).lods.size()));
+	}
+	lodHistogram.assign(lodCount, 0);
+}
+
+void Scene::CreateDescriptors(DescriptorLayoutCache& layoutCache) {
+	std::vector<VkDescriptorSetLayoutBinding> bindings(1);
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	objectSetLayout = layoutCache.Get(bindings);
+
+	//? Nothing here is ever reset: the object set plus a cull set per frame in flight.
+	//? A cull set holds up to seven storage buffers where the pool assumes two a set, so it counts four times
+	descriptorAllocator.Init(context.device, 1 + 4 * Settings::maxFramesInFlight);
+	objectSet = descriptorAllocator.Allocate(objectSetLayout);
+
+	VkDescriptorBufferInfo bufferInfo {};
+	bufferInfo.buffer = objectBuffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = objectSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(context.device, 1, &write, 0, nullptr);
+	FrameCapture::UpdateDescriptorSets(1, &write);
+}
+
+void Scene::CreatePipeline(VkDescriptorSetLayout frameSetLayout, VkRenderPass renderPass) {
+	this->renderPass = renderPass;
+
+	VkDescriptorSetLayout setLayouts[] = { frameSetLayout, objectSetLayout };
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 2;
+	layoutInfo.pSetLayouts = setLayouts;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+	FrameCapture::AddPipelineLayout(pipelineLayout, layoutInfo);
+
+	pipeline = BuildPipeline();
+}
+
+//? Also run on the shader reload thread, so it only reads what stays put after startup
+VkPipeline Scene::BuildPipeline() const {
+	VkShaderModule vertModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/mesh.vert.spv"));
+	VkShaderModule fragModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/mesh.frag.spv"));
+
+	VkPipelineShaderStageCreateInfo shaderStages[2] {};
+	shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStages[0].module = vertModule;
+	shaderStages[0].pName = "main";
+	shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStages[1].module = fragModule;
+	shaderStages[1].pName = "main";
+
+	VkVertexInputBindingDescription bindingDescription {};
+	bindingDescription.binding = 0;
+	bindingDescription.stride = sizeof(MeshVertex);
+	bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions {};
+	attributeDescriptions[0].binding = 0;
+	attributeDescriptions[0].location = 0;
+	attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+	attributeDescriptions[0].offset = offsetof(MeshVertex, position);
+	attributeDescriptions[1].binding = 0;
+	attributeDescriptions[1].location = 1;
+	attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+	attributeDescriptions[1].offset = offsetof(MeshVertex, normal);
+
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo {};
+	inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+
+	VkPipelineViewportStateCreateInfo viewportInfo {};
+	viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportInfo.viewportCount = 1;
+	viewportInfo.scissorCount = 1;
+
+	//? The projection flips Y, which turns counter clockwise meshes clockwise on screen
+	VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
+	rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizerInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizerInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterizerInfo.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisamplingInfo {};
+	multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisamplingInfo.minSampleShading = 1.0f;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencilInfo {};
+	depthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilInfo.depthTestEnable = VK_TRUE;
+	depthStencilInfo.depthWriteEnable = VK_TRUE;
+	depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.blendEnable = VK_FALSE;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendInfo {};
+	colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendInfo.logicOpEnable = VK_FALSE;
+	colorBlendInfo.attachmentCount = 1;
+	colorBlendInfo.pAttachments = &colorBlendAttachment;
+
+
+	VkGraphicsPipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+	pipelineInfo.pViewportState = &viewportInfo;
+	pipelineInfo.pDynamicState = &DrawStreamCache::dynamicState;
+	pipelineInfo.pRasterizationState = &rasterizerInfo;
+	pipelineInfo.pMultisampleState = &multisamplingInfo;
+	pipelineInfo.pDepthStencilState = &depthStencilInfo;
+	pipelineInfo.pColorBlendState = &colorBlendInfo;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+
+	VkPipeline built;
+	VkResult result = vkCreateGraphicsPipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built);
+	vkDestroyShaderModule(context.device, vertModule, nullptr);
+	vkDestroyShaderModule(context.device, fragModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a graphics pipeline");
+	}
+	FrameCapture::AddGraphicsPipeline(built, pipelineInfo);
+	return built;
+}
+
+void Scene::CreateCulling(DescriptorLayoutCache& layoutCache, VkImageView depthView) {
+	if (context.HasExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+		drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(context.device, "vkCmdDrawIndexedIndirectCountKHR"));
+	}
+
+	std::vector<ObjectBounds> bounds(entities.Size());
+	for (uint row = 0; row < entities.Size(); row++) {
+		bounds[row] = MakeBounds(row);
+	}
+	std::vector<MeshInfo> meshInfos(meshes.Count());
+	std::vector<LodInfo> lodInfos;
+	for (uint i = 0; i < meshes.Count(); i++) {
+		const MeshLibrary::Mesh& mesh = meshes.Get(i);
+		meshInfos[i].vertexOffset = mesh.vertexOffset;
+		meshInfos[i].firstLod = lodInfos.size();
+		meshInfos[i].lodCount = mesh.lods.size();
+		for (const MeshLibrary::Lod& lod : mesh.lods) {
+			lodInfos.push_back({ lod.indexOffset, lod.indexCount, lod.error, 0 });
+		}
+	}
+
+	VkBufferUsageFlags staticUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	context.CreateBuffer(sizeof(ObjectBounds) * bounds.size(), staticUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, boundsBuffer, boundsMemory);
+	context.UploadBuffer(boundsBuffer, bounds.data(), sizeof(ObjectBounds) * bounds.size());
+	context.CreateBuffer(sizeof(MeshInfo) * meshInfos.size(), staticUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, meshInfoBuffer, meshInfoMemory);
+	context.UploadBuffer(meshInfoBuffer, meshInfos.data(), sizeof(MeshInfo) * meshInfos.size());
+	context.CreateBuffer(sizeof(LodInfo) * lodInfos.size(), staticUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, lodInfoBuffer, lodInfoMemory);
+	context.UploadBuffer(lodInfoBuffer, lodInfos.data(), sizeof(LodInfo) * lodInfos.size());
+
+	//? Room for every object, the count says how many records the cull wrote
+	VkDeviceSize drawSize = sizeof(VkDrawIndexedIndirectCommand) * entities.Size();
+	VkBufferUsageFlags indirectUsage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	drawBuffers.resize(Settings::maxFramesInFlight);
+	drawMemory.resize(Settings::maxFramesInFlight);
+	countBuffers.resize(Settings::maxFramesInFlight);
+	countMemory.resize(Settings::maxFramesInFlight);
+	countMapped.resize(Settings::maxFramesInFlight);
+	countsPending.assign(Settings::maxFramesInFlight, false);
+	cullDataBuffers.resize(Settings::maxFramesInFlight);
+	cullDataMemory.resize(Settings::maxFramesInFlight);
+	cullDataMapped.resize(Settings::maxFramesInFlight);
+	for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+		context.CreateBuffer(drawSize, indirectUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, drawBuffers[i], drawMemory[i]);
+		//? Host visible so the stats can be read back without a copy
+		context.CreateBuffer(sizeof(CullCounts), indirectUsage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, countBuffers[i], countMemory[i]);
+		vkMapMemory(context.device, countMemory[i], 0, sizeof(CullCounts), 0, &countMapped[i]);
+		context.CreateBuffer(sizeof(CullData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, cullDataBuffers[i], cullDataMemory[i]);
+		vkMapMemory(context.device, cullDataMemory[i], 0, sizeof(CullData), 0, &cullDataMapped[i]);
+	}
+
+	if (occlusionCulling) {
+		pyramid.Init(context, layoutCache, depthView, extent);
+
+		lateDrawBuffers.resize(Settings::maxFramesInFlight);
+		lateDrawMemory.resize(Settings::maxFramesInFlight);
+		visibilityBuffers.resize(Settings::maxFramesInFlight);
+		visibilityMemory.resize(Settings::maxFramesInFlight);
+		for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+			context.CreateBuffer(drawSize, indirectUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, lateDrawBuffers[i], lateDrawMemory[i]);
+			context.CreateBuffer(sizeof(uint) * entities.Size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, visibilityBuffers[i], visibilityMemory[i]);
+		}
+
+		gpuTimer.Init(context, context.graphicsFamily, 2);
+		sceneScope = gpuTimer.AddScope("scene");
+		pyramidScope = gpuTimer.AddScope("pyramid");
+		baselineFrames.assign(Settings::maxFramesInFlight, false);
+	}
+
+	//? occlusion.comp adds the second phase's draws, the visibility and the pyramid
+	uint bindingCount = occlusionCulling ? 9 : 6;
+	std::vector<VkDescriptorSetLayoutBinding> bindings(bindingCount);
+	for (uint i = 0; i < bindings.size(); i++) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	if (occlusionCulling) {
+		bindings[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	}
+	cullSetLayout = layoutCache.Get(bindings);
+
+	cullSets.resize(Settings::maxFramesInFlight);
+	for (uint i = 0; i < Settings::maxFramesInFlight; i++) {
+		cullSets[i] = descriptorAllocator.Allocate(cullSetLayout);
+
+		std::array<VkDescriptorBufferInfo, 8> bufferInfos {};
+		bufferInfos[0].buffer = boundsBuffer;
+		bufferInfos[1].buffer = meshInfoBuffer;
+		bufferInfos[2].buffer = lodInfoBuffer;
+		bufferInfos[3].buffer = drawBuffers[i];
+		bufferInfos[4].buffer = countBuffers[i];
+		bufferInfos[5].buffer = cullDataBuffers[i];
+		if (occlusionCulling) {
+			bufferInfos[6].buffer = lateDrawBuffers[i];
+			bufferInfos[7].buffer = visibilityBuffers[i];
+		}
+
+		VkDescriptorImageInfo pyramidInfo {};
+		std::array<VkWriteDescriptorSet, 9> writes {};
+		for (uint binding = 0; binding < bindingCount; binding++) {
+			writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[binding].dstSet = cullSets[i];
+			writes[binding].dstBinding = binding;
+			writes[binding].descriptorCount = 1;
+			writes[binding].descriptorType = bindings[binding].descriptorType;
+			if (binding < bufferInfos.size()) {
+				bufferInfos[binding].offset = 0;
+				bufferInfos[binding].range = VK_WHOLE_SIZE;
+				writes[binding].pBufferInfo = &bufferInfos[binding];
+			}
+		}
+		if (occlusionCulling) {
+			pyramidInfo.sampler = pyramid.Sampler();
+			pyramidInfo.imageView = pyramid.View();
+			pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			writes[8].pImageInfo = &pyramidInfo;
+		}
+		vkUpdateDescriptorSets(context.device, bindingCount, writes.data(), 0, nullptr);
+	}
+
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(CullPhase);
+
+	VkPipelineLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &cullSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &cullLayout) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a pipeline layout.");
+	}
+	cullPipeline = BuildCullPipeline();
+}
+
+VkPipeline Scene::BuildCullPipeline() const {
+	VkShaderModule module = context.CreateShaderModule(Context::ReadFile(CullShader() + ".spv"));
+
+	VkComputePipelineCreateInfo pipelineInfo {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = cullLayout;
+
+	VkPipeline built;
+	VkResult result = vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &built);
+	vkDestroyShaderModule(context.device, module, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a compute pipeline.");
+	}
+	return built;
+}
+
+std::string Scene::CullShader() const {
+	return occlusionCulling ? "src/Shaders/occlusion.comp" : "src/Shaders/cull.comp";
+}
+
+void Scene::RegisterShaders(ShaderReloader& reloader) {
+	reloader.Register("mesh", { "src/Shaders/mesh.vert", "src/Shaders/mesh.frag" }, pipeline, [this] { return BuildPipeline(); });
+	if (gpuCulling) {
+		reloader.Register("culling", { CullShader() }, cullPipeline, [this] { return BuildCullPipeline(); });
+	}
+	if (occlusionCulling) {
+		pyramid.RegisterShaders(reloader);
+	}
+}
+
+void Scene::SetRenderExtent(VkExtent2D renderExtent) {
+	if (renderExtent.width != this->renderExtent.width or renderExtent.height != this->renderExtent.height) {
+		renderExtentChanged = true;
+	}
+	this->renderExtent = renderExtent;
+	pixelsPerUnit = renderExtent.height / (2.0f * std::tan(fieldOfView * 0.5f));
+}
+
+void Scene::Update(uint frameIndex, float time) {
+	uint side = uint(std::ceil(std::sqrt(float(Settings::sceneObjects))));
+	float fieldSize = side * objectSpacing;
+
+	//? Low and inside the grid, so objects range from right next to the camera to the far edge
+	float angle = time * 0.1f;
+	float orbit = fieldSize * 0.3f;
+	cameraPosition = glm::vec3(std::cos(angle) * orbit, 3.0f + 2.0f * std::sin(time * 0.3f), std::sin(angle) * orbit);
+	view = glm::lookAt(cameraPosition, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	farPlane = fieldSize * 2.0f;
+	projection = glm::perspective(fieldOfView, float(extent.width) / float(extent.height), nearPlane, farPlane);
+	//? Vulkan's Y axis points down
+	projection[1][1] *= -1.0f;
+	updates++;
+
+	Spin(time - lastTime);
+	lastTime = time;
+	PackUploads(frameIndex);
+
+	if (gpuCulling) {
+		ReadCullCounts(frameIndex);
+
+		CullData cullData {};
+		cullData.view = view;
+		Bvh::FrustumPlanes(projection * view, cullData.planes);
+		cullData.camera = glm::vec4(cameraPosition, pixelsPerUnit);
+		cullData.projection = glm::vec4(projection[0][0], std::abs(projection[1][1]), projection[2][2], projection[3][2]);
+		cullData.pixelError = Settings::lodPixelError;
+		cullData.nearPlane = nearPlane;
+		cullData.objectCount = entities.Size();
+
+		if (occlusionCulling) {
+			VkExtent2D pyramidExtent = pyramid.Extent();
+			cullData.pyramidSize = glm::vec2(pyramidExtent.width, pyramidExtent.height);
+			//? Baseline frames draw everything in the frustum in the first phase, what the test saves is measured against them
+			baselineFrames[frameIndex] = Settings::occlusionBaselineInterval > 0 and updates % Settings::occlusionBaselineInterval == 0;
+			cullData.occlusion = baselineFrames[frameIndex] or renderExtentChanged ? 0 : 1;
+			cullData.viewportScale = glm::vec2(renderExtent.width, renderExtent.height) / glm::vec2(extent.width, extent.height);
+			renderExtentChanged = false;
+		}
+		memcpy(cullDataMapped[frameIndex], &cullData, sizeof(CullData));
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bvh.Refit(entities.Bounds(), movedRows.data(), movedRows.size());
+	auto refitted = std::chrono::steady_clock::now();
+	glm::vec4 planes[6];
+	Bvh::FrustumPlanes(projection * view, planes);
+	visibleRows.clear();
+	bvh.QueryFrustum(planes, visibleRows);
+	refitSeconds += std::chrono::duration<double>(refitted - start).count();
+	querySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - refitted).count();
+	objectsFrustumCulled += entities.Size() - visibleRows.size();
+
+	const uint* meshIds = entities.Meshes();
+	const uint8* flags = entities.EntityFlags();
+	for (uint row : visibleRows) {
+		if (!(flags[row] & EntityStore::Visible)) {
+			continue;
+		}
+		lods[row] = SelectLod(row);
+		const MeshLibrary::Mesh& mesh = meshes.Get(meshIds[row]);
+		trianglesDrawn += mesh.lods[lods[row]].indexCount / 3;
+		trianglesFull += mesh.lods[0].indexCount / 3;
+		lodHistogram[lods[row]]++;
+		objectsDrawn++;
+	}
+	frames++;
+}
+
+void Scene::Spin(float deltaTime) {
+	glm::quat turn = glm::angleAxis(deltaTime * spinSpeed, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::quat* rotations = entities.Rotations();
+	movedRows.clear();
+	for (EntityStore::Entity entity : spinning) {
+		uint row = entities.Row(entity);
+		rotations[row] = glm::normalize(turn * rotations[row]);
+		entities.UpdateBounds(row, row + 1);
+		entities.MarkDirty(row, row + 1);
+		movedRows.push_back(row);
+	}
+}
+
+void Scene::PackUploads(uint frameIndex) {
+	dirtyRanges.clear();
+	objectCopies.clear();
+	boundsCopies.clear();
+	entities.CollectDirtyRanges(uploadMergeGap, dirtyRanges);
+
+	ObjectData* objectData = static_cast<ObjectData*>(uploadMapped[frameIndex]);
+	VkDeviceSize boundsOffset = sizeof(ObjectData) * entities.Size();
+	ObjectBounds* bounds = reinterpret_cast<ObjectBounds*>(static_cast<uint8*>(uploadMapped[frameIndex]) + boundsOffset);
+
+	uint packed = 0;
+	for (const EntityStore::Range& range : dirtyRanges) {
+		uint count = range.end - range.begin;
+		for (uint i = 0; i < count; i++) {
+			objectData[packed + i] = MakeObjectData(range.begin + i);
+		}
+		objectCopies.push_back({ sizeof(ObjectData) * packed, sizeof(ObjectData) * range.begin, sizeof(ObjectData) * count });
+		//? Only the cull shaders read bounds
+		if (gpuCulling) {
+			for (uint i = 0; i < count; i++) {
+				bounds[packed + i] = MakeBounds(range.begin + i);
+			}
+			boundsCopies.push_back({ boundsOffset + sizeof(ObjectBounds) * packed, sizeof(ObjectBounds) * range.begin, sizeof(ObjectBounds) * count });
+		}
+		packed += count;
+	}
+	rowsUploaded += packed;
+	rangesUploaded += dirtyRanges.size();
+}
+
+void Scene::RecordUploads(VkCommandBuffer commandBuffer, uint frameIndex) {
+	if (objectCopies.empty()) {
+		return;
+	}
+
+	//? The last frame's draws and culling may still be reading the rows about to be overwritten
+	VkMemoryBarrier readBarrier {};
+	readBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readBarrier.srcAccessMask = 0;
+	readBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+	vkCmdCopyBuffer(commandBuffer, uploadBuffers[frameIndex], objectBuffer, objectCopies.size(), objectCopies.data());
+	if (!boundsCopies.empty()) {
+		vkCmdCopyBuffer(commandBuffer, uploadBuffers[frameIndex], boundsBuffer, boundsCopies.size(), boundsCopies.data());
+	}
+
+	VkMemoryBarrier writeBarrier {};
+	writeBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	writeBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	writeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &writeBarrier, 0, nullptr, 0, nullptr);
+}
+
+Scene::ObjectData Scene::MakeObjectData(uint row) const {
+	ObjectData data {};
+	data.model = entities.Model(row);
+	data.color = materialColors[entities.Materials()[row]];
+	return data;
+}
+
+Scene::ObjectBounds Scene::MakeBounds(uint row) const {
+	ObjectBounds bounds {};
+	bounds.sphere = entities.Bounds()[row];
+	bounds.mesh = entities.Meshes()[row];
+	bounds.scale = entities.Scales()[row];
+	bounds.flags = entities.EntityFlags()[row];
+	return bounds;
+}
+
+void Scene::ReadCullCounts(uint frameIndex) {
+	if (!countsPending[frameIndex]) {
+		return;
+	}
+	CullCounts counts;
+	memcpy(&counts, countMapped[frameIndex], sizeof(CullCounts));
+	countsPending[frameIndex] = false;
+
+	if (occlusionCulling) {
+		gpuTimer.Resolve(frameIndex);
+		if (gpuTimer.Valid(sceneScope) and gpuTimer.Valid(pyramidScope)) {
+			pyramidMs += gpuTimer.Milliseconds(pyramidScope);
+			pyramidTimed++;
+			if (baselineFrames[frameIndex]) {
+				baselineMs += gpuTimer.Milliseconds(sceneScope);
+				baselineTimed++;
+			} else {
+				occlusionMs += gpuTimer.Milliseconds(sceneScope);
+				occlusionTimed++;
+			}
+		}
+		if (!baselineFrames[frameIndex]) {
+			objectsOccluded += counts.occluded;
+			occlusionFrames++;
+		}
+		lateDraws += counts.lateDrawCount;
+	}
+	objectsFrustumCulled += counts.frustumCulled;
+	objectsDrawn += counts.drawCount + counts.lateDrawCount;
+	trianglesDrawn += counts.triangles;
+	trianglesFull += counts.trianglesFull;
+	for (uint i = 0; i < lodHistogram.size(); i++) {
+		lodHistogram[i] += counts.lodDraws[i];
+	}
+	frames++;
+}
+
+glm::mat4 Scene::ViewProjection() const {
+	return projection * view;
+}
+
+uint Scene::SelectLod(uint row) const {
+	const MeshLibrary::Mesh& mesh = meshes.Get(entities.Meshes()[row]);
+	glm::vec4 sphere = entities.Bounds()[row];
+	//? Distance to the nearest point of the bounding sphere, the worst case for the whole object
+	float distance = std::max(glm::length(glm::vec3(sphere) - cameraPosition) - sphere.w, nearPlane);
+	float scale = entities.Scales()[row];
+
+	for (uint i = mesh.lods.size() - 1; i > 0; i--) {
+		float pixels = mesh.lods[i].error * scale / distance * pixelsPerUnit;
+		if (pixels <= Settings::lodPixelError) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+void Scene::RecordCulling(VkCommandBuffer commandBuffer, uint frameIndex) {
+	auto start = std::chrono::steady_clock::now();
+	RecordUploads(commandBuffer, frameIndex);
+	if (!gpuCulling) {
+		recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return;
+	}
+
+	if (occlusionCulling) {
+		gpuTimer.Reset(commandBuffer, frameIndex);
+		gpuTimer.Begin(commandBuffer, frameIndex, sceneScope);
+	}
+
+	//? Without the count variant every record gets drawn, the ones past the count have to be empty
+	vkCmdFillBuffer(commandBuffer, countBuffers[frameIndex], 0, VK_WHOLE_SIZE, 0);
+	if (drawIndexedIndirectCount == nullptr) {
+		vkCmdFillBuffer(commandBuffer, drawBuffers[frameIndex], 0, VK_WHOLE_SIZE, 0);
+		if (occlusionCulling) {
+			vkCmdFillBuffer(commandBuffer, lateDrawBuffers[frameIndex], 0, VK_WHOLE_SIZE, 0);
+		}
+	}
+
+	//? Also makes the last frame's pyramid visible to the first phase
+	VkMemoryBarrier clearBarrier {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+	DispatchCulling(commandBuffer, frameIndex, 0);
+
+	countsPending[frameIndex] = true;
+	recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::RecordOcclusion(VkCommandBuffer commandBuffer, uint frameIndex) {
+	if (!occlusionCulling) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	//? The first phase read the pyramid this overwrites and the first draws read the counts the second phase adds to.
+	//? The render pass already made the depth readable
+	VkMemoryBarrier readBarrier {};
+	readBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readBarrier.srcAccessMask = 0;
+	readBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &readBarrier, 0, nullptr, 0, nullptr);
+
+	//? Its last barrier also makes the first phase's visibility readable
+	gpuTimer.Begin(commandBuffer, frameIndex, pyramidScope);
+	pyramid.Build(commandBuffer);
+	gpuTimer.End(commandBuffer, frameIndex, pyramidScope);
+
+	DispatchCulling(commandBuffer, frameIndex, 1);
+
+	recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::DispatchCulling(VkCommandBuffer commandBuffer, uint frameIndex, uint late) {
+	CullPhase phase {};
+	phase.late = late;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullLayout, 0, 1, &cullSets[frameIndex], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPhase), &phase);
+	vkCmdDispatch(commandBuffer, (entities.Size() + cullWorkgroupSize - 1) / cullWorkgroupSize, 1, 1);
+
+	//? The counts are also read by the host once the frame's fence has signaled
+	VkMemoryBarrier cullBarrier {};
+	cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cullBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	cullBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &cullBarrier, 0, nullptr, 0, nullptr);
+}
+
+void Scene::Draw(VkCommandBuffer commandBuffer, uint frameIndex, VkDescriptorSet frameSet, FrameArena& arena, FrameStats& stats) {
+	auto start = std::chrono::steady_clock::now();
+
+	if (gpuCulling) {
+		RecordDraws(commandBuffer, drawBuffers[frameIndex], countBuffers[frameIndex], offsetof(CullCounts, drawCount), frameSet, stats);
+	} else {
+		DrawQueue::Packet packet {};
+		packet.pipeline = pipeline;
+		packet.layout = pipelineLayout;
+		packet.sets[0] = frameSet;
+		packet.sets[1] = objectSet;
+		packet.setCount = 2;
+		packet.vertexBuffer = meshes.VertexBuffer();
+		packet.indexBuffer = meshes.IndexBuffer();
+
+		drawQueue.Begin(arena);
+		const uint* meshIds = entities.Meshes();
+		const glm::vec4* bounds = entities.Bounds();
+		const uint8* flags = entities.EntityFlags();
+		for (uint row : visibleRows) {
+			if (!(flags[row] & EntityStore::Visible)) {
+				continue;
+			}
+			const MeshLibrary::Mesh& mesh = meshes.Get(meshIds[row]);
+			const MeshLibrary::Lod& lod = mesh.lods[lods[row]];
+			packet.count = lod.indexCount;
+			packet.first = lod.indexOffset;
+			packet.vertexOffset = mesh.vertexOffset;
+			//? The first instance is the object's row, mesh.vert reads its data with it
+			packet.firstInstance = row;
+			//? Everything shares one pipeline, set pair and buffer pair, so only depth orders the draws
+			float depth = glm::length(glm::vec3(bounds[row]) - cameraPosition) / farPlane;
+			drawQueue.Add(DrawQueue::Key(0, 0, 0, 0, depth), packet);
+		}
+		drawQueue.Sort();
+		drawQueue.Record(commandBuffer, stats);
+	}
+
+	recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::DrawLate(VkCommandBuffer commandBuffer, uint frameIndex, VkDescriptorSet frameSet, FrameStats& stats) {
+	if (!occlusionCulling) {
+		return;
+	}
+	auto start = std::chrono::steady_clock::now();
+
+	RecordDraws(commandBuffer, lateDrawBuffers[frameIndex], countBuffers[frameIndex], offsetof(CullCounts, lateDrawCount), frameSet, stats);
+
+	recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Scene::EndFrame(VkCommandBuffer commandBuffer, uint frameIndex) {
+	if (occlusionCulling) {
+		gpuTimer.End(commandBuffer, frameIndex, sceneScope);
+	}
+}
+
+bool Scene::DrawsChange() const {
+	return !gpuCulling;
+}
+
+void Scene::BindDrawState(VkCommandBuffer commandBuffer, VkDescriptorSet frameSet, FrameStats& stats) {
+	FrameCapture::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	stats.pipelineBinds++;
+
+	VkDescriptorSet descriptorSets[] = { frameSet, objectSet };
+	FrameCapture::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+	stats.descriptorSetBinds++;
+
+	//? One pair of buffers for every mesh and level, draws only move their ranges
+	VkBuffer vertexBuffers[] = { meshes.VertexBuffer() };
+	VkDeviceSize offsets[] = { 0 };
+	FrameCapture::CmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+	FrameCapture::CmdBindIndexBuffer(commandBuffer, meshes.IndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	stats.vertexBufferBinds++;
+}
+
+void Scene::RecordDraws(VkCommandBuffer commandBuffer, VkBuffer drawBuffer, VkBuffer countBuffer, VkDeviceSize countOffset, VkDescriptorSet frameSet, FrameStats& stats) {
+	BindDrawState(commandBuffer, frameSet, stats);
+
+	uint stride = sizeof(VkDrawIndexedIndirectCommand);
+	if (drawIndexedIndirectCount != nullptr) {
+		FrameCapture::CmdDrawIndexedIndirectCount(drawIndexedIndirectCount, commandBuffer, drawBuffer, 0, countBuffer, countOffset, entities.Size(), stride);
+		stats.draws++;
+	} else if (context.multiDrawIndirect) {
+		FrameCapture::CmdDrawIndexedIndirect(commandBuffer, drawBuffer, 0, entities.Size(), stride);
+		stats.draws++;
+	} else {
+		//? Without multi draw every record needs its own call, still nothing per object on the CPU but the call
+		for (uint i = 0; i < entities.Size(); i++) {
+			FrameCapture::CmdDrawIndexedIndirect(commandBuffer, drawBuffer, i * stride, 1, stride);
+			stats.draws++;
+		}
+	}
+}
+
+const GpuTimer& Scene::Timer() const {
+	return gpuTimer;
+}
+
+void Scene::PrintStats() {
+	meshes.PrintStats();
+
+	double frameCount = double(std::max(frames, uint64(1)));
+	std::cout << "Scene:\n";
+	std::cout << "\tObjects: " << entities.Size() << ", pixel error threshold " << Settings::lodPixelError << "\n";
+	std::cout << "\tUploads per frame: " << rowsUploaded / double(std::max(updates, uint64(1))) << " rows in " << rangesUploaded / double(std::max(updates, uint64(1))) << " ranges, " << spinning.size() << " objects spinning\n";
+	if (!gpuCulling) {
+		std::cout << "\tCulling: CPU frustum over a " << Bvh::Width << " wide BVH, " << bvh.NodeCount() << " nodes, depth " << bvh.Depth() << ", SAH cost " << bvh.SahCost();
+		std::cout << ", levels picked on the CPU, one draw per object\n";
+		std::cout << "\tBVH refit: " << refitSeconds / frameCount * 1000000.0 << " us, frustum query: " << querySeconds / frameCount * 1000000.0 << " us per frame\n";
+	} else {
+		std::cout << "\tCulling: GPU frustum" << (occlusionCulling ? " and two phase occlusion" : "");
+		std::cout << (drawIndexedIndirectCount != nullptr ? ", indirect draw with count\n" : ", indirect draws padded with empty records\n");
+	}
+	std::cout << "\tObjects drawn per frame: " << objectsDrawn / frameCount << "\n";
+	std::cout << "\tOutside the frustum per frame: " << objectsFrustumCulled / frameCount << "\n";
+	if (occlusionCulling) {
+		std::cout << "\tOccluded per frame: " << (occlusionFrames > 0 ? double(objectsOccluded) / occlusionFrames : 0.0) << ", drawn by the second phase: " << lateDraws / frameCount << "\n";
+		if (pyramidTimed > 0) {
+			double building = pyramidMs / pyramidTimed;
+			std::cout << "\tDepth pyramid: " << building << " ms, " << pyramid.Levels() << " levels\n";
+			if (occlusionTimed > 0 and baselineTimed > 0) {
+				double occluding = occlusionMs / occlusionTimed;
+				double baseline = baselineMs / baselineTimed;
+				//? Baseline frames still build a pyramid for the next frame, without occlusion culling there'd be none
+				std::cout << "\tScene GPU time: " << occluding << " ms, " << baseline << " ms without the occlusion test (" << baselineTimed << " frames)\n";
+				std::cout << "\tGPU time saved: " << baseline - building - occluding << " ms per frame, pyramid included\n";
+			}
+		} else {
+			std::cout << "\tGPU timings: not supported on the graphics queue\n";
+		}
+	}
+	std::cout << "\tTriangles per frame: " << trianglesDrawn / frameCount << " with levels of detail, " << trianglesFull / frameCount << " without";
+	std::cout << " (" << (trianglesFull > 0 ? double(trianglesDrawn) / trianglesFull * 100.0 : 0.0) << "%)\n";
+	std::cout << "\tLevel usage:";
+	uint64 selections = std::max(objectsDrawn, uint64(1));
+	for (uint i = 0; i < lodHistogram.size(); i++) {
+		std::cout << " " << i << ": " << double(lodHistogram[i]) / selections * 100.0 << "%";
+	}
+	std::cout << "\n";
+	std::cout << "\tCPU recording: " << (updates > 0 ? recordSeconds / updates * 1000000.0 : 0.0) << " us per frame\n";
+	std::cout << std::endl;
+
+	if (!gpuCulling) {
+		drawQueue.PrintStats("Scene");
+	}
+}
@@ -0,0 +1,241 @@
+#include "ShaderReloader.hpp"
+#include <filesystem>
+#include <cstdlib>
+
+namespace {
+	const std::vector<std::string> shaderExtensions = { ".vert", ".frag", ".comp", ".glsl" };
+
+	bool IsInclude(const std::string& path) {
+		return std::filesystem::path(path).extension() == ".glsl";
+	}
+
+	//? Direct includes only, Dependents follows them through other includes
+	bool Includes(const std::string& path, const std::string& fileName) {
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.find("#include") != std::string::npos and line.find("\"" + fileName + "\"") != std::string::npos) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+void ShaderReloader::Init(const Context& context, const std::string& directory) {
+	this->context = context;
+	this->directory = directory;
+	watcher = std::thread(&ShaderReloader::WatchLoop, this);
+}
+
+void ShaderReloader::CleanUp() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (watcher.joinable()) {
+		watcher.join();
+	}
+	for (const Built& result : built) {
+		vkDestroyPipeline(context.device, result.pipeline, nullptr);
+	}
+	for (uint i = 0; i < retiredCount; i++) {
+		vkDestroyPipeline(context.device, retired[(retiredHead + i) % retired.size()].pipeline, nullptr);
+	}
+	built.clear();
+	retiredCount = 0;
+}
+
+void ShaderReloader::Register(const std::string& name, const std::vector<std::string>& sources, VkPipeline& pipeline, Builder build) {
+	std::lock_guard<std::mutex> lock(mutex);
+	watched.push_back({ name, sources, &pipeline, std::move(build) });
+	//? Reload keeps one finished pipeline per registered one, and Update swaps each in at most once
+	//? a frame, so these are as large as they get and Update never allocates
+	built.reserve(watched.size());
+	swapping.reserve(watched.size());
+	retired.resize(watched.size() * Settings::maxFramesInFlight);
+}
+
+bool ShaderReloader::Update(uint64 frameNumber) {
+	Clock::time_point start = Clock::now();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::swap(built, swapping);
+	}
+
+	//? Retired in frame order, so the ones done are at the head. Destroyed before retiring more,
+	//? then at most maxFramesInFlight frames of swaps are left in the ring
+	while (retiredCount > 0 and retired[retiredHead].frame <= frameNumber) {
+		vkDestroyPipeline(context.device, retired[retiredHead].pipeline, nullptr);
+		retiredHead = (retiredHead + 1) % retired.size();
+		retiredCount--;
+	}
+
+	//? Only the main thread writes watched, reading it here needs no lock
+	for (const Built& result : swapping) {
+		Watched& target = watched[result.watched];
+		//? Frames up to this one may have recorded the old pipeline, the last of them is
+		//? done once its slot comes around again
+		retired[(retiredHead + retiredCount) % retired.size()] = { *target.pipeline, frameNumber + Settings::maxFramesInFlight };
+		retiredCount++;
+		*target.pipeline = result.pipeline;
+		swaps++;
+		changeToSwapSeconds += std::chrono::duration<double>(start - result.changed).count();
+	}
+	bool changed = !swapping.empty();
+	swapping.clear();
+
+	longestUpdateMs = std::max(longestUpdateMs, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	return changed;
+}
+
+void ShaderReloader::PrintStats() {
+	std::cout << "Shader reload:\n";
+	std::cout << "\tWatching: " << directory << ", " << watched.size() << " pipelines\n";
+	std::cout << "\tCompiles: " << compiles << " (" << compileFailures << " failed)";
+	if (compiles > 0) {
+		std::cout << ", " << compileSeconds / compiles * 1000.0 << " ms average";
+	}
+	std::cout << "\n";
+	std::cout << "\tPipelines swapped in: " << swaps << " (" << buildFailures << " failed to build)";
+	if (swaps > 0) {
+		std::cout << ", " << buildSeconds / swaps * 1000.0 << " ms average build, " << changeToSwapSeconds / swaps * 1000.0 << " ms from change to swap";
+	}
+	std::cout << "\n";
+	std::cout << "\tLongest update on the frame loop: " << longestUpdateMs << " ms\n";
+	std::cout << std::endl;
+}
+
+void ShaderReloader::WatchLoop() {
+	std::map<std::string, int64> stamps = Scan();
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!wake.wait_for(lock, std::chrono::milliseconds(Settings::shaderPollMs), [this] { return stopping; })) {
+		lock.unlock();
+
+		std::map<std::string, int64> current = Scan();
+		std::vector<std::string> changed;
+		for (const auto& [path, stamp] : current) {
+			auto previous = stamps.find(path);
+			if (previous == stamps.end() or previous->second != stamp) {
+				changed.push_back(path);
+			}
+		}
+		stamps = std::move(current);
+		if (!changed.empty()) {
+			Reload(changed, Clock::now());
+		}
+
+		lock.lock();
+	}
+}
+
+std::map<std::string, int64> ShaderReloader::Scan() const {
+	//? Editors replace files while they save, anything that vanishes halfway is picked up next time
+	std::map<std::string, int64> stamps;
+	std::error_code error;
+	for (std::filesystem::recursive_directory_iterator entry(directory, error), end; !error and entry != end; entry.increment(error)) {
+		const std::filesystem::path& path = entry->path();
+		if (!entry->is_regular_file(error) or std::find(shaderExtensions.begin(), shaderExtensions.end(), path.extension().string()) == shaderExtensions.end()) {
+			continue;
+		}
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+		if (!error) {
+			stamps[path.generic_string()] = int64(time.time_since_epoch().count());
+		}
+		error.clear();
+	}
+	return stamps;
+}
+
+void ShaderReloader::Reload(const std::vector<std::string>& changed, Clock::time_point changedAt) {
+	std::set<std::string> sources;
+	for (const std::string& path : changed) {
+		if (IsInclude(path)) {
+			for (const std::string& dependent : Dependents(path)) {
+				sources.insert(dependent);
+			}
+		} else {
+			sources.insert(path);
+		}
+	}
+
+	//? The compile command writes its output to the console, errors included
+	std::set<std::string> compiled;
+	std::set<std::string> failed;
+	for (const std::string& source : sources) {
+		Clock::time_point start = Clock::now();
+		int result = std::system((Settings::shaderCompileCommand + " " + source + ".spv").c_str());
+		compileSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		compiles++;
+		if (result == 0) {
+			compiled.insert(source);
+		} else {
+			failed.insert(source);
+			compileFailures++;
+			std::cout << "Shader reload: " << source << " didn't compile, keeping the last good pipelines" << std::endl;
+		}
+	}
+
+	std::vector<Watched> targets;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		targets = watched;
+	}
+	for (uint i = 0; i < targets.size(); i++) {
+		bool stale = false;
+		bool broken = false;
+		for (const std::string& source : targets[i].sources) {
+			stale = stale or compiled.count(source) > 0;
+			broken = broken or failed.count(source) > 0;
+		}
+		if (!stale or broken) {
+			continue;
+		}
+
+		Clock::time_point start = Clock::now();
+		try {
+			VkPipeline pipeline = targets[i].build();
+			buildSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			{
+				//? A pipeline Update hasn't taken yet was never recorded, the newer one replaces it
+				std::lock_guard<std::mutex> lock(mutex);
+				auto pending = std::find_if(built.begin(), built.end(), [i](const Built& result) { return result.watched == i; });
+				if (pending != built.end()) {
+					vkDestroyPipeline(context.device, pending->pipeline, nullptr);
+					*pending = { i, pipeline, changedAt };
+				} else {
+					built.push_back({ i, pipeline, changedAt });
+				}
+			}
+			//? Printed here, the frame loop only swaps
+			std::cout << "Shader reload: " << targets[i].name << " rebuilt, swapped in at the next frame" << std::endl;
+		} catch (std::exception& e) {
+			buildFailures++;
+			std::cout << "Shader reload: " << targets[i].name << " didn't build, " << e.what() << std::endl;
+		}
+	}
+}
+
+std::vector<std::string> ShaderReloader::Dependents(const std::string& include) const {
+	std::map<std::string, int64> files = Scan();
+	std::vector<std::string> dependents;
+	std::set<std::string> seen = { include };
+	std::vector<std::string> pending = { include };
+	while (!pending.empty()) {
+		std::string fileName = std::filesystem::path(pending.back()).filename().string();
+		pending.pop_back();
+		for (const auto& [path, stamp] : files) {
+			if (seen.count(path) > 0 or !Includes(path, fileName)) {
+				continue;
+			}
+			seen.insert(path);
+			if (IsInclude(path)) {
+				pending.push_back(path);
+			} else {
+				dependents.push_back(path);
+			}
+		}
+	}
+	return dependents;
+}
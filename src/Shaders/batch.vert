@@ -0,0 +1,41 @@
+#version 450
+
+layout (push_constant) uniform Parameters {
+	float time;
+	uint scene;
+	uint instances;
+	float aspect;
+} parameters;
+
+layout (location = 0) out vec3 fragColor;
+
+const vec2 corners[3] = vec2[](
+	vec2(0.0, -0.5),
+	vec2(0.5, 0.5),
+	vec2(-0.5, 0.5)
+);
+
+float Hash(uint value) {
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return float(value) / 4294967295.0;
+}
+
+void main() {
+	//? Instances are laid out on a square grid, each spinning at its own rate
+	uint seed = parameters.scene * 7919u + uint(gl_InstanceIndex);
+	uint side = uint(ceil(sqrt(float(parameters.instances))));
+	vec2 cell = vec2(gl_InstanceIndex % side, gl_InstanceIndex / side);
+	vec2 center = (cell + 0.5) / float(side) * 2.0 - 1.0;
+
+	float angle = parameters.time * (0.5 + Hash(seed) * 2.0);
+	mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+	vec2 position = rotation * corners[gl_VertexIndex] / float(side);
+	position.x /= parameters.aspect;
+
+	gl_Position = vec4(center + position, 0.0, 1.0);
+	fragColor = vec3(Hash(seed + 1u), Hash(seed + 2u), Hash(seed + 3u));
+}
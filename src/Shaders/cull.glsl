@@ -0,0 +1,121 @@
+//? Shared by cull.comp and occlusion.comp, the structs mirror the ones in Scene.hpp
+
+//? cullWorkgroupSize in Scene.cpp has to match
+layout (local_size_x = 64) in;
+
+struct ObjectBounds {
+	vec4 sphere;
+	uint mesh;
+	float scale;
+	uint flags;
+	uint padding;
+};
+
+//? EntityStore::Visible
+const uint objectVisible = 1;
+
+struct MeshInfo {
+	int vertexOffset;
+	uint firstLod;
+	uint lodCount;
+	uint padding;
+};
+
+struct LodInfo {
+	uint indexOffset;
+	uint indexCount;
+	float error;
+	uint padding;
+};
+
+//? VkDrawIndexedIndirectCommand
+struct DrawCommand {
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Bounds {
+	ObjectBounds bounds[];
+};
+
+layout (std430, set = 0, binding = 1) readonly buffer Meshes {
+	MeshInfo meshes[];
+};
+
+layout (std430, set = 0, binding = 2) readonly buffer Lods {
+	LodInfo lods[];
+};
+
+layout (std430, set = 0, binding = 3) writeonly buffer Draws {
+	DrawCommand draws[];
+};
+
+layout (std430, set = 0, binding = 4) buffer Counts {
+	uint drawCount;
+	uint lateDrawCount;
+	uint triangles;
+	uint trianglesFull;
+	uint occluded;
+	uint frustumCulled;
+	uint padding0;
+	uint padding1;
+	uint lodDraws[8];
+} counts;
+
+layout (set = 0, binding = 5) uniform CullData {
+	mat4 view;
+	vec4 planes[6];
+	//? xyz is the camera position, w the pixels per unit at distance one
+	vec4 camera;
+	//? P00, P11 (positive), P22 and P32 of the projection
+	vec4 projection;
+	float pixelError;
+	float nearPlane;
+	uint objectCount;
+	//? Zero when the first phase should skip the pyramid
+	uint occlusion;
+	vec2 pyramidSize;
+	//? Fraction of the depth image the frame renders to
+	vec2 viewportScale;
+} cull;
+
+bool InFrustum(vec3 center, float radius) {
+	for (int i = 0; i < 6; i++) {
+		if (dot(cull.planes[i].xyz, center) + cull.planes[i].w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//? Same rule as Scene::SelectLod, the coarsest level under the pixel error.
+//? Also adds the draw to the stats
+DrawCommand MakeDraw(uint index, ObjectBounds object) {
+	MeshInfo mesh = meshes[object.mesh];
+	float distance = max(length(object.sphere.xyz - cull.camera.xyz) - object.sphere.w, cull.nearPlane);
+	uint lod = 0;
+	for (uint i = mesh.lodCount - 1; i > 0; i--) {
+		float pixels = lods[mesh.firstLod + i].error * object.scale / distance * cull.camera.w;
+		if (pixels <= cull.pixelError) {
+			lod = i;
+			break;
+		}
+	}
+	LodInfo level = lods[mesh.firstLod + lod];
+
+	atomicAdd(counts.triangles, level.indexCount / 3);
+	atomicAdd(counts.trianglesFull, lods[mesh.firstLod].indexCount / 3);
+	atomicAdd(counts.lodDraws[lod], 1);
+
+	DrawCommand draw;
+	draw.indexCount = level.indexCount;
+	draw.instanceCount = 1;
+	draw.firstIndex = level.indexOffset;
+	draw.vertexOffset = mesh.vertexOffset;
+	//? mesh.vert picks the object data with it
+	draw.firstInstance = index;
+	return draw;
+}
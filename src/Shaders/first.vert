@@ -14,10 +14,22 @@
 
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inColor;
+layout (location = 2) in vec2 inTexCoord;
 
 layout (location = 0) out vec3 fragColor;
+layout (location = 1) out vec2 fragTexCoord;
+
+layout (set = 0, binding = 0) uniform FrameData {
+	mat4 viewProjection;
+	vec4 time;
+} frame;
+
+layout (push_constant) uniform DrawData {
+	mat4 model;
+} draw;
 
 void main() {
-	gl_Position = vec4(inPosition, 1.0);
+	gl_Position = frame.viewProjection * draw.model * vec4(inPosition, 1.0);
 	fragColor = inColor;
+	fragTexCoord = inTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) out vec4 outColor;
+
+layout (location = 0) in vec3 fragColor;
+layout (location = 1) in vec2 fragTexCoord;
+
+//? BindlessTable::imageBinding, the draw picks its texture by slot
+layout (set = 1, binding = 1) uniform sampler2D textures[];
+
+layout (push_constant) uniform DrawData {
+	layout (offset = 64) uint texture;
+} draw;
+
+void main() {
+	outColor = vec4(fragColor, 1.0) * texture(textures[nonuniformEXT(draw.texture)], fragTexCoord);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 450
+
+layout (location = 0) in vec2 cell;
+layout (location = 1) flat in uvec2 glyph;
+layout (location = 2) in vec4 color;
+
+layout (location = 0) out vec4 outColor;
+
+//? Solid quads set every bit, so only glyphs ever discard
+void main() {
+	ivec2 texel = clamp(ivec2(cell), ivec2(0), ivec2(4, 6));
+	uint column = texel.x < 4 ? glyph.x >> (8 * texel.x) : glyph.y;
+	if (((column >> texel.y) & 1u) == 0u) {
+		discard;
+	}
+	outColor = color;
+}
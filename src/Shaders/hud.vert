@@ -0,0 +1,22 @@
+#version 450
+
+layout (push_constant) uniform Screen {
+	//? Two over the image size, pixels to clip space
+	vec2 pixelToClip;
+} screen;
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec2 cell;
+layout (location = 2) in uvec2 glyph;
+layout (location = 3) in vec4 color;
+
+layout (location = 0) out vec2 outCell;
+layout (location = 1) flat out uvec2 outGlyph;
+layout (location = 2) out vec4 outColor;
+
+void main() {
+	gl_Position = vec4(position * screen.pixelToClip - 1.0, 0.0, 1.0);
+	outCell = cell;
+	outGlyph = glyph;
+	outColor = color;
+}
@@ -0,0 +1,13 @@
+#version 450
+
+layout (location = 0) in vec3 fragNormal;
+layout (location = 1) in vec3 fragColor;
+
+layout (location = 0) out vec4 outColor;
+
+const vec3 lightDirection = normalize(vec3(0.4, 1.0, 0.3));
+
+void main() {
+	float diffuse = max(dot(normalize(fragNormal), lightDirection), 0.0);
+	outColor = vec4(fragColor * (0.15 + 0.85 * diffuse), 1.0);
+}
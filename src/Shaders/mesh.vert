@@ -0,0 +1,30 @@
+#version 450
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inNormal;
+
+layout (location = 0) out vec3 fragNormal;
+layout (location = 1) out vec3 fragColor;
+
+layout (set = 0, binding = 0) uniform FrameData {
+	mat4 viewProjection;
+	vec4 time;
+} frame;
+
+struct ObjectData {
+	mat4 model;
+	vec4 color;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer Objects {
+	ObjectData objects[];
+};
+
+void main() {
+	//? Scene draws pass the object index as the first instance
+	ObjectData object = objects[gl_InstanceIndex];
+	gl_Position = frame.viewProjection * object.model * vec4(inPosition, 1.0);
+	//? Scaling is uniform, so the model matrix transforms normals as well
+	fragNormal = mat3(object.model) * inNormal;
+	fragColor = object.color.rgb;
+}
@@ -0,0 +1,14 @@
+#version 450
+
+layout (location = 0) in vec4 inPosition;
+layout (location = 1) in vec4 inVelocity;
+
+layout (location = 0) out vec3 fragColor;
+
+void main() {
+	gl_Position = vec4(inPosition.xyz, 1.0);
+	gl_PointSize = 1.0;
+
+	float speed = clamp(length(inVelocity.xy), 0.0, 1.0);
+	fragColor = mix(vec3(0.02, 0.04, 0.1), vec3(0.1, 0.05, 0.01), speed);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+//? Shared by the post-processing passes, PostProcess::PassConstants has to match
+
+layout (push_constant) uniform Pass {
+	//? One over the sampled image's full size, and the largest coordinate inside its used extent
+	vec2 sourceTexel;
+	vec2 sourceMax;
+	vec2 bloomTexel;
+	vec2 bloomMax;
+	ivec2 destinationSize;
+	float deltaTime;
+	//? Downsample: 1 on the first level. Composite: which adapted slot this frame writes
+	uint mode;
+} pass;
+
+//? The scene for the first downsample and the composite, the bloom level below otherwise
+layout (set = 0, binding = 0) uniform sampler2D source;
+layout (set = 0, binding = 1, rgba16f) uniform image2D destination;
+
+layout (set = 0, binding = 2) buffer Exposure {
+	//? Fixed point sum of (log2(luminance) + logOffset) * logScale, cleared every frame
+	uint logSum;
+	uint samples;
+	//? Adapted average luminance, written by alternating frames
+	float adapted[2];
+} exposure;
+
+//? The first bloom level, only read by the composite
+layout (set = 0, binding = 3) uniform sampler2D bloom;
+
+const float logOffset = 16.0;
+const float logScale = 32.0;
+
+float Luminance(vec3 color) {
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
@@ -0,0 +1,845 @@
+#include "TextureManager.hpp"
+#include "FrameCapture.hpp"
+
+namespace {
+	const uint8 ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct Ktx2Header {
+		uint8 identifier[12];
+		uint32 vkFormat;
+		uint32 typeSize;
+		uint32 pixelWidth;
+		uint32 pixelHeight;
+		uint32 pixelDepth;
+		uint32 layerCount;
+		uint32 faceCount;
+		uint32 levelCount;
+		uint32 supercompressionScheme;
+		uint32 dfdByteOffset;
+		uint32 dfdByteLength;
+		uint32 kvdByteOffset;
+		uint32 kvdByteLength;
+		uint64 sgdByteOffset;
+		uint64 sgdByteLength;
+	};
+	static_assert(sizeof(Ktx2Header) == 80, "The KTX2 header is 80 bytes.");
+
+	struct Ktx2Level {
+		uint64 byteOffset;
+		uint64 byteLength;
+		uint64 uncompressedByteLength;
+	};
+
+	//? Region offsets must be a multiple of the texel block size and of 4
+	const VkDeviceSize stagingAlignment = 16;
+
+	void Expand565(uint16 color, uint8* rgba) {
+		rgba[0] = uint8(((color >> 11) & 31) * 255 / 31);
+		rgba[1] = uint8(((color >> 5) & 63) * 255 / 63);
+		rgba[2] = uint8((color & 31) * 255 / 31);
+		rgba[3] = 255;
+	}
+
+	//? BC1 colors, also the color half of BC2 and BC3, which are always in four color mode
+	void DecodeColorBlock(const uint8* block, uint8* pixels, bool threeColorMode, bool punchThrough) {
+		uint16 color0 = uint16(block[0] | block[1] << 8);
+		uint16 color1 = uint16(block[2] | block[3] << 8);
+
+		uint8 palette[4][4];
+		Expand565(color0, palette[0]);
+		Expand565(color1, palette[1]);
+		for (uint c = 0; c < 4; c++) {
+			if (color0 > color1 or !threeColorMode) {
+				palette[2][c] = uint8((2 * palette[0][c] + palette[1][c]) / 3);
+				palette[3][c] = uint8((palette[0][c] + 2 * palette[1][c]) / 3);
+			} else {
+				palette[2][c] = uint8((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		if (threeColorMode and color0 <= color1 and !punchThrough) {
+			palette[3][3] = 255;
+		}
+
+		uint32 indices = uint32(block[4]) | uint32(block[5]) << 8 | uint32(block[6]) << 16 | uint32(block[7]) << 24;
+		for (uint i = 0; i < 16; i++) {
+			memcpy(pixels + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+		}
+	}
+
+	void DecodeAlphaBlock(const uint8* block, uint8* pixels) {
+		uint8 palette[8];
+		palette[0] = block[0];
+		palette[1] = block[1];
+		if (palette[0] > palette[1]) {
+			for (uint i = 1; i < 7; i++) {
+				palette[i + 1] = uint8(((7 - i) * palette[0] + i * palette[1]) / 7);
+			}
+		} else {
+			for (uint i = 1; i < 5; i++) {
+				palette[i + 1] = uint8(((5 - i) * palette[0] + i * palette[1]) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64 indices = 0;
+		for (uint i = 0; i < 6; i++) {
+			indices |= uint64(block[2 + i]) << (8 * i);
+		}
+		for (uint i = 0; i < 16; i++) {
+			pixels[i * 4 + 3] = palette[(indices >> (3 * i)) & 7];
+		}
+	}
+}
+
+void TextureManager::Init(const Context& context, VkDeviceSize budget, BindlessTable* bindless) {
+	this->context = context;
+	this->budget = budget;
+	this->bindless = bindless;
+
+	VkSamplerCreateInfo samplerInfo {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+	if (vkCreateSampler(context.device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a texture sampler.");
+	}
+	FrameCapture::AddSampler(sampler, samplerInfo);
+
+	Source white {};
+	white.format = VK_FORMAT_R8G8B8A8_UNORM;
+	white.extent = { 1, 1 };
+	white.levels.push_back(std::string(4, char(255)));
+	Upload(white, fallbackImage, fallbackMemory);
+	fallbackView = context.CreateImageView(fallbackImage, white.format, VK_IMAGE_ASPECT_COLOR_BIT);
+	if (bindless != nullptr) {
+		fallbackBindlessIndex = bindless->AddImage(fallbackView, sampler);
+	}
+
+	VkCommandPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = context.graphicsFamily;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &uploadPool) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't create a command pool.");
+	}
+
+	//? Blits for generated mip chains need the graphics queue, so uploads go there as well
+	uploadSlots.resize(Settings::textureUploadSlots);
+	for (UploadSlot& slot : uploadSlots) {
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = uploadPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(context.device, &allocInfo, &slot.commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't allocate command buffers.");
+		}
+
+		VkFenceCreateInfo fenceInfo {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(context.device, &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a fence.");
+		}
+	}
+	loader = std::thread(&TextureManager::LoadLoop, this);
+
+	if (context.memoryTracker != nullptr) {
+		//? Streamed textures are the first thing to give up memory
+		pressureHandler = context.memoryTracker->AddPressureHandler(0, [this](uint heap, VkDeviceSize needed) -> VkDeviceSize {
+			if (!this->context.memoryTracker->DeviceLocal(heap)) {
+				return 0;
+			}
+			return Release(needed);
+		});
+	}
+}
+
+void TextureManager::CleanUp() {
+	if (context.memoryTracker != nullptr) {
+		context.memoryTracker->RemovePressureHandler(pressureHandler);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (loader.joinable()) {
+		loader.join();
+	}
+	requests.clear();
+	loaded.clear();
+	ready.clear();
+
+	for (UploadSlot& slot : uploadSlots) {
+		if (slot.busy) {
+			vkWaitForFences(context.device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+		}
+		vkDestroyFence(context.device, slot.fence, nullptr);
+		if (slot.stagingBuffer != VK_NULL_HANDLE) {
+			vkUnmapMemory(context.device, slot.stagingMemory);
+			context.DestroyBuffer(slot.stagingBuffer, slot.stagingMemory);
+		}
+	}
+	uploadSlots.clear();
+	vkDestroyCommandPool(context.device, uploadPool, nullptr);
+
+	for (uint i = 0; i < textures.size(); i++) {
+		if (textures[i].image != VK_NULL_HANDLE) {
+			Evict(i);
+		}
+	}
+	textures.clear();
+	vkDestroyImageView(context.device, fallbackView, nullptr);
+	context.DestroyImage(fallbackImage, fallbackMemory);
+	vkDestroySampler(context.device, sampler, nullptr);
+}
+
+uint TextureManager::Load(const std::string& path) {
+	Texture texture {};
+	texture.name = path;
+	texture.path = path;
+	return Register(std::move(texture));
+}
+
+uint TextureManager::Create(const std::string& name, std::vector<uint8> pixels, VkExtent2D extent, bool srgb) {
+	if (pixels.size() != size_t(extent.width) * extent.height * 4) {
+		throw std::runtime_error("Texture " + name + " doesn't have width * height RGBA8 pixels.");
+	}
+	Texture texture {};
+	texture.name = name;
+	texture.pixels = std::make_shared<const std::vector<uint8>>(std::move(pixels));
+	texture.extent = extent;
+	texture.srgb = srgb;
+	return Register(std::move(texture));
+}
+
+uint TextureManager::Register(Texture texture) {
+	uint index = textures.size();
+	if (bindless != nullptr) {
+		texture.bindlessIndex = bindless->AddImage(fallbackView, sampler);
+	}
+	texture.lastUsed = currentFrame;
+	textures.push_back(std::move(texture));
+	Request(index);
+	return index;
+}
+
+void TextureManager::BeginFrame(uint64 frameNumber) {
+	currentFrame = frameNumber;
+
+	//? Back to full quality once the pressure is gone
+	if (downgradeLevels > 0 and context.memoryTracker != nullptr) {
+		bool relaxed = true;
+		context.memoryTracker->HeapStatistics(heapStats);
+		for (const MemoryTracker::HeapStats& heap : heapStats) {
+			if (heap.deviceLocal and heap.usage > heap.budget / 2) {
+				relaxed = false;
+			}
+		}
+		if (relaxed) {
+			downgradeLevels--;
+		}
+	}
+
+	FinishUploads();
+	StartUploads();
+}
+
+void TextureManager::Use(uint texture) {
+	textures[texture].lastUsed = currentFrame;
+	if (textures[texture].image == VK_NULL_HANDLE and !textures[texture].loading and !textures[texture].failed) {
+		Request(texture);
+	}
+}
+
+bool TextureManager::Resident(uint texture) const {
+	return textures[texture].image != VK_NULL_HANDLE and !textures[texture].loading;
+}
+
+VkImageView TextureManager::View(uint texture) const {
+	return Resident(texture) ? textures[texture].view : fallbackView;
+}
+
+VkSampler TextureManager::Sampler() const {
+	return sampler;
+}
+
+uint TextureManager::BindlessIndex(uint texture) const {
+	return Resident(texture) ? textures[texture].bindlessIndex : fallbackBindlessIndex;
+}
+
+VkDeviceSize TextureManager::ResidentBytes() const {
+	return residentBytes;
+}
+
+void TextureManager::Request(uint index) {
+	Texture& texture = textures[index];
+	//? Known from an earlier load, saves reading the source just to find out it won't fit
+	if (texture.footprint > 0 and !MakeRoom(texture.footprint, index)) {
+		budgetMisses++;
+		return;
+	}
+
+	texture.loading = true;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.push_back({ index, texture.path, texture.pixels, texture.extent, texture.srgb });
+	}
+	wake.notify_one();
+}
+
+void TextureManager::LoadLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wake.wait(lock, [this] { return stopping or !requests.empty(); });
+		if (stopping) {
+			return;
+		}
+		LoadRequest request = std::move(requests.front());
+		requests.pop_front();
+
+		lock.unlock();
+		Loaded result = Read(request);
+		lock.lock();
+		loaded.push_back(std::move(result));
+	}
+}
+
+//? Loader thread, only reads the request and what's fixed after Init
+TextureManager::Loaded TextureManager::Read(const LoadRequest& request) const {
+	Loaded result {};
+	result.texture = request.texture;
+	try {
+		Source source {};
+		if (request.path.empty()) {
+			source.format = request.srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+			source.extent = request.extent;
+			source.levels.push_back(std::string(request.pixels->begin(), request.pixels->end()));
+			source.generateMips = true;
+		} else {
+			source = ReadKtx2(request.path);
+		}
+		result.source = PrepareSource(std::move(source), result.decoded);
+	} catch (std::exception& e) {
+		result.error = e.what();
+	}
+	return result;
+}
+
+void TextureManager::StartUploads() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!loaded.empty()) {
+			ready.push_back(std::move(loaded.front()));
+			loaded.pop_front();
+		}
+	}
+
+	//? A source that doesn't fit leaves its slot free for the next one
+	for (UploadSlot& slot : uploadSlots) {
+		while (!slot.busy and !ready.empty()) {
+			Loaded result = std::move(ready.front());
+			ready.pop_front();
+			StartUpload(slot, result);
+		}
+	}
+}
+
+void TextureManager::StartUpload(UploadSlot& slot, Loaded& result) {
+	Texture& texture = textures[result.texture];
+	//? A broken source keeps the fallback, the app is already running by now
+	if (!result.error.empty()) {
+		std::cout << "Texture " << texture.name << " couldn't be loaded, " << result.error << std::endl;
+		loadFailures++;
+		texture.loading = false;
+		texture.failed = true;
+		return;
+	}
+	if (result.decoded) {
+		cpuDecodes++;
+	}
+
+	Source& source = result.source;
+	texture.extent = source.extent;
+
+	uint skipLevels = std::min<uint>(downgradeLevels, source.levels.size() - 1);
+	if (skipLevels > 0) {
+		source.levels.erase(source.levels.begin(), source.levels.begin() + skipLevels);
+		source.extent = { std::max(source.extent.width >> skipLevels, 1u), std::max(source.extent.height >> skipLevels, 1u) };
+		downgradedLoads++;
+	}
+
+	FormatInfo info;
+	GetFormatInfo(source.format, info);
+	uint mipLevels = source.levels.size();
+	if (source.generateMips) {
+		mipLevels = uint(std::floor(std::log2(std::max(source.extent.width, source.extent.height)))) + 1;
+	}
+
+	VkDeviceSize estimate = 0;
+	VkDeviceSize uncompressed = 0;
+	FormatInfo rgba8 = { 4, 1 };
+	for (uint level = 0; level < mipLevels; level++) {
+		estimate += LevelSize(info, source.extent, level);
+		uncompressed += LevelSize(rgba8, source.extent, level);
+	}
+
+	texture.footprint = estimate;
+	if (!MakeRoom(estimate, result.texture)) {
+		budgetMisses++;
+		texture.loading = false;
+		return;
+	}
+
+	texture.mipLevels = CreateImage(source, texture.image, texture.memory);
+	std::vector<VkDeviceSize> offsets;
+	VkDeviceSize stagingSize = StagingOffsets(source, offsets);
+	if (stagingSize > slot.stagingSize) {
+		if (slot.stagingBuffer != VK_NULL_HANDLE) {
+			vkUnmapMemory(context.device, slot.stagingMemory);
+			context.DestroyBuffer(slot.stagingBuffer, slot.stagingMemory);
+		}
+		context.CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, slot.stagingBuffer, slot.stagingMemory);
+		vkMapMemory(context.device, slot.stagingMemory, 0, stagingSize, 0, reinterpret_cast<void**>(&slot.mapped));
+		slot.stagingSize = stagingSize;
+	}
+	for (uint level = 0; level < source.levels.size(); level++) {
+		memcpy(slot.mapped + offsets[level], source.levels[level].data(), source.levels[level].size());
+	}
+
+	vkResetCommandBuffer(slot.commandBuffer, 0);
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+	RecordUpload(slot.commandBuffer, source, texture.image, texture.mipLevels, slot.stagingBuffer, offsets);
+	if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't record a command buffer.");
+	}
+
+	VkSubmitInfo submitInfo {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &slot.commandBuffer;
+	vkResetFences(context.device, 1, &slot.fence);
+	if (vkQueueSubmit(context.graphicsQueue, 1, &submitInfo, slot.fence) != VK_SUCCESS) {
+		throw std::runtime_error("Couldn't submit a texture upload.");
+	}
+	slot.texture = result.texture;
+	slot.busy = true;
+
+	texture.format = source.format;
+	texture.view = context.CreateImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(context.device, texture.image, &requirements);
+	texture.bytes = requirements.size;
+	texture.uncompressedBytes = uncompressed;
+	residentBytes += texture.bytes;
+	peakResidentBytes = std::max(peakResidentBytes, residentBytes);
+}
+
+void TextureManager::FinishUploads() {
+	for (UploadSlot& slot : uploadSlots) {
+		if (!slot.busy or vkGetFenceStatus(context.device, slot.fence) != VK_SUCCESS) {
+			continue;
+		}
+		slot.busy = false;
+		Texture& texture = textures[slot.texture];
+		texture.loading = false;
+		uploads++;
+		if (bindless != nullptr) {
+			bindless->SetImage(texture.bindlessIndex, texture.view, sampler);
+		}
+	}
+}
+
+void TextureManager::Evict(uint index) {
+	Texture& texture = textures[index];
+	if (bindless != nullptr) {
+		bindless->SetImage(texture.bindlessIndex, fallbackView, sampler);
+	}
+	vkDestroyImageView(context.device, texture.view, nullptr);
+	context.DestroyImage(texture.image, texture.memory);
+	texture.view = VK_NULL_HANDLE;
+	texture.image = VK_NULL_HANDLE;
+	texture.memory = VK_NULL_HANDLE;
+	residentBytes -= texture.bytes;
+	texture.bytes = 0;
+}
+
+bool TextureManager::MakeRoom(VkDeviceSize bytes, uint keep) {
+	while (residentBytes + bytes > budget) {
+		uint victim = EvictionCandidate(keep);
+		if (victim == keep) {
+			return false;
+		}
+		Evict(victim);
+		evictions++;
+	}
+	return true;
+}
+
+VkDeviceSize TextureManager::Release(VkDeviceSize bytes) {
+	VkDeviceSize released = 0;
+	while (released < bytes) {
+		uint victim = EvictionCandidate(textures.size());
+		if (victim == textures.size()) {
+			break;
+		}
+		released += textures[victim].bytes;
+		Evict(victim);
+		pressureEvictions++;
+	}
+	if (released < bytes) {
+		downgradeLevels++;
+	}
+	return released;
+}
+
+uint TextureManager::EvictionCandidate(uint keep) const {
+	uint victim = keep;
+	for (uint i = 0; i < textures.size(); i++) {
+		const Texture& texture = textures[i];
+		bool retired = texture.lastUsed + Settings::maxFramesInFlight <= currentFrame;
+		if (i == keep or texture.image == VK_NULL_HANDLE or texture.loading or !retired) {
+			continue;
+		}
+		if (victim == keep or texture.lastUsed < textures[victim].lastUsed) {
+			victim = i;
+		}
+	}
+	return victim;
+}
+
+TextureManager::Source TextureManager::ReadKtx2(const std::string& path) const {
+	std::string file = Context::ReadFile(path);
+
+	Ktx2Header header;
+	if (file.size() < sizeof(Ktx2Header)) {
+		throw std::runtime_error("Couldn't read a KTX2 header from " + path + ".");
+	}
+	memcpy(&header, file.data(), sizeof(Ktx2Header));
+	if (memcmp(header.identifier, ktx2Identifier, sizeof(ktx2Identifier)) != 0) {
+		throw std::runtime_error(path + " isn't a KTX2 file.");
+	}
+	if (header.pixelDepth > 1 or header.layerCount > 1 or header.faceCount != 1) {
+		throw std::runtime_error(path + " isn't a single 2D texture.");
+	}
+	if (header.supercompressionScheme != 0) {
+		throw std::runtime_error(path + " is supercompressed, which isn't supported.");
+	}
+
+	Source source {};
+	source.format = VkFormat(header.vkFormat);
+	source.extent = { header.pixelWidth, header.pixelHeight };
+	//? A level count of 0 asks the loader to generate the chain
+	source.generateMips = header.levelCount == 0;
+	uint levelCount = std::max(header.levelCount, 1u);
+
+	FormatInfo info;
+	if (!GetFormatInfo(source.format, info)) {
+		throw std::runtime_error(path + " uses an unsupported format.");
+	}
+	if (sizeof(Ktx2Header) + levelCount * sizeof(Ktx2Level) > file.size()) {
+		throw std::runtime_error(path + " is truncated.");
+	}
+
+	for (uint level = 0; level < levelCount; level++) {
+		Ktx2Level index;
+		memcpy(&index, file.data() + sizeof(Ktx2Header) + level * sizeof(Ktx2Level), sizeof(Ktx2Level));
+		VkDeviceSize expected = LevelSize(info, source.extent, level);
+		if (index.byteLength < expected or index.byteOffset + index.byteLength > file.size()) {
+			throw std::runtime_error(path + " has a corrupt mip level.");
+		}
+		source.levels.push_back(file.substr(index.byteOffset, expected));
+	}
+	return source;
+}
+
+TextureManager::Source TextureManager::PrepareSource(Source source, bool& decoded) const {
+	if (FormatSupported(source.format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+		//? Blitting needs the format to be a linear filtered blit source and destination, block compressed formats never are
+		VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		if (source.generateMips and !FormatSupported(source.format, blitFeatures)) {
+			source.generateMips = false;
+		}
+		return source;
+	}
+
+	//? Devices without BC support (most mobile GPUs) get the data decoded to RGBA8
+	bool srgb = source.format == VK_FORMAT_BC1_RGB_SRGB_BLOCK or source.format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+		or source.format == VK_FORMAT_BC2_SRGB_BLOCK or source.format == VK_FORMAT_BC3_SRGB_BLOCK;
+	for (uint level = 0; level < source.levels.size(); level++) {
+		VkExtent2D extent = { std::max(source.extent.width >> level, 1u), std::max(source.extent.height >> level, 1u) };
+		source.levels[level] = DecodeBc(source.format, source.levels[level], extent);
+	}
+	source.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+	decoded = true;
+	return PrepareSource(std::move(source), decoded);
+}
+
+bool TextureManager::FormatSupported(VkFormat format, VkFormatFeatureFlags features) const {
+	VkFormatProperties properties;
+	vkGetPhysicalDeviceFormatProperties(context.physicalDevice, format, &properties);
+	return (properties.optimalTilingFeatures & features) == features;
+}
+
+uint TextureManager::Upload(const Source& source, VkImage& image, VkDeviceMemory& memory) {
+	uint mipLevels = CreateImage(source, image, memory);
+	std::vector<VkDeviceSize> offsets;
+	VkDeviceSize stagingSize = StagingOffsets(source, offsets);
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	context.CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
+
+	uint8* mapped;
+	vkMapMemory(context.device, stagingMemory, 0, stagingSize, 0, reinterpret_cast<void**>(&mapped));
+	for (uint level = 0; level < source.levels.size(); level++) {
+		memcpy(mapped + offsets[level], source.levels[level].data(), source.levels[level].size());
+	}
+	vkUnmapMemory(context.device, stagingMemory);
+
+	context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+		RecordUpload(commandBuffer, source, image, mipLevels, stagingBuffer, offsets);
+	});
+
+	context.DestroyBuffer(stagingBuffer, stagingMemory);
+	return mipLevels;
+}
+
+uint TextureManager::CreateImage(const Source& source, VkImage& image, VkDeviceMemory& memory) {
+	uint mipLevels = source.levels.size();
+	if (source.generateMips) {
+		mipLevels = uint(std::floor(std::log2(std::max(source.extent.width, source.extent.height)))) + 1;
+	}
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (mipLevels > source.levels.size()) {
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
+	context.CreateImage(source.extent, mipLevels, source.format, usage, image, memory);
+	return mipLevels;
+}
+
+VkDeviceSize TextureManager::StagingOffsets(const Source& source, std::vector<VkDeviceSize>& offsets) {
+	VkDeviceSize stagingSize = 0;
+	for (const std::string& level : source.levels) {
+		stagingSize = (stagingSize + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+		offsets.push_back(stagingSize);
+		stagingSize += level.size();
+	}
+	return stagingSize;
+}
+
+void TextureManager::RecordUpload(VkCommandBuffer commandBuffer, const Source& source, VkImage image, uint mipLevels, VkBuffer stagingBuffer, const std::vector<VkDeviceSize>& offsets) {
+	VkImageMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	std::vector<VkBufferImageCopy> regions(source.levels.size());
+	for (uint level = 0; level < regions.size(); level++) {
+		regions[level].bufferOffset = offsets[level];
+		regions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[level].imageSubresource.mipLevel = level;
+		regions[level].imageSubresource.baseArrayLayer = 0;
+		regions[level].imageSubresource.layerCount = 1;
+		regions[level].imageExtent = { std::max(source.extent.width >> level, 1u), std::max(source.extent.height >> level, 1u), 1 };
+	}
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
+
+	if (mipLevels > source.levels.size()) {
+		GenerateMips(commandBuffer, image, source.extent, mipLevels);
+		return;
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void TextureManager::GenerateMips(VkCommandBuffer commandBuffer, VkImage image, VkExtent2D extent, uint mipLevels) {
+	VkImageMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	int32 width = extent.width;
+	int32 height = extent.height;
+	//? Each level is blitted from the one above it, which is then done and handed to the shaders
+	for (uint level = 1; level < mipLevels; level++) {
+		barrier.subresourceRange.baseMipLevel = level - 1;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		int32 nextWidth = std::max(width / 2, 1);
+		int32 nextHeight = std::max(height / 2, 1);
+
+		VkImageBlit blit {};
+		blit.srcOffsets[0] = { 0, 0, 0 };
+		blit.srcOffsets[1] = { width, height, 1 };
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.baseArrayLayer = 0;
+		blit.srcSubresource.layerCount = 1;
+		blit.dstOffsets[0] = { 0, 0, 0 };
+		blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.baseArrayLayer = 0;
+		blit.dstSubresource.layerCount = 1;
+		vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	gpuMipChains++;
+}
+
+void TextureManager::PrintStats() {
+	uint resident = 0;
+	VkDeviceSize uncompressed = 0;
+	for (const Texture& texture : textures) {
+		if (texture.image != VK_NULL_HANDLE) {
+			resident++;
+			uncompressed += texture.uncompressedBytes;
+		}
+	}
+
+	std::cout << "Textures:\n";
+	std::cout << "\tResident: " << resident << " of " << textures.size() << ", " << residentBytes / 1024 << " KiB (peak " << peakResidentBytes / 1024 << " KiB, budget " << budget / 1024 << " KiB)\n";
+	std::cout << "\tAs RGBA8: " << uncompressed / 1024 << " KiB";
+	if (uncompressed > 0) {
+		std::cout << ", " << (1.0 - double(residentBytes) / double(uncompressed)) * 100.0 << "% saved";
+	}
+	std::cout << "\n";
+	std::cout << "\tUploads: " << uploads << ", evictions: " << evictions << ", over budget: " << budgetMisses << ", failed to load: " << loadFailures << "\n";
+	std::cout << "\tUnder memory pressure: " << pressureEvictions << " evictions, " << downgradedLoads << " downgraded loads\n";
+	std::cout << "\tMip chains blitted: " << gpuMipChains << ", decoded on the CPU: " << cpuDecodes << "\n";
+	std::cout << std::endl;
+}
+
+bool TextureManager::GetFormatInfo(VkFormat format, FormatInfo& info) {
+	switch (format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			info = { 8, 4 };
+			return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			info = { 16, 4 };
+			return true;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			info = { 4, 1 };
+			return true;
+		default:
+			return false;
+	}
+}
+
+VkDeviceSize TextureManager::LevelSize(const FormatInfo& info, VkExtent2D extent, uint level) {
+	VkDeviceSize width = std::max(extent.width >> level, 1u);
+	VkDeviceSize height = std::max(extent.height >> level, 1u);
+	VkDeviceSize blocksWide = (width + info.blockSize - 1) / info.blockSize;
+	VkDeviceSize blocksHigh = (height + info.blockSize - 1) / info.blockSize;
+	return blocksWide * blocksHigh * info.blockBytes;
+}
+
+std::string TextureManager::DecodeBc(VkFormat format, const std::string& data, VkExtent2D extent) {
+	bool bc1 = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK or format == VK_FORMAT_BC1_RGB_SRGB_BLOCK
+		or format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK or format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	bool bc3 = format == VK_FORMAT_BC3_UNORM_BLOCK or format == VK_FORMAT_BC3_SRGB_BLOCK;
+	if (!bc1 and !bc3) {
+		throw std::runtime_error("Couldn't find a supported format: only BC1 and BC3 can be decoded on the CPU.");
+	}
+	bool punchThrough = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK or format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	uint blockBytes = bc1 ? 8 : 16;
+
+	std::string pixels(size_t(extent.width) * extent.height * 4, '\0');
+	uint blocksWide = (extent.width + 3) / 4;
+	uint blocksHigh = (extent.height + 3) / 4;
+	uint8 block[16 * 4];
+	for (uint by = 0; by < blocksHigh; by++) {
+		for (uint bx = 0; bx < blocksWide; bx++) {
+			const uint8* encoded = reinterpret_cast<const uint8*>(data.data()) + (size_t(by) * blocksWide + bx) * blockBytes;
+			if (bc1) {
+				DecodeColorBlock(encoded, block, true, punchThrough);
+			} else {
+				DecodeColorBlock(encoded + 8, block, false, false);
+				DecodeAlphaBlock(encoded, block);
+			}
+
+			for (uint y = 0; y < 4 and by * 4 + y < extent.height; y++) {
+				for (uint x = 0; x < 4 and bx * 4 + x < extent.width; x++) {
+					size_t offset = ((size_t(by) * 4 + y) * extent.width + bx * 4 + x) * 4;
+					memcpy(&pixels[offset], block + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+	return pixels;
+}
@@ -0,0 +1,80 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(uint threadCount) {
+	threadCount = std::max(threadCount, 1u);
+	jobs.resize(std::max(threadCount * 4, 16u));
+	for (uint i = 0; i < threadCount; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (jobCount == jobs.size()) {
+			//? Unrolled into the new ring so the oldest job sits at the start again
+			std::vector<std::function<void()>> grown(jobs.size() * 2);
+			for (uint i = 0; i < jobCount; i++) {
+				grown[i] = std::move(jobs[(firstJob + i) % jobs.size()]);
+			}
+			jobs = std::move(grown);
+			firstJob = 0;
+		}
+		jobs[(firstJob + jobCount) % jobs.size()] = std::move(job);
+		jobCount++;
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	jobsDone.wait(lock, [this] { return jobCount == 0 and activeJobs == 0; });
+}
+
+uint ThreadPool::ThreadCount() const {
+	return uint(workers.size());
+}
+
+uint ThreadPool::PendingJobs() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobCount + activeJobs;
+}
+
+void ThreadPool::WorkerLoop() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this] { return stopping or jobCount > 0; });
+			if (jobCount == 0) {
+				return;
+			}
+			job = std::move(jobs[firstJob]);
+			jobs[firstJob] = nullptr;
+			firstJob = (firstJob + 1) % jobs.size();
+			jobCount--;
+			activeJobs++;
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			activeJobs--;
+			if (jobCount == 0 and activeJobs == 0) {
+				jobsDone.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,807 @@
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "MemoryTracker.hpp"
+#include "Hud.hpp"
+#include <filesystem>
+
+//? Microbenchmarks of the pieces every subsystem is built from: memory, uploads, shader modules,
+//? pipelines, command recording and queue round trips. Headless, meant for a software ICD so runs
+//? compare across machines, `make bench` points the loader at lavapipe. Results go to a JSON file.
+//? Usage: bench [output]
+namespace {
+	const std::string defaultOutput = "bench.json";
+	const uint warmupSamples = 4;
+
+	//? Each sample times a batch, too short alone for the clock
+	const uint memoryTypeSamples = 200;
+	const uint memoryTypeBatch = 1000;
+	const uint allocationSamples = 200;
+	const std::vector<VkDeviceSize> allocationSizes = { 64ull << 10, 4ull << 20 };
+	const uint uploadSamples = 20;
+	const VkDeviceSize uploadSize = 16ull << 20;
+	const uint shaderSamples = 20;
+	const uint pipelineSamples = 50;
+	const uint recordingSamples = 100;
+	const uint drawsPerRecording = 1000;
+	const VkExtent2D attachmentExtent = { 256, 256 };
+	const VkFormat attachmentFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	const uint roundTripSamples = 500;
+	const uint submitSamples = 100;
+	const uint submitBatch = 64;
+
+	struct Result {
+		std::string name;
+		//? Each sample, in microseconds per operation
+		std::vector<double> us;
+		//? Optional, left empty when the operation has no rate worth reporting
+		double throughput = 0.0;
+		std::string throughputUnit;
+	};
+
+	struct Times {
+		double min = 0.0;
+		double median = 0.0;
+		double mean = 0.0;
+		double p95 = 0.0;
+	};
+
+	Times Summarize(std::vector<double> us) {
+		Times times;
+		if (us.empty()) {
+			return times;
+		}
+		std::sort(us.begin(), us.end());
+		times.min = us.front();
+		times.median = us[us.size() / 2];
+		times.p95 = us[std::min(us.size() - 1, us.size() * 95 / 100)];
+		for (double value : us) {
+			times.mean += value;
+		}
+		times.mean /= double(us.size());
+		return times;
+	}
+
+	//? Runs body warmupSamples + samples times, each run counting as operations operations
+	template<typename F>
+	std::vector<double> Measure(uint samples, uint operations, F body) {
+		std::vector<double> us;
+		us.reserve(samples);
+		for (uint i = 0; i < warmupSamples + samples; i++) {
+			auto start = std::chrono::steady_clock::now();
+			body();
+			double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			if (i >= warmupSamples) {
+				us.push_back(elapsed / operations);
+			}
+		}
+		return us;
+	}
+
+	std::string Escape(const std::string& text) {
+		std::string escaped;
+		for (char character : text) {
+			if (character == '"' or character == '\\') {
+				escaped += '\\';
+			}
+			escaped += character;
+		}
+		return escaped;
+	}
+
+	const char* DeviceType(VkPhysicalDeviceType type) {
+		switch (type) {
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+			case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+			default: return "other";
+		}
+	}
+}
+
+class Bench {
+public:
+	void Run(const std::string& output) {
+		CreateInstance();
+		PickPhysicalDevice();
+		CreateLogicalDevice();
+		CreateCommands();
+
+		BenchMemoryTypes();
+		BenchAllocation();
+		BenchUploads();
+		BenchShaderModules();
+		CreateRenderTarget();
+		BenchPipelines();
+		BenchRecording();
+		BenchRoundTrips();
+		BenchSubmits();
+
+		Write(output);
+		PrintStats(output);
+		CleanUp();
+	}
+
+private:
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties properties {};
+	VkDevice device = VK_NULL_HANDLE;
+	uint queueFamily = 0;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint instanceApiVersion = VK_API_VERSION_1_0;
+	Context context;
+	MemoryTracker memoryTracker;
+
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	//? Recorded once, empty, submitted as often as needed
+	VkCommandBuffer emptyCommandBuffer = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+
+	VkImage attachment = VK_NULL_HANDLE;
+	VkDeviceMemory attachmentMemory = VK_NULL_HANDLE;
+	VkImageView attachmentView = VK_NULL_HANDLE;
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+	VkShaderModule vertModule = VK_NULL_HANDLE;
+	VkShaderModule fragModule = VK_NULL_HANDLE;
+
+	std::vector<Result> results;
+
+	//? Validation stays off, the layers would be most of what's measured
+	void CreateInstance() {
+		auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		if (enumerateInstanceVersion != nullptr) {
+			enumerateInstanceVersion(&instanceApiVersion);
+		}
+		instanceApiVersion = std::min(instanceApiVersion, uint(VK_API_VERSION_1_2));
+
+		VkApplicationInfo appInfo {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Hello Triangle Bench";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "No Engine";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = instanceApiVersion;
+
+		VkInstanceCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+
+		VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create VkInstance.\nError code: " + std::to_string(int(result)) + ".");
+		}
+	}
+
+	//? A CPU device if the loader offers one, numbers from a software ICD compare across machines
+	void PickPhysicalDevice() {
+		uint deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+		int bestScore = -1;
+		for (VkPhysicalDevice candidate : devices) {
+			uint family = 0;
+			if (!FindGraphicsFamily(candidate, family)) {
+				continue;
+			}
+			VkPhysicalDeviceProperties candidateProperties;
+			vkGetPhysicalDeviceProperties(candidate, &candidateProperties);
+			int score = candidateProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? 1 : 0;
+			if (score > bestScore) {
+				bestScore = score;
+				physicalDevice = candidate;
+				queueFamily = family;
+				properties = candidateProperties;
+			}
+		}
+		if (physicalDevice == VK_NULL_HANDLE) {
+			throw std::runtime_error("Couldn't find a device with a graphics queue.");
+		}
+		if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU) {
+			std::cout << "No software device found, benchmarking " << properties.deviceName << "." << std::endl;
+		}
+	}
+
+	static bool FindGraphicsFamily(VkPhysicalDevice candidate, uint& family) {
+		uint familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+		for (uint i = 0; i < familyCount; i++) {
+			if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				family = i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void CreateLogicalDevice() {
+		context.apiVersion = std::min(instanceApiVersion, properties.apiVersion);
+
+		float queuePriority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo {};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamily;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &queuePriority;
+
+		VkPhysicalDeviceFeatures features {};
+		VkDeviceCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.queueCreateInfoCount = 1;
+		createInfo.pQueueCreateInfos = &queueInfo;
+		createInfo.pEnabledFeatures = &features;
+
+		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a logical device.");
+		}
+		vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+		context.physicalDevice = physicalDevice;
+		context.device = device;
+		context.graphicsFamily = queueFamily;
+		context.graphicsQueue = queue;
+		context.computeFamily = queueFamily;
+		context.computeQueue = queue;
+		memoryTracker.Init(physicalDevice, false);
+		context.memoryTracker = &memoryTracker;
+	}
+
+	void CreateCommands() {
+		VkCommandPoolCreateInfo poolInfo {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a command pool.");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS or vkAllocateCommandBuffers(device, &allocInfo, &emptyCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't allocate command buffers.");
+		}
+
+		//? Submitted again while earlier submits may still be pending
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+		vkBeginCommandBuffer(emptyCommandBuffer, &beginInfo);
+		if (vkEndCommandBuffer(emptyCommandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Coudln't record a command buffer.");
+		}
+
+		VkFenceCreateInfo fenceInfo {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkSemaphoreCreateInfo semaphoreInfo {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS or vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create sync objects.");
+		}
+	}
+
+	void BenchMemoryTypes() {
+		//? The type bits of a real buffer, so the search walks what the app's searches walk
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		context.CreateBuffer(4096, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+		VkMemoryRequirements requirements;
+		vkGetBufferMemoryRequirements(device, buffer, &requirements);
+		context.DestroyBuffer(buffer, memory);
+
+		const VkMemoryPropertyFlags flags[2] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+		volatile uint sink = 0;
+		Result result;
+		result.name = "find_memory_type";
+		result.us = Measure(memoryTypeSamples, memoryTypeBatch, [&] {
+			for (uint i = 0; i < memoryTypeBatch; i++) {
+				sink = sink + context.FindMemoryType(requirements.memoryTypeBits, flags[i & 1]);
+			}
+		});
+		results.push_back(result);
+	}
+
+	//? Create, allocate, bind and free, the whole of Context::CreateBuffer and DestroyBuffer
+	void BenchAllocation() {
+		for (VkDeviceSize size : allocationSizes) {
+			Result result;
+			result.name = "buffer_allocation_" + std::to_string(size >> 10) + "KiB";
+			result.us = Measure(allocationSamples, 1, [&] {
+				VkBuffer buffer;
+				VkDeviceMemory memory;
+				context.CreateBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+				context.DestroyBuffer(buffer, memory);
+			});
+			result.throughput = 1e6 / Summarize(result.us).median;
+			result.throughputUnit = "allocations/s";
+			results.push_back(result);
+		}
+	}
+
+	//? Context::UploadBuffer as loading code uses it, a new staging buffer every time, against a
+	//? staging buffer kept mapped. Both wait for the copy, like ImmediateSubmit does
+	void BenchUploads() {
+		std::vector<uint8> data(uploadSize);
+		for (size_t i = 0; i < data.size(); i++) {
+			data[i] = uint8(i * 2654435761u >> 24);
+		}
+		VkBuffer destination;
+		VkDeviceMemory destinationMemory;
+		context.CreateBuffer(uploadSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, destination, destinationMemory);
+		std::string sizeName = std::to_string(uploadSize >> 20) + "MiB";
+
+		Result temporary;
+		temporary.name = "upload_buffer_" + sizeName;
+		temporary.us = Measure(uploadSamples, 1, [&] {
+			context.UploadBuffer(destination, data.data(), uploadSize);
+		});
+		temporary.throughput = uploadSize / Summarize(temporary.us).median / 1e3;
+		temporary.throughputUnit = "GB/s";
+		results.push_back(temporary);
+
+		VkBuffer staging;
+		VkDeviceMemory stagingMemory;
+		context.CreateBuffer(uploadSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMemory);
+		void* mapped;
+		vkMapMemory(device, stagingMemory, 0, uploadSize, 0, &mapped);
+
+		Result persistent;
+		persistent.name = "staging_upload_" + sizeName;
+		persistent.us = Measure(uploadSamples, 1, [&] {
+			memcpy(mapped, data.data(), uploadSize);
+			context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+				VkBufferCopy region {};
+				region.size = uploadSize;
+				vkCmdCopyBuffer(commandBuffer, staging, destination, 1, &region);
+			});
+		});
+		persistent.throughput = uploadSize / Summarize(persistent.us).median / 1e3;
+		persistent.throughputUnit = "GB/s";
+		results.push_back(persistent);
+
+		vkUnmapMemory(device, stagingMemory);
+		context.DestroyBuffer(staging, stagingMemory);
+		context.DestroyBuffer(destination, destinationMemory);
+	}
+
+	//? Every compiled shader in the tree, read and turned into a module separately
+	void BenchShaderModules() {
+		std::vector<std::string> paths;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(Settings::shaderDirectory)) {
+			if (entry.path().extension() == ".spv") {
+				paths.push_back(entry.path().string());
+			}
+		}
+		if (paths.empty()) {
+			throw std::runtime_error("Couldn't find compiled shaders in " + Settings::shaderDirectory + ".");
+		}
+		std::sort(paths.begin(), paths.end());
+
+		std::vector<std::string> code(paths.size());
+		Result read;
+		read.name = "shader_read_file";
+		read.us = Measure(shaderSamples, paths.size(), [&] {
+			for (uint i = 0; i < paths.size(); i++) {
+				code[i] = Context::ReadFile(paths[i]);
+			}
+		});
+		size_t bytes = 0;
+		for (const std::string& spirv : code) {
+			bytes += spirv.size();
+		}
+		double bytesPerModule = double(bytes) / paths.size();
+		read.throughput = bytesPerModule / Summarize(read.us).median;
+		read.throughputUnit = "MB/s";
+		results.push_back(read);
+
+		Result create;
+		create.name = "shader_module_create";
+		create.us = Measure(shaderSamples, paths.size(), [&] {
+			for (const std::string& spirv : code) {
+				vkDestroyShaderModule(device, context.CreateShaderModule(spirv), nullptr);
+			}
+		});
+		create.throughput = bytesPerModule / Summarize(create.us).median;
+		create.throughputUnit = "MB/s";
+		results.push_back(create);
+	}
+
+	//? The HUD's pipeline needs nothing but a push constant and a vertex buffer
+	void CreateRenderTarget() {
+		context.CreateImage(attachmentExtent, 1, attachmentFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, attachment, attachmentMemory);
+		attachmentView = context.CreateImageView(attachment, attachmentFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+		VkAttachmentDescription colorAttachment {};
+		colorAttachment.format = attachmentFormat;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference attachmentReference {};
+		attachmentReference.attachment = 0;
+		attachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &attachmentReference;
+
+		VkRenderPassCreateInfo renderPassInfo {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &colorAttachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a render pass.");
+		}
+
+		VkFramebufferCreateInfo framebufferInfo {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &attachmentView;
+		framebufferInfo.width = attachmentExtent.width;
+		framebufferInfo.height = attachmentExtent.height;
+		framebufferInfo.layers = 1;
+		if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a framebuffer.");
+		}
+
+		VkPushConstantRange pushConstantRange {};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstantRange.size = sizeof(glm::vec2);
+
+		VkPipelineLayoutCreateInfo layoutInfo {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+		if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a pipeline layout.");
+		}
+
+		vertModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/hud.vert.spv"));
+		fragModule = context.CreateShaderModule(Context::ReadFile("src/Shaders/hud.frag.spv"));
+
+		context.CreateBuffer(6 * sizeof(Hud::Vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBuffer, vertexMemory);
+	}
+
+	VkPipeline CreatePipeline(VkPipelineCache cache) {
+		std::array<VkPipelineShaderStageCreateInfo, 2> stages {};
+		stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		stages[0].module = vertModule;
+		stages[0].pName = "main";
+		stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		stages[1].module = fragModule;
+		stages[1].pName = "main";
+
+		VkVertexInputBindingDescription binding {};
+		binding.binding = 0;
+		binding.stride = sizeof(Hud::Vertex);
+		binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		std::array<VkVertexInputAttributeDescription, 4> attributes {};
+		const VkFormat formats[4] = { VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R8G8B8A8_UNORM };
+		const uint offsets[4] = { offsetof(Hud::Vertex, position), offsetof(Hud::Vertex, cell), offsetof(Hud::Vertex, glyph), offsetof(Hud::Vertex, color) };
+		for (uint i = 0; i < attributes.size(); i++) {
+			attributes[i].location = i;
+			attributes[i].format = formats[i];
+			attributes[i].offset = offsets[i];
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.pVertexBindingDescriptions = &binding;
+		vertexInputInfo.vertexAttributeDescriptionCount = attributes.size();
+		vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo {};
+		inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+		VkViewport viewport {};
+		viewport.width = float(attachmentExtent.width);
+		viewport.height = float(attachmentExtent.height);
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor {};
+		scissor.extent = attachmentExtent;
+
+		VkPipelineViewportStateCreateInfo viewportInfo {};
+		viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportInfo.viewportCount = 1;
+		viewportInfo.pViewports = &viewport;
+		viewportInfo.scissorCount = 1;
+		viewportInfo.pScissors = &scissor;
+
+		VkPipelineRasterizationStateCreateInfo rasterizerInfo {};
+		rasterizerInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizerInfo.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizerInfo.cullMode = VK_CULL_MODE_NONE;
+		rasterizerInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
+		rasterizerInfo.lineWidth = 1.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisamplingInfo {};
+		multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment {};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo {};
+		colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlendInfo.attachmentCount = 1;
+		colorBlendInfo.pAttachments = &colorBlendAttachment;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = stages.size();
+		pipelineInfo.pStages = stages.data();
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssemblyInfo;
+		pipelineInfo.pViewportState = &viewportInfo;
+		pipelineInfo.pRasterizationState = &rasterizerInfo;
+		pipelineInfo.pMultisampleState = &multisamplingInfo;
+		pipelineInfo.pColorBlendState = &colorBlendInfo;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.renderPass = renderPass;
+		pipelineInfo.subpass = 0;
+
+		VkPipeline created;
+		if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &created) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a graphics pipeline");
+		}
+		return created;
+	}
+
+	//? Cold is without a cache, `make bench` also turns off the driver's own disk cache. Cached
+	//? is against a VkPipelineCache that has seen the same pipeline once
+	void BenchPipelines() {
+		Result cold;
+		cold.name = "pipeline_create_cold";
+		cold.us = Measure(pipelineSamples, 1, [&] {
+			vkDestroyPipeline(device, CreatePipeline(VK_NULL_HANDLE), nullptr);
+		});
+		results.push_back(cold);
+
+		VkPipelineCacheCreateInfo cacheInfo {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		VkPipelineCache cache;
+		if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a pipeline cache.");
+		}
+		vkDestroyPipeline(device, CreatePipeline(cache), nullptr);
+
+		Result cached;
+		cached.name = "pipeline_create_cached";
+		cached.us = Measure(pipelineSamples, 1, [&] {
+			vkDestroyPipeline(device, CreatePipeline(cache), nullptr);
+		});
+		results.push_back(cached);
+		vkDestroyPipelineCache(device, cache, nullptr);
+
+		pipeline = CreatePipeline(VK_NULL_HANDLE);
+	}
+
+	//? A pass with a push constant and a draw per object, the shape of the app's streams
+	void BenchRecording() {
+		glm::vec2 pixelToClip(2.0f / attachmentExtent.width, 2.0f / attachmentExtent.height);
+		VkClearValue clearValue {};
+		Result result;
+		result.name = "command_recording_" + std::to_string(drawsPerRecording) + "_draws";
+		result.us = Measure(recordingSamples, 1, [&] {
+			vkResetCommandBuffer(commandBuffer, 0);
+			VkCommandBufferBeginInfo beginInfo {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+			VkRenderPassBeginInfo renderPassInfo {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = renderPass;
+			renderPassInfo.framebuffer = framebuffer;
+			renderPassInfo.renderArea.extent = attachmentExtent;
+			renderPassInfo.clearValueCount = 1;
+			renderPassInfo.pClearValues = &clearValue;
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			VkDeviceSize offset = 0;
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+			for (uint i = 0; i < drawsPerRecording; i++) {
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::vec2), &pixelToClip);
+				vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+			}
+			vkCmdEndRenderPass(commandBuffer);
+			if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Coudln't record a command buffer.");
+			}
+		});
+		uint commands = 2 * drawsPerRecording + 4;
+		result.throughput = commands / Summarize(result.us).median;
+		result.throughputUnit = "M commands/s";
+		results.push_back(result);
+	}
+
+	//? An empty submit waited on with a fence, then two chained through a semaphore
+	void BenchRoundTrips() {
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &emptyCommandBuffer;
+
+		Result fenced;
+		fenced.name = "fence_round_trip";
+		fenced.us = Measure(roundTripSamples, 1, [&] {
+			vkResetFences(device, 1, &fence);
+			if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't submit a command buffer.");
+			}
+			vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+		});
+		results.push_back(fenced);
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		std::array<VkSubmitInfo, 2> chained {};
+		chained[0] = submitInfo;
+		chained[0].signalSemaphoreCount = 1;
+		chained[0].pSignalSemaphores = &semaphore;
+		chained[1] = submitInfo;
+		chained[1].waitSemaphoreCount = 1;
+		chained[1].pWaitSemaphores = &semaphore;
+		chained[1].pWaitDstStageMask = &waitStage;
+
+		Result semaphoreChain;
+		semaphoreChain.name = "semaphore_round_trip";
+		semaphoreChain.us = Measure(roundTripSamples, 1, [&] {
+			vkResetFences(device, 1, &fence);
+			if (vkQueueSubmit(queue, chained.size(), chained.data(), fence) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't submit a command buffer.");
+			}
+			vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+		});
+		results.push_back(semaphoreChain);
+	}
+
+	//? Only the vkQueueSubmit calls are timed, the queue drains after each sample. One call per
+	//? submit against one call carrying the whole batch
+	void BenchSubmits() {
+		VkSubmitInfo submitInfo {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &emptyCommandBuffer;
+		std::vector<VkSubmitInfo> batch(submitBatch, submitInfo);
+
+		Result single;
+		single.name = "submit_overhead";
+		Result batched;
+		batched.name = "submit_overhead_batched";
+		for (uint i = 0; i < warmupSamples + submitSamples; i++) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint j = 0; j < submitBatch; j++) {
+				if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+					throw std::runtime_error("Couldn't submit a command buffer.");
+				}
+			}
+			auto submitted = std::chrono::steady_clock::now();
+			vkQueueWaitIdle(queue);
+
+			auto batchStart = std::chrono::steady_clock::now();
+			if (vkQueueSubmit(queue, batch.size(), batch.data(), VK_NULL_HANDLE) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't submit a command buffer.");
+			}
+			auto batchSubmitted = std::chrono::steady_clock::now();
+			vkQueueWaitIdle(queue);
+
+			if (i >= warmupSamples) {
+				single.us.push_back(std::chrono::duration<double, std::micro>(submitted - start).count() / submitBatch);
+				batched.us.push_back(std::chrono::duration<double, std::micro>(batchSubmitted - batchStart).count() / submitBatch);
+			}
+		}
+		results.push_back(single);
+		results.push_back(batched);
+	}
+
+	void Write(const std::string& path) {
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			throw std::runtime_error("Couldn't open " + path + " for writing.");
+		}
+		file.precision(6);
+		file << "{\n";
+		file << "\t\"device\": \"" << Escape(properties.deviceName) << "\",\n";
+		file << "\t\"deviceType\": \"" << DeviceType(properties.deviceType) << "\",\n";
+		file << "\t\"apiVersion\": \"" << VK_VERSION_MAJOR(context.apiVersion) << "." << VK_VERSION_MINOR(context.apiVersion) << "." << VK_VERSION_PATCH(context.apiVersion) << "\",\n";
+		file << "\t\"driverVersion\": " << properties.driverVersion << ",\n";
+		file << "\t\"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() << ",\n";
+		file << "\t\"unit\": \"us\",\n";
+		file << "\t\"benchmarks\": [\n";
+		for (uint i = 0; i < results.size(); i++) {
+			const Result& result = results[i];
+			Times times = Summarize(result.us);
+			file << "\t\t{ \"name\": \"" << result.name << "\", \"samples\": " << result.us.size();
+			file << ", \"min\": " << times.min << ", \"median\": " << times.median << ", \"mean\": " << times.mean << ", \"p95\": " << times.p95;
+			if (!result.throughputUnit.empty()) {
+				file << ", \"throughput\": " << result.throughput << ", \"throughputUnit\": \"" << result.throughputUnit << "\"";
+			}
+			file << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		file << "\t]\n";
+		file << "}\n";
+	}
+
+	void PrintStats(const std::string& output) {
+		std::cout << "Bench:\n";
+		std::cout << "\tDevice: " << properties.deviceName << " (" << DeviceType(properties.deviceType) << ")\n";
+		for (const Result& result : results) {
+			Times times = Summarize(result.us);
+			std::cout << "\t" << result.name << ": median " << times.median << " us, p95 " << times.p95 << " us";
+			if (!result.throughputUnit.empty()) {
+				std::cout << ", " << result.throughput << " " << result.throughputUnit;
+			}
+			std::cout << "\n";
+		}
+		std::cout << "\tWritten to " << output << "\n" << std::endl;
+	}
+
+	void CleanUp() {
+		vkDeviceWaitIdle(device);
+		vkDestroyPipeline(device, pipeline, nullptr);
+		vkDestroyShaderModule(device, vertModule, nullptr);
+		vkDestroyShaderModule(device, fragModule, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		vkDestroyFramebuffer(device, framebuffer, nullptr);
+		vkDestroyRenderPass(device, renderPass, nullptr);
+		vkDestroyImageView(device, attachmentView, nullptr);
+		context.DestroyImage(attachment, attachmentMemory);
+		context.DestroyBuffer(vertexBuffer, vertexMemory);
+		vkDestroySemaphore(device, semaphore, nullptr);
+		vkDestroyFence(device, fence, nullptr);
+		vkDestroyCommandPool(device, commandPool, nullptr);
+
+		memoryTracker.ReportLeaks();
+		vkDestroyDevice(device, nullptr);
+		vkDestroyInstance(instance, nullptr);
+	}
+};
+
+int main(int argc, char** argv) {
+	std::string output = argc > 1 ? argv[1] : defaultOutput;
+
+	Bench bench;
+	try {
+		bench.Run(output);
+	} catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "MeshImport.hpp"
+#include "MeshLibrary.hpp"
+
+//? Converts OBJ and glTF meshes into one MeshFile, with levels of detail and meshlets built here
+//? instead of at startup. Every mesh of every input ends up in the output, in order.
+//? Usage: meshconv [--lods count] <output> <input>...
+//?        meshconv --compare <input>...
+//? --compare runs MeshLibrary::Benchmark on each input instead, text against container.
+namespace {
+	const char* usage = "Usage: meshconv [--lods count] <output> <input>...\n       meshconv --compare <input>...";
+
+	void Convert(const std::string& output, const std::vector<std::string>& inputs, uint lods) {
+		MeshLibrary library;
+		uint64 triangles = 0;
+		for (const std::string& input : inputs) {
+			for (const MeshImport::Mesh& mesh : MeshImport::Load(input)) {
+				library.Add(mesh.name, mesh.vertices, mesh.indices, lods);
+				triangles += mesh.indices.size() / 3;
+				std::cout << input << ": " << mesh.name << ", " << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles\n";
+			}
+		}
+		library.Save(output);
+		std::cout << "Wrote " << library.Count() << " meshes, " << triangles << " triangles, to " << output << "\n" << std::endl;
+		library.PrintStats();
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+	uint lods = Settings::lodLevels;
+	bool compare = false;
+	std::vector<std::string> paths;
+	for (uint i = 0; i < arguments.size(); i++) {
+		if (arguments[i] == "--compare") {
+			compare = true;
+		} else if (arguments[i] == "--lods" and i + 1 < arguments.size()) {
+			lods = uint(std::max(std::atoi(arguments[++i].c_str()), 1));
+		} else {
+			paths.push_back(arguments[i]);
+		}
+	}
+	if (paths.size() < (compare ? 1u : 2u)) {
+		std::cout << usage << std::endl;
+		return 1;
+	}
+
+	try {
+		if (compare) {
+			for (const std::string& path : paths) {
+				MeshLibrary::Benchmark(path);
+			}
+		} else {
+			Convert(paths[0], std::vector<std::string>(paths.begin() + 1, paths.end()), lods);
+		}
+	} catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,1032 @@
+#include "System.hpp"
+#include "Types.hpp"
+#include "Settings.hpp"
+#include "Context.hpp"
+#include "MemoryTracker.hpp"
+#include "GpuTimer.hpp"
+#include "TextureManager.hpp"
+#include "CaptureFile.hpp"
+
+//? Runs a frame captured by FrameCapture again, headless and without the app around it.
+//? Every object is created up front and the commands are recorded once into a primary, which is
+//? then submitted in a loop with each submit waited on, so the times are the frame's alone.
+//? Usage: replay <capture> [iterations] [--record]
+//? --record records the commands again every iteration and times that as well.
+namespace {
+	const uint defaultIterations = 1000;
+	const uint warmupIterations = 16;
+
+	struct Times {
+		double min = 0.0;
+		double median = 0.0;
+		double mean = 0.0;
+		double p95 = 0.0;
+	};
+
+	Times Summarize(std::vector<double> ms) {
+		Times times;
+		if (ms.empty()) {
+			return times;
+		}
+		std::sort(ms.begin(), ms.end());
+		times.min = ms.front();
+		times.median = ms[ms.size() / 2];
+		times.p95 = ms[std::min(ms.size() - 1, ms.size() * 95 / 100)];
+		for (double value : ms) {
+			times.mean += value;
+		}
+		times.mean /= double(ms.size());
+		return times;
+	}
+
+	void PrintTimes(const std::string& name, const std::vector<double>& ms) {
+		Times times = Summarize(ms);
+		std::cout << "\t" << name << ": min " << times.min << " ms, median " << times.median << " ms, mean " << times.mean << " ms, p95 " << times.p95 << " ms\n";
+	}
+
+	//? The swap chain isn't there to present, its images stay attachments
+	VkImageLayout ReplayLayout(VkImageLayout layout) {
+		return layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : layout;
+	}
+
+	template<typename T>
+	std::vector<T> Unpack(const std::string& data) {
+		std::vector<T> values(data.size() / sizeof(T));
+		memcpy(values.data(), data.data(), values.size() * sizeof(T));
+		return values;
+	}
+}
+
+class Replay {
+public:
+	void Run(const std::string& path, uint iterations, bool rerecord) {
+		auto setupStart = std::chrono::steady_clock::now();
+		capture = CaptureFile::Load(path);
+		CreateInstance();
+		PickPhysicalDevice();
+		CreateLogicalDevice();
+		CreateObjects();
+		CreateCommands();
+		double setupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - setupStart).count();
+
+		std::vector<double> cpuMs;
+		std::vector<double> recordMs;
+		std::vector<double> gpuMs;
+		std::vector<std::vector<double>> passMs(passScopes.size());
+		for (uint i = 0; i < warmupIterations + iterations; i++) {
+			auto start = std::chrono::steady_clock::now();
+			if (rerecord) {
+				vkResetCommandBuffer(commandBuffer, 0);
+				RecordCommands();
+			}
+			auto recorded = std::chrono::steady_clock::now();
+
+			VkSubmitInfo submitInfo {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &commandBuffer;
+			vkResetFences(device, 1, &fence);
+			if (vkQueueSubmit(queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't submit the replayed frame.");
+			}
+			vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+			auto end = std::chrono::steady_clock::now();
+
+			if (i < warmupIterations) {
+				continue;
+			}
+			cpuMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+			recordMs.push_back(std::chrono::duration<double, std::milli>(recorded - start).count());
+			timer.Resolve(0);
+			if (timer.Valid(frameScope)) {
+				gpuMs.push_back(timer.Milliseconds(frameScope));
+			}
+			for (uint pass = 0; pass < passScopes.size(); pass++) {
+				if (timer.Valid(passScopes[pass])) {
+					passMs[pass].push_back(timer.Milliseconds(passScopes[pass]));
+				}
+			}
+		}
+
+		uint64 checksum = 0;
+		bool hasChecksum = Checksum(checksum);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		uint draws = 0;
+		for (const CaptureFile::Command& command : capture.commands) {
+			draws += command.op == CaptureFile::Op::Draw or command.op == CaptureFile::Op::DrawIndexed
+				or command.op == CaptureFile::Op::DrawIndexedIndirect or command.op == CaptureFile::Op::DrawIndexedIndirectCount;
+		}
+
+		std::cout << "Replay:\n";
+		std::cout << "\tCapture: " << path << ", frame " << capture.frame << " from " << capture.deviceName << "\n";
+		std::cout << "\tDevice: " << properties.deviceName << (capture.deviceName != properties.deviceName ? ", not the capturing one" : "") << "\n";
+		std::cout << "\tObjects: " << capture.buffers.size() << " buffers, " << capture.images.size() << " images, " << capture.pipelines.size() << " pipelines, " << capture.descriptorSets.size() << " descriptor sets\n";
+		std::cout << "\tCommands: " << capture.commands.size() << ", " << draws << " draws, " << passScopes.size() << " render passes\n";
+		std::cout << "\tSetup: " << setupMs << " ms, " << capture.ContentBytes() / 1024 << " KiB uploaded\n";
+		std::cout << "\tIterations: " << iterations << " after " << warmupIterations << " warmup\n";
+		PrintTimes("CPU submit to fence", cpuMs);
+		if (rerecord) {
+			PrintTimes("CPU recording", recordMs);
+		}
+		if (gpuMs.empty()) {
+			std::cout << "\tGPU: no timestamps on this queue\n";
+		} else {
+			PrintTimes("GPU", gpuMs);
+			for (uint pass = 0; pass < passScopes.size(); pass++) {
+				PrintTimes("GPU pass " + std::to_string(pass), passMs[pass]);
+			}
+		}
+		if (hasChecksum) {
+			std::cout << "\tLast color attachment: 0x" << std::hex << checksum << std::dec << "\n";
+		}
+		std::cout << std::endl;
+
+		CleanUp();
+	}
+
+private:
+	CaptureFile capture;
+
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkDevice device = VK_NULL_HANDLE;
+	uint queueFamily = 0;
+	VkQueue queue = VK_NULL_HANDLE;
+	uint instanceApiVersion = VK_API_VERSION_1_0;
+	bool validation = false;
+	Context context;
+	MemoryTracker memoryTracker;
+	PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+	//? Same order as the capture's lists, commands index into them
+	std::vector<VkBuffer> buffers;
+	std::vector<VkDeviceMemory> bufferMemory;
+	std::vector<VkImage> images;
+	std::vector<VkDeviceMemory> imageMemory;
+	std::vector<VkImageView> imageViews;
+	std::vector<VkSampler> samplers;
+	std::vector<VkShaderModule> shaderModules;
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	std::vector<VkPipelineLayout> pipelineLayouts;
+	std::vector<VkRenderPass> renderPasses;
+	std::vector<VkFramebuffer> framebuffers;
+	std::vector<VkPipeline> pipelines;
+	std::vector<VkDescriptorSet> descriptorSets;
+	VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	VkFence fence = VK_NULL_HANDLE;
+	GpuTimer timer;
+	uint frameScope = 0;
+	std::vector<uint> passScopes;
+
+	void CreateInstance() {
+		//? Validation is welcome but not required, replays often run where the SDK isn't installed
+		if (Settings::useValidationLayers) {
+			uint layerCount = 0;
+			vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+			std::vector<VkLayerProperties> layers(layerCount);
+			vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+			validation = std::all_of(Settings::validationLayers.begin(), Settings::validationLayers.end(), [&](const char* name) {
+				return std::any_of(layers.begin(), layers.end(), [&](const VkLayerProperties& layer) { return strcmp(layer.layerName, name) == 0; });
+			});
+			if (!validation) {
+				std::cout << "Validation layers are not present, replaying without them." << std::endl;
+			}
+		}
+
+		auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		if (enumerateInstanceVersion != nullptr) {
+			enumerateInstanceVersion(&instanceApiVersion);
+		}
+		instanceApiVersion = std::min(instanceApiVersion, uint(VK_API_VERSION_1_2));
+
+		VkApplicationInfo appInfo {};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "Hello Triangle Replay";
+		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.pEngineName = "No Engine";
+		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+		appInfo.apiVersion = instanceApiVersion;
+
+		VkInstanceCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		createInfo.pApplicationInfo = &appInfo;
+		if (validation) {
+			createInfo.enabledLayerCount = uint(Settings::validationLayers.size());
+			createInfo.ppEnabledLayerNames = Settings::validationLayers.data();
+		}
+
+		VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("Failed to create VkInstance.\nError code: " + std::to_string(int(result)) + ".");
+		}
+	}
+
+	void PickPhysicalDevice() {
+		uint deviceCount = 0;
+		vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+		std::vector<VkPhysicalDevice> devices(deviceCount);
+		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+		//? The capturing device if it's here, then any discrete one, then whatever has a graphics queue
+		int bestScore = -1;
+		for (VkPhysicalDevice candidate : devices) {
+			uint family = 0;
+			if (!FindGraphicsFamily(candidate, family)) {
+				continue;
+			}
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(candidate, &properties);
+			int score = 0;
+			score += capture.deviceName == properties.deviceName ? 2 : 0;
+			score += properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 1 : 0;
+			if (score > bestScore) {
+				bestScore = score;
+				physicalDevice = candidate;
+				queueFamily = family;
+			}
+		}
+		if (physicalDevice == VK_NULL_HANDLE) {
+			throw std::runtime_error("Couldn't find a device with a graphics queue.");
+		}
+	}
+
+	static bool FindGraphicsFamily(VkPhysicalDevice candidate, uint& family) {
+		uint familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+		for (uint i = 0; i < familyCount; i++) {
+			if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+				family = i;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ExtensionSupported(const char* name) {
+		uint extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+		return std::any_of(extensions.begin(), extensions.end(), [&](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, name) == 0; });
+	}
+
+	//? Only the features the capture says its commands rely on, a device without one can't replay it
+	void CreateLogicalDevice() {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		context.apiVersion = std::min(instanceApiVersion, properties.apiVersion);
+
+		VkPhysicalDeviceFeatures supported;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supported);
+		VkPhysicalDeviceFeatures features {};
+		if (capture.multiDrawIndirect and !supported.multiDrawIndirect) {
+			throw std::runtime_error("Couldn't replay the capture, the device lacks multiDrawIndirect.");
+		}
+		if (capture.drawIndirectFirstInstance and !supported.drawIndirectFirstInstance) {
+			throw std::runtime_error("Couldn't replay the capture, the device lacks drawIndirectFirstInstance.");
+		}
+		features.multiDrawIndirect = capture.multiDrawIndirect;
+		features.drawIndirectFirstInstance = capture.drawIndirectFirstInstance;
+		context.multiDrawIndirect = capture.multiDrawIndirect;
+		context.drawIndirectFirstInstance = capture.drawIndirectFirstInstance;
+
+		std::vector<const char*> extensions;
+		if (capture.drawIndirectCount) {
+			if (!ExtensionSupported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+				throw std::runtime_error("Couldn't replay the capture, the device lacks " + std::string(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) + ".");
+			}
+			extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		}
+
+		//? The same subset TriangleApp enables for BindlessTable
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		if (capture.descriptorIndexing) {
+			bool extension = ExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			if (context.apiVersion < VK_API_VERSION_1_1 or (context.apiVersion < VK_API_VERSION_1_2 and !extension)) {
+				throw std::runtime_error("Couldn't replay the capture, the device lacks descriptor indexing.");
+			}
+			if (extension) {
+				extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+				extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			}
+
+			VkPhysicalDeviceFeatures2 features2 {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &indexingFeatures;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+			bool indexing = indexingFeatures.runtimeDescriptorArray
+				and indexingFeatures.descriptorBindingPartiallyBound
+				and indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+				and indexingFeatures.shaderStorageBufferArrayNonUniformIndexing
+				and indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+				and indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind
+				and indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+			if (!indexing) {
+				throw std::runtime_error("Couldn't replay the capture, the device lacks descriptor indexing.");
+			}
+			indexingFeatures = {};
+			indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+			indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+			indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+			indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			indexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+			indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		}
+		context.enabledExtensions = std::set<std::string>(extensions.begin(), extensions.end());
+		context.descriptorIndexing = capture.descriptorIndexing;
+
+		float queuePriority = 1.0f;
+		VkDeviceQueueCreateInfo queueInfo {};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamily;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &queuePriority;
+
+		VkDeviceCreateInfo createInfo {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = capture.descriptorIndexing ? &indexingFeatures : nullptr;
+		createInfo.queueCreateInfoCount = 1;
+		createInfo.pQueueCreateInfos = &queueInfo;
+		createInfo.pEnabledFeatures = &features;
+		createInfo.enabledExtensionCount = uint(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
+		if (validation) {
+			createInfo.enabledLayerCount = uint(Settings::validationLayers.size());
+			createInfo.ppEnabledLayerNames = Settings::validationLayers.data();
+		}
+
+		if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a logical device.");
+		}
+		vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+		if (capture.drawIndirectCount) {
+			drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR"));
+		}
+
+		context.physicalDevice = physicalDevice;
+		context.device = device;
+		context.graphicsFamily = queueFamily;
+		context.graphicsQueue = queue;
+		context.computeFamily = queueFamily;
+		context.computeQueue = queue;
+		memoryTracker.Init(physicalDevice, false);
+		context.memoryTracker = &memoryTracker;
+	}
+
+	void CreateObjects() {
+		for (const CaptureFile::Buffer& captured : capture.buffers) {
+			VkBuffer buffer;
+			VkDeviceMemory memory;
+			context.CreateBuffer(captured.size, captured.usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+			if (!captured.data.empty()) {
+				context.UploadBuffer(buffer, captured.data.data(), captured.data.size());
+			}
+			buffers.push_back(buffer);
+			bufferMemory.push_back(memory);
+		}
+
+		for (const CaptureFile::Image& captured : capture.images) {
+			VkImage image;
+			VkDeviceMemory memory;
+			//? Transfer source for the checksum
+			context.CreateImage(captured.extent, captured.mipLevels, captured.format, captured.usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, image, memory);
+			if (captured.layout != VK_IMAGE_LAYOUT_UNDEFINED) {
+				UploadImage(image, captured);
+			}
+			images.push_back(image);
+			imageMemory.push_back(memory);
+		}
+
+		for (const CaptureFile::ImageView& captured : capture.imageViews) {
+			imageViews.push_back(context.CreateImageView(images[captured.image], captured.format, captured.aspect, captured.mipLevels));
+		}
+
+		for (const CaptureFile::Sampler& captured : capture.samplers) {
+			VkSamplerCreateInfo samplerInfo = captured.info;
+			samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			VkSampler sampler;
+			if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't create a sampler.");
+			}
+			samplers.push_back(sampler);
+		}
+
+		for (const CaptureFile::ShaderModule& captured : capture.shaderModules) {
+			shaderModules.push_back(context.CreateShaderModule(captured.code));
+		}
+
+		for (const CaptureFile::SetLayout& captured : capture.setLayouts) {
+			setLayouts.push_back(CreateSetLayout(captured));
+		}
+
+		for (const CaptureFile::PipelineLayout& captured : capture.pipelineLayouts) {
+			std::vector<VkDescriptorSetLayout> layouts;
+			for (uint64 setLayout : captured.setLayouts) {
+				layouts.push_back(setLayouts[setLayout]);
+			}
+			VkPipelineLayoutCreateInfo layoutInfo {};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutInfo.setLayoutCount = uint(layouts.size());
+			layoutInfo.pSetLayouts = layouts.data();
+			layoutInfo.pushConstantRangeCount = uint(captured.pushConstants.size());
+			layoutInfo.pPushConstantRanges = captured.pushConstants.data();
+
+			VkPipelineLayout layout;
+			if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't create a pipeline layout.");
+			}
+			pipelineLayouts.push_back(layout);
+		}
+
+		for (const CaptureFile::RenderPass& captured : capture.renderPasses) {
+			renderPasses.push_back(CreateRenderPass(captured));
+		}
+
+		for (const CaptureFile::Framebuffer& captured : capture.framebuffers) {
+			std::vector<VkImageView> attachments;
+			for (uint64 attachment : captured.attachments) {
+				attachments.push_back(imageViews[attachment]);
+			}
+			VkFramebufferCreateInfo framebufferInfo {};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPasses[captured.renderPass];
+			framebufferInfo.attachmentCount = uint(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = captured.extent.width;
+			framebufferInfo.height = captured.extent.height;
+			framebufferInfo.layers = 1;
+
+			VkFramebuffer framebuffer;
+			if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+				throw std::runtime_error("Couldn't create a framebuffer.");
+			}
+			framebuffers.push_back(framebuffer);
+		}
+
+		for (const CaptureFile::Pipeline& captured : capture.pipelines) {
+			pipelines.push_back(CreatePipeline(captured));
+		}
+
+		CreateDescriptorSets();
+	}
+
+	//? Every level through one staging buffer, then into the layout the descriptors expect.
+	//? Images captured without contents still get the layout, sampling them reads garbage
+	void UploadImage(VkImage image, const CaptureFile::Image& captured) {
+		VkDeviceSize size = 0;
+		for (const std::string& level : captured.levels) {
+			size += level.size();
+		}
+
+		VkBuffer stagingBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+		if (size > 0) {
+			context.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory);
+			void* mapped;
+			vkMapMemory(device, stagingMemory, 0, size, 0, &mapped);
+			char* bytes = static_cast<char*>(mapped);
+			for (const std::string& level : captured.levels) {
+				memcpy(bytes, level.data(), level.size());
+				bytes += level.size();
+			}
+			vkUnmapMemory(device, stagingMemory);
+		}
+
+		VkImageAspectFlags aspect = captured.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+		context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+			VkImageMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = aspect;
+			barrier.subresourceRange.levelCount = captured.mipLevels;
+			barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkDeviceSize offset = 0;
+			for (uint level = 0; level < captured.levels.size(); level++) {
+				VkBufferImageCopy region {};
+				region.bufferOffset = offset;
+				region.imageSubresource.aspectMask = aspect;
+				region.imageSubresource.mipLevel = level;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent = { std::max(captured.extent.width >> level, 1u), std::max(captured.extent.height >> level, 1u), 1 };
+				vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+				offset += captured.levels[level].size();
+			}
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = captured.layout;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		});
+
+		if (stagingBuffer != VK_NULL_HANDLE) {
+			context.DestroyBuffer(stagingBuffer, stagingMemory);
+		}
+	}
+
+	VkDescriptorSetLayout CreateSetLayout(const CaptureFile::SetLayout& captured) {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> flags;
+		bool anyFlags = false;
+		for (const CaptureFile::SetLayoutBinding& binding : captured.bindings) {
+			VkDescriptorSetLayoutBinding layoutBinding {};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.type;
+			layoutBinding.descriptorCount = binding.count;
+			layoutBinding.stageFlags = binding.stages;
+			bindings.push_back(layoutBinding);
+			flags.push_back(binding.flags);
+			anyFlags = anyFlags or binding.flags != 0;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = uint(flags.size());
+		bindingFlagsInfo.pBindingFlags = flags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = anyFlags ? &bindingFlagsInfo : nullptr;
+		layoutInfo.flags = captured.flags;
+		layoutInfo.bindingCount = uint(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout layout;
+		if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a descriptor set layout.");
+		}
+		return layout;
+	}
+
+	VkRenderPass CreateRenderPass(const CaptureFile::RenderPass& captured) {
+		std::vector<VkAttachmentDescription> attachments = captured.attachments;
+		for (VkAttachmentDescription& attachment : attachments) {
+			attachment.initialLayout = ReplayLayout(attachment.initialLayout);
+			attachment.finalLayout = ReplayLayout(attachment.finalLayout);
+		}
+
+		VkSubpassDescription subpass {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = uint(captured.colorReferences.size());
+		subpass.pColorAttachments = captured.colorReferences.data();
+		if (captured.depthReference.attachment != VK_ATTACHMENT_UNUSED) {
+			subpass.pDepthStencilAttachment = &captured.depthReference;
+		}
+
+		VkRenderPassCreateInfo renderPassInfo {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = uint(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = uint(captured.dependencies.size());
+		renderPassInfo.pDependencies = captured.dependencies.data();
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a render pass.");
+		}
+		return renderPass;
+	}
+
+	VkPipeline CreatePipeline(const CaptureFile::Pipeline& captured) {
+		std::vector<VkSpecializationInfo> specializations(captured.stages.size());
+		std::vector<VkPipelineShaderStageCreateInfo> stages;
+		for (uint i = 0; i < captured.stages.size(); i++) {
+			const CaptureFile::ShaderStage& stage = captured.stages[i];
+			VkPipelineShaderStageCreateInfo stageInfo {};
+			stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stageInfo.stage = stage.stage;
+			stageInfo.module = shaderModules[stage.module];
+			stageInfo.pName = stage.entry.c_str();
+			if (!stage.specializationEntries.empty()) {
+				specializations[i].mapEntryCount = uint(stage.specializationEntries.size());
+				specializations[i].pMapEntries = stage.specializationEntries.data();
+				specializations[i].dataSize = stage.specializationData.size();
+				specializations[i].pData = stage.specializationData.data();
+				stageInfo.pSpecializationInfo = &specializations[i];
+			}
+			stages.push_back(stageInfo);
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = uint(captured.vertexBindings.size());
+		vertexInputInfo.pVertexBindingDescriptions = captured.vertexBindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = uint(captured.vertexAttributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions = captured.vertexAttributes.data();
+
+		VkPipelineViewportStateCreateInfo viewportInfo {};
+		viewportInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportInfo.viewportCount = captured.viewportCount;
+		viewportInfo.pViewports = captured.viewports.empty() ? nullptr : captured.viewports.data();
+		viewportInfo.scissorCount = captured.scissorCount;
+		viewportInfo.pScissors = captured.scissors.empty() ? nullptr : captured.scissors.data();
+
+		VkPipelineColorBlendStateCreateInfo colorBlendInfo = captured.colorBlend;
+		colorBlendInfo.attachmentCount = uint(captured.blendAttachments.size());
+		colorBlendInfo.pAttachments = captured.blendAttachments.data();
+
+		VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
+		dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicStateInfo.dynamicStateCount = uint(captured.dynamicStates.size());
+		dynamicStateInfo.pDynamicStates = captured.dynamicStates.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = uint(stages.size());
+		pipelineInfo.pStages = stages.data();
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &captured.inputAssembly;
+		pipelineInfo.pViewportState = &viewportInfo;
+		pipelineInfo.pRasterizationState = &captured.rasterization;
+		pipelineInfo.pMultisampleState = &captured.multisample;
+		pipelineInfo.pDepthStencilState = captured.depthStencilEnabled ? &captured.depthStencil : nullptr;
+		pipelineInfo.pColorBlendState = &colorBlendInfo;
+		pipelineInfo.pDynamicState = captured.dynamicStates.empty() ? nullptr : &dynamicStateInfo;
+		pipelineInfo.layout = pipelineLayouts[captured.layout];
+		pipelineInfo.renderPass = renderPasses[captured.renderPass];
+		pipelineInfo.subpass = captured.subpass;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a graphics pipeline");
+		}
+		return pipeline;
+	}
+
+	//? One pool sized for exactly the captured sets
+	void CreateDescriptorSets() {
+		if (capture.descriptorSets.empty()) {
+			return;
+		}
+
+		std::map<VkDescriptorType, uint> typeCounts;
+		bool updateAfterBind = false;
+		for (const CaptureFile::DescriptorSet& set : capture.descriptorSets) {
+			const CaptureFile::SetLayout& layout = capture.setLayouts[set.layout];
+			for (const CaptureFile::SetLayoutBinding& binding : layout.bindings) {
+				typeCounts[binding.type] += binding.count;
+			}
+			updateAfterBind = updateAfterBind or (layout.flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+		}
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const auto& typeCount : typeCounts) {
+			poolSizes.push_back({ typeCount.first, std::max(typeCount.second, 1u) });
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		if (updateAfterBind) {
+			poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		}
+		poolInfo.maxSets = uint(capture.descriptorSets.size());
+		poolInfo.poolSizeCount = uint(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a descriptor pool.");
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts;
+		for (const CaptureFile::DescriptorSet& set : capture.descriptorSets) {
+			layouts.push_back(setLayouts[set.layout]);
+		}
+		VkDescriptorSetAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = descriptorPool;
+		allocInfo.descriptorSetCount = uint(layouts.size());
+		allocInfo.pSetLayouts = layouts.data();
+		descriptorSets.resize(layouts.size());
+		if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't allocate the replay's descriptor sets.");
+		}
+
+		//? Reserved up front, the writes point into these
+		size_t descriptorCount = 0;
+		for (const CaptureFile::DescriptorSet& set : capture.descriptorSets) {
+			descriptorCount += set.descriptors.size();
+		}
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+		bufferInfos.reserve(descriptorCount);
+		imageInfos.reserve(descriptorCount);
+		writes.reserve(descriptorCount);
+		for (uint i = 0; i < capture.descriptorSets.size(); i++) {
+			for (const CaptureFile::Descriptor& descriptor : capture.descriptorSets[i].descriptors) {
+				VkWriteDescriptorSet write {};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = descriptorSets[i];
+				write.dstBinding = descriptor.binding;
+				write.dstArrayElement = descriptor.arrayElement;
+				write.descriptorCount = 1;
+				write.descriptorType = descriptor.type;
+				if (descriptor.buffer != CaptureFile::none) {
+					bufferInfos.push_back({ buffers[descriptor.buffer], descriptor.offset, descriptor.range });
+					write.pBufferInfo = &bufferInfos.back();
+				} else {
+					VkDescriptorImageInfo imageInfo {};
+					imageInfo.sampler = descriptor.sampler != CaptureFile::none ? samplers[descriptor.sampler] : VK_NULL_HANDLE;
+					imageInfo.imageView = descriptor.view != CaptureFile::none ? imageViews[descriptor.view] : VK_NULL_HANDLE;
+					imageInfo.imageLayout = descriptor.layout;
+					imageInfos.push_back(imageInfo);
+					write.pImageInfo = &imageInfos.back();
+				}
+				writes.push_back(write);
+			}
+		}
+		vkUpdateDescriptorSets(device, uint(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	void CreateCommands() {
+		VkCommandPoolCreateInfo poolInfo {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a command pool.");
+		}
+
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't allocate a command buffer.");
+		}
+
+		VkFenceCreateInfo fenceInfo {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't create a fence.");
+		}
+
+		uint passCount = uint(std::count_if(capture.commands.begin(), capture.commands.end(), [](const CaptureFile::Command& command) {
+			return command.op == CaptureFile::Op::BeginRenderPass;
+		}));
+		timer.Init(context, queueFamily, 1 + passCount);
+		frameScope = timer.AddScope("Frame");
+		for (uint pass = 0; pass < passCount; pass++) {
+			passScopes.push_back(timer.AddScope("Pass " + std::to_string(pass)));
+		}
+
+		RecordCommands();
+	}
+
+	void RecordCommands() {
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't begin recording a command buffer.");
+		}
+		timer.Reset(commandBuffer, 0);
+		timer.Begin(commandBuffer, 0, frameScope);
+
+		uint pass = 0;
+		for (const CaptureFile::Command& command : capture.commands) {
+			Record(command, pass);
+		}
+
+		timer.End(commandBuffer, 0, frameScope);
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+			throw std::runtime_error("Couldn't record a command buffer.");
+		}
+	}
+
+	void Record(const CaptureFile::Command& command, uint& pass) {
+		const std::vector<uint64>& args = command.args;
+		switch (command.op) {
+			case CaptureFile::Op::BeginRenderPass: {
+				std::vector<VkClearValue> clearValues = Unpack<VkClearValue>(command.data);
+				VkRenderPassBeginInfo renderPassInfo {};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = renderPasses[args[0]];
+				renderPassInfo.framebuffer = framebuffers[args[1]];
+				renderPassInfo.renderArea.offset = { int32(args[2]), int32(args[3]) };
+				renderPassInfo.renderArea.extent = { uint(args[4]), uint(args[5]) };
+				renderPassInfo.clearValueCount = uint(clearValues.size());
+				renderPassInfo.pClearValues = clearValues.data();
+				timer.Begin(commandBuffer, 0, passScopes[pass]);
+				vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+				break;
+			}
+			case CaptureFile::Op::EndRenderPass:
+				vkCmdEndRenderPass(commandBuffer);
+				timer.End(commandBuffer, 0, passScopes[pass++]);
+				break;
+			case CaptureFile::Op::BindPipeline:
+				vkCmdBindPipeline(commandBuffer, VkPipelineBindPoint(args[0]), pipelines[args[1]]);
+				break;
+			case CaptureFile::Op::BindDescriptorSets: {
+				std::vector<VkDescriptorSet> sets;
+				for (size_t i = 3; i < args.size(); i++) {
+					sets.push_back(descriptorSets[args[i]]);
+				}
+				std::vector<uint> dynamicOffsets = Unpack<uint>(command.data);
+				vkCmdBindDescriptorSets(commandBuffer, VkPipelineBindPoint(args[0]), pipelineLayouts[args[1]], uint(args[2]), uint(sets.size()), sets.data(), uint(dynamicOffsets.size()), dynamicOffsets.data());
+				break;
+			}
+			case CaptureFile::Op::BindVertexBuffers: {
+				std::vector<VkBuffer> vertexBuffers;
+				std::vector<VkDeviceSize> offsets;
+				for (size_t i = 1; i + 1 < args.size(); i += 2) {
+					vertexBuffers.push_back(buffers[args[i]]);
+					offsets.push_back(args[i + 1]);
+				}
+				vkCmdBindVertexBuffers(commandBuffer, uint(args[0]), uint(vertexBuffers.size()), vertexBuffers.data(), offsets.data());
+				break;
+			}
+			case CaptureFile::Op::BindIndexBuffer:
+				vkCmdBindIndexBuffer(commandBuffer, buffers[args[0]], args[1], VkIndexType(args[2]));
+				break;
+			case CaptureFile::Op::PushConstants:
+				vkCmdPushConstants(commandBuffer, pipelineLayouts[args[0]], VkShaderStageFlags(args[1]), uint(args[2]), uint(command.data.size()), command.data.data());
+				break;
+			case CaptureFile::Op::SetViewport: {
+				std::vector<VkViewport> viewports = Unpack<VkViewport>(command.data);
+				vkCmdSetViewport(commandBuffer, uint(args[0]), uint(viewports.size()), viewports.data());
+				break;
+			}
+			case CaptureFile::Op::SetScissor: {
+				std::vector<VkRect2D> scissors = Unpack<VkRect2D>(command.data);
+				vkCmdSetScissor(commandBuffer, uint(args[0]), uint(scissors.size()), scissors.data());
+				break;
+			}
+			case CaptureFile::Op::Draw:
+				vkCmdDraw(commandBuffer, uint(args[0]), uint(args[1]), uint(args[2]), uint(args[3]));
+				break;
+			case CaptureFile::Op::DrawIndexed:
+				vkCmdDrawIndexed(commandBuffer, uint(args[0]), uint(args[1]), uint(args[2]), int32(args[3]), uint(args[4]));
+				break;
+			case CaptureFile::Op::DrawIndexedIndirect:
+				vkCmdDrawIndexedIndirect(commandBuffer, buffers[args[0]], args[1], uint(args[2]), uint(args[3]));
+				break;
+			case CaptureFile::Op::DrawIndexedIndirectCount:
+				drawIndexedIndirectCount(commandBuffer, buffers[args[0]], args[1], buffers[args[2]], args[3], uint(args[4]), uint(args[5]));
+				break;
+			case CaptureFile::Op::ExecuteCommands:
+				throw std::runtime_error("Couldn't replay the capture, it still executes secondaries.");
+		}
+	}
+
+	//? FNV-1a of the last render pass' first color attachment after the last iteration.
+	//? Equal between runs on the same device and driver, a quick check that a change didn't alter the frame
+	bool Checksum(uint64& checksum) {
+		const CaptureFile::Command* lastPass = nullptr;
+		for (const CaptureFile::Command& command : capture.commands) {
+			if (command.op == CaptureFile::Op::BeginRenderPass) {
+				lastPass = &command;
+			}
+		}
+		if (lastPass == nullptr) {
+			return false;
+		}
+		const CaptureFile::RenderPass& renderPass = capture.renderPasses[lastPass->args[0]];
+		const CaptureFile::Framebuffer& framebuffer = capture.framebuffers[lastPass->args[1]];
+		if (renderPass.colorReferences.empty()) {
+			return false;
+		}
+		uint attachment = renderPass.colorReferences[0].attachment;
+		uint imageIndex = uint(capture.imageViews[framebuffer.attachments[attachment]].image);
+		const CaptureFile::Image& captured = capture.images[imageIndex];
+		TextureManager::FormatInfo format;
+		if (!TextureManager::GetFormatInfo(captured.format, format)) {
+			return false;
+		}
+		VkDeviceSize size = TextureManager::LevelSize(format, captured.extent, 0);
+		VkImageLayout layout = ReplayLayout(renderPass.attachments[attachment].finalLayout);
+
+		VkBuffer readbackBuffer;
+		VkDeviceMemory readbackMemory;
+		context.CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackMemory);
+		context.ImmediateSubmit([&](VkCommandBuffer commandBuffer) {
+			VkImageMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.oldLayout = layout;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = images[imageIndex];
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkBufferImageCopy region {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { captured.extent.width, captured.extent.height, 1 };
+			vkCmdCopyImageToBuffer(commandBuffer, images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+			VkMemoryBarrier toHost {};
+			toHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost, 0, nullptr, 0, nullptr);
+		});
+
+		void* mapped;
+		vkMapMemory(device, readbackMemory, 0, size, 0, &mapped);
+		const uint8* bytes = static_cast<const uint8*>(mapped);
+		checksum = 0xcbf29ce484222325ull;
+		for (VkDeviceSize i = 0; i < size; i++) {
+			checksum = (checksum ^ bytes[i]) * 0x100000001b3ull;
+		}
+		vkUnmapMemory(device, readbackMemory);
+		context.DestroyBuffer(readbackBuffer, readbackMemory);
+		return true;
+	}
+
+	void CleanUp() {
+		vkDeviceWaitIdle(device);
+		timer.CleanUp();
+		vkDestroyFence(device, fence, nullptr);
+		vkDestroyCommandPool(device, commandPool, nullptr);
+		if (descriptorPool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+		}
+		for (VkPipeline pipeline : pipelines) {
+			vkDestroyPipeline(device, pipeline, nullptr);
+		}
+		for (VkFramebuffer framebuffer : framebuffers) {
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+		}
+		for (VkRenderPass renderPass : renderPasses) {
+			vkDestroyRenderPass(device, renderPass, nullptr);
+		}
+		for (VkPipelineLayout layout : pipelineLayouts) {
+			vkDestroyPipelineLayout(device, layout, nullptr);
+		}
+		for (VkDescriptorSetLayout layout : setLayouts) {
+			vkDestroyDescriptorSetLayout(device, layout, nullptr);
+		}
+		for (VkShaderModule module : shaderModules) {
+			vkDestroyShaderModule(device, module, nullptr);
+		}
+		for (VkSampler sampler : samplers) {
+			vkDestroySampler(device, sampler, nullptr);
+		}
+		for (VkImageView view : imageViews) {
+			vkDestroyImageView(device, view, nullptr);
+		}
+		for (uint i = 0; i < images.size(); i++) {
+			context.DestroyImage(images[i], imageMemory[i]);
+		}
+		for (uint i = 0; i < buffers.size(); i++) {
+			context.DestroyBuffer(buffers[i], bufferMemory[i]);
+		}
+
+		memoryTracker.ReportLeaks();
+		vkDestroyDevice(device, nullptr);
+		vkDestroyInstance(instance, nullptr);
+	}
+};
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cout << "Usage: replay <capture> [iterations] [--record]" << std::endl;
+		return 1;
+	}
+	uint iterations = defaultIterations;
+	bool rerecord = false;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--record") == 0) {
+			rerecord = true;
+		} else {
+			iterations = uint(std::max(std::atoi(argv[i]), 1));
+		}
+	}
+
+	Replay replay;
+	try {
+		replay.Run(argv[1], iterations, rerecord);
+	} catch (std::exception& e) {
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}